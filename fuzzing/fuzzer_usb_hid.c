@@ -0,0 +1,39 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "os_io_usb.h"
+
+static void send_report(__attribute__((unused)) unsigned char *buffer,
+                        __attribute__((unused)) unsigned short length)
+{
+}
+
+// The input is a stream of HID reports, each one prefixed by its length (1 byte)
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    io_usb_hid_init();
+
+    while (size > 0) {
+        size_t length = data[0];
+        data++;
+        size--;
+        if (length > size) {
+            length = size;
+        }
+
+        // Exact size copy, to catch any read past the report
+        unsigned char *report = malloc(length ? length : 1);
+        memcpy(report, data, length);
+        if (io_usb_hid_receive(send_report, report, length, NULL) == IO_USB_APDU_RECEIVED) {
+            if (G_io_usb_hid_total_length > sizeof(G_io_apdu_buffer)) {
+                abort();
+            }
+        }
+        free(report);
+
+        data += length;
+        size -= length;
+    }
+    return 0;
+}
@@ -0,0 +1,19 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "lcx_rng.h"
+#include "os_io_seproxyhal.h"
+
+io_seph_app_t G_io_app;
+unsigned char G_io_apdu_buffer[IO_APDU_BUFFER_SIZE];
+
+void io_seph_send(__attribute__((unused)) const unsigned char *buffer,
+                  __attribute__((unused)) unsigned short       length)
+{
+}
+
+void cx_rng_no_throw(uint8_t *buffer, size_t len)
+{
+    memset(buffer, 0x5A, len);
+}
@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+
+"""
+Reference encoder of the compressed APDUs of apps built with
+ENABLE_APDU_COMPRESSION=1, and estimation of the transport gain.
+
+The command APDUs (hexadecimal, one per line) are read from a file or stdin,
+and compressed with the LZSS format decoded by src/lzss.c. For each of them,
+the number of HID reports (or BLE frames, with --mtu) needed to send it as is
+(tag 0x05) and compressed (tag 0x0A) is given. The compressed reports can be
+printed with --reports, to be replayed to the device.
+"""
+
+import argparse
+import sys
+
+MIN_MATCH = 3
+MAX_MATCH = MIN_MATCH + 0x0F
+MAX_OFFSET = 4096
+
+
+def compress(data):
+    """Greedy LZSS compression, the longest and then closest match being used."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        flags_index = len(out)
+        out.append(0)
+        for bit in range(8):
+            if i >= len(data):
+                break
+            best_length, best_offset = 0, 0
+            for j in range(max(0, i - MAX_OFFSET), i):
+                length = 0
+                while (length < MAX_MATCH and i + length < len(data)
+                       and data[j + length] == data[i + length]):
+                    length += 1
+                if length >= best_length:
+                    best_length, best_offset = length, i - j
+            if best_length >= MIN_MATCH:
+                reference = ((best_offset - 1) << 4) | (best_length - MIN_MATCH)
+                out += reference.to_bytes(2, "big")
+                i += best_length
+            else:
+                out[flags_index] |= 1 << bit
+                out.append(data[i])
+                i += 1
+    return bytes(out)
+
+
+def decompress(stream, length):
+    """Mirror of src/lzss.c, to check the encoder."""
+    out = bytearray()
+    i = 0
+    while i < len(stream):
+        flags = stream[i]
+        i += 1
+        for bit in range(8):
+            if i >= len(stream):
+                break
+            if flags & (1 << bit):
+                out.append(stream[i])
+                i += 1
+            else:
+                reference = int.from_bytes(stream[i:i + 2], "big")
+                i += 2
+                offset = (reference >> 4) + 1
+                for _ in range((reference & 0x0F) + MIN_MATCH):
+                    out.append(out[-offset])
+    assert len(out) == length
+    return bytes(out)
+
+
+def frames(tag, header, payload, mtu, channel=0x0101):
+    """Splits a payload in frames: <channel> <tag> <sequence> [<header>] <data>."""
+    result = []
+    sequence = 0
+    offset = 0
+    while offset < len(payload) or sequence == 0:
+        frame = channel.to_bytes(2, "big") + bytes([tag]) + sequence.to_bytes(2, "big")
+        if sequence == 0:
+            frame += header
+        size = mtu - len(frame)
+        frame += payload[offset:offset + size]
+        offset += size
+        sequence += 1
+        result.append(frame.ljust(mtu, b"\x00"))
+    return result
+
+
+def encode(apdu, mtu):
+    """Returns the plain and compressed frames of a command APDU."""
+    stream = compress(apdu)
+    assert decompress(stream, len(apdu)) == apdu
+    plain = frames(0x05, len(apdu).to_bytes(2, "big"), apdu, mtu)
+    compressed = frames(0x0A, len(apdu).to_bytes(2, "big") + len(stream).to_bytes(2, "big"),
+                        stream, mtu)
+    return plain, compressed
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", nargs="?", help="file of hexadecimal APDUs (default: stdin)")
+    parser.add_argument("--mtu", type=int, default=64, help="frame size (default: 64, USB HID)")
+    parser.add_argument("--reports", action="store_true", help="print the compressed frames")
+    args = parser.parse_args()
+
+    total_plain = total_compressed = 0
+    for line in open(args.input) if args.input else sys.stdin:
+        line = line.strip()
+        if not line:
+            continue
+        apdu = bytes.fromhex(line)
+        plain, compressed = encode(apdu, args.mtu)
+        if args.reports:
+            for frame in compressed:
+                print(frame.hex())
+            continue
+        # a compressed command is only worth sending when it saves frames
+        best = min(len(plain), len(compressed))
+        total_plain += len(plain)
+        total_compressed += best
+        print("%5d bytes: %3d frames, %3d compressed" % (len(apdu), len(plain), len(compressed)))
+
+    if not args.reports and total_compressed:
+        print("total: %d frames, %d with compression (x%.2f)"
+              % (total_plain, total_compressed, total_plain / total_compressed))
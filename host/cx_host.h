@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>  // uint*_t
+#include <stdio.h>   // FILE
+
+/**
+ * Statistics of one cryptographic entry point of the host backend.
+ *
+ * The total time includes the nested calls to other entry points, e.g. the
+ * hash calls made by an HMAC, while the self time excludes them.
+ */
+typedef struct cx_host_stat_s {
+    const char            *name;        /// Function name
+    uint64_t               calls;       /// Number of calls
+    uint64_t               total_ns;    /// Cumulated time, nested calls included
+    uint64_t               self_ns;     /// Cumulated time, nested calls excluded
+    uint64_t               max_ns;      /// Longest call, nested calls included
+    struct cx_host_stat_s *next;        /// Next entry point, in order of first call
+    int                    registered;  /// Whether the entry is in the list
+} cx_host_stat_t;
+
+/**
+ * @brief   Returns the statistics of the entry points called so far.
+ *
+ * @return  First entry of the list, NULL if no entry point was called.
+ */
+const cx_host_stat_t *cx_host_stats_first(void);
+
+/**
+ * @brief   Clears the counters of all the entry points.
+ */
+void cx_host_stats_reset(void);
+
+/**
+ * @brief   Prints the statistics, sorted by decreasing self time.
+ *
+ * @details If the CX_HOST_PROFILE environment variable is set, this is done
+ *          at exit, to the file it names or to stderr if its value is "-".
+ *
+ * @param[in] out Output stream.
+ */
+void cx_host_stats_dump(FILE *out);
+
+/**
+ * @brief   Returns the number of blocks compressed so far by the SHA-2 and
+ *          RIPEMD-160 functions of the backend.
+ */
+uint64_t cx_host_hash_blocks(void);
@@ -0,0 +1,391 @@
+
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include <stdint.h>  // uint*_t
+#include <string.h>  // memset, memcpy, explicit_bzero
+
+#include <openssl/evp.h>
+
+#include "cx.h"
+#include "cx_host_internal.h"
+
+/*
+ * The AES "hardware" is an OpenSSL ECB context, keyed by cx_aes_set_key_hw.
+ * The modes of operation are built on cx_aes_block_hw, as done by the OS.
+ */
+
+static EVP_CIPHER_CTX *aes_hw;
+static bool            aes_hw_keyed;
+
+cx_err_t cx_aes_set_key_hw(const cx_aes_key_t *key, uint32_t mode)
+{
+    CX_HOST_PROFILE();
+    const EVP_CIPHER *cipher;
+    int               enc;
+
+    switch (key->size) {
+        case 16:
+            cipher = EVP_aes_128_ecb();
+            break;
+        case 24:
+            cipher = EVP_aes_192_ecb();
+            break;
+        case 32:
+            cipher = EVP_aes_256_ecb();
+            break;
+        default:
+            return CX_INVALID_PARAMETER;
+    }
+    switch (mode & CX_MASK_SIGCRYPT) {
+        case CX_ENCRYPT:
+        case CX_SIGN:
+        case CX_VERIFY:
+            enc = 1;
+            break;
+        default:
+            enc = 0;
+            break;
+    }
+    if ((aes_hw == NULL) && ((aes_hw = EVP_CIPHER_CTX_new()) == NULL)) {
+        return CX_INTERNAL_ERROR;
+    }
+    if ((EVP_CipherInit_ex(aes_hw, cipher, NULL, key->keys, NULL, enc) != 1)
+        || (EVP_CIPHER_CTX_set_padding(aes_hw, 0) != 1)) {
+        return CX_INTERNAL_ERROR;
+    }
+    aes_hw_keyed = true;
+    return CX_OK;
+}
+
+void cx_aes_reset_hw(void)
+{
+    CX_HOST_PROFILE();
+
+    if (aes_hw != NULL) {
+        EVP_CIPHER_CTX_reset(aes_hw);
+    }
+    aes_hw_keyed = false;
+}
+
+cx_err_t cx_aes_block_hw(const unsigned char *inblock, unsigned char *outblock)
+{
+    CX_HOST_PROFILE();
+    int len;
+
+    if (!aes_hw_keyed) {
+        return CX_INVALID_PARAMETER;
+    }
+    if (EVP_CipherUpdate(aes_hw, outblock, &len, inblock, CX_AES_BLOCK_SIZE) != 1) {
+        return CX_INTERNAL_ERROR;
+    }
+    return CX_OK;
+}
+
+cx_err_t cx_aes_init_key_no_throw(const uint8_t *rawkey, size_t key_len, cx_aes_key_t *key)
+{
+    CX_HOST_PROFILE();
+
+    if ((key == NULL) || (rawkey == NULL)
+        || ((key_len != 16) && (key_len != 24) && (key_len != 32))) {
+        return CX_INVALID_PARAMETER;
+    }
+    memset(key, 0, sizeof(cx_aes_key_t));
+    key->size = key_len;
+    memcpy(key->keys, rawkey, key_len);
+    return CX_OK;
+}
+
+static cx_err_t aes_block(const cx_aes_key_t *key,
+                          uint32_t            mode,
+                          const uint8_t      *inblock,
+                          uint8_t            *outblock)
+{
+    cx_err_t error;
+
+    CX_CHECK(cx_aes_set_key_hw(key, mode));
+    error = cx_aes_block_hw(inblock, outblock);
+
+end:
+    cx_aes_reset_hw();
+    return error;
+}
+
+cx_err_t cx_aes_enc_block(const cx_aes_key_t *key, const uint8_t *inblock, uint8_t *outblock)
+{
+    CX_HOST_PROFILE();
+
+    return aes_block(key, CX_ENCRYPT, inblock, outblock);
+}
+
+cx_err_t cx_aes_dec_block(const cx_aes_key_t *key, const uint8_t *inblock, uint8_t *outblock)
+{
+    CX_HOST_PROFILE();
+
+    return aes_block(key, CX_DECRYPT, inblock, outblock);
+}
+
+/*
+ * Returns the length of the padded input, or 0 if the padding cannot be
+ * applied.
+ */
+static size_t aes_padded_len(uint32_t mode, size_t in_len)
+{
+    size_t rem = in_len % CX_AES_BLOCK_SIZE;
+
+    if (!(mode & CX_LAST)) {
+        return (rem == 0) ? in_len : 0;
+    }
+    switch (mode & CX_MASK_PAD) {
+        case CX_PAD_NONE:
+            return (rem == 0) ? in_len : 0;
+        case CX_PAD_ISO9797M1:
+            return (rem == 0 && in_len != 0) ? in_len : in_len - rem + CX_AES_BLOCK_SIZE;
+        case CX_PAD_ISO9797M2:
+            return in_len - rem + CX_AES_BLOCK_SIZE;
+        default:
+            return 0;
+    }
+}
+
+static void aes_ctr_increment(uint8_t *counter)
+{
+    for (size_t i = CX_AES_BLOCK_SIZE; i > 0; i--) {
+        if (++counter[i - 1] != 0) {
+            break;
+        }
+    }
+}
+
+static cx_err_t aes_ctr(const uint8_t *iv, const uint8_t *in, size_t in_len, uint8_t *out)
+{
+    cx_err_t error = CX_OK;
+    uint8_t  counter[CX_AES_BLOCK_SIZE];
+    uint8_t  stream[CX_AES_BLOCK_SIZE];
+    size_t   n;
+
+    memcpy(counter, iv, CX_AES_BLOCK_SIZE);
+    while (in_len > 0) {
+        CX_CHECK(cx_aes_block_hw(counter, stream));
+        aes_ctr_increment(counter);
+        n = (in_len < CX_AES_BLOCK_SIZE) ? in_len : CX_AES_BLOCK_SIZE;
+        for (size_t i = 0; i < n; i++) {
+            out[i] = in[i] ^ stream[i];
+        }
+        in += n;
+        out += n;
+        in_len -= n;
+    }
+
+end:
+    explicit_bzero(stream, sizeof(stream));
+    return error;
+}
+
+/*
+ * Encrypts or MACs the input, padded according to the mode. The whole
+ * ciphertext is written to out unless only the last block is wanted.
+ */
+static cx_err_t aes_encrypt(uint32_t       mode,
+                            const uint8_t *iv,
+                            const uint8_t *in,
+                            size_t         in_len,
+                            size_t         padded_len,
+                            uint8_t       *out,
+                            bool           last_block_only)
+{
+    cx_err_t error = CX_OK;
+    uint8_t  block[CX_AES_BLOCK_SIZE];
+    uint8_t  chain[CX_AES_BLOCK_SIZE];
+    size_t   n;
+
+    memcpy(chain, iv, CX_AES_BLOCK_SIZE);
+    for (size_t off = 0; off < padded_len; off += CX_AES_BLOCK_SIZE) {
+        n = (in_len > off) ? in_len - off : 0;
+        if (n >= CX_AES_BLOCK_SIZE) {
+            memcpy(block, in + off, CX_AES_BLOCK_SIZE);
+        }
+        else {
+            memset(block, 0, CX_AES_BLOCK_SIZE);
+            memcpy(block, in + off, n);
+            if ((mode & CX_MASK_PAD) == CX_PAD_ISO9797M2) {
+                block[n] = 0x80;
+            }
+        }
+        if ((mode & CX_MASK_CHAIN) == CX_CHAIN_CBC) {
+            for (size_t i = 0; i < CX_AES_BLOCK_SIZE; i++) {
+                block[i] ^= chain[i];
+            }
+        }
+        CX_CHECK(cx_aes_block_hw(block, chain));
+        if (!last_block_only) {
+            memcpy(out + off, chain, CX_AES_BLOCK_SIZE);
+        }
+    }
+    if (last_block_only) {
+        memcpy(out, chain, CX_AES_BLOCK_SIZE);
+    }
+
+end:
+    explicit_bzero(block, sizeof(block));
+    explicit_bzero(chain, sizeof(chain));
+    return error;
+}
+
+static cx_err_t aes_decrypt(uint32_t       mode,
+                            const uint8_t *iv,
+                            const uint8_t *in,
+                            size_t         in_len,
+                            uint8_t       *out,
+                            size_t        *out_len)
+{
+    cx_err_t error = CX_OK;
+    uint8_t  chain[CX_AES_BLOCK_SIZE];
+    uint8_t  next[CX_AES_BLOCK_SIZE];
+    size_t   len;
+
+    memcpy(chain, iv, CX_AES_BLOCK_SIZE);
+    for (size_t off = 0; off < in_len; off += CX_AES_BLOCK_SIZE) {
+        // in and out may overlap
+        memcpy(next, in + off, CX_AES_BLOCK_SIZE);
+        CX_CHECK(cx_aes_block_hw(next, out + off));
+        if ((mode & CX_MASK_CHAIN) == CX_CHAIN_CBC) {
+            for (size_t i = 0; i < CX_AES_BLOCK_SIZE; i++) {
+                out[off + i] ^= chain[i];
+            }
+            memcpy(chain, next, CX_AES_BLOCK_SIZE);
+        }
+    }
+    len = in_len;
+    if ((mode & CX_LAST) && ((mode & CX_MASK_PAD) == CX_PAD_ISO9797M2)) {
+        while ((len > 0) && (out[len - 1] == 0)) {
+            len--;
+        }
+        if ((len == 0) || (out[len - 1] != 0x80)) {
+            error = CX_INVALID_PARAMETER;
+            goto end;
+        }
+        len--;
+    }
+    *out_len = len;
+
+end:
+    explicit_bzero(chain, sizeof(chain));
+    return error;
+}
+
+cx_err_t cx_aes_iv_no_throw(const cx_aes_key_t *key,
+                            uint32_t            mode,
+                            const uint8_t      *iv,
+                            size_t              iv_len,
+                            const uint8_t      *in,
+                            size_t              in_len,
+                            uint8_t            *out,
+                            size_t             *out_len)
+{
+    CX_HOST_PROFILE();
+    cx_err_t error;
+    uint8_t  zero_iv[CX_AES_BLOCK_SIZE] = {0};
+    uint8_t  mac[CX_AES_BLOCK_SIZE];
+    uint32_t chain = mode & CX_MASK_CHAIN;
+    uint32_t op    = mode & CX_MASK_SIGCRYPT;
+    size_t   len;
+
+    if ((key == NULL) || (out_len == NULL) || ((in == NULL) && (in_len != 0))
+        || ((iv != NULL) && (iv_len != CX_AES_BLOCK_SIZE))) {
+        return CX_INVALID_PARAMETER;
+    }
+    if ((chain != CX_CHAIN_ECB) && (chain != CX_CHAIN_CBC) && (chain != CX_CHAIN_CTR)) {
+        return CX_INVALID_PARAMETER;
+    }
+    if (iv == NULL) {
+        iv = zero_iv;
+    }
+
+    if (chain == CX_CHAIN_CTR) {
+        len = in_len;
+    }
+    else if ((op == CX_DECRYPT) && (in_len % CX_AES_BLOCK_SIZE == 0)) {
+        len = in_len;
+    }
+    else if ((op == CX_DECRYPT) || ((len = aes_padded_len(mode, in_len)) == 0)) {
+        return CX_INVALID_PARAMETER;
+    }
+    if ((op == CX_SIGN) || (op == CX_VERIFY)) {
+        len = CX_AES_BLOCK_SIZE;
+    }
+    if (*out_len < len) {
+        return CX_INVALID_PARAMETER;
+    }
+
+    CX_CHECK(cx_aes_set_key_hw(key, mode));
+    switch (op) {
+        case CX_ENCRYPT:
+            if (chain == CX_CHAIN_CTR) {
+                CX_CHECK(aes_ctr(iv, in, in_len, out));
+            }
+            else {
+                CX_CHECK(aes_encrypt(mode, iv, in, in_len, len, out, false));
+            }
+            *out_len = len;
+            break;
+        case CX_DECRYPT:
+            if (chain == CX_CHAIN_CTR) {
+                CX_CHECK(aes_ctr(iv, in, in_len, out));
+                *out_len = len;
+            }
+            else {
+                CX_CHECK(aes_decrypt(mode, iv, in, in_len, out, out_len));
+            }
+            break;
+        case CX_SIGN:
+        case CX_VERIFY:
+            // CBC-MAC, the signature is the last block
+            if (chain != CX_CHAIN_CBC) {
+                error = CX_INVALID_PARAMETER;
+                goto end;
+            }
+            CX_CHECK(aes_encrypt(mode, iv, in, in_len, aes_padded_len(mode, in_len), mac, true));
+            if (op == CX_SIGN) {
+                memcpy(out, mac, CX_AES_BLOCK_SIZE);
+            }
+            else if (CRYPTO_memcmp(out, mac, CX_AES_BLOCK_SIZE) != 0) {
+                error = CX_INVALID_PARAMETER;
+                goto end;
+            }
+            *out_len = CX_AES_BLOCK_SIZE;
+            break;
+        default:
+            error = CX_INVALID_PARAMETER;
+            break;
+    }
+
+end:
+    cx_aes_reset_hw();
+    explicit_bzero(mac, sizeof(mac));
+    return error;
+}
+
+cx_err_t cx_aes_no_throw(const cx_aes_key_t *key,
+                         uint32_t            mode,
+                         const uint8_t      *in,
+                         size_t              in_len,
+                         uint8_t            *out,
+                         size_t             *out_len)
+{
+    CX_HOST_PROFILE();
+
+    return cx_aes_iv_no_throw(key, mode, NULL, 0, in, in_len, out, out_len);
+}
@@ -0,0 +1,1346 @@
+
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include <stdint.h>  // uint*_t
+#include <string.h>  // memset
+
+#include <openssl/bn.h>
+
+#include "cx.h"
+#include "os_math.h"
+#include "os_utils.h"
+#include "cx_host_internal.h"
+
+/*
+ * The BN processor memory is a table of OpenSSL BIGNUMs. Each BN keeps the
+ * size it was allocated with, and the results are reduced modulo 2^(8 * size)
+ * as done by the hardware.
+ */
+
+/** Maximal number of BNs allocated at the same time */
+#define BN_MAX_COUNT 64
+
+/** Maximal size of a BN, in bytes */
+#define BN_MAX_NBYTES 1024
+
+typedef struct {
+    BIGNUM *v;       ///< Value, NULL if the BN is not allocated
+    size_t  nbytes;  ///< Size of the BN, multiple of the word size
+} bn_slot_t;
+
+static bn_slot_t bn_slots[BN_MAX_COUNT];
+static size_t    bn_word_nbytes;
+static bool      bn_locked;
+static BN_CTX   *bn_ctx;
+
+BN_CTX *cx_host_bn_ctx(void)
+{
+    if (bn_ctx == NULL) {
+        bn_ctx = BN_CTX_new();
+    }
+    return bn_ctx;
+}
+
+static cx_err_t bn_slot(cx_bn_t x, bn_slot_t **slot)
+{
+    if (!bn_locked) {
+        return CX_NOT_LOCKED;
+    }
+    if ((x >= BN_MAX_COUNT) || (bn_slots[x].v == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+    *slot = &bn_slots[x];
+    return CX_OK;
+}
+
+/*
+ * Stores a value in a BN, reduced to its size. Negative values are taken
+ * modulo 2^(8 * size) too, which is what a subtraction borrow gives.
+ */
+static cx_err_t bn_store(bn_slot_t *slot, const BIGNUM *v)
+{
+    cx_err_t error = CX_OK;
+    int      nbits = (int) slot->nbytes * 8;
+
+    if (BN_copy(slot->v, v) == NULL) {
+        return CX_MEMORY_FULL;
+    }
+    if (BN_is_negative(slot->v)) {
+        BIGNUM *m = BN_new();
+
+        if ((m == NULL) || !BN_set_bit(m, nbits) || !BN_nnmod(slot->v, slot->v, m, bn_ctx)) {
+            BN_free(m);
+            return CX_MEMORY_FULL;
+        }
+        BN_free(m);
+        error = CX_CARRY;
+    }
+    if (BN_num_bits(slot->v) > nbits) {
+        BN_mask_bits(slot->v, nbits);
+        error = CX_CARRY;
+    }
+    return error;
+}
+
+BIGNUM *cx_host_bn_get(cx_bn_t x, size_t *nbytes)
+{
+    bn_slot_t *slot;
+
+    if (bn_slot(x, &slot) != CX_OK) {
+        return NULL;
+    }
+    if (nbytes != NULL) {
+        *nbytes = slot->nbytes;
+    }
+    return slot->v;
+}
+
+cx_err_t cx_host_bn_set(cx_bn_t x, const BIGNUM *v)
+{
+    cx_err_t   error;
+    bn_slot_t *slot;
+
+    CX_CHECK(bn_slot(x, &slot));
+    error = bn_store(slot, v);
+
+end:
+    return error;
+}
+
+/* ======================================================================= */
+/*                                  Config                                 */
+/* ======================================================================= */
+
+cx_err_t cx_bn_lock(size_t word_nbytes, uint32_t flags)
+{
+    CX_HOST_PROFILE();
+    (void) flags;
+
+    if (bn_locked) {
+        return CX_LOCKED;
+    }
+    if ((word_nbytes == 0) || (word_nbytes % CX_BN_WORD_ALIGNEMENT != 0)) {
+        return CX_INVALID_PARAMETER_SIZE;
+    }
+    if (cx_host_bn_ctx() == NULL) {
+        return CX_MEMORY_FULL;
+    }
+    bn_word_nbytes = word_nbytes;
+    bn_locked      = true;
+    return CX_OK;
+}
+
+uint32_t cx_bn_unlock(void)
+{
+    CX_HOST_PROFILE();
+
+    if (!bn_locked) {
+        return CX_NOT_LOCKED;
+    }
+    for (size_t i = 0; i < BN_MAX_COUNT; i++) {
+        BN_clear_free(bn_slots[i].v);
+        bn_slots[i].v      = NULL;
+        bn_slots[i].nbytes = 0;
+    }
+    bn_locked = false;
+    return CX_OK;
+}
+
+bool cx_bn_is_locked(void)
+{
+    CX_HOST_PROFILE();
+
+    return bn_locked;
+}
+
+cx_err_t cx_bn_locked(void)
+{
+    return bn_locked ? CX_OK : CX_NOT_LOCKED;
+}
+
+/* ======================================================================= */
+/*                                  Alloca                                 */
+/* ======================================================================= */
+
+cx_err_t cx_bn_alloc(cx_bn_t *x, size_t nbytes)
+{
+    CX_HOST_PROFILE();
+
+    if (!bn_locked) {
+        return CX_NOT_LOCKED;
+    }
+    nbytes = (nbytes + bn_word_nbytes - 1) / bn_word_nbytes * bn_word_nbytes;
+    if ((nbytes == 0) || (nbytes > BN_MAX_NBYTES)) {
+        return CX_INVALID_PARAMETER_SIZE;
+    }
+    for (cx_bn_t i = 0; i < BN_MAX_COUNT; i++) {
+        if (bn_slots[i].v == NULL) {
+            if ((bn_slots[i].v = BN_secure_new()) == NULL) {
+                return CX_MEMORY_FULL;
+            }
+            bn_slots[i].nbytes = nbytes;
+            *x                 = i;
+            return CX_OK;
+        }
+    }
+    return CX_MEMORY_FULL;
+}
+
+cx_err_t cx_bn_alloc_init(cx_bn_t       *x,
+                          size_t         nbytes,
+                          const uint8_t *value,
+                          size_t         value_nbytes)
+{
+    CX_HOST_PROFILE();
+    cx_err_t error;
+
+    if (value_nbytes > nbytes) {
+        return CX_INVALID_PARAMETER_SIZE;
+    }
+    CX_CHECK(cx_bn_alloc(x, nbytes));
+    CX_CHECK(cx_bn_init(*x, value, value_nbytes));
+
+end:
+    return error;
+}
+
+cx_err_t cx_bn_destroy(cx_bn_t *x)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *slot;
+
+    if ((x == NULL) || (*x & CX_BN_FLAG_UNSET)) {
+        return CX_OK;
+    }
+    CX_CHECK(bn_slot(*x, &slot));
+    BN_clear_free(slot->v);
+    slot->v      = NULL;
+    slot->nbytes = 0;
+    *x           = CX_BN_FLAG_UNSET;
+
+end:
+    return error;
+}
+
+cx_err_t cx_bn_nbytes(const cx_bn_t x, size_t *nbytes)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *slot;
+
+    CX_CHECK(bn_slot(x, &slot));
+    *nbytes = slot->nbytes;
+
+end:
+    return error;
+}
+
+/* ======================================================================= */
+/*                              Basic operations                           */
+/* ======================================================================= */
+
+cx_err_t cx_bn_init(cx_bn_t x, const uint8_t *value, size_t value_nbytes)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *slot;
+
+    CX_CHECK(bn_slot(x, &slot));
+    if (value_nbytes > slot->nbytes) {
+        return CX_INVALID_PARAMETER_SIZE;
+    }
+    if (BN_bin2bn(value, (int) value_nbytes, slot->v) == NULL) {
+        return CX_MEMORY_FULL;
+    }
+
+end:
+    return error;
+}
+
+cx_err_t cx_bn_rand(cx_bn_t x)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *slot;
+
+    CX_CHECK(bn_slot(x, &slot));
+    if (!BN_priv_rand(slot->v, (int) slot->nbytes * 8, BN_RAND_TOP_ANY, BN_RAND_BOTTOM_ANY)) {
+        return CX_INTERNAL_ERROR;
+    }
+
+end:
+    return error;
+}
+
+cx_err_t cx_bn_copy(cx_bn_t a, const cx_bn_t b)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *sa, *sb;
+
+    CX_CHECK(bn_slot(a, &sa));
+    CX_CHECK(bn_slot(b, &sb));
+    if (sa->nbytes < sb->nbytes) {
+        return CX_INVALID_PARAMETER_SIZE;
+    }
+    if (BN_copy(sa->v, sb->v) == NULL) {
+        return CX_MEMORY_FULL;
+    }
+
+end:
+    return error;
+}
+
+cx_err_t cx_bn_set_u32(cx_bn_t x, uint32_t n)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *slot;
+
+    CX_CHECK(bn_slot(x, &slot));
+    if (!BN_set_word(slot->v, n)) {
+        return CX_MEMORY_FULL;
+    }
+
+end:
+    return error;
+}
+
+cx_err_t cx_bn_get_u32(const cx_bn_t x, uint32_t *n)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *slot;
+    uint8_t    low[4];
+
+    CX_CHECK(bn_slot(x, &slot));
+    // Least significant word, as read from the BN memory
+    if (BN_bn2binpad(slot->v, low, sizeof(low)) < 0) {
+        BIGNUM *t = BN_dup(slot->v);
+
+        if (t == NULL) {
+            return CX_MEMORY_FULL;
+        }
+        BN_mask_bits(t, 32);
+        BN_bn2binpad(t, low, sizeof(low));
+        BN_free(t);
+    }
+    *n = U4BE(low, 0);
+
+end:
+    return error;
+}
+
+cx_err_t cx_bn_export(const cx_bn_t x, uint8_t *bytes, size_t nbytes)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *slot;
+    BIGNUM    *t;
+
+    CX_CHECK(bn_slot(x, &slot));
+    if ((bytes == NULL) || (nbytes == 0)) {
+        return CX_INVALID_PARAMETER_SIZE;
+    }
+    // Only the least significant bytes are kept
+    if ((t = BN_dup(slot->v)) == NULL) {
+        return CX_MEMORY_FULL;
+    }
+    if (nbytes < slot->nbytes) {
+        BN_mask_bits(t, (int) nbytes * 8);
+    }
+    BN_bn2binpad(t, bytes, (int) nbytes);
+    BN_clear_free(t);
+
+end:
+    return error;
+}
+
+cx_err_t cx_bn_cmp(const cx_bn_t a, const cx_bn_t b, int *diff)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *sa, *sb;
+
+    CX_CHECK(bn_slot(a, &sa));
+    CX_CHECK(bn_slot(b, &sb));
+    *diff = BN_cmp(sa->v, sb->v);
+
+end:
+    return error;
+}
+
+cx_err_t cx_bn_cmp_u32(const cx_bn_t a, uint32_t b, int *diff)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *sa;
+    BIGNUM    *t;
+
+    CX_CHECK(bn_slot(a, &sa));
+    BN_CTX_start(bn_ctx);
+    if (((t = BN_CTX_get(bn_ctx)) == NULL) || !BN_set_word(t, b)) {
+        error = CX_MEMORY_FULL;
+    }
+    else {
+        *diff = BN_cmp(sa->v, t);
+    }
+    BN_CTX_end(bn_ctx);
+
+end:
+    return error;
+}
+
+cx_err_t cx_bn_is_odd(const cx_bn_t n, bool *odd)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *slot;
+
+    CX_CHECK(bn_slot(n, &slot));
+    *odd = BN_is_odd(slot->v);
+
+end:
+    return error;
+}
+
+/* ======================================================================= */
+/*                           Bitwise operations                            */
+/* ======================================================================= */
+
+typedef enum {
+    BN_OP_XOR,
+    BN_OP_OR,
+    BN_OP_AND
+} bn_bitwise_op_t;
+
+static cx_err_t bn_bitwise(cx_bn_t r, const cx_bn_t a, const cx_bn_t b, bn_bitwise_op_t op)
+{
+    cx_err_t   error;
+    bn_slot_t *sr, *sa, *sb;
+    uint8_t    va[BN_MAX_NBYTES];
+    uint8_t    vb[BN_MAX_NBYTES];
+    size_t     len;
+
+    CX_CHECK(bn_slot(r, &sr));
+    CX_CHECK(bn_slot(a, &sa));
+    CX_CHECK(bn_slot(b, &sb));
+    if ((sa->nbytes != sr->nbytes) || (sb->nbytes != sr->nbytes)) {
+        return CX_INVALID_PARAMETER_SIZE;
+    }
+    len = sr->nbytes;
+    BN_bn2binpad(sa->v, va, (int) len);
+    BN_bn2binpad(sb->v, vb, (int) len);
+    for (size_t i = 0; i < len; i++) {
+        switch (op) {
+            case BN_OP_XOR:
+                va[i] ^= vb[i];
+                break;
+            case BN_OP_OR:
+                va[i] |= vb[i];
+                break;
+            default:
+                va[i] &= vb[i];
+                break;
+        }
+    }
+    if (BN_bin2bn(va, (int) len, sr->v) == NULL) {
+        error = CX_MEMORY_FULL;
+    }
+    explicit_bzero(va, len);
+    explicit_bzero(vb, len);
+
+end:
+    return error;
+}
+
+cx_err_t cx_bn_xor(cx_bn_t r, const cx_bn_t a, const cx_bn_t b)
+{
+    CX_HOST_PROFILE();
+
+    return bn_bitwise(r, a, b, BN_OP_XOR);
+}
+
+cx_err_t cx_bn_or(cx_bn_t r, const cx_bn_t a, const cx_bn_t b)
+{
+    CX_HOST_PROFILE();
+
+    return bn_bitwise(r, a, b, BN_OP_OR);
+}
+
+cx_err_t cx_bn_and(cx_bn_t r, const cx_bn_t a, const cx_bn_t b)
+{
+    CX_HOST_PROFILE();
+
+    return bn_bitwise(r, a, b, BN_OP_AND);
+}
+
+cx_err_t cx_bn_tst_bit(const cx_bn_t x, uint32_t pos, bool *set)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *slot;
+
+    CX_CHECK(bn_slot(x, &slot));
+    if (pos >= slot->nbytes * 8) {
+        return CX_INVALID_PARAMETER;
+    }
+    *set = BN_is_bit_set(slot->v, (int) pos);
+
+end:
+    return error;
+}
+
+cx_err_t cx_bn_set_bit(cx_bn_t x, uint32_t pos)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *slot;
+
+    CX_CHECK(bn_slot(x, &slot));
+    if (pos >= slot->nbytes * 8) {
+        return CX_INVALID_PARAMETER;
+    }
+    if (!BN_set_bit(slot->v, (int) pos)) {
+        return CX_MEMORY_FULL;
+    }
+
+end:
+    return error;
+}
+
+cx_err_t cx_bn_clr_bit(cx_bn_t x, uint32_t pos)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *slot;
+
+    CX_CHECK(bn_slot(x, &slot));
+    if (pos >= slot->nbytes * 8) {
+        return CX_INVALID_PARAMETER;
+    }
+    BN_clear_bit(slot->v, (int) pos);
+
+end:
+    return error;
+}
+
+cx_err_t cx_bn_shr(cx_bn_t x, uint32_t n)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *slot;
+
+    CX_CHECK(bn_slot(x, &slot));
+    if (!BN_rshift(slot->v, slot->v, (int) MIN(n, slot->nbytes * 8))) {
+        return CX_MEMORY_FULL;
+    }
+
+end:
+    return error;
+}
+
+cx_err_t cx_bn_shl(cx_bn_t x, uint32_t n)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *slot;
+
+    CX_CHECK(bn_slot(x, &slot));
+    if (!BN_lshift(slot->v, slot->v, (int) MIN(n, slot->nbytes * 8))) {
+        return CX_MEMORY_FULL;
+    }
+    // The bits shifted out of the BN are lost
+    BN_mask_bits(slot->v, (int) slot->nbytes * 8);
+
+end:
+    return error;
+}
+
+cx_err_t cx_bn_cnt_bits(cx_bn_t n, uint32_t *nbits)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *slot;
+
+    CX_CHECK(bn_slot(n, &slot));
+    // As the OS does, this is the position of the most significant bit set
+    *nbits = (uint32_t) BN_num_bits(slot->v);
+
+end:
+    return error;
+}
+
+/* ======================================================================= */
+/*                         Non-modular arithmetic                          */
+/* ======================================================================= */
+
+cx_err_t cx_bn_add(cx_bn_t r, const cx_bn_t a, const cx_bn_t b)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *sr, *sa, *sb;
+    BIGNUM    *t;
+
+    CX_CHECK(bn_slot(r, &sr));
+    CX_CHECK(bn_slot(a, &sa));
+    CX_CHECK(bn_slot(b, &sb));
+    if ((sa->nbytes != sr->nbytes) || (sb->nbytes != sr->nbytes)) {
+        return CX_INVALID_PARAMETER_SIZE;
+    }
+    BN_CTX_start(bn_ctx);
+    if (((t = BN_CTX_get(bn_ctx)) == NULL) || !BN_add(t, sa->v, sb->v)) {
+        error = CX_MEMORY_FULL;
+    }
+    else {
+        error = bn_store(sr, t);
+    }
+    BN_CTX_end(bn_ctx);
+
+end:
+    return error;
+}
+
+cx_err_t cx_bn_sub(cx_bn_t r, const cx_bn_t a, const cx_bn_t b)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *sr, *sa, *sb;
+    BIGNUM    *t;
+
+    CX_CHECK(bn_slot(r, &sr));
+    CX_CHECK(bn_slot(a, &sa));
+    CX_CHECK(bn_slot(b, &sb));
+    if ((sa->nbytes != sr->nbytes) || (sb->nbytes != sr->nbytes)) {
+        return CX_INVALID_PARAMETER_SIZE;
+    }
+    BN_CTX_start(bn_ctx);
+    if (((t = BN_CTX_get(bn_ctx)) == NULL) || !BN_sub(t, sa->v, sb->v)) {
+        error = CX_MEMORY_FULL;
+    }
+    else {
+        error = bn_store(sr, t);
+    }
+    BN_CTX_end(bn_ctx);
+
+end:
+    return error;
+}
+
+cx_err_t cx_bn_mul(cx_bn_t r, const cx_bn_t a, const cx_bn_t b)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *sr, *sa, *sb;
+    BIGNUM    *t;
+
+    CX_CHECK(bn_slot(r, &sr));
+    CX_CHECK(bn_slot(a, &sa));
+    CX_CHECK(bn_slot(b, &sb));
+    if (sr->nbytes < sa->nbytes + sb->nbytes) {
+        return CX_INVALID_PARAMETER_SIZE;
+    }
+    BN_CTX_start(bn_ctx);
+    if (((t = BN_CTX_get(bn_ctx)) == NULL) || !BN_mul(t, sa->v, sb->v, bn_ctx)) {
+        error = CX_MEMORY_FULL;
+    }
+    else {
+        error = bn_store(sr, t);
+    }
+    BN_CTX_end(bn_ctx);
+
+end:
+    return error;
+}
+
+/* ======================================================================= */
+/*                           Modular arithmetic                            */
+/* ======================================================================= */
+
+/*
+ * Checks the operands of a modular operation: all of them have the size of
+ * the modulus, which is not zero.
+ */
+static cx_err_t bn_mod_operands(bn_slot_t *sn, bn_slot_t *const *ops, size_t count)
+{
+    if (BN_is_zero(sn->v)) {
+        return CX_INVALID_PARAMETER;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (ops[i]->nbytes != sn->nbytes) {
+            return CX_INVALID_PARAMETER_SIZE;
+        }
+    }
+    return CX_OK;
+}
+
+typedef enum {
+    BN_MOD_ADD,
+    BN_MOD_SUB,
+    BN_MOD_MUL
+} bn_mod_op_t;
+
+static cx_err_t bn_mod_op(cx_bn_t r, const cx_bn_t a, const cx_bn_t b, const cx_bn_t n,
+                          bn_mod_op_t op)
+{
+    cx_err_t   error;
+    bn_slot_t *sr, *sa, *sb, *sn;
+    BIGNUM    *t;
+    int        ok;
+
+    CX_CHECK(bn_slot(r, &sr));
+    CX_CHECK(bn_slot(a, &sa));
+    CX_CHECK(bn_slot(b, &sb));
+    CX_CHECK(bn_slot(n, &sn));
+    CX_CHECK(bn_mod_operands(sn, (bn_slot_t *[]){sr, sa, sb}, 3));
+    BN_CTX_start(bn_ctx);
+    if ((t = BN_CTX_get(bn_ctx)) == NULL) {
+        ok = 0;
+    }
+    else if (op == BN_MOD_ADD) {
+        ok = BN_mod_add(t, sa->v, sb->v, sn->v, bn_ctx);
+    }
+    else if (op == BN_MOD_SUB) {
+        ok = BN_mod_sub(t, sa->v, sb->v, sn->v, bn_ctx);
+    }
+    else {
+        ok = BN_mod_mul(t, sa->v, sb->v, sn->v, bn_ctx);
+    }
+    error = ok ? bn_store(sr, t) : CX_MEMORY_FULL;
+    BN_CTX_end(bn_ctx);
+
+end:
+    return error;
+}
+
+cx_err_t cx_bn_mod_add(cx_bn_t r, const cx_bn_t a, const cx_bn_t b, const cx_bn_t n)
+{
+    CX_HOST_PROFILE();
+
+    return bn_mod_op(r, a, b, n, BN_MOD_ADD);
+}
+
+cx_err_t cx_bn_mod_sub(cx_bn_t r, const cx_bn_t a, const cx_bn_t b, const cx_bn_t n)
+{
+    CX_HOST_PROFILE();
+
+    return bn_mod_op(r, a, b, n, BN_MOD_SUB);
+}
+
+cx_err_t cx_bn_mod_mul(cx_bn_t r, const cx_bn_t a, const cx_bn_t b, const cx_bn_t n)
+{
+    CX_HOST_PROFILE();
+
+    return bn_mod_op(r, a, b, n, BN_MOD_MUL);
+}
+
+cx_err_t cx_bn_reduce(cx_bn_t r, const cx_bn_t d, const cx_bn_t n)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *sr, *sd, *sn;
+    BIGNUM    *t;
+
+    CX_CHECK(bn_slot(r, &sr));
+    CX_CHECK(bn_slot(d, &sd));
+    CX_CHECK(bn_slot(n, &sn));
+    CX_CHECK(bn_mod_operands(sn, &sr, 1));
+    BN_CTX_start(bn_ctx);
+    if (((t = BN_CTX_get(bn_ctx)) == NULL) || !BN_nnmod(t, sd->v, sn->v, bn_ctx)) {
+        error = CX_MEMORY_FULL;
+    }
+    else {
+        error = bn_store(sr, t);
+    }
+    BN_CTX_end(bn_ctx);
+
+end:
+    return error;
+}
+
+cx_err_t cx_bn_mod_sqrt(cx_bn_t r, const cx_bn_t a, const cx_bn_t n, uint32_t sign)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *sr, *sa, *sn;
+    BIGNUM    *t, *check;
+
+    CX_CHECK(bn_slot(r, &sr));
+    CX_CHECK(bn_slot(a, &sa));
+    CX_CHECK(bn_slot(n, &sn));
+    CX_CHECK(bn_mod_operands(sn, (bn_slot_t *[]){sr, sa}, 2));
+    BN_CTX_start(bn_ctx);
+    t     = BN_CTX_get(bn_ctx);
+    check = BN_CTX_get(bn_ctx);
+    if ((check == NULL) || (BN_mod_sqrt(t, sa->v, sn->v, bn_ctx) == NULL)
+        || !BN_mod_sqr(check, t, sn->v, bn_ctx) || !BN_nnmod(t, t, sn->v, bn_ctx)) {
+        error = CX_NO_RESIDUE;
+        goto end_ctx;
+    }
+    BN_nnmod(check, check, sn->v, bn_ctx);
+    BN_nnmod(sr->v, sa->v, sn->v, bn_ctx);
+    if (BN_cmp(check, sr->v) != 0) {
+        error = CX_NO_RESIDUE;
+        goto end_ctx;
+    }
+    // The root of the requested parity is kept
+    if (!BN_is_zero(t) && ((uint32_t) BN_is_odd(t) != (sign & 1))) {
+        BN_sub(t, sn->v, t);
+    }
+    error = bn_store(sr, t);
+
+end_ctx:
+    BN_CTX_end(bn_ctx);
+end:
+    return error;
+}
+
+static cx_err_t bn_mod_pow(bn_slot_t *sr, bn_slot_t *sa, const BIGNUM *e, bn_slot_t *sn)
+{
+    cx_err_t error;
+    BIGNUM  *t;
+
+    CX_CHECK(bn_mod_operands(sn, (bn_slot_t *[]){sr, sa}, 2));
+    BN_CTX_start(bn_ctx);
+    if (((t = BN_CTX_get(bn_ctx)) == NULL) || !BN_mod_exp(t, sa->v, e, sn->v, bn_ctx)) {
+        error = CX_MEMORY_FULL;
+    }
+    else {
+        error = bn_store(sr, t);
+    }
+    BN_CTX_end(bn_ctx);
+
+end:
+    return error;
+}
+
+cx_err_t cx_bn_mod_pow_bn(cx_bn_t r, const cx_bn_t a, const cx_bn_t e, const cx_bn_t n)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *sr, *sa, *se, *sn;
+
+    CX_CHECK(bn_slot(r, &sr));
+    CX_CHECK(bn_slot(a, &sa));
+    CX_CHECK(bn_slot(e, &se));
+    CX_CHECK(bn_slot(n, &sn));
+    error = bn_mod_pow(sr, sa, se->v, sn);
+
+end:
+    return error;
+}
+
+cx_err_t cx_bn_mod_pow(cx_bn_t        r,
+                       const cx_bn_t  a,
+                       const uint8_t *e,
+                       uint32_t       e_len,
+                       const cx_bn_t  n)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *sr, *sa, *sn;
+    BIGNUM    *t;
+
+    CX_CHECK(bn_slot(r, &sr));
+    CX_CHECK(bn_slot(a, &sa));
+    CX_CHECK(bn_slot(n, &sn));
+    if ((e == NULL) || (e_len == 0)) {
+        return CX_INVALID_PARAMETER;
+    }
+    if ((t = BN_bin2bn(e, (int) e_len, NULL)) == NULL) {
+        return CX_MEMORY_FULL;
+    }
+    error = bn_mod_pow(sr, sa, t, sn);
+    BN_clear_free(t);
+
+end:
+    return error;
+}
+
+cx_err_t cx_bn_mod_pow2(cx_bn_t        r,
+                        const cx_bn_t  a,
+                        const uint8_t *e,
+                        uint32_t       e_len,
+                        const cx_bn_t  n)
+{
+    CX_HOST_PROFILE();
+
+    return cx_bn_mod_pow(r, a, e, e_len, n);
+}
+
+cx_err_t cx_bn_mod_invert_nprime(cx_bn_t r, const cx_bn_t a, const cx_bn_t n)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *sr, *sa, *sn;
+    BIGNUM    *t;
+
+    CX_CHECK(bn_slot(r, &sr));
+    CX_CHECK(bn_slot(a, &sa));
+    CX_CHECK(bn_slot(n, &sn));
+    CX_CHECK(bn_mod_operands(sn, (bn_slot_t *[]){sr, sa}, 2));
+    BN_CTX_start(bn_ctx);
+    if (((t = BN_CTX_get(bn_ctx)) == NULL)
+        || (BN_mod_inverse(t, sa->v, sn->v, bn_ctx) == NULL)) {
+        error = CX_NOT_INVERTIBLE;
+    }
+    else {
+        error = bn_store(sr, t);
+    }
+    BN_CTX_end(bn_ctx);
+
+end:
+    return error;
+}
+
+cx_err_t cx_bn_mod_u32_invert(cx_bn_t r, uint32_t a, cx_bn_t n)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *sr, *sn;
+    BIGNUM    *t;
+
+    CX_CHECK(bn_slot(r, &sr));
+    CX_CHECK(bn_slot(n, &sn));
+    CX_CHECK(bn_mod_operands(sn, &sr, 1));
+    BN_CTX_start(bn_ctx);
+    if (((t = BN_CTX_get(bn_ctx)) == NULL) || !BN_set_word(t, a)
+        || (BN_mod_inverse(t, t, sn->v, bn_ctx) == NULL)) {
+        error = CX_NOT_INVERTIBLE;
+    }
+    else {
+        error = bn_store(sr, t);
+    }
+    BN_CTX_end(bn_ctx);
+    // The modulus is used as a work area by the OS
+    BN_zero(sn->v);
+
+end:
+    return error;
+}
+
+/* ======================================================================= */
+/*                                Montgomery                               */
+/* ======================================================================= */
+
+/*
+ * The Montgomery representation of x is x * R mod n, with R = 2^(8 * size).
+ * The operations are emulated with plain modular arithmetic.
+ */
+
+static cx_err_t mont_slots(const cx_bn_mont_ctx_t *ctx, bn_slot_t **sn, BIGNUM **rr)
+{
+    cx_err_t error;
+
+    if (ctx == NULL) {
+        return CX_INVALID_PARAMETER;
+    }
+    CX_CHECK(bn_slot(ctx->n, sn));
+    if (rr != NULL) {
+        // R mod n
+        if (((*rr = BN_CTX_get(bn_ctx)) == NULL) || !BN_set_bit(*rr, (int) (*sn)->nbytes * 8)
+            || !BN_nnmod(*rr, *rr, (*sn)->v, bn_ctx)) {
+            return CX_MEMORY_FULL;
+        }
+    }
+
+end:
+    return error;
+}
+
+cx_err_t cx_mont_alloc(cx_bn_mont_ctx_t *ctx, size_t length)
+{
+    CX_HOST_PROFILE();
+    cx_err_t error;
+
+    CX_CHECK(cx_bn_alloc(&ctx->n, length));
+    CX_CHECK(cx_bn_alloc(&ctx->h, length));
+
+end:
+    return error;
+}
+
+cx_err_t cx_mont_init(cx_bn_mont_ctx_t *ctx, const cx_bn_t n)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *sn, *sh;
+    BIGNUM    *t;
+
+    CX_CHECK(cx_bn_copy(ctx->n, n));
+    CX_CHECK(bn_slot(ctx->n, &sn));
+    CX_CHECK(bn_slot(ctx->h, &sh));
+    if (!BN_is_odd(sn->v)) {
+        return CX_INVALID_PARAMETER;
+    }
+    // h = R^2 mod n
+    BN_CTX_start(bn_ctx);
+    if (((t = BN_CTX_get(bn_ctx)) == NULL) || !BN_set_bit(t, (int) sn->nbytes * 16)
+        || !BN_nnmod(t, t, sn->v, bn_ctx)) {
+        error = CX_MEMORY_FULL;
+    }
+    else {
+        error = bn_store(sh, t);
+    }
+    BN_CTX_end(bn_ctx);
+
+end:
+    return error;
+}
+
+cx_err_t cx_mont_init2(cx_bn_mont_ctx_t *ctx, const cx_bn_t n, const cx_bn_t h)
+{
+    CX_HOST_PROFILE();
+    cx_err_t error;
+
+    CX_CHECK(cx_bn_copy(ctx->n, n));
+    CX_CHECK(cx_bn_copy(ctx->h, h));
+
+end:
+    return error;
+}
+
+/*
+ * r = a * b * R^e mod n, with e in {-1, 0, 1}.
+ */
+static cx_err_t mont_mul(cx_bn_t                 r,
+                         const BIGNUM           *a,
+                         const BIGNUM           *b,
+                         int                     e,
+                         const cx_bn_mont_ctx_t *ctx)
+{
+    cx_err_t   error;
+    bn_slot_t *sr, *sn;
+    BIGNUM    *rr, *t;
+
+    CX_CHECK(bn_slot(r, &sr));
+    BN_CTX_start(bn_ctx);
+    if ((error = mont_slots(ctx, &sn, &rr)) != CX_OK) {
+        goto end_ctx;
+    }
+    if (sr->nbytes != sn->nbytes) {
+        error = CX_INVALID_PARAMETER_SIZE;
+        goto end_ctx;
+    }
+    if (((t = BN_CTX_get(bn_ctx)) == NULL) || !BN_mod_mul(t, a, b, sn->v, bn_ctx)
+        || ((e < 0) && (BN_mod_inverse(rr, rr, sn->v, bn_ctx) == NULL))
+        || ((e != 0) && !BN_mod_mul(t, t, rr, sn->v, bn_ctx))) {
+        error = CX_MEMORY_FULL;
+        goto end_ctx;
+    }
+    error = bn_store(sr, t);
+
+end_ctx:
+    BN_CTX_end(bn_ctx);
+end:
+    return error;
+}
+
+cx_err_t cx_mont_to_montgomery(cx_bn_t x, const cx_bn_t z, const cx_bn_mont_ctx_t *ctx)
+{
+    CX_HOST_PROFILE();
+    BIGNUM *v = cx_host_bn_get(z, NULL);
+
+    if (v == NULL) {
+        return bn_locked ? CX_INVALID_PARAMETER : CX_NOT_LOCKED;
+    }
+    return mont_mul(x, v, BN_value_one(), 1, ctx);
+}
+
+cx_err_t cx_mont_from_montgomery(cx_bn_t z, const cx_bn_t x, const cx_bn_mont_ctx_t *ctx)
+{
+    CX_HOST_PROFILE();
+    BIGNUM *v = cx_host_bn_get(x, NULL);
+
+    if (v == NULL) {
+        return bn_locked ? CX_INVALID_PARAMETER : CX_NOT_LOCKED;
+    }
+    return mont_mul(z, v, BN_value_one(), -1, ctx);
+}
+
+cx_err_t cx_mont_mul(cx_bn_t r, const cx_bn_t a, const cx_bn_t b, const cx_bn_mont_ctx_t *ctx)
+{
+    CX_HOST_PROFILE();
+    BIGNUM *va = cx_host_bn_get(a, NULL);
+    BIGNUM *vb = cx_host_bn_get(b, NULL);
+
+    if ((va == NULL) || (vb == NULL)) {
+        return bn_locked ? CX_INVALID_PARAMETER : CX_NOT_LOCKED;
+    }
+    return mont_mul(r, va, vb, -1, ctx);
+}
+
+/*
+ * r = (a / R)^e * R mod n, i.e. the exponentiation in Montgomery
+ * representation.
+ */
+static cx_err_t mont_pow(cx_bn_t r, const cx_bn_t a, const BIGNUM *e, const cx_bn_mont_ctx_t *ctx)
+{
+    cx_err_t   error;
+    bn_slot_t *sa, *sn;
+    BIGNUM    *rr, *t;
+
+    CX_CHECK(bn_slot(a, &sa));
+    BN_CTX_start(bn_ctx);
+    if ((mont_slots(ctx, &sn, &rr) != CX_OK) || ((t = BN_CTX_get(bn_ctx)) == NULL)
+        || (BN_mod_inverse(t, rr, sn->v, bn_ctx) == NULL)
+        || !BN_mod_mul(t, sa->v, t, sn->v, bn_ctx) || !BN_mod_exp(t, t, e, sn->v, bn_ctx)) {
+        error = CX_INVALID_PARAMETER;
+    }
+    else {
+        error = mont_mul(r, t, rr, 0, ctx);
+    }
+    BN_CTX_end(bn_ctx);
+
+end:
+    return error;
+}
+
+cx_err_t cx_mont_pow(cx_bn_t                 r,
+                     const cx_bn_t           a,
+                     const uint8_t          *e,
+                     uint32_t                e_len,
+                     const cx_bn_mont_ctx_t *ctx)
+{
+    CX_HOST_PROFILE();
+    cx_err_t error;
+    BIGNUM  *t;
+
+    if ((e == NULL) || (e_len == 0)) {
+        return CX_INVALID_PARAMETER;
+    }
+    if ((t = BN_bin2bn(e, (int) e_len, NULL)) == NULL) {
+        return CX_MEMORY_FULL;
+    }
+    error = mont_pow(r, a, t, ctx);
+    BN_clear_free(t);
+    return error;
+}
+
+cx_err_t cx_mont_pow_bn(cx_bn_t r, const cx_bn_t a, const cx_bn_t e, const cx_bn_mont_ctx_t *ctx)
+{
+    CX_HOST_PROFILE();
+    BIGNUM *ve = cx_host_bn_get(e, NULL);
+
+    if (ve == NULL) {
+        return bn_locked ? CX_INVALID_PARAMETER : CX_NOT_LOCKED;
+    }
+    return mont_pow(r, a, ve, ctx);
+}
+
+cx_err_t cx_mont_invert_nprime(cx_bn_t r, const cx_bn_t a, const cx_bn_mont_ctx_t *ctx)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *sa, *sn;
+    BIGNUM    *rr, *t;
+
+    CX_CHECK(bn_slot(a, &sa));
+    // (a / R)^-1 * R = a^-1 * R^2
+    BN_CTX_start(bn_ctx);
+    if ((mont_slots(ctx, &sn, &rr) != CX_OK) || ((t = BN_CTX_get(bn_ctx)) == NULL)
+        || (BN_mod_inverse(t, sa->v, sn->v, bn_ctx) == NULL)
+        || !BN_mod_mul(rr, rr, rr, sn->v, bn_ctx)) {
+        error = CX_NOT_INVERTIBLE;
+    }
+    else {
+        error = mont_mul(r, t, rr, 0, ctx);
+    }
+    BN_CTX_end(bn_ctx);
+
+end:
+    return error;
+}
+
+/* ======================================================================= */
+/*                           Primes and randomness                         */
+/* ======================================================================= */
+
+cx_err_t cx_bn_is_prime(const cx_bn_t n, bool *prime)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *sn;
+    int        ret;
+
+    CX_CHECK(bn_slot(n, &sn));
+    if ((ret = BN_check_prime(sn->v, bn_ctx, NULL)) < 0) {
+        return CX_MEMORY_FULL;
+    }
+    *prime = (ret == 1);
+
+end:
+    return error;
+}
+
+cx_err_t cx_bn_next_prime(cx_bn_t n)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *sn;
+    int        ret;
+
+    CX_CHECK(bn_slot(n, &sn));
+    if (!BN_is_odd(sn->v) && !BN_add_word(sn->v, 1)) {
+        return CX_MEMORY_FULL;
+    }
+    while ((ret = BN_check_prime(sn->v, bn_ctx, NULL)) == 0) {
+        if (!BN_add_word(sn->v, 2)) {
+            return CX_MEMORY_FULL;
+        }
+    }
+    if (ret < 0) {
+        return CX_MEMORY_FULL;
+    }
+    if (BN_num_bits(sn->v) > (int) sn->nbytes * 8) {
+        return CX_OVERFLOW;
+    }
+
+end:
+    return error;
+}
+
+cx_err_t cx_bn_rng(cx_bn_t r, const cx_bn_t n)
+{
+    CX_HOST_PROFILE();
+    cx_err_t   error;
+    bn_slot_t *sr, *sn;
+
+    CX_CHECK(bn_slot(r, &sr));
+    CX_CHECK(bn_slot(n, &sn));
+    CX_CHECK(bn_mod_operands(sn, &sr, 1));
+    if (BN_is_one(sn->v)) {
+        return CX_INVALID_PARAMETER;
+    }
+    // 0 < r < n
+    do {
+        if (!BN_priv_rand_range(sr->v, sn->v)) {
+            return CX_INTERNAL_ERROR;
+        }
+    } while (BN_is_zero(sr->v));
+
+end:
+    return error;
+}
+
+/* ======================================================================= */
+/*                              Byte arrays                                */
+/* ======================================================================= */
+
+/*
+ * The cx_math functions lock the BN processor on the device, so they fail
+ * if it is already locked.
+ */
+static cx_err_t math_mod_op(uint8_t       *r,
+                            const uint8_t *a,
+                            const uint8_t *b,
+                            const uint8_t *m,
+                            size_t         len,
+                            bn_mod_op_t    op)
+{
+    BN_CTX *ctx = cx_host_bn_ctx();
+    BIGNUM *va, *vb, *vm;
+    int     ok;
+
+    if (bn_locked) {
+        return CX_NOT_UNLOCKED;
+    }
+    if ((r == NULL) || (a == NULL) || (b == NULL) || (m == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+    BN_CTX_start(ctx);
+    va = BN_CTX_get(ctx);
+    vb = BN_CTX_get(ctx);
+    vm = BN_CTX_get(ctx);
+    ok = (vm != NULL) && BN_bin2bn(a, (int) len, va) && BN_bin2bn(b, (int) len, vb)
+         && BN_bin2bn(m, (int) len, vm);
+    if (ok && BN_is_zero(vm)) {
+        BN_CTX_end(ctx);
+        return CX_INVALID_PARAMETER;
+    }
+    if (op == BN_MOD_ADD) {
+        ok = ok && BN_mod_add(va, va, vb, vm, ctx);
+    }
+    else if (op == BN_MOD_SUB) {
+        ok = ok && BN_mod_sub(va, va, vb, vm, ctx);
+    }
+    else {
+        ok = ok && BN_mod_mul(va, va, vb, vm, ctx);
+    }
+    ok = ok && (BN_bn2binpad(va, r, (int) len) >= 0);
+    BN_CTX_end(ctx);
+    return ok ? CX_OK : CX_MEMORY_FULL;
+}
+
+cx_err_t cx_math_addm_no_throw(uint8_t       *r,
+                               const uint8_t *a,
+                               const uint8_t *b,
+                               const uint8_t *m,
+                               size_t         len)
+{
+    CX_HOST_PROFILE();
+
+    return math_mod_op(r, a, b, m, len, BN_MOD_ADD);
+}
+
+cx_err_t cx_math_subm_no_throw(uint8_t       *r,
+                               const uint8_t *a,
+                               const uint8_t *b,
+                               const uint8_t *m,
+                               size_t         len)
+{
+    CX_HOST_PROFILE();
+
+    return math_mod_op(r, a, b, m, len, BN_MOD_SUB);
+}
+
+cx_err_t cx_math_multm_no_throw(uint8_t       *r,
+                                const uint8_t *a,
+                                const uint8_t *b,
+                                const uint8_t *m,
+                                size_t         len)
+{
+    CX_HOST_PROFILE();
+
+    return math_mod_op(r, a, b, m, len, BN_MOD_MUL);
+}
+
+cx_err_t cx_math_modm_no_throw(uint8_t *v, size_t len_v, const uint8_t *m, size_t len_m)
+{
+    CX_HOST_PROFILE();
+    BN_CTX *ctx = cx_host_bn_ctx();
+    BIGNUM *vv, *vm;
+    int     ok;
+
+    if (bn_locked) {
+        return CX_NOT_UNLOCKED;
+    }
+    if ((v == NULL) || (m == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+    BN_CTX_start(ctx);
+    vv = BN_CTX_get(ctx);
+    vm = BN_CTX_get(ctx);
+    ok = (vm != NULL) && BN_bin2bn(v, (int) len_v, vv) && BN_bin2bn(m, (int) len_m, vm);
+    if (ok && BN_is_zero(vm)) {
+        BN_CTX_end(ctx);
+        return CX_INVALID_PARAMETER;
+    }
+    ok = ok && BN_nnmod(vv, vv, vm, ctx) && (BN_bn2binpad(vv, v, (int) len_v) >= 0);
+    BN_CTX_end(ctx);
+    return ok ? CX_OK : CX_MEMORY_FULL;
+}
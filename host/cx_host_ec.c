@@ -0,0 +1,1314 @@
+
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include <stdint.h>  // uint*_t
+#include <string.h>  // memcpy, explicit_bzero
+
+#include <openssl/bn.h>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/obj_mac.h>
+
+#include "cx.h"
+#include "cx_host_internal.h"
+#include "lib_cxng/src/cx_ecfp.h"
+
+/*
+ * Only the short Weierstrass curves known to OpenSSL are supported. The
+ * points are kept in affine coordinates, the point at infinity has z = 0.
+ *
+ * OpenSSL has no arithmetic on Ed25519, only signatures: the domain
+ * parameters, cx_ecfp_scalar_mult_no_throw and the EdDSA key derivation are
+ * done here in software, slowly, and the signature by OpenSSL.
+ */
+
+typedef struct {
+    cx_curve_t curve;
+    int        nid;
+} ec_curve_nid_t;
+
+static const ec_curve_nid_t ec_curves[] = {
+    {CX_CURVE_SECP256K1, NID_secp256k1},
+    {CX_CURVE_SECP256R1, NID_X9_62_prime256v1},
+    {CX_CURVE_SECP384R1, NID_secp384r1},
+    {CX_CURVE_SECP521R1, NID_secp521r1},
+    {CX_CURVE_BrainPoolP256T1, NID_brainpoolP256t1},
+    {CX_CURVE_BrainPoolP256R1, NID_brainpoolP256r1},
+    {CX_CURVE_BrainPoolP320T1, NID_brainpoolP320t1},
+    {CX_CURVE_BrainPoolP320R1, NID_brainpoolP320r1},
+    {CX_CURVE_BrainPoolP384T1, NID_brainpoolP384t1},
+    {CX_CURVE_BrainPoolP384R1, NID_brainpoolP384r1},
+    {CX_CURVE_BrainPoolP512T1, NID_brainpoolP512t1},
+    {CX_CURVE_BrainPoolP512R1, NID_brainpoolP512r1},
+};
+
+#define EC_CURVES_COUNT (sizeof(ec_curves) / sizeof(ec_curves[0]))
+
+#define ED25519_SIZE 32
+
+/** Ed25519 domain, -x^2 + y^2 = 1 + d.x^2.y^2, indexed by cx_curve_dom_param_t */
+static const char *const ed25519_domain[] = {
+    [CX_CURVE_PARAM_A]     = "7FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEC",
+    [CX_CURVE_PARAM_B]     = "52036CEE2B6FFE738CC740797779E89800700A4D4141D8AB75EB4DCA135978A3",
+    [CX_CURVE_PARAM_Field] = "7FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFED",
+    [CX_CURVE_PARAM_Gx]    = "216936D3CD6E53FEC0A4E231FDD6DC5C692CC7609525A7B2C9562D608F25D51A",
+    [CX_CURVE_PARAM_Gy]    = "6666666666666666666666666666666666666666666666666666666666666658",
+    [CX_CURVE_PARAM_Order] = "1000000000000000000000000000000014DEF9DEA2F79CD65812631A5CF5D3ED",
+    [CX_CURVE_PARAM_Cofactor] = "08",
+};
+
+static EC_GROUP *ec_groups[EC_CURVES_COUNT];
+
+static const EC_GROUP *ec_group(cx_curve_t curve)
+{
+    for (size_t i = 0; i < EC_CURVES_COUNT; i++) {
+        if (ec_curves[i].curve == curve) {
+            if (ec_groups[i] == NULL) {
+                ec_groups[i] = EC_GROUP_new_by_curve_name(ec_curves[i].nid);
+            }
+            return ec_groups[i];
+        }
+    }
+    return NULL;
+}
+
+static size_t ec_length(const EC_GROUP *group)
+{
+    return (EC_GROUP_get_degree(group) + 7) / 8;
+}
+
+static cx_err_t ec_bn(cx_bn_t x, BIGNUM **v)
+{
+    if ((*v = cx_host_bn_get(x, NULL)) == NULL) {
+        return cx_bn_is_locked() ? CX_INVALID_PARAMETER : CX_NOT_LOCKED;
+    }
+    return CX_OK;
+}
+
+/*
+ * Loads a point, which shall be on its curve unless it is the point at
+ * infinity.
+ */
+static cx_err_t ec_point_load(const cx_ecpoint_t *P, const EC_GROUP **group, EC_POINT **pt)
+{
+    cx_err_t error;
+    BIGNUM  *x, *y, *z;
+
+    if (P == NULL) {
+        return CX_INVALID_PARAMETER;
+    }
+    if ((*group = ec_group(P->curve)) == NULL) {
+        return CX_EC_INVALID_CURVE;
+    }
+    CX_CHECK(ec_bn(P->x, &x));
+    CX_CHECK(ec_bn(P->y, &y));
+    CX_CHECK(ec_bn(P->z, &z));
+    if ((*pt = EC_POINT_new(*group)) == NULL) {
+        return CX_MEMORY_FULL;
+    }
+    if (BN_is_zero(z)) {
+        EC_POINT_set_to_infinity(*group, *pt);
+    }
+    else if (!EC_POINT_set_affine_coordinates(*group, *pt, x, y, cx_host_bn_ctx())) {
+        error = CX_EC_INVALID_POINT;
+    }
+
+end:
+    return error;
+}
+
+static cx_err_t ec_point_store(cx_ecpoint_t *P, const EC_GROUP *group, const EC_POINT *pt)
+{
+    cx_err_t error;
+    BN_CTX  *ctx = cx_host_bn_ctx();
+    BIGNUM  *x, *y;
+
+    BN_CTX_start(ctx);
+    x = BN_CTX_get(ctx);
+    y = BN_CTX_get(ctx);
+    if (y == NULL) {
+        error = CX_MEMORY_FULL;
+        goto end;
+    }
+    if (EC_POINT_is_at_infinity(group, pt)) {
+        BN_zero(x);
+        CX_CHECK(cx_host_bn_set(P->x, x));
+        CX_CHECK(cx_host_bn_set(P->y, x));
+        CX_CHECK(cx_host_bn_set(P->z, x));
+        goto end;
+    }
+    if (!EC_POINT_get_affine_coordinates(group, pt, x, y, ctx)) {
+        error = CX_EC_INVALID_POINT;
+        goto end;
+    }
+    CX_CHECK(cx_host_bn_set(P->x, x));
+    CX_CHECK(cx_host_bn_set(P->y, y));
+    CX_CHECK(cx_host_bn_set(P->z, BN_value_one()));
+
+end:
+    BN_CTX_end(ctx);
+    return error;
+}
+
+/* ======================================================================= */
+/*                                  Domain                                 */
+/* ======================================================================= */
+
+cx_err_t cx_ecdomain_size(cx_curve_t curve, size_t *length)
+{
+    CX_HOST_PROFILE();
+    const EC_GROUP *group = ec_group(curve);
+
+    if (curve == CX_CURVE_Ed25519) {
+        *length = 255;
+        return CX_OK;
+    }
+    if (group == NULL) {
+        return CX_EC_INVALID_CURVE;
+    }
+    *length = EC_GROUP_get_degree(group);
+    return CX_OK;
+}
+
+cx_err_t cx_ecdomain_parameters_length(cx_curve_t cv, size_t *length)
+{
+    CX_HOST_PROFILE();
+    const EC_GROUP *group = ec_group(cv);
+
+    if (cv == CX_CURVE_Ed25519) {
+        *length = ED25519_SIZE;
+        return CX_OK;
+    }
+    if (group == NULL) {
+        return CX_EC_INVALID_CURVE;
+    }
+    *length = ec_length(group);
+    return CX_OK;
+}
+
+/*
+ * Computes a domain parameter into v.
+ */
+static cx_err_t ec_domain_parameter(cx_curve_t cv, cx_curve_dom_param_t id, BIGNUM *v)
+{
+    const EC_GROUP *group = ec_group(cv);
+    BN_CTX         *ctx   = cx_host_bn_ctx();
+    BIGNUM         *p, *a, *b;
+    int             ok;
+
+    if (cv == CX_CURVE_Ed25519) {
+        if ((id < CX_CURVE_PARAM_A) || (id > CX_CURVE_PARAM_Cofactor)) {
+            return CX_INVALID_PARAMETER;
+        }
+        return BN_hex2bn(&v, ed25519_domain[id]) ? CX_OK : CX_MEMORY_FULL;
+    }
+    if (group == NULL) {
+        return CX_EC_INVALID_CURVE;
+    }
+    BN_CTX_start(ctx);
+    p  = BN_CTX_get(ctx);
+    a  = BN_CTX_get(ctx);
+    b  = BN_CTX_get(ctx);
+    ok = (b != NULL) && EC_GROUP_get_curve(group, p, a, b, ctx);
+    switch (id) {
+        case CX_CURVE_PARAM_A:
+            ok = ok && (BN_copy(v, a) != NULL);
+            break;
+        case CX_CURVE_PARAM_B:
+            ok = ok && (BN_copy(v, b) != NULL);
+            break;
+        case CX_CURVE_PARAM_Field:
+            ok = ok && (BN_copy(v, p) != NULL);
+            break;
+        case CX_CURVE_PARAM_Gx:
+            ok = ok
+                 && EC_POINT_get_affine_coordinates(
+                     group, EC_GROUP_get0_generator(group), v, NULL, ctx);
+            break;
+        case CX_CURVE_PARAM_Gy:
+            ok = ok
+                 && EC_POINT_get_affine_coordinates(
+                     group, EC_GROUP_get0_generator(group), NULL, v, ctx);
+            break;
+        case CX_CURVE_PARAM_Order:
+            ok = ok && (BN_copy(v, EC_GROUP_get0_order(group)) != NULL);
+            break;
+        case CX_CURVE_PARAM_Cofactor:
+            ok = ok && (BN_copy(v, EC_GROUP_get0_cofactor(group)) != NULL);
+            break;
+        default:
+            BN_CTX_end(ctx);
+            return CX_INVALID_PARAMETER;
+    }
+    BN_CTX_end(ctx);
+    return ok ? CX_OK : CX_MEMORY_FULL;
+}
+
+cx_err_t cx_ecdomain_parameter(cx_curve_t cv, cx_curve_dom_param_t id, uint8_t *p, uint32_t p_len)
+{
+    CX_HOST_PROFILE();
+    cx_err_t error;
+    BIGNUM  *v = BN_new();
+
+    if (v == NULL) {
+        return CX_MEMORY_FULL;
+    }
+    CX_CHECK(ec_domain_parameter(cv, id, v));
+    if (BN_bn2binpad(v, p, (int) p_len) < 0) {
+        error = CX_INVALID_PARAMETER;
+    }
+
+end:
+    BN_free(v);
+    return error;
+}
+
+cx_err_t cx_ecdomain_parameter_bn(cx_curve_t cv, cx_curve_dom_param_t id, cx_bn_t p)
+{
+    CX_HOST_PROFILE();
+    cx_err_t error;
+    BIGNUM  *v = BN_new();
+
+    if (v == NULL) {
+        return CX_MEMORY_FULL;
+    }
+    CX_CHECK(ec_domain_parameter(cv, id, v));
+    if (cx_host_bn_set(p, v) == CX_CARRY) {
+        error = CX_INVALID_PARAMETER_SIZE;
+    }
+
+end:
+    BN_free(v);
+    return error;
+}
+
+cx_err_t cx_ecdomain_generator(cx_curve_t cv, uint8_t *Gx, uint8_t *Gy, size_t len)
+{
+    CX_HOST_PROFILE();
+    cx_err_t error;
+
+    CX_CHECK(cx_ecdomain_parameter(cv, CX_CURVE_PARAM_Gx, Gx, len));
+    CX_CHECK(cx_ecdomain_parameter(cv, CX_CURVE_PARAM_Gy, Gy, len));
+
+end:
+    return error;
+}
+
+cx_err_t cx_ecdomain_generator_bn(cx_curve_t cv, cx_ecpoint_t *P)
+{
+    CX_HOST_PROFILE();
+    const EC_GROUP *group = ec_group(cv);
+
+    if (group == NULL) {
+        return CX_EC_INVALID_CURVE;
+    }
+    if (P->curve != cv) {
+        return CX_EC_INVALID_CURVE;
+    }
+    return ec_point_store(P, group, EC_GROUP_get0_generator(group));
+}
+
+/* ======================================================================= */
+/*                                  Points                                 */
+/* ======================================================================= */
+
+cx_err_t cx_ecpoint_alloc(cx_ecpoint_t *P, cx_curve_t cv)
+{
+    CX_HOST_PROFILE();
+    cx_err_t        error;
+    const EC_GROUP *group = ec_group(cv);
+
+    if (P == NULL) {
+        return CX_INVALID_PARAMETER;
+    }
+    if (group == NULL) {
+        return CX_EC_INVALID_CURVE;
+    }
+    P->curve = cv;
+    CX_CHECK(cx_bn_alloc(&P->x, ec_length(group)));
+    CX_CHECK(cx_bn_alloc(&P->y, ec_length(group)));
+    CX_CHECK(cx_bn_alloc(&P->z, ec_length(group)));
+
+end:
+    return error;
+}
+
+cx_err_t cx_ecpoint_destroy(cx_ecpoint_t *P)
+{
+    CX_HOST_PROFILE();
+    cx_err_t error;
+
+    if (P == NULL) {
+        return CX_INVALID_PARAMETER;
+    }
+    CX_CHECK(cx_bn_destroy(&P->x));
+    CX_CHECK(cx_bn_destroy(&P->y));
+    CX_CHECK(cx_bn_destroy(&P->z));
+    P->curve = CX_CURVE_NONE;
+
+end:
+    return error;
+}
+
+cx_err_t cx_ecpoint_init(cx_ecpoint_t  *P,
+                         const uint8_t *x,
+                         size_t         x_len,
+                         const uint8_t *y,
+                         size_t         y_len)
+{
+    CX_HOST_PROFILE();
+    cx_err_t        error;
+    const EC_GROUP *group;
+
+    if ((P == NULL) || (x == NULL) || (y == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+    if ((group = ec_group(P->curve)) == NULL) {
+        return CX_EC_INVALID_CURVE;
+    }
+    if ((x_len > ec_length(group)) || (y_len > ec_length(group))) {
+        return CX_INVALID_PARAMETER_SIZE;
+    }
+    CX_CHECK(cx_bn_init(P->x, x, x_len));
+    CX_CHECK(cx_bn_init(P->y, y, y_len));
+    CX_CHECK(cx_bn_set_u32(P->z, 1));
+
+end:
+    return error;
+}
+
+cx_err_t cx_ecpoint_init_bn(cx_ecpoint_t *P, const cx_bn_t x, const cx_bn_t y)
+{
+    CX_HOST_PROFILE();
+    cx_err_t error;
+
+    if (P == NULL) {
+        return CX_INVALID_PARAMETER;
+    }
+    if (ec_group(P->curve) == NULL) {
+        return CX_EC_INVALID_CURVE;
+    }
+    CX_CHECK(cx_bn_copy(P->x, x));
+    CX_CHECK(cx_bn_copy(P->y, y));
+    CX_CHECK(cx_bn_set_u32(P->z, 1));
+
+end:
+    return error;
+}
+
+cx_err_t cx_ecpoint_export(const cx_ecpoint_t *P,
+                           uint8_t            *x,
+                           size_t              x_len,
+                           uint8_t            *y,
+                           size_t              y_len)
+{
+    CX_HOST_PROFILE();
+    cx_err_t error;
+    bool     infinity;
+
+    CX_CHECK(cx_ecpoint_is_at_infinity(P, &infinity));
+    if (infinity) {
+        return CX_EC_INFINITE_POINT;
+    }
+    if (x != NULL) {
+        CX_CHECK(cx_bn_export(P->x, x, x_len));
+    }
+    if (y != NULL) {
+        CX_CHECK(cx_bn_export(P->y, y, y_len));
+    }
+
+end:
+    return error;
+}
+
+cx_err_t cx_ecpoint_export_bn(const cx_ecpoint_t *P, cx_bn_t *x, cx_bn_t *y)
+{
+    CX_HOST_PROFILE();
+    cx_err_t error;
+    bool     infinity;
+
+    CX_CHECK(cx_ecpoint_is_at_infinity(P, &infinity));
+    if (infinity) {
+        return CX_EC_INFINITE_POINT;
+    }
+    CX_CHECK(cx_bn_copy(*x, P->x));
+    CX_CHECK(cx_bn_copy(*y, P->y));
+
+end:
+    return error;
+}
+
+cx_err_t cx_ecpoint_compress(const cx_ecpoint_t *P,
+                             uint8_t            *xy_compressed,
+                             size_t              xy_compressed_len,
+                             uint32_t           *sign)
+{
+    CX_HOST_PROFILE();
+    cx_err_t error;
+    bool     odd;
+
+    CX_CHECK(cx_ecpoint_export(P, xy_compressed, xy_compressed_len, NULL, 0));
+    CX_CHECK(cx_bn_is_odd(P->y, &odd));
+    *sign = odd;
+
+end:
+    return error;
+}
+
+cx_err_t cx_ecpoint_decompress(cx_ecpoint_t  *P,
+                               const uint8_t *xy_compressed,
+                               size_t         xy_compressed_len,
+                               uint32_t       sign)
+{
+    CX_HOST_PROFILE();
+    cx_err_t        error = CX_OK;
+    const EC_GROUP *group;
+    EC_POINT       *pt = NULL;
+    BIGNUM         *x  = NULL;
+
+    if ((P == NULL) || (xy_compressed == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+    if ((group = ec_group(P->curve)) == NULL) {
+        return CX_EC_INVALID_CURVE;
+    }
+    if (xy_compressed_len > ec_length(group)) {
+        return CX_INVALID_PARAMETER_SIZE;
+    }
+    if (((x = BN_bin2bn(xy_compressed, (int) xy_compressed_len, NULL)) == NULL)
+        || ((pt = EC_POINT_new(group)) == NULL)) {
+        error = CX_MEMORY_FULL;
+        goto end;
+    }
+    if (!EC_POINT_set_compressed_coordinates(group, pt, x, sign & 1, cx_host_bn_ctx())) {
+        error = CX_NO_RESIDUE;
+        goto end;
+    }
+    CX_CHECK(ec_point_store(P, group, pt));
+
+end:
+    BN_free(x);
+    EC_POINT_free(pt);
+    return error;
+}
+
+cx_err_t cx_ecpoint_add(cx_ecpoint_t *R, const cx_ecpoint_t *P, const cx_ecpoint_t *Q)
+{
+    CX_HOST_PROFILE();
+    cx_err_t        error;
+    const EC_GROUP *group;
+    EC_POINT       *p = NULL, *q = NULL;
+
+    if ((R == NULL) || (P == NULL) || (Q == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+    if ((P->curve != R->curve) || (Q->curve != R->curve)) {
+        return CX_EC_INVALID_CURVE;
+    }
+    CX_CHECK(ec_point_load(P, &group, &p));
+    CX_CHECK(ec_point_load(Q, &group, &q));
+    if (EC_POINT_is_at_infinity(group, p) || EC_POINT_is_at_infinity(group, q)) {
+        error = CX_EC_INFINITE_POINT;
+        goto end;
+    }
+    if (!EC_POINT_add(group, p, p, q, cx_host_bn_ctx())) {
+        error = CX_MEMORY_FULL;
+        goto end;
+    }
+    CX_CHECK(ec_point_store(R, group, p));
+
+end:
+    EC_POINT_free(p);
+    EC_POINT_free(q);
+    return error;
+}
+
+cx_err_t cx_ecpoint_neg(cx_ecpoint_t *P)
+{
+    CX_HOST_PROFILE();
+    cx_err_t        error;
+    const EC_GROUP *group;
+    EC_POINT       *p = NULL;
+
+    CX_CHECK(ec_point_load(P, &group, &p));
+    if (EC_POINT_is_at_infinity(group, p)) {
+        error = CX_EC_INFINITE_POINT;
+        goto end;
+    }
+    EC_POINT_invert(group, p, cx_host_bn_ctx());
+    CX_CHECK(ec_point_store(P, group, p));
+
+end:
+    EC_POINT_free(p);
+    return error;
+}
+
+/*
+ * R = [k]P + [r]Q, Q and r being optional.
+ */
+static cx_err_t ec_mul(cx_ecpoint_t       *R,
+                       const cx_ecpoint_t *P,
+                       const BIGNUM       *k,
+                       const cx_ecpoint_t *Q,
+                       const BIGNUM       *r)
+{
+    cx_err_t        error;
+    const EC_GROUP *group;
+    EC_POINT       *p = NULL, *q = NULL;
+
+    if ((R == NULL) || (P->curve != R->curve) || ((Q != NULL) && (Q->curve != R->curve))) {
+        return (R == NULL) ? CX_INVALID_PARAMETER : CX_EC_INVALID_CURVE;
+    }
+    CX_CHECK(ec_point_load(P, &group, &p));
+    if (!EC_POINT_mul(group, p, NULL, p, k, cx_host_bn_ctx())) {
+        error = CX_MEMORY_FULL;
+        goto end;
+    }
+    if (Q != NULL) {
+        CX_CHECK(ec_point_load(Q, &group, &q));
+        if (!EC_POINT_mul(group, q, NULL, q, r, cx_host_bn_ctx())
+            || !EC_POINT_add(group, p, p, q, cx_host_bn_ctx())) {
+            error = CX_MEMORY_FULL;
+            goto end;
+        }
+    }
+    CX_CHECK(ec_point_store(R, group, p));
+
+end:
+    EC_POINT_free(p);
+    EC_POINT_free(q);
+    return error;
+}
+
+static cx_err_t ec_scalarmul(cx_ecpoint_t *P, const uint8_t *k, size_t k_len)
+{
+    cx_err_t error;
+    BIGNUM  *bk;
+
+    if ((P == NULL) || (k == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+    if ((bk = BN_bin2bn(k, (int) k_len, NULL)) == NULL) {
+        return CX_MEMORY_FULL;
+    }
+    error = ec_mul(P, P, bk, NULL, NULL);
+    BN_clear_free(bk);
+    return error;
+}
+
+static cx_err_t ec_scalarmul_bn(cx_ecpoint_t *P, const cx_bn_t bn_k)
+{
+    cx_err_t error;
+    BIGNUM  *bk;
+
+    if (P == NULL) {
+        return CX_INVALID_PARAMETER;
+    }
+    CX_CHECK(ec_bn(bn_k, &bk));
+    error = ec_mul(P, P, bk, NULL, NULL);
+
+end:
+    return error;
+}
+
+cx_err_t cx_ecpoint_scalarmul(cx_ecpoint_t *P, const uint8_t *k, size_t k_len)
+{
+    CX_HOST_PROFILE();
+
+    return ec_scalarmul(P, k, k_len);
+}
+
+cx_err_t cx_ecpoint_scalarmul_bn(cx_ecpoint_t *P, const cx_bn_t bn_k)
+{
+    CX_HOST_PROFILE();
+
+    return ec_scalarmul_bn(P, bn_k);
+}
+
+cx_err_t cx_ecpoint_rnd_scalarmul(cx_ecpoint_t *P, const uint8_t *k, size_t k_len)
+{
+    CX_HOST_PROFILE();
+
+    return ec_scalarmul(P, k, k_len);
+}
+
+cx_err_t cx_ecpoint_rnd_scalarmul_bn(cx_ecpoint_t *P, const cx_bn_t bn_k)
+{
+    CX_HOST_PROFILE();
+
+    return ec_scalarmul_bn(P, bn_k);
+}
+
+cx_err_t cx_ecpoint_rnd_fixed_scalarmul(cx_ecpoint_t *P, const uint8_t *k, size_t k_len)
+{
+    CX_HOST_PROFILE();
+
+    return ec_scalarmul(P, k, k_len);
+}
+
+cx_err_t cx_ecpoint_double_scalarmul(cx_ecpoint_t  *R,
+                                     cx_ecpoint_t  *P,
+                                     cx_ecpoint_t  *Q,
+                                     const uint8_t *k,
+                                     size_t         k_len,
+                                     const uint8_t *r,
+                                     size_t         r_len)
+{
+    CX_HOST_PROFILE();
+    cx_err_t error;
+    BIGNUM  *bk, *br;
+
+    if ((P == NULL) || (Q == NULL) || (k == NULL) || (r == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+    bk = BN_bin2bn(k, (int) k_len, NULL);
+    br = BN_bin2bn(r, (int) r_len, NULL);
+    error = ((bk == NULL) || (br == NULL)) ? CX_MEMORY_FULL : ec_mul(R, P, bk, Q, br);
+    BN_clear_free(bk);
+    BN_clear_free(br);
+    return error;
+}
+
+cx_err_t cx_ecpoint_double_scalarmul_bn(cx_ecpoint_t *R,
+                                        cx_ecpoint_t *P,
+                                        cx_ecpoint_t *Q,
+                                        const cx_bn_t bn_k,
+                                        const cx_bn_t bn_r)
+{
+    CX_HOST_PROFILE();
+    cx_err_t error;
+    BIGNUM  *bk, *br;
+
+    if ((P == NULL) || (Q == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+    CX_CHECK(ec_bn(bn_k, &bk));
+    CX_CHECK(ec_bn(bn_r, &br));
+    error = ec_mul(R, P, bk, Q, br);
+
+end:
+    return error;
+}
+
+cx_err_t cx_ecpoint_cmp(const cx_ecpoint_t *P, const cx_ecpoint_t *Q, bool *is_equal)
+{
+    CX_HOST_PROFILE();
+    cx_err_t        error;
+    const EC_GROUP *group;
+    EC_POINT       *p = NULL, *q = NULL;
+
+    if ((P == NULL) || (Q == NULL) || (is_equal == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+    if (P->curve != Q->curve) {
+        return CX_EC_INVALID_CURVE;
+    }
+    CX_CHECK(ec_point_load(P, &group, &p));
+    CX_CHECK(ec_point_load(Q, &group, &q));
+    *is_equal = (EC_POINT_cmp(group, p, q, cx_host_bn_ctx()) == 0);
+
+end:
+    EC_POINT_free(p);
+    EC_POINT_free(q);
+    return error;
+}
+
+cx_err_t cx_ecpoint_is_on_curve(const cx_ecpoint_t *R, bool *is_on_curve)
+{
+    CX_HOST_PROFILE();
+    const EC_GROUP *group;
+    EC_POINT       *p = NULL;
+    cx_err_t        error;
+
+    if (is_on_curve == NULL) {
+        return CX_INVALID_PARAMETER;
+    }
+    // Loading fails on a point which does not satisfy the curve equation
+    error        = ec_point_load(R, &group, &p);
+    *is_on_curve = (error == CX_OK);
+    if (error == CX_EC_INVALID_POINT) {
+        error = CX_OK;
+    }
+    EC_POINT_free(p);
+    return error;
+}
+
+cx_err_t cx_ecpoint_is_at_infinity(const cx_ecpoint_t *R, bool *is_at_infinity)
+{
+    CX_HOST_PROFILE();
+    cx_err_t error;
+    BIGNUM  *z;
+
+    if ((R == NULL) || (is_at_infinity == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+    if (ec_group(R->curve) == NULL) {
+        return CX_EC_INVALID_CURVE;
+    }
+    CX_CHECK(ec_bn(R->z, &z));
+    *is_at_infinity = BN_is_zero(z);
+
+end:
+    return error;
+}
+
+cx_err_t cx_ecpoint_x25519(const cx_bn_t bn_u, const uint8_t *k, size_t k_len)
+{
+    CX_HOST_PROFILE();
+    (void) bn_u;
+    (void) k;
+    (void) k_len;
+
+    return CX_EC_INVALID_CURVE;
+}
+
+cx_err_t cx_ecpoint_x448(const cx_bn_t bn_u, const uint8_t *k, size_t k_len)
+{
+    CX_HOST_PROFILE();
+    (void) bn_u;
+    (void) k;
+    (void) k_len;
+
+    return CX_EC_INVALID_CURVE;
+}
+
+/* ======================================================================= */
+/*                               Keys, ECDSA                               */
+/* ======================================================================= */
+
+/*
+ * Signatures encoded in TLV: 30 || L || 02 || Lr || r || 02 || Ls || s, the
+ * integers being minimal and positive. The lengths are below 128 bytes.
+ */
+
+static size_t ec_der_integer(uint8_t *out, const uint8_t *v, size_t v_len)
+{
+    while ((v_len > 1) && (v[0] == 0)) {
+        v++;
+        v_len--;
+    }
+    out[0] = 0x02;
+    out[1] = (uint8_t) (v_len + (v[0] >> 7));
+    out[2] = 0;
+    memcpy(out + 2 + (v[0] >> 7), v, v_len);
+    return 2 + out[1];
+}
+
+size_t cx_ecfp_encode_sig_der(uint8_t       *sig,
+                              size_t         sig_len,
+                              const uint8_t *r,
+                              size_t         r_len,
+                              const uint8_t *s,
+                              size_t         s_len)
+{
+    CX_HOST_PROFILE();
+    uint8_t der[2 * (2 + 1 + 64)];
+    size_t  len;
+
+    if ((r_len == 0) || (r_len > 64) || (s_len == 0) || (s_len > 64)) {
+        return 0;
+    }
+    len = ec_der_integer(der, r, r_len);
+    len += ec_der_integer(der + len, s, s_len);
+    if ((len > 127) || (2 + len > sig_len)) {
+        return 0;
+    }
+    sig[0] = 0x30;
+    sig[1] = (uint8_t) len;
+    memcpy(sig + 2, der, len);
+    return 2 + len;
+}
+
+static bool ec_der_read_integer(const uint8_t **p,
+                                const uint8_t  *end,
+                                size_t          max_size,
+                                const uint8_t **v,
+                                size_t         *v_len)
+{
+    size_t len;
+
+    if ((end - *p < 2) || ((*p)[0] != 0x02) || ((*p)[1] == 0) || ((*p)[1] > end - *p - 2)) {
+        return false;
+    }
+    len = (*p)[1];
+    *v  = *p + 2;
+    *p += 2 + len;
+    // Negative integers are rejected, the sign byte is skipped
+    if ((*v)[0] & 0x80) {
+        return false;
+    }
+    if ((len > 1) && ((*v)[0] == 0)) {
+        (*v)++;
+        len--;
+    }
+    *v_len = len;
+    return len <= max_size;
+}
+
+int cx_ecfp_decode_sig_der(const uint8_t  *sig,
+                           size_t          sig_len,
+                           size_t          max_size,
+                           const uint8_t **r,
+                           size_t         *r_len,
+                           const uint8_t **s,
+                           size_t         *s_len)
+{
+    CX_HOST_PROFILE();
+    const uint8_t *p, *end;
+
+    if ((sig == NULL) || (sig_len < 2) || (sig[0] != 0x30) || (sig[1] != sig_len - 2)) {
+        return 0;
+    }
+    p   = sig + 2;
+    end = sig + sig_len;
+    if (!ec_der_read_integer(&p, end, max_size, r, r_len)
+        || !ec_der_read_integer(&p, end, max_size, s, s_len) || (p != end)) {
+        return 0;
+    }
+    return 1;
+}
+
+cx_err_t cx_ecfp_generate_pair_no_throw(cx_curve_t             curve,
+                                        cx_ecfp_public_key_t  *pubkey,
+                                        cx_ecfp_private_key_t *privkey,
+                                        bool                   keepprivate)
+{
+    CX_HOST_PROFILE();
+    const EC_GROUP *group = ec_group(curve);
+    BN_CTX         *ctx   = cx_host_bn_ctx();
+    BIGNUM         *d     = NULL;
+    EC_POINT       *Q     = NULL;
+    size_t          len;
+    cx_err_t        error = CX_MEMORY_FULL;
+
+    if (group == NULL) {
+        return CX_EC_INVALID_CURVE;
+    }
+    if ((pubkey == NULL) || (privkey == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+    len = ec_length(group);
+    if (len > 32) {
+        return CX_INVALID_PARAMETER_SIZE;
+    }
+    if ((d = BN_new()) == NULL) {
+        goto end;
+    }
+    if (keepprivate) {
+        if ((privkey->curve != curve) || (privkey->d_len != len)
+            || (BN_bin2bn(privkey->d, (int) len, d) == NULL)) {
+            error = CX_INVALID_PARAMETER;
+            goto end;
+        }
+    }
+    else {
+        do {
+            if (!BN_rand_range(d, EC_GROUP_get0_order(group))) {
+                goto end;
+            }
+        } while (BN_is_zero(d));
+        privkey->curve = curve;
+        privkey->d_len = len;
+        BN_bn2binpad(d, privkey->d, (int) len);
+    }
+    if (((Q = EC_POINT_new(group)) == NULL) || !EC_POINT_mul(group, Q, d, NULL, NULL, ctx)) {
+        goto end;
+    }
+    pubkey->curve = curve;
+    pubkey->W_len = EC_POINT_point2oct(
+        group, Q, POINT_CONVERSION_UNCOMPRESSED, pubkey->W, 1 + 2 * len, ctx);
+    error = (pubkey->W_len == 1 + 2 * len) ? CX_OK : CX_INTERNAL_ERROR;
+
+end:
+    BN_clear_free(d);
+    EC_POINT_free(Q);
+    return error;
+}
+
+/*
+ * Leftmost bits of the digest, as many as in the order, as an integer.
+ */
+static BIGNUM *ec_digest(const EC_GROUP *group, const uint8_t *hash, size_t hash_len)
+{
+    int     bits = BN_num_bits(EC_GROUP_get0_order(group));
+    BIGNUM *h;
+
+    if (hash_len > (size_t) (bits + 7) / 8) {
+        hash_len = (bits + 7) / 8;
+    }
+    h = BN_bin2bn(hash, (int) hash_len, NULL);
+    if ((h != NULL) && ((int) hash_len * 8 > bits)) {
+        BN_rshift(h, h, (int) hash_len * 8 - bits);
+    }
+    return h;
+}
+
+cx_err_t cx_ecdsa_sign_no_throw(const cx_ecfp_private_key_t *pvkey,
+                                uint32_t                     mode,
+                                cx_md_t                      hashID,
+                                const uint8_t               *hash,
+                                size_t                       hash_len,
+                                uint8_t                     *sig,
+                                size_t                      *sig_len,
+                                uint32_t                    *info)
+{
+    CX_HOST_PROFILE();
+    const EC_GROUP *group;
+    const BIGNUM   *n;
+    BN_CTX         *ctx = cx_host_bn_ctx();
+    BIGNUM         *d, *h, *k, *x, *y, *r, *s;
+    EC_POINT       *R     = NULL;
+    uint8_t         rs[2][32];
+    size_t          len;
+    cx_err_t        error = CX_MEMORY_FULL;
+
+    // The nonce is always random, RFC 6979 is not emulated
+    (void) mode;
+    (void) hashID;
+
+    if ((pvkey == NULL) || (hash == NULL) || (sig == NULL) || (sig_len == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+    if ((group = ec_group(pvkey->curve)) == NULL) {
+        return CX_EC_INVALID_CURVE;
+    }
+    len = ec_length(group);
+    if ((len > 32) || (pvkey->d_len != len)) {
+        return CX_INVALID_PARAMETER_SIZE;
+    }
+    n = EC_GROUP_get0_order(group);
+    h = ec_digest(group, hash, hash_len);
+    BN_CTX_start(ctx);
+    d = BN_CTX_get(ctx);
+    k = BN_CTX_get(ctx);
+    x = BN_CTX_get(ctx);
+    y = BN_CTX_get(ctx);
+    r = BN_CTX_get(ctx);
+    s = BN_CTX_get(ctx);
+    if ((h == NULL) || (s == NULL) || ((R = EC_POINT_new(group)) == NULL)
+        || (BN_bin2bn(pvkey->d, (int) len, d) == NULL)) {
+        goto end;
+    }
+    do {
+        // R = [k]G, r = x(R) mod n, s = (h + r.d) / k mod n
+        if (!BN_rand_range(k, n) || !EC_POINT_mul(group, R, k, NULL, NULL, ctx)
+            || !EC_POINT_get_affine_coordinates(group, R, x, y, ctx) || !BN_nnmod(r, x, n, ctx)
+            || !BN_mod_mul(s, r, d, n, ctx) || !BN_mod_add(s, s, h, n, ctx)
+            || !BN_mod_inverse(k, k, n, ctx) || !BN_mod_mul(s, s, k, n, ctx)) {
+            goto end;
+        }
+    } while (BN_is_zero(r) || BN_is_zero(s));
+    BN_bn2binpad(r, rs[0], (int) len);
+    BN_bn2binpad(s, rs[1], (int) len);
+    *sig_len = cx_ecfp_encode_sig_der(sig, *sig_len, rs[0], len, rs[1], len);
+    if (*sig_len == 0) {
+        error = CX_INVALID_PARAMETER;
+        goto end;
+    }
+    if (info != NULL) {
+        *info = BN_is_odd(y) ? CX_ECCINFO_PARITY_ODD : 0;
+        if (BN_cmp(x, n) >= 0) {
+            *info |= CX_ECCINFO_xGTn;
+        }
+    }
+    error = CX_OK;
+
+end:
+    BN_CTX_end(ctx);
+    BN_clear_free(h);
+    EC_POINT_free(R);
+    return error;
+}
+
+bool cx_ecdsa_verify_no_throw(const cx_ecfp_public_key_t *pukey,
+                              const uint8_t              *hash,
+                              size_t                      hash_len,
+                              const uint8_t              *sig,
+                              size_t                      sig_len)
+{
+    CX_HOST_PROFILE();
+    const EC_GROUP *group;
+    const BIGNUM   *n;
+    BN_CTX         *ctx = cx_host_bn_ctx();
+    const uint8_t  *sig_r, *sig_s;
+    size_t          r_len, s_len;
+    BIGNUM         *h, *r, *s, *u1, *u2, *x;
+    EC_POINT       *Q = NULL, *R = NULL;
+    bool            verified = false;
+
+    if ((pukey == NULL) || (hash == NULL) || ((group = ec_group(pukey->curve)) == NULL)) {
+        return false;
+    }
+    if (cx_ecfp_decode_sig_der(sig, sig_len, ec_length(group), &sig_r, &r_len, &sig_s, &s_len)
+        != 1) {
+        return false;
+    }
+    n = EC_GROUP_get0_order(group);
+    h = ec_digest(group, hash, hash_len);
+    BN_CTX_start(ctx);
+    r  = BN_CTX_get(ctx);
+    s  = BN_CTX_get(ctx);
+    u1 = BN_CTX_get(ctx);
+    u2 = BN_CTX_get(ctx);
+    x  = BN_CTX_get(ctx);
+    if ((h == NULL) || (x == NULL) || ((Q = EC_POINT_new(group)) == NULL)
+        || ((R = EC_POINT_new(group)) == NULL)
+        || !EC_POINT_oct2point(group, Q, pukey->W, pukey->W_len, ctx)
+        || (BN_bin2bn(sig_r, (int) r_len, r) == NULL)
+        || (BN_bin2bn(sig_s, (int) s_len, s) == NULL)) {
+        goto end;
+    }
+    if (BN_is_zero(r) || BN_is_zero(s) || (BN_cmp(r, n) >= 0) || (BN_cmp(s, n) >= 0)) {
+        goto end;
+    }
+    // x([h/s]G + [r/s]Q) mod n = r
+    if (!BN_mod_inverse(s, s, n, ctx) || !BN_mod_mul(u1, h, s, n, ctx)
+        || !BN_mod_mul(u2, r, s, n, ctx) || !EC_POINT_mul(group, R, u1, Q, u2, ctx)
+        || EC_POINT_is_at_infinity(group, R)
+        || !EC_POINT_get_affine_coordinates(group, R, x, NULL, ctx) || !BN_nnmod(x, x, n, ctx)) {
+        goto end;
+    }
+    verified = (BN_cmp(x, r) == 0);
+
+end:
+    BN_CTX_end(ctx);
+    BN_free(h);
+    EC_POINT_free(Q);
+    EC_POINT_free(R);
+    return verified;
+}
+
+/* ======================================================================= */
+/*                             Ed25519, EdDSA                              */
+/* ======================================================================= */
+
+/*
+ * Adds (x2, y2) to (x1, y1), with the unified addition law of the twisted
+ * Edwards curves, which also doubles and adds the neutral (0, 1):
+ * x3 = (x1.y2 + y1.x2) / (1 + d.x1.x2.y1.y2)
+ * y3 = (y1.y2 + x1.x2) / (1 - d.x1.x2.y1.y2)
+ */
+static int ed25519_add(BIGNUM       *x1,
+                       BIGNUM       *y1,
+                       const BIGNUM *x2,
+                       const BIGNUM *y2,
+                       const BIGNUM *p,
+                       const BIGNUM *d,
+                       BN_CTX       *ctx)
+{
+    BIGNUM *t, *u, *v, *w;
+    int     ok;
+
+    BN_CTX_start(ctx);
+    t  = BN_CTX_get(ctx);
+    u  = BN_CTX_get(ctx);
+    v  = BN_CTX_get(ctx);
+    w  = BN_CTX_get(ctx);
+    ok = (w != NULL) && BN_mod_mul(t, x1, x2, p, ctx) && BN_mod_mul(u, y1, y2, p, ctx)
+         && BN_mod_mul(v, t, u, p, ctx) && BN_mod_mul(v, v, d, p, ctx)
+         // y3 numerator in u, x3 numerator in t
+         && BN_mod_add(u, u, t, p, ctx) && BN_mod_mul(t, x1, y2, p, ctx)
+         && BN_mod_mul(w, y1, x2, p, ctx) && BN_mod_add(t, t, w, p, ctx)
+         // x3 = t / (1 + v), y3 = u / (1 - v)
+         && BN_mod_add(w, BN_value_one(), v, p, ctx) && BN_mod_inverse(w, w, p, ctx)
+         && BN_mod_mul(x1, t, w, p, ctx) && BN_mod_sub(w, BN_value_one(), v, p, ctx)
+         && BN_mod_inverse(w, w, p, ctx) && BN_mod_mul(y1, u, w, p, ctx);
+    BN_CTX_end(ctx);
+    return ok;
+}
+
+/*
+ * Computes P = [k]P on Ed25519, P being 04 || x || y.
+ */
+static cx_err_t ed25519_scalar_mult(uint8_t *P, const uint8_t *k, size_t k_len)
+{
+    BN_CTX  *ctx = cx_host_bn_ctx();
+    BIGNUM  *p, *d, *x, *y, *rx, *ry;
+    cx_err_t error = CX_MEMORY_FULL;
+
+    if (P[0] != 0x04) {
+        return CX_EC_INVALID_POINT;
+    }
+    BN_CTX_start(ctx);
+    p  = BN_CTX_get(ctx);
+    d  = BN_CTX_get(ctx);
+    x  = BN_CTX_get(ctx);
+    y  = BN_CTX_get(ctx);
+    rx = BN_CTX_get(ctx);
+    ry = BN_CTX_get(ctx);
+    if ((ry == NULL) || (ec_domain_parameter(CX_CURVE_Ed25519, CX_CURVE_PARAM_Field, p) != CX_OK)
+        || (ec_domain_parameter(CX_CURVE_Ed25519, CX_CURVE_PARAM_B, d) != CX_OK)
+        || (BN_bin2bn(P + 1, ED25519_SIZE, x) == NULL)
+        || (BN_bin2bn(P + 1 + ED25519_SIZE, ED25519_SIZE, y) == NULL)) {
+        goto end;
+    }
+    // Double and add, from the neutral (0, 1)
+    BN_zero(rx);
+    BN_one(ry);
+    for (size_t i = 0; i < 8 * k_len; i++) {
+        if (!ed25519_add(rx, ry, rx, ry, p, d, ctx)
+            || (((k[i / 8] >> (7 - i % 8)) & 1) && !ed25519_add(rx, ry, x, y, p, d, ctx))) {
+            goto end;
+        }
+    }
+    if (BN_is_zero(rx) && BN_is_one(ry)) {
+        error = CX_EC_INFINITE_POINT;
+        goto end;
+    }
+    BN_bn2binpad(rx, P + 1, ED25519_SIZE);
+    BN_bn2binpad(ry, P + 1 + ED25519_SIZE, ED25519_SIZE);
+    error = CX_OK;
+
+end:
+    BN_CTX_end(ctx);
+    return error;
+}
+
+cx_err_t cx_ecfp_scalar_mult_no_throw(cx_curve_t curve, uint8_t *P, const uint8_t *k, size_t k_len)
+{
+    CX_HOST_PROFILE();
+    const EC_GROUP *group;
+    BN_CTX         *ctx = cx_host_bn_ctx();
+    BIGNUM         *n;
+    EC_POINT       *Q;
+    size_t          len;
+    cx_err_t        error = CX_MEMORY_FULL;
+
+    if ((P == NULL) || (k == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+    if (curve == CX_CURVE_Ed25519) {
+        return ed25519_scalar_mult(P, k, k_len);
+    }
+    if ((group = ec_group(curve)) == NULL) {
+        return CX_EC_INVALID_CURVE;
+    }
+    len = ec_length(group);
+    n   = BN_bin2bn(k, (int) k_len, NULL);
+    if (((Q = EC_POINT_new(group)) == NULL) || (n == NULL)) {
+        goto end;
+    }
+    if (!EC_POINT_oct2point(group, Q, P, 1 + 2 * len, ctx)) {
+        error = CX_EC_INVALID_POINT;
+        goto end;
+    }
+    if (!EC_POINT_mul(group, Q, NULL, Q, n, ctx)) {
+        goto end;
+    }
+    if (EC_POINT_is_at_infinity(group, Q)) {
+        error = CX_EC_INFINITE_POINT;
+        goto end;
+    }
+    EC_POINT_point2oct(group, Q, POINT_CONVERSION_UNCOMPRESSED, P, 1 + 2 * len, ctx);
+    error = CX_OK;
+
+end:
+    BN_clear_free(n);
+    EC_POINT_free(Q);
+    return error;
+}
+
+/*
+ * Only SHA-512 is supported, i.e. Ed25519 as in RFC 8032.
+ */
+cx_err_t cx_eddsa_get_public_key_no_throw(const cx_ecfp_private_key_t *pvkey,
+                                          cx_md_t                      hashID,
+                                          cx_ecfp_public_key_t        *pukey,
+                                          uint8_t                     *a,
+                                          size_t                       a_len,
+                                          uint8_t                     *h,
+                                          size_t                       h_len)
+{
+    CX_HOST_PROFILE();
+    cx_err_t error;
+    uint8_t  digest[2 * ED25519_SIZE];
+    uint8_t  scalar[ED25519_SIZE];
+
+    if ((pvkey == NULL) || (pukey == NULL) || (hashID != CX_SHA512)) {
+        return CX_INVALID_PARAMETER;
+    }
+    if (pvkey->curve != CX_CURVE_Ed25519) {
+        return CX_EC_INVALID_CURVE;
+    }
+    if ((pvkey->d_len != ED25519_SIZE) || ((a != NULL) && (a_len < ED25519_SIZE))
+        || ((h != NULL) && (h_len < ED25519_SIZE))) {
+        return CX_INVALID_PARAMETER_SIZE;
+    }
+    if (!EVP_Digest(pvkey->d, ED25519_SIZE, digest, NULL, EVP_sha512(), NULL)) {
+        return CX_INTERNAL_ERROR;
+    }
+    // Clamped little-endian scalar, returned big-endian
+    digest[0] &= 0xF8;
+    digest[ED25519_SIZE - 1] = (digest[ED25519_SIZE - 1] & 0x7F) | 0x40;
+    for (size_t i = 0; i < ED25519_SIZE; i++) {
+        scalar[i] = digest[ED25519_SIZE - 1 - i];
+    }
+
+    pukey->curve = CX_CURVE_Ed25519;
+    pukey->W_len = 1 + 2 * ED25519_SIZE;
+    pukey->W[0]  = 0x04;
+    CX_CHECK(cx_ecdomain_generator(
+        CX_CURVE_Ed25519, pukey->W + 1, pukey->W + 1 + ED25519_SIZE, ED25519_SIZE));
+    CX_CHECK(ed25519_scalar_mult(pukey->W, scalar, sizeof(scalar)));
+    if (a != NULL) {
+        memcpy(a, scalar, ED25519_SIZE);
+    }
+    if (h != NULL) {
+        memcpy(h, digest + ED25519_SIZE, ED25519_SIZE);
+    }
+
+end:
+    explicit_bzero(digest, sizeof(digest));
+    explicit_bzero(scalar, sizeof(scalar));
+    return error;
+}
+
+/*
+ * The message is signed by OpenSSL, which gives a reference independent of
+ * the arithmetic above.
+ */
+cx_err_t cx_eddsa_sign_no_throw(const cx_ecfp_private_key_t *pvkey,
+                                cx_md_t                      hashID,
+                                const uint8_t               *hash,
+                                size_t                       hash_len,
+                                uint8_t                     *sig,
+                                size_t                       sig_len)
+{
+    CX_HOST_PROFILE();
+    EVP_PKEY   *key = NULL;
+    EVP_MD_CTX *ctx = NULL;
+    cx_err_t    error = CX_INTERNAL_ERROR;
+
+    if ((pvkey == NULL) || (sig == NULL) || ((hash == NULL) && (hash_len != 0))
+        || (hashID != CX_SHA512)) {
+        return CX_INVALID_PARAMETER;
+    }
+    if (pvkey->curve != CX_CURVE_Ed25519) {
+        return CX_EC_INVALID_CURVE;
+    }
+    if ((pvkey->d_len != ED25519_SIZE) || (sig_len < 2 * ED25519_SIZE)) {
+        return CX_INVALID_PARAMETER_SIZE;
+    }
+    key = EVP_PKEY_new_raw_private_key(EVP_PKEY_ED25519, NULL, pvkey->d, ED25519_SIZE);
+    ctx = EVP_MD_CTX_new();
+    if ((key != NULL) && (ctx != NULL) && EVP_DigestSignInit(ctx, NULL, NULL, NULL, key)
+        && EVP_DigestSign(ctx, sig, &sig_len, hash, hash_len)) {
+        error = CX_OK;
+    }
+    EVP_MD_CTX_free(ctx);
+    EVP_PKEY_free(key);
+    return error;
+}
@@ -0,0 +1,793 @@
+
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include <stdint.h>  // uint*_t
+#include <string.h>  // memset, memcpy
+
+#include "cx.h"
+#include "os_utils.h"
+#include "lib_cxng/src/cx_hash.h"
+#include "lib_cxng/src/cx_ripemd160.h"
+#include "lib_cxng/src/cx_sha256.h"
+#include "lib_cxng/src/cx_sha512.h"
+#include "lib_cxng/src/cx_sha3.h"
+#include "cx_host_internal.h"
+
+/*
+ * The contexts have the layout of the OS ones: the chaining value is kept in
+ * acc as native words, and header.counter counts the compressed blocks.
+ */
+
+#define ROTR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+#define ROTR64(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+
+/* ======================================================================= */
+/*                                 SHA-256                                 */
+/* ======================================================================= */
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4,
+    0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe,
+    0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f,
+    0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+    0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116,
+    0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7,
+    0xc67178f2};
+
+static const uint32_t sha224_iv[8] = {0xc1059ed8,
+                                      0x367cd507,
+                                      0x3070dd17,
+                                      0xf70e5939,
+                                      0xffc00b31,
+                                      0x68581511,
+                                      0x64f98fa7,
+                                      0xbefa4fa4};
+
+static const uint32_t sha256_iv[8] = {0x6a09e667,
+                                      0xbb67ae85,
+                                      0x3c6ef372,
+                                      0xa54ff53a,
+                                      0x510e527f,
+                                      0x9b05688c,
+                                      0x1f83d9ab,
+                                      0x5be0cd19};
+
+static void sha256_block(uint8_t *acc, const uint8_t *block)
+{
+    uint32_t h[8];
+    uint32_t w[64];
+    uint32_t v[8];
+    uint32_t t1, t2;
+
+    memcpy(h, acc, sizeof(h));
+    for (int i = 0; i < 16; i++) {
+        w[i] = U4BE(block, 4 * i);
+    }
+    for (int i = 16; i < 64; i++) {
+        w[i] = (ROTR32(w[i - 2], 17) ^ ROTR32(w[i - 2], 19) ^ (w[i - 2] >> 10)) + w[i - 7]
+               + (ROTR32(w[i - 15], 7) ^ ROTR32(w[i - 15], 18) ^ (w[i - 15] >> 3)) + w[i - 16];
+    }
+    memcpy(v, h, sizeof(v));
+    for (int i = 0; i < 64; i++) {
+        t1 = v[7] + (ROTR32(v[4], 6) ^ ROTR32(v[4], 11) ^ ROTR32(v[4], 25))
+             + ((v[4] & v[5]) ^ (~v[4] & v[6])) + sha256_k[i] + w[i];
+        t2 = (ROTR32(v[0], 2) ^ ROTR32(v[0], 13) ^ ROTR32(v[0], 22))
+             + ((v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]));
+        memmove(v + 1, v, 7 * sizeof(uint32_t));
+        v[4] += t1;
+        v[0] = t1 + t2;
+    }
+    for (int i = 0; i < 8; i++) {
+        h[i] += v[i];
+    }
+    memcpy(acc, h, sizeof(h));
+}
+
+/* ======================================================================= */
+/*                                 SHA-512                                 */
+/* ======================================================================= */
+
+static const uint64_t sha512_k[80] = {
+    0x428a2f98d728ae22, 0x7137449123ef65cd, 0xb5c0fbcfec4d3b2f, 0xe9b5dba58189dbbc,
+    0x3956c25bf348b538, 0x59f111f1b605d019, 0x923f82a4af194f9b, 0xab1c5ed5da6d8118,
+    0xd807aa98a3030242, 0x12835b0145706fbe, 0x243185be4ee4b28c, 0x550c7dc3d5ffb4e2,
+    0x72be5d74f27b896f, 0x80deb1fe3b1696b1, 0x9bdc06a725c71235, 0xc19bf174cf692694,
+    0xe49b69c19ef14ad2, 0xefbe4786384f25e3, 0x0fc19dc68b8cd5b5, 0x240ca1cc77ac9c65,
+    0x2de92c6f592b0275, 0x4a7484aa6ea6e483, 0x5cb0a9dcbd41fbd4, 0x76f988da831153b5,
+    0x983e5152ee66dfab, 0xa831c66d2db43210, 0xb00327c898fb213f, 0xbf597fc7beef0ee4,
+    0xc6e00bf33da88fc2, 0xd5a79147930aa725, 0x06ca6351e003826f, 0x142929670a0e6e70,
+    0x27b70a8546d22ffc, 0x2e1b21385c26c926, 0x4d2c6dfc5ac42aed, 0x53380d139d95b3df,
+    0x650a73548baf63de, 0x766a0abb3c77b2a8, 0x81c2c92e47edaee6, 0x92722c851482353b,
+    0xa2bfe8a14cf10364, 0xa81a664bbc423001, 0xc24b8b70d0f89791, 0xc76c51a30654be30,
+    0xd192e819d6ef5218, 0xd69906245565a910, 0xf40e35855771202a, 0x106aa07032bbd1b8,
+    0x19a4c116b8d2d0c8, 0x1e376c085141ab53, 0x2748774cdf8eeb99, 0x34b0bcb5e19b48a8,
+    0x391c0cb3c5c95a63, 0x4ed8aa4ae3418acb, 0x5b9cca4f7763e373, 0x682e6ff3d6b2b8a3,
+    0x748f82ee5defb2fc, 0x78a5636f43172f60, 0x84c87814a1f0ab72, 0x8cc702081a6439ec,
+    0x90befffa23631e28, 0xa4506cebde82bde9, 0xbef9a3f7b2c67915, 0xc67178f2e372532b,
+    0xca273eceea26619c, 0xd186b8c721c0c207, 0xeada7dd6cde0eb1e, 0xf57d4f7fee6ed178,
+    0x06f067aa72176fba, 0x0a637dc5a2c898a6, 0x113f9804bef90dae, 0x1b710b35131c471b,
+    0x28db77f523047d84, 0x32caab7b40c72493, 0x3c9ebe0a15c9bebc, 0x431d67c49c100d4c,
+    0x4cc5d4becb3e42b6, 0x597f299cfc657e2a, 0x5fcb6fab3ad6faec, 0x6c44198c4a475817};
+
+static const uint64_t sha384_iv[8] = {0xcbbb9d5dc1059ed8,
+                                      0x629a292a367cd507,
+                                      0x9159015a3070dd17,
+                                      0x152fecd8f70e5939,
+                                      0x67332667ffc00b31,
+                                      0x8eb44a8768581511,
+                                      0xdb0c2e0d64f98fa7,
+                                      0x47b5481dbefa4fa4};
+
+static const uint64_t sha512_iv[8] = {0x6a09e667f3bcc908,
+                                      0xbb67ae8584caa73b,
+                                      0x3c6ef372fe94f82b,
+                                      0xa54ff53a5f1d36f1,
+                                      0x510e527fade682d1,
+                                      0x9b05688c2b3e6c1f,
+                                      0x1f83d9abfb41bd6b,
+                                      0x5be0cd19137e2179};
+
+static uint64_t load64_be(const uint8_t *p)
+{
+    return ((uint64_t) U4BE(p, 0) << 32) | U4BE(p, 4);
+}
+
+static void sha512_block(uint8_t *acc, const uint8_t *block)
+{
+    uint64_t h[8];
+    uint64_t w[80];
+    uint64_t v[8];
+    uint64_t t1, t2;
+
+    memcpy(h, acc, sizeof(h));
+    for (int i = 0; i < 16; i++) {
+        w[i] = load64_be(block + 8 * i);
+    }
+    for (int i = 16; i < 80; i++) {
+        w[i] = (ROTR64(w[i - 2], 19) ^ ROTR64(w[i - 2], 61) ^ (w[i - 2] >> 6)) + w[i - 7]
+               + (ROTR64(w[i - 15], 1) ^ ROTR64(w[i - 15], 8) ^ (w[i - 15] >> 7)) + w[i - 16];
+    }
+    memcpy(v, h, sizeof(v));
+    for (int i = 0; i < 80; i++) {
+        t1 = v[7] + (ROTR64(v[4], 14) ^ ROTR64(v[4], 18) ^ ROTR64(v[4], 41))
+             + ((v[4] & v[5]) ^ (~v[4] & v[6])) + sha512_k[i] + w[i];
+        t2 = (ROTR64(v[0], 28) ^ ROTR64(v[0], 34) ^ ROTR64(v[0], 39))
+             + ((v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]));
+        memmove(v + 1, v, 7 * sizeof(uint64_t));
+        v[4] += t1;
+        v[0] = t1 + t2;
+    }
+    for (int i = 0; i < 8; i++) {
+        h[i] += v[i];
+    }
+    memcpy(acc, h, sizeof(h));
+}
+
+/* ======================================================================= */
+/*                               RIPEMD-160                                */
+/* ======================================================================= */
+
+static const uint8_t ripemd160_r[2][80] = {
+    {0, 1, 2,  3,  4,  5,  6,  7, 8, 9,  10, 11, 12, 13, 14, 15, 7,  4,  13, 1,
+     10, 6, 15, 3,  12, 0,  9,  5, 2, 14, 11, 8,  3,  10, 14, 4,  9,  15, 8,  1,
+     2, 7, 0,  6,  13, 11, 5,  12, 1, 9,  11, 10, 0,  8,  12, 4,  13, 3,  7,  15,
+     14, 5, 6, 2,  4,  0,  5,  9,  7, 12, 2,  10, 14, 1,  3,  8,  11, 6,  15, 13},
+    {5, 14, 7,  0,  9, 2,  11, 4,  13, 6,  15, 8,  1,  10, 3,  12, 6,  11, 3,  7,
+     0, 13, 5,  10, 14, 15, 8,  12, 4,  9,  1,  2,  15, 5,  1,  3,  7,  14, 6,  9,
+     11, 8, 12, 2,  10, 0,  4,  13, 8,  6,  4,  1,  3,  11, 15, 0,  5,  12, 2,  13,
+     9, 7,  10, 14, 12, 15, 10, 4,  1,  5,  8,  7,  6,  2,  13, 14, 0,  3,  9,  11}};
+
+static const uint8_t ripemd160_s[2][80] = {
+    {11, 14, 15, 12, 5,  8,  7,  9,  11, 13, 14, 15, 6,  7,  9,  8,  7,  6,  8,  13,
+     11, 9,  7,  15, 7,  12, 15, 9,  11, 7,  13, 12, 11, 13, 6,  7,  14, 9,  13, 15,
+     14, 8,  13, 6,  5,  12, 7,  5,  11, 12, 14, 15, 14, 15, 9,  8,  9,  14, 5,  6,
+     8,  6,  5,  12, 9,  15, 5,  11, 6,  8,  13, 12, 5,  12, 13, 14, 11, 8,  5,  6},
+    {8,  9,  9,  11, 13, 15, 15, 5,  7,  7,  8,  11, 14, 14, 12, 6,  9,  13, 15, 7,
+     12, 8,  9,  11, 7,  7,  12, 7,  6,  15, 13, 11, 9,  7,  15, 11, 8,  6,  6,  14,
+     12, 13, 5,  14, 13, 13, 7,  5,  15, 5,  8,  11, 14, 14, 6,  14, 6,  9,  12, 9,
+     12, 5,  15, 8,  8,  5,  12, 9,  12, 5,  14, 6,  8,  13, 6,  5,  15, 13, 11, 11}};
+
+static const uint32_t ripemd160_k[2][5] = {
+    {0x00000000, 0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xa953fd4e},
+    {0x50a28be6, 0x5c4dd124, 0x6d703ef3, 0x7a6d76e9, 0x00000000}};
+
+static const uint32_t ripemd160_iv[5]
+    = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+
+static uint32_t ripemd160_f(int j, uint32_t x, uint32_t y, uint32_t z)
+{
+    switch (j / 16) {
+        case 0:
+            return x ^ y ^ z;
+        case 1:
+            return (x & y) | (~x & z);
+        case 2:
+            return (x | ~y) ^ z;
+        case 3:
+            return (x & z) | (y & ~z);
+        default:
+            return x ^ (y | ~z);
+    }
+}
+
+static void ripemd160_block(uint8_t *acc, const uint8_t *block)
+{
+    uint32_t h[5];
+    uint32_t x[16];
+    uint32_t v[2][5];
+    uint32_t t;
+
+    memcpy(h, acc, sizeof(h));
+    for (int i = 0; i < 16; i++) {
+        x[i] = U4LE(block, 4 * i);
+    }
+    for (int line = 0; line < 2; line++) {
+        memcpy(v[line], h, sizeof(h));
+        for (int j = 0; j < 80; j++) {
+            // The parallel line uses the round functions in reverse order
+            int f = (line == 0) ? j : 79 - j;
+
+            t = v[line][0] + ripemd160_f(f, v[line][1], v[line][2], v[line][3])
+                + x[ripemd160_r[line][j]] + ripemd160_k[line][j / 16];
+            t          = ROTL32(t, ripemd160_s[line][j]) + v[line][4];
+            v[line][0] = v[line][4];
+            v[line][4] = v[line][3];
+            v[line][3] = ROTL32(v[line][2], 10);
+            v[line][2] = v[line][1];
+            v[line][1] = t;
+        }
+    }
+    t    = h[1] + v[0][2] + v[1][3];
+    h[1] = h[2] + v[0][3] + v[1][4];
+    h[2] = h[3] + v[0][4] + v[1][0];
+    h[3] = h[4] + v[0][0] + v[1][1];
+    h[4] = h[0] + v[0][1] + v[1][2];
+    h[0] = t;
+    memcpy(acc, h, sizeof(h));
+}
+
+/* ======================================================================= */
+/*                          Merkle-Damgard helpers                         */
+/* ======================================================================= */
+
+typedef void (*md_block_t)(uint8_t *acc, const uint8_t *block);
+
+static uint64_t md_blocks;
+
+uint64_t cx_host_hash_blocks(void)
+{
+    return md_blocks;
+}
+
+static cx_err_t md_update(cx_hash_t     *header,
+                          size_t        *blen,
+                          uint8_t       *block,
+                          size_t         block_size,
+                          md_block_t     compress,
+                          uint8_t       *acc,
+                          const uint8_t *data,
+                          size_t         len)
+{
+    size_t r;
+
+    if ((data == NULL) && (len != 0)) {
+        return CX_INVALID_PARAMETER;
+    }
+    if (*blen >= block_size) {
+        return CX_INVALID_PARAMETER;
+    }
+    while (len > 0) {
+        r = block_size - *blen;
+        if (r > len) {
+            r = len;
+        }
+        memcpy(block + *blen, data, r);
+        *blen += r;
+        data += r;
+        len -= r;
+        if (*blen == block_size) {
+            if (header->counter == CX_HASH_MAX_BLOCK_COUNT) {
+                return CX_INVALID_PARAMETER;
+            }
+            compress(acc, block);
+            md_blocks++;
+            header->counter++;
+            *blen = 0;
+        }
+    }
+    return CX_OK;
+}
+
+/*
+ * Appends the padding and the bit length, on len_size bytes, in the given
+ * endianness.
+ */
+static void md_final(cx_hash_t *header,
+                     size_t    *blen,
+                     uint8_t   *block,
+                     size_t     block_size,
+                     size_t     len_size,
+                     bool       big_endian,
+                     md_block_t compress,
+                     uint8_t   *acc)
+{
+    uint64_t bits = ((uint64_t) header->counter * block_size + *blen) * 8;
+
+    block[(*blen)++] = 0x80;
+    if (*blen > block_size - len_size) {
+        memset(block + *blen, 0, block_size - *blen);
+        compress(acc, block);
+        md_blocks++;
+        *blen = 0;
+    }
+    memset(block + *blen, 0, block_size - *blen);
+    for (size_t i = 0; i < 8; i++) {
+        size_t pos = big_endian ? block_size - 1 - i : block_size - len_size + i;
+
+        block[pos] = (uint8_t) (bits >> (8 * i));
+    }
+    compress(acc, block);
+    md_blocks++;
+    *blen = 0;
+}
+
+/* ======================================================================= */
+/*                                 Contexts                                */
+/* ======================================================================= */
+
+static cx_err_t sha256_init_func(cx_hash_t *ctx)
+{
+    return cx_sha256_init_no_throw((cx_sha256_t *) ctx);
+}
+
+static cx_err_t sha224_init_func(cx_hash_t *ctx)
+{
+    return cx_sha224_init_no_throw((cx_sha256_t *) ctx);
+}
+
+static cx_err_t sha256_update_func(cx_hash_t *ctx, const uint8_t *data, size_t len)
+{
+    return cx_sha256_update((cx_sha256_t *) ctx, data, len);
+}
+
+static cx_err_t sha256_final_func(cx_hash_t *ctx, uint8_t *digest)
+{
+    return cx_sha256_final((cx_sha256_t *) ctx, digest);
+}
+
+static cx_err_t sha512_init_func(cx_hash_t *ctx)
+{
+    return cx_sha512_init_no_throw((cx_sha512_t *) ctx);
+}
+
+static cx_err_t sha384_init_func(cx_hash_t *ctx)
+{
+    return cx_sha384_init_no_throw((cx_sha512_t *) ctx);
+}
+
+static cx_err_t sha512_update_func(cx_hash_t *ctx, const uint8_t *data, size_t len)
+{
+    return cx_sha512_update((cx_sha512_t *) ctx, data, len);
+}
+
+static cx_err_t sha512_final_func(cx_hash_t *ctx, uint8_t *digest)
+{
+    return cx_sha512_final((cx_sha512_t *) ctx, digest);
+}
+
+static cx_err_t ripemd160_init_func(cx_hash_t *ctx)
+{
+    return cx_ripemd160_init_no_throw((cx_ripemd160_t *) ctx);
+}
+
+static cx_err_t ripemd160_update_func(cx_hash_t *ctx, const uint8_t *data, size_t len)
+{
+    return cx_ripemd160_update((cx_ripemd160_t *) ctx, data, len);
+}
+
+static cx_err_t ripemd160_final_func(cx_hash_t *ctx, uint8_t *digest)
+{
+    return cx_ripemd160_final((cx_ripemd160_t *) ctx, digest);
+}
+
+static cx_err_t sha3_init_ex_func(cx_hash_t *ctx, size_t output_size)
+{
+    return cx_sha3_init_no_throw((cx_sha3_t *) ctx, output_size * 8);
+}
+
+static cx_err_t keccak_init_ex_func(cx_hash_t *ctx, size_t output_size)
+{
+    return cx_keccak_init_no_throw((cx_sha3_t *) ctx, output_size * 8);
+}
+
+static cx_err_t shake128_init_ex_func(cx_hash_t *ctx, size_t output_size)
+{
+    return cx_sha3_xof_init_no_throw((cx_sha3_t *) ctx, 128, output_size);
+}
+
+static cx_err_t shake256_init_ex_func(cx_hash_t *ctx, size_t output_size)
+{
+    return cx_sha3_xof_init_no_throw((cx_sha3_t *) ctx, 256, output_size);
+}
+
+static cx_err_t sha3_update_func(cx_hash_t *ctx, const uint8_t *data, size_t len)
+{
+    return cx_sha3_update((cx_sha3_t *) ctx, data, len);
+}
+
+static cx_err_t sha3_final_func(cx_hash_t *ctx, uint8_t *digest)
+{
+    return cx_sha3_final((cx_sha3_t *) ctx, digest);
+}
+
+static size_t sha3_output_size_func(const cx_hash_t *ctx)
+{
+    return cx_sha3_get_output_size((const cx_sha3_t *) ctx);
+}
+
+const cx_hash_info_t cx_sha224_info = {CX_SHA224,
+                                       CX_SHA224_SIZE,
+                                       64,
+                                       sha224_init_func,
+                                       sha256_update_func,
+                                       sha256_final_func,
+                                       NULL,
+                                       NULL};
+
+const cx_hash_info_t cx_sha256_info = {CX_SHA256,
+                                       CX_SHA256_SIZE,
+                                       64,
+                                       sha256_init_func,
+                                       sha256_update_func,
+                                       sha256_final_func,
+                                       NULL,
+                                       NULL};
+
+const cx_hash_info_t cx_sha384_info = {CX_SHA384,
+                                       CX_SHA384_SIZE,
+                                       128,
+                                       sha384_init_func,
+                                       sha512_update_func,
+                                       sha512_final_func,
+                                       NULL,
+                                       NULL};
+
+const cx_hash_info_t cx_sha512_info = {CX_SHA512,
+                                       CX_SHA512_SIZE,
+                                       128,
+                                       sha512_init_func,
+                                       sha512_update_func,
+                                       sha512_final_func,
+                                       NULL,
+                                       NULL};
+
+const cx_hash_info_t cx_ripemd160_info = {CX_RIPEMD160,
+                                          CX_RIPEMD160_SIZE,
+                                          64,
+                                          ripemd160_init_func,
+                                          ripemd160_update_func,
+                                          ripemd160_final_func,
+                                          NULL,
+                                          NULL};
+
+const cx_hash_info_t cx_sha3_info = {CX_SHA3,
+                                     0,
+                                     0,
+                                     NULL,
+                                     sha3_update_func,
+                                     sha3_final_func,
+                                     sha3_init_ex_func,
+                                     sha3_output_size_func};
+
+const cx_hash_info_t cx_keccak_info = {CX_KECCAK,
+                                       0,
+                                       0,
+                                       NULL,
+                                       sha3_update_func,
+                                       sha3_final_func,
+                                       keccak_init_ex_func,
+                                       sha3_output_size_func};
+
+const cx_hash_info_t cx_shake128_info = {CX_SHAKE128,
+                                         0,
+                                         0,
+                                         NULL,
+                                         sha3_update_func,
+                                         sha3_final_func,
+                                         shake128_init_ex_func,
+                                         sha3_output_size_func};
+
+const cx_hash_info_t cx_shake256_info = {CX_SHAKE256,
+                                         0,
+                                         0,
+                                         NULL,
+                                         sha3_update_func,
+                                         sha3_final_func,
+                                         shake256_init_ex_func,
+                                         sha3_output_size_func};
+
+/* ======================================================================= */
+/*                               Entry points                              */
+/* ======================================================================= */
+
+cx_err_t cx_sha224_init_no_throw(cx_sha256_t *hash)
+{
+    CX_HOST_PROFILE();
+
+    memset(hash, 0, sizeof(cx_sha256_t));
+    hash->header.info = &cx_sha224_info;
+    memcpy(hash->acc, sha224_iv, sizeof(sha224_iv));
+    return CX_OK;
+}
+
+cx_err_t cx_sha256_init_no_throw(cx_sha256_t *hash)
+{
+    CX_HOST_PROFILE();
+
+    memset(hash, 0, sizeof(cx_sha256_t));
+    hash->header.info = &cx_sha256_info;
+    memcpy(hash->acc, sha256_iv, sizeof(sha256_iv));
+    return CX_OK;
+}
+
+cx_err_t cx_sha256_update(cx_sha256_t *ctx, const uint8_t *data, size_t len)
+{
+    CX_HOST_PROFILE();
+
+    if (ctx == NULL) {
+        return CX_INVALID_PARAMETER;
+    }
+    return md_update(
+        &ctx->header, &ctx->blen, ctx->block, 64, sha256_block, ctx->acc, data, len);
+}
+
+cx_err_t cx_sha256_final(cx_sha256_t *ctx, uint8_t *digest)
+{
+    CX_HOST_PROFILE();
+    uint32_t h[8];
+    size_t   size = (ctx->header.info == &cx_sha224_info) ? CX_SHA224_SIZE : CX_SHA256_SIZE;
+
+    md_final(&ctx->header, &ctx->blen, ctx->block, 64, 8, true, sha256_block, ctx->acc);
+    memcpy(h, ctx->acc, sizeof(h));
+    for (size_t i = 0; i < size / 4; i++) {
+        U4BE_ENCODE(digest, 4 * i, h[i]);
+    }
+    return CX_OK;
+}
+
+size_t cx_hash_sha256(const uint8_t *in, size_t len, uint8_t *out, size_t out_len)
+{
+    CX_HOST_PROFILE();
+    cx_sha256_t ctx;
+
+    if (out_len < CX_SHA256_SIZE) {
+        return 0;
+    }
+    cx_sha256_init_no_throw(&ctx);
+    if (cx_sha256_update(&ctx, in, len) != CX_OK) {
+        return 0;
+    }
+    cx_sha256_final(&ctx, out);
+    explicit_bzero(&ctx, sizeof(ctx));
+    return CX_SHA256_SIZE;
+}
+
+cx_err_t cx_sha384_init_no_throw(cx_sha512_t *hash)
+{
+    CX_HOST_PROFILE();
+
+    memset(hash, 0, sizeof(cx_sha512_t));
+    hash->header.info = &cx_sha384_info;
+    memcpy(hash->acc, sha384_iv, sizeof(sha384_iv));
+    return CX_OK;
+}
+
+cx_err_t cx_sha512_init_no_throw(cx_sha512_t *hash)
+{
+    CX_HOST_PROFILE();
+
+    memset(hash, 0, sizeof(cx_sha512_t));
+    hash->header.info = &cx_sha512_info;
+    memcpy(hash->acc, sha512_iv, sizeof(sha512_iv));
+    return CX_OK;
+}
+
+cx_err_t cx_sha512_update(cx_sha512_t *ctx, const uint8_t *data, size_t len)
+{
+    CX_HOST_PROFILE();
+
+    if (ctx == NULL) {
+        return CX_INVALID_PARAMETER;
+    }
+    return md_update(
+        &ctx->header, &ctx->blen, ctx->block, 128, sha512_block, ctx->acc, data, len);
+}
+
+cx_err_t cx_sha512_final(cx_sha512_t *ctx, uint8_t *digest)
+{
+    CX_HOST_PROFILE();
+    uint64_t h[8];
+    size_t   size = (ctx->header.info == &cx_sha384_info) ? CX_SHA384_SIZE : CX_SHA512_SIZE;
+
+    md_final(&ctx->header, &ctx->blen, ctx->block, 128, 16, true, sha512_block, ctx->acc);
+    memcpy(h, ctx->acc, sizeof(h));
+    for (size_t i = 0; i < size / 8; i++) {
+        U4BE_ENCODE(digest, 8 * i, (uint32_t) (h[i] >> 32));
+        U4BE_ENCODE(digest, 8 * i + 4, (uint32_t) h[i]);
+    }
+    return CX_OK;
+}
+
+size_t cx_hash_sha512(const uint8_t *in, size_t in_len, uint8_t *out, size_t out_len)
+{
+    CX_HOST_PROFILE();
+    cx_sha512_t ctx;
+
+    if (out_len < CX_SHA512_SIZE) {
+        return 0;
+    }
+    cx_sha512_init_no_throw(&ctx);
+    if (cx_sha512_update(&ctx, in, in_len) != CX_OK) {
+        return 0;
+    }
+    cx_sha512_final(&ctx, out);
+    explicit_bzero(&ctx, sizeof(ctx));
+    return CX_SHA512_SIZE;
+}
+
+cx_err_t cx_ripemd160_init_no_throw(cx_ripemd160_t *hash)
+{
+    CX_HOST_PROFILE();
+
+    memset(hash, 0, sizeof(cx_ripemd160_t));
+    hash->header.info = &cx_ripemd160_info;
+    memcpy(hash->acc, ripemd160_iv, sizeof(ripemd160_iv));
+    return CX_OK;
+}
+
+cx_err_t cx_ripemd160_update(cx_ripemd160_t *ctx, const uint8_t *data, size_t len)
+{
+    CX_HOST_PROFILE();
+
+    if (ctx == NULL) {
+        return CX_INVALID_PARAMETER;
+    }
+    return md_update(
+        &ctx->header, &ctx->blen, ctx->block, 64, ripemd160_block, ctx->acc, data, len);
+}
+
+cx_err_t cx_ripemd160_final(cx_ripemd160_t *ctx, uint8_t *digest)
+{
+    CX_HOST_PROFILE();
+    uint32_t h[5];
+
+    md_final(&ctx->header, &ctx->blen, ctx->block, 64, 8, false, ripemd160_block, ctx->acc);
+    memcpy(h, ctx->acc, sizeof(h));
+    for (size_t i = 0; i < 5; i++) {
+        U4LE_ENCODE(digest, 4 * i, h[i]);
+    }
+    return CX_OK;
+}
+
+const cx_hash_info_t *cx_hash_get_info(cx_md_t md_type)
+{
+    switch (md_type) {
+        case CX_SHA224:
+            return &cx_sha224_info;
+        case CX_SHA256:
+            return &cx_sha256_info;
+        case CX_SHA384:
+            return &cx_sha384_info;
+        case CX_SHA512:
+            return &cx_sha512_info;
+        case CX_RIPEMD160:
+            return &cx_ripemd160_info;
+        case CX_SHA3:
+            return &cx_sha3_info;
+        case CX_KECCAK:
+            return &cx_keccak_info;
+        case CX_SHAKE128:
+            return &cx_shake128_info;
+        case CX_SHAKE256:
+            return &cx_shake256_info;
+        default:
+            return NULL;
+    }
+}
+
+size_t cx_hash_get_size(const cx_hash_t *ctx)
+{
+    CX_HOST_PROFILE();
+
+    if (ctx->info->output_size_func != NULL) {
+        return ctx->info->output_size_func(ctx);
+    }
+    return ctx->info->output_size;
+}
+
+cx_err_t cx_hash_init(cx_hash_t *hash, cx_md_t hash_id)
+{
+    CX_HOST_PROFILE();
+    const cx_hash_info_t *info = cx_hash_get_info(hash_id);
+
+    if ((hash == NULL) || (info == NULL) || (info->init_func == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+    return info->init_func(hash);
+}
+
+cx_err_t cx_hash_init_ex(cx_hash_t *hash, cx_md_t hash_id, size_t output_size)
+{
+    CX_HOST_PROFILE();
+    const cx_hash_info_t *info = cx_hash_get_info(hash_id);
+
+    if ((hash == NULL) || (info == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+    if (info->init_ex_func != NULL) {
+        return info->init_ex_func(hash, output_size);
+    }
+    if (output_size != info->output_size) {
+        return CX_INVALID_PARAMETER;
+    }
+    return info->init_func(hash);
+}
+
+cx_err_t cx_hash_update(cx_hash_t *hash, const uint8_t *in, size_t in_len)
+{
+    CX_HOST_PROFILE();
+
+    if ((hash == NULL) || (hash->info == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+    return hash->info->update_func(hash, in, in_len);
+}
+
+cx_err_t cx_hash_final(cx_hash_t *hash, uint8_t *digest)
+{
+    CX_HOST_PROFILE();
+
+    if ((hash == NULL) || (hash->info == NULL) || (digest == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+    return hash->info->finish_func(hash, digest);
+}
+
+cx_err_t cx_hash_no_throw(cx_hash_t     *hash,
+                          uint32_t       mode,
+                          const uint8_t *in,
+                          size_t         len,
+                          uint8_t       *out,
+                          size_t         out_len)
+{
+    CX_HOST_PROFILE();
+    cx_err_t error;
+
+    CX_CHECK(cx_hash_update(hash, in, len));
+    if (mode & CX_LAST) {
+        if (out_len < cx_hash_get_size(hash)) {
+            return CX_INVALID_PARAMETER;
+        }
+        CX_CHECK(cx_hash_final(hash, out));
+    }
+
+end:
+    return error;
+}
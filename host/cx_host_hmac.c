@@ -0,0 +1,246 @@
+
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include <stdint.h>  // uint*_t
+#include <string.h>  // memset, memcpy, explicit_bzero
+
+#include "cx.h"
+#include "os_math.h"
+#include "cx_host_internal.h"
+
+#define HMAC_IPAD           0x36
+#define HMAC_OPAD           0x5c
+#define HMAC_MAX_BLOCK_SIZE 128
+#define HMAC_MAX_MAC_LEN    64
+
+static size_t hmac_block_size(cx_md_t hash_id)
+{
+    switch (hash_id) {
+        case CX_SHA224:
+        case CX_SHA256:
+        case CX_RIPEMD160:
+            return 64;
+        case CX_SHA384:
+        case CX_SHA512:
+            return 128;
+        default:
+            return 0;
+    }
+}
+
+/*
+ * Restarts the inner hash with the stored key, which is zero-padded to the
+ * block size.
+ */
+static cx_err_t hmac_start(cx_hmac_t *hmac, cx_md_t hash_id)
+{
+    cx_err_t error;
+    uint8_t  pad[HMAC_MAX_BLOCK_SIZE];
+    size_t   block_size = hmac_block_size(hash_id);
+
+    for (size_t i = 0; i < block_size; i++) {
+        pad[i] = hmac->key[i] ^ HMAC_IPAD;
+    }
+    CX_CHECK(cx_hash_init(&hmac->hash_ctx, hash_id));
+    CX_CHECK(cx_hash_update(&hmac->hash_ctx, pad, block_size));
+
+end:
+    explicit_bzero(pad, sizeof(pad));
+    return error;
+}
+
+cx_err_t cx_hmac_init(cx_hmac_t *hmac, cx_md_t hash_id, const uint8_t *key, size_t key_len)
+{
+    CX_HOST_PROFILE();
+    cx_err_t error;
+    size_t   block_size = hmac_block_size(hash_id);
+
+    if ((hmac == NULL) || (block_size == 0)) {
+        return CX_INVALID_PARAMETER;
+    }
+    if (key != NULL) {
+        memset(hmac->key, 0, sizeof(hmac->key));
+        // Keys longer than a block are replaced by their hash
+        if (key_len > block_size) {
+            CX_CHECK(cx_hash_init(&hmac->hash_ctx, hash_id));
+            CX_CHECK(cx_hash_update(&hmac->hash_ctx, key, key_len));
+            CX_CHECK(cx_hash_final(&hmac->hash_ctx, hmac->key));
+        }
+        else {
+            memcpy(hmac->key, key, key_len);
+        }
+    }
+    CX_CHECK(hmac_start(hmac, hash_id));
+
+end:
+    return error;
+}
+
+cx_err_t cx_hmac_update(cx_hmac_t *hmac, const uint8_t *in, size_t in_len)
+{
+    CX_HOST_PROFILE();
+
+    if ((hmac == NULL) || (hmac->hash_ctx.info == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+    return cx_hash_update(&hmac->hash_ctx, in, in_len);
+}
+
+static cx_err_t hmac_finish(cx_hmac_t *hmac, uint8_t *mac, bool reinit)
+{
+    cx_err_t error;
+    cx_md_t  hash_id    = hmac->hash_ctx.info->md_type;
+    size_t   block_size = hmac_block_size(hash_id);
+    uint8_t  pad[HMAC_MAX_BLOCK_SIZE];
+    uint8_t  inner_mac[HMAC_MAX_MAC_LEN];
+    size_t   mac_len = hmac->hash_ctx.info->output_size;
+
+    CX_CHECK(cx_hash_final(&hmac->hash_ctx, inner_mac));
+    for (size_t i = 0; i < block_size; i++) {
+        pad[i] = hmac->key[i] ^ HMAC_OPAD;
+    }
+    CX_CHECK(cx_hash_init(&hmac->hash_ctx, hash_id));
+    CX_CHECK(cx_hash_update(&hmac->hash_ctx, pad, block_size));
+    CX_CHECK(cx_hash_update(&hmac->hash_ctx, inner_mac, mac_len));
+    CX_CHECK(cx_hash_final(&hmac->hash_ctx, mac));
+    if (reinit) {
+        CX_CHECK(hmac_start(hmac, hash_id));
+    }
+
+end:
+    explicit_bzero(pad, sizeof(pad));
+    explicit_bzero(inner_mac, sizeof(inner_mac));
+    return error;
+}
+
+cx_err_t cx_hmac_final(cx_hmac_t *ctx, uint8_t *out, size_t *out_len)
+{
+    CX_HOST_PROFILE();
+    cx_err_t error;
+    uint8_t  mac[HMAC_MAX_MAC_LEN];
+
+    if ((ctx == NULL) || (ctx->hash_ctx.info == NULL) || (out == NULL) || (out_len == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+    CX_CHECK(hmac_finish(ctx, mac, false));
+    // Only the most significant bytes are kept if the output is shorter
+    *out_len = MIN(*out_len, ctx->hash_ctx.info->output_size);
+    memcpy(out, mac, *out_len);
+
+end:
+    explicit_bzero(mac, sizeof(mac));
+    return error;
+}
+
+cx_err_t cx_hmac_no_throw(cx_hmac_t     *hmac,
+                          uint32_t       mode,
+                          const uint8_t *in,
+                          size_t         len,
+                          uint8_t       *mac,
+                          size_t         mac_len)
+{
+    CX_HOST_PROFILE();
+    cx_err_t error;
+    uint8_t  out[HMAC_MAX_MAC_LEN];
+
+    CX_CHECK(cx_hmac_update(hmac, in, len));
+    if (mode & CX_LAST) {
+        if ((mac == NULL) || (mac_len < hmac->hash_ctx.info->output_size)) {
+            return CX_INVALID_PARAMETER;
+        }
+        CX_CHECK(hmac_finish(hmac, out, !(mode & CX_NO_REINIT)));
+        memcpy(mac, out, hmac->hash_ctx.info->output_size);
+    }
+
+end:
+    explicit_bzero(out, sizeof(out));
+    return error;
+}
+
+cx_err_t cx_hmac_ripemd160_init_no_throw(cx_hmac_ripemd160_t *hmac,
+                                         const uint8_t       *key,
+                                         size_t               key_len)
+{
+    CX_HOST_PROFILE();
+
+    return cx_hmac_init((cx_hmac_t *) hmac, CX_RIPEMD160, key, key_len);
+}
+
+cx_err_t cx_hmac_sha224_init(cx_hmac_sha256_t *hmac, const uint8_t *key, unsigned int key_len)
+{
+    CX_HOST_PROFILE();
+
+    return cx_hmac_init((cx_hmac_t *) hmac, CX_SHA224, key, key_len);
+}
+
+cx_err_t cx_hmac_sha256_init_no_throw(cx_hmac_sha256_t *hmac, const uint8_t *key, size_t key_len)
+{
+    CX_HOST_PROFILE();
+
+    return cx_hmac_init((cx_hmac_t *) hmac, CX_SHA256, key, key_len);
+}
+
+cx_err_t cx_hmac_sha384_init(cx_hmac_sha512_t *hmac, const uint8_t *key, unsigned int key_len)
+{
+    CX_HOST_PROFILE();
+
+    return cx_hmac_init((cx_hmac_t *) hmac, CX_SHA384, key, key_len);
+}
+
+cx_err_t cx_hmac_sha512_init_no_throw(cx_hmac_sha512_t *hmac, const uint8_t *key, size_t key_len)
+{
+    CX_HOST_PROFILE();
+
+    return cx_hmac_init((cx_hmac_t *) hmac, CX_SHA512, key, key_len);
+}
+
+size_t cx_hmac_sha256(const uint8_t *key,
+                      size_t         key_len,
+                      const uint8_t *in,
+                      size_t         len,
+                      uint8_t       *mac,
+                      size_t         mac_len)
+{
+    CX_HOST_PROFILE();
+    cx_hmac_sha256_t hmac;
+    size_t           size = 0;
+
+    if ((cx_hmac_sha256_init_no_throw(&hmac, key, key_len) == CX_OK)
+        && (cx_hmac_no_throw((cx_hmac_t *) &hmac, CX_LAST, in, len, mac, mac_len) == CX_OK)) {
+        size = CX_SHA256_SIZE;
+    }
+    explicit_bzero(&hmac, sizeof(hmac));
+    return size;
+}
+
+size_t cx_hmac_sha512(const uint8_t *key,
+                      size_t         key_len,
+                      const uint8_t *in,
+                      size_t         len,
+                      uint8_t       *mac,
+                      size_t         mac_len)
+{
+    CX_HOST_PROFILE();
+    cx_hmac_sha512_t hmac;
+    size_t           size = 0;
+
+    if ((cx_hmac_sha512_init_no_throw(&hmac, key, key_len) == CX_OK)
+        && (cx_hmac_no_throw((cx_hmac_t *) &hmac, CX_LAST, in, len, mac, mac_len) == CX_OK)) {
+        size = CX_SHA512_SIZE;
+    }
+    explicit_bzero(&hmac, sizeof(hmac));
+    return size;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdint.h>  // uint*_t
+
+#include <openssl/bn.h>
+
+#include "cx.h"
+#include "cx_host.h"
+
+/**
+ * Timer of the entry point being executed.
+ */
+typedef struct cx_host_timer_s {
+    cx_host_stat_t         *stat;      /// Statistics of the entry point
+    uint64_t                start_ns;  /// Start of the call
+    uint64_t                child_ns;  /// Time spent in nested entry points
+    struct cx_host_timer_s *parent;    /// Timer of the calling entry point, if any
+} cx_host_timer_t;
+
+void cx_host_timer_start(cx_host_timer_t *timer, cx_host_stat_t *stat);
+void cx_host_timer_stop(cx_host_timer_t *timer);
+
+/**
+ * Counts and times the enclosing function, on every return path.
+ * It shall be the first statement of the function.
+ */
+#define CX_HOST_PROFILE()                                                  \
+    static cx_host_stat_t cx_host_stat_ = {.name = __func__};              \
+    cx_host_timer_t       cx_host_timer_ __attribute__((cleanup(cx_host_timer_stop))); \
+    cx_host_timer_start(&cx_host_timer_, &cx_host_stat_)
+
+/*
+ * Big numbers, shared with the elliptic curve backend.
+ */
+
+/**
+ * @brief   Returns the value of a locked BN.
+ *
+ * @param[in]  x      BN index.
+ *
+ * @param[out] nbytes Size of the BN, can be NULL.
+ *
+ * @return            Value of the BN, NULL if the BN processor is not locked
+ *                    or if the index is invalid.
+ */
+BIGNUM *cx_host_bn_get(cx_bn_t x, size_t *nbytes);
+
+/**
+ * @brief   Sets a BN from a non-negative value, reduced to the BN size.
+ *
+ * @param[in] x BN index.
+ *
+ * @param[in] v Value.
+ *
+ * @return      Error code:
+ *              - CX_OK on success
+ *              - CX_CARRY if the value did not fit in the BN
+ *              - CX_NOT_LOCKED
+ *              - CX_INVALID_PARAMETER
+ */
+cx_err_t cx_host_bn_set(cx_bn_t x, const BIGNUM *v);
+
+/**
+ * @brief   Returns the BN context used for the temporary values.
+ */
+BN_CTX *cx_host_bn_ctx(void);
+
+/**
+ * @brief   Fills a buffer with random bytes.
+ */
+void cx_host_random(uint8_t *buf, size_t len);
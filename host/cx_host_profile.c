@@ -0,0 +1,176 @@
+
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include <stdint.h>  // uint*_t
+#include <stdio.h>   // FILE, fprintf
+#include <stdlib.h>  // getenv, atexit, qsort
+#include <string.h>  // strcmp
+#include <time.h>    // clock_gettime
+
+#include "exceptions.h"
+#include "cx_host_internal.h"
+
+static cx_host_stat_t  *stats_head;
+static cx_host_stat_t **stats_tail = &stats_head;
+static size_t           stats_count;
+static cx_host_timer_t *current_timer;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+}
+
+static void stats_dump_at_exit(void)
+{
+    const char *path = getenv("CX_HOST_PROFILE");
+    FILE       *out;
+
+    if (strcmp(path, "-") == 0) {
+        cx_host_stats_dump(stderr);
+        return;
+    }
+    out = fopen(path, "w");
+    if (out != NULL) {
+        cx_host_stats_dump(out);
+        fclose(out);
+    }
+}
+
+void cx_host_timer_start(cx_host_timer_t *timer, cx_host_stat_t *stat)
+{
+    if (!stat->registered) {
+        if ((stats_head == NULL) && (getenv("CX_HOST_PROFILE") != NULL)) {
+            atexit(stats_dump_at_exit);
+        }
+        stat->registered = 1;
+        *stats_tail      = stat;
+        stats_tail       = &stat->next;
+        stats_count++;
+    }
+    timer->stat     = stat;
+    timer->child_ns = 0;
+    timer->parent   = current_timer;
+    current_timer   = timer;
+    timer->start_ns = now_ns();
+}
+
+void cx_host_timer_stop(cx_host_timer_t *timer)
+{
+    uint64_t elapsed = now_ns() - timer->start_ns;
+
+    timer->stat->calls++;
+    timer->stat->total_ns += elapsed;
+    timer->stat->self_ns += elapsed - timer->child_ns;
+    if (elapsed > timer->stat->max_ns) {
+        timer->stat->max_ns = elapsed;
+    }
+    if (timer->parent != NULL) {
+        timer->parent->child_ns += elapsed;
+    }
+    current_timer = timer->parent;
+}
+
+const cx_host_stat_t *cx_host_stats_first(void)
+{
+    return stats_head;
+}
+
+void cx_host_stats_reset(void)
+{
+    for (cx_host_stat_t *stat = stats_head; stat != NULL; stat = stat->next) {
+        stat->calls    = 0;
+        stat->total_ns = 0;
+        stat->self_ns  = 0;
+        stat->max_ns   = 0;
+    }
+}
+
+static int stats_cmp_self(const void *a, const void *b)
+{
+    const cx_host_stat_t *sa = *(const cx_host_stat_t *const *) a;
+    const cx_host_stat_t *sb = *(const cx_host_stat_t *const *) b;
+
+    return (sa->self_ns < sb->self_ns) - (sa->self_ns > sb->self_ns);
+}
+
+void cx_host_stats_dump(FILE *out)
+{
+    const cx_host_stat_t **sorted;
+    size_t                 n = 0;
+
+    sorted = malloc(stats_count * sizeof(*sorted));
+    if (sorted == NULL) {
+        return;
+    }
+    for (const cx_host_stat_t *stat = stats_head; stat != NULL; stat = stat->next) {
+        if (stat->calls != 0) {
+            sorted[n++] = stat;
+        }
+    }
+    qsort(sorted, n, sizeof(*sorted), stats_cmp_self);
+
+    fprintf(out,
+            "%-36s %10s %12s %12s %10s %10s\n",
+            "function",
+            "calls",
+            "total_us",
+            "self_us",
+            "avg_ns",
+            "max_ns");
+    for (size_t i = 0; i < n; i++) {
+        fprintf(out,
+                "%-36s %10llu %12.1f %12.1f %10llu %10llu\n",
+                sorted[i]->name,
+                (unsigned long long) sorted[i]->calls,
+                sorted[i]->total_ns / 1000.0,
+                sorted[i]->self_ns / 1000.0,
+                (unsigned long long) (sorted[i]->total_ns / sorted[i]->calls),
+                (unsigned long long) sorted[i]->max_ns);
+    }
+    free(sorted);
+}
+
+/*
+ * Exception context, used by the throwing wrappers of the cx API.
+ */
+
+static try_context_t *try_context;
+
+try_context_t *try_context_get(void)
+{
+    return try_context;
+}
+
+try_context_t *try_context_set(try_context_t *context)
+{
+    try_context_t *previous = try_context;
+
+    try_context = context;
+    return previous;
+}
+
+void os_longjmp(unsigned int exception)
+{
+    // An exception thrown outside of any TRY block is fatal, as on the device
+    if (try_context == NULL) {
+        fprintf(stderr, "cx_host: uncaught exception 0x%04X\n", exception);
+        abort();
+    }
+    longjmp(try_context->jmp_buf, exception);
+}
@@ -0,0 +1,71 @@
+
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include <stdint.h>  // uint*_t
+#include <stdlib.h>  // abort
+
+#include <openssl/rand.h>
+
+#include "cx.h"
+#include "os_random.h"
+#include "ox_rng.h"
+#include "cx_host_internal.h"
+
+void cx_host_random(uint8_t *buf, size_t len)
+{
+    // The device cannot fail to provide random bytes
+    if ((len != 0) && (RAND_bytes(buf, (int) len) != 1)) {
+        abort();
+    }
+}
+
+void cx_trng_get_random_data(uint8_t *buf, size_t size)
+{
+    CX_HOST_PROFILE();
+
+    cx_host_random(buf, size);
+}
+
+cx_err_t cx_get_random_bytes(void *buffer, size_t len)
+{
+    CX_HOST_PROFILE();
+
+    cx_host_random(buffer, len);
+    return CX_OK;
+}
+
+void cx_rng_no_throw(uint8_t *buffer, size_t len)
+{
+    CX_HOST_PROFILE();
+
+    cx_host_random(buffer, len);
+}
+
+uint32_t cx_rng_u32_range_func(uint32_t a, uint32_t b, cx_rng_u32_range_randfunc_t randfunc)
+{
+    CX_HOST_PROFILE();
+    uint32_t range = b - a;
+    uint32_t r;
+
+    if ((range & (range - 1)) == 0) {
+        return a + (randfunc() & (range - 1));
+    }
+    // Rejection sampling, to keep the distribution uniform
+    do {
+        r = randfunc();
+    } while (r >= UINT32_MAX - (UINT32_MAX % range));
+    return a + (r % range);
+}
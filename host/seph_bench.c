@@ -0,0 +1,336 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * APDU replay benchmark, for apps built with the seph_bench library. The APDUs
+ * of a trace are given to the app by io_exchange() with DEBUG_APDU, as they
+ * would be by the transport, and the time spent by the app until each reply is
+ * measured. The whole trace is replayed several times, and the minimum time of
+ * each APDU is kept, being the least noisy on a host.
+ *
+ * usage: <app> [-n <iterations>] [-o <results>] [-b <baseline>] [-t <percent>] <trace>
+ *
+ * The trace has an APDU per line, in hex, '#' starting a comment. The results
+ * have a line per APDU:
+ *   <index> <CLA INS> <status word> <minimum time (ns)> <average time (ns)>
+ * and can be saved as a baseline: the app then exits with 1 if an APDU is
+ * slower by more than the threshold, 10% by default, or if its status word
+ * differs.
+ */
+#include <getopt.h>   // getopt
+#include <stdbool.h>  // bool
+#include <stdint.h>   // uint*_t
+#include <stdio.h>    // FILE, fprintf, fgets
+#include <stdlib.h>   // exit, strtoul, realloc
+#include <string.h>   // memcpy, strcspn
+#include <time.h>     // clock_gettime
+
+#include "os.h"
+#include "io.h"
+
+#define BENCH_APDU_MAX (5 + 255)
+
+typedef struct {
+    uint8_t  data[BENCH_APDU_MAX];
+    size_t   length;
+    uint16_t sw;
+    uint64_t min_ns;
+    uint64_t total_ns;
+} bench_apdu_t;
+
+ux_state_t        G_ux;
+bolos_ux_params_t G_ux_params;
+
+static bench_apdu_t *apdus;
+static size_t        apdus_count;
+static size_t        current;
+static bool          in_flight;
+static uint64_t      start_ns;
+static unsigned long iteration;
+static unsigned long iterations = 100;
+static const char   *results_path;
+static const char   *baseline_path;
+static double        threshold = 10;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+}
+
+static bool parse_hex(const char *hex, uint8_t *out, size_t max, size_t *length)
+{
+    size_t l = strlen(hex);
+
+    if ((l % 2) || (l / 2 > max)) {
+        return false;
+    }
+    for (size_t i = 0; i < l / 2; i++) {
+        char  byte[3] = {hex[2 * i], hex[2 * i + 1], 0};
+        char *end;
+
+        out[i] = strtoul(byte, &end, 16);
+        if (*end != 0) {
+            return false;
+        }
+    }
+    *length = l / 2;
+    return true;
+}
+
+static void load_trace(const char *path)
+{
+    FILE        *f = fopen(path, "r");
+    char         line[1024];
+    unsigned int number = 0;
+
+    if (f == NULL) {
+        perror(path);
+        exit(2);
+    }
+    while (fgets(line, sizeof(line), f) != NULL) {
+        char *hex;
+
+        number++;
+        line[strcspn(line, "#\r\n")] = 0;
+        hex = line + strspn(line, " \t");
+        hex[strcspn(hex, " \t")] = 0;
+        if (*hex == 0) {
+            continue;
+        }
+        apdus = realloc(apdus, (apdus_count + 1) * sizeof(bench_apdu_t));
+        memset(&apdus[apdus_count], 0, sizeof(bench_apdu_t));
+        if (!parse_hex(hex, apdus[apdus_count].data, BENCH_APDU_MAX, &apdus[apdus_count].length)
+            || (apdus[apdus_count].length < 4)) {
+            fprintf(stderr, "%s:%u: invalid APDU\n", path, number);
+            exit(2);
+        }
+        apdus[apdus_count].min_ns = UINT64_MAX;
+        apdus_count++;
+    }
+    fclose(f);
+    if (apdus_count == 0) {
+        fprintf(stderr, "%s: no APDU\n", path);
+        exit(2);
+    }
+}
+
+static void write_results(FILE *out)
+{
+    for (size_t i = 0; i < apdus_count; i++) {
+        fprintf(out,
+                "%zu %02X%02X %04X %llu %llu\n",
+                i,
+                apdus[i].data[0],
+                apdus[i].data[1],
+                apdus[i].sw,
+                (unsigned long long) apdus[i].min_ns,
+                (unsigned long long) (apdus[i].total_ns / iterations));
+    }
+}
+
+/*
+ * Returns the number of APDUs slower than in the baseline, or replied with
+ * another status word.
+ */
+static unsigned int compare_baseline(const char *path)
+{
+    FILE              *f = fopen(path, "r");
+    unsigned int       regressions = 0;
+    size_t             index;
+    unsigned int       cla_ins;
+    unsigned int       sw;
+    unsigned long long min_ns;
+    unsigned long long avg_ns;
+    size_t             count = 0;
+
+    if (f == NULL) {
+        perror(path);
+        exit(2);
+    }
+    while (fscanf(f, "%zu %x %x %llu %llu", &index, &cla_ins, &sw, &min_ns, &avg_ns) == 5) {
+        const bench_apdu_t *apdu;
+
+        if ((index != count++) || (index >= apdus_count)
+            || (cla_ins != U2BE(apdus[index].data, 0))) {
+            fprintf(stderr, "%s: the baseline is not the one of the trace\n", path);
+            exit(2);
+        }
+        apdu = &apdus[index];
+        if (sw != apdu->sw) {
+            fprintf(stderr,
+                    "apdu %zu (%04X): status %04X instead of %04X\n",
+                    index,
+                    cla_ins,
+                    apdu->sw,
+                    sw);
+            regressions++;
+        }
+        else if (apdu->min_ns > min_ns * (1 + threshold / 100)) {
+            fprintf(stderr,
+                    "apdu %zu (%04X): %llu ns instead of %llu ns, +%.1f%%\n",
+                    index,
+                    cla_ins,
+                    (unsigned long long) apdu->min_ns,
+                    min_ns,
+                    (apdu->min_ns - min_ns) * 100.0 / min_ns);
+            regressions++;
+        }
+    }
+    fclose(f);
+    if (count != apdus_count) {
+        fprintf(stderr, "%s: the baseline is not the one of the trace\n", path);
+        exit(2);
+    }
+    return regressions;
+}
+
+static void finish(void)
+{
+    FILE        *out         = stdout;
+    unsigned int regressions = 0;
+
+    if (results_path != NULL) {
+        out = fopen(results_path, "w");
+        if (out == NULL) {
+            perror(results_path);
+            exit(2);
+        }
+    }
+    write_results(out);
+    if (out != stdout) {
+        fclose(out);
+    }
+    if (baseline_path != NULL) {
+        regressions = compare_baseline(baseline_path);
+        fprintf(stderr, "%u regression(s) over %zu APDUs\n", regressions, apdus_count);
+    }
+    exit((regressions == 0) ? 0 : 1);
+}
+
+unsigned short debug_apdu_next(unsigned char *buffer, unsigned short max_length)
+{
+    const bench_apdu_t *apdu;
+
+    if (in_flight) {
+        fprintf(stderr,
+                "apdu %zu is replied asynchronously, e.g. once approved, which can't be "
+                "replayed\n",
+                current);
+        exit(2);
+    }
+    if (current == apdus_count) {
+        if (++iteration == iterations) {
+            finish();
+        }
+        current = 0;
+    }
+    apdu = &apdus[current];
+    if (apdu->length > max_length) {
+        THROW(INVALID_PARAMETER);
+    }
+    memcpy(buffer, apdu->data, apdu->length);
+    in_flight = true;
+    start_ns  = now_ns();
+    return apdu->length;
+}
+
+void debug_apdu_replied(unsigned short tx_len)
+{
+    uint64_t      elapsed = now_ns() - start_ns;
+    bench_apdu_t *apdu    = &apdus[current];
+
+    if (!in_flight) {
+        return;
+    }
+    in_flight = false;
+    if (elapsed < apdu->min_ns) {
+        apdu->min_ns = elapsed;
+    }
+    apdu->total_ns += elapsed;
+    apdu->sw = (tx_len >= 2) ? U2BE(G_io_apdu_buffer, tx_len - 2) : 0;
+    current++;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [-n <iterations>] [-o <results>] [-b <baseline>] [-t <percent>] "
+            "<trace>\n",
+            name);
+    exit(2);
+}
+
+/*
+ * Entry point of the app, in place of the one of lib_standard_app: no MCU
+ * simulator is connected, the display statuses are acknowledged by seph_host.
+ */
+int main(int argc, char *argv[])
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:o:b:t:")) != -1) {
+        switch (opt) {
+            case 'n':
+                iterations = strtoul(optarg, NULL, 0);
+                break;
+            case 'o':
+                results_path = optarg;
+                break;
+            case 'b':
+                baseline_path = optarg;
+                break;
+            case 't':
+                threshold = strtod(optarg, NULL);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if ((iterations == 0) || (optind + 1 != argc)) {
+        usage(argv[0]);
+    }
+    load_trace(argv[optind]);
+
+    try_context_set(NULL);
+
+    BEGIN_TRY
+    {
+        TRY
+        {
+            UX_INIT();
+
+            io_seproxyhal_init();
+
+            USB_power(0);
+            USB_power(1);
+
+            app_main();
+        }
+        CATCH_OTHER(e)
+        {
+            fprintf(stderr, "Exiting following exception: 0x%04X\n", e);
+            return 1;
+        }
+        FINALLY {}
+    }
+    END_TRY;
+
+    fprintf(stderr, "the app stopped at apdu %zu\n", current);
+    return 1;
+}
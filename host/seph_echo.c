@@ -0,0 +1,160 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include <stdbool.h>  // bool
+#include <stddef.h>   // size_t
+#include <stdint.h>   // uint*_t
+#include <string.h>   // memset
+
+#include "os.h"
+#include "ux.h"
+#include "io.h"
+#include "parser.h"
+#include "offsets.h"
+
+/*
+ * Minimal app replying to:
+ * - E0 01 00 00 <data>: <data> 9000, straight away
+ * - E0 01 00 00 00 <Lc on 2 bytes> <data>: the same, with an extended APDU when
+ *   the app is built with a larger CUSTOM_IO_APDU_BUFFER_SIZE
+ * - E0 02 00 00 <data>: <data> 9000 once approved with the right button, 6985
+ *   if rejected with the left one, extended as well, the buffer being reused by
+ *   the UX once the reply is sent
+ * It measures the IO and UX paths of the SDK, with the MCU simulator.
+ */
+#define CLA_ECHO       0xE0
+#define INS_ECHO       0x01
+#define INS_APPROVE    0x02
+#define SW_OK          0x9000
+#define SW_DENY        0x6985
+#define SW_BAD_INS     0x6D00
+#define SW_BAD_CLA     0x6E00
+#define SW_BAD_LC      0x6700
+#define TEXT_FONT      (BAGL_FONT_OPEN_SANS_REGULAR_11px | BAGL_FONT_ALIGNMENT_CENTER)
+#define TITLE_FONT     (BAGL_FONT_OPEN_SANS_EXTRABOLD_11px | BAGL_FONT_ALIGNMENT_CENTER)
+#define RELEASED_LEFT  (BUTTON_EVT_RELEASED | BUTTON_LEFT)
+#define RELEASED_RIGHT (BUTTON_EVT_RELEASED | BUTTON_RIGHT)
+
+static command_t      G_cmd;
+static const uint8_t *G_approve_data;
+static size_t         G_approve_length;
+
+static const bagl_element_t ui_idle[] = {
+    {{BAGL_RECTANGLE, 0x00, 0, 0, 128, 32, 0, 0, BAGL_FILL, 0x000000, 0xFFFFFF, 0, 0}, NULL},
+    {{BAGL_LABELINE, 0x01, 0, 12, 128, 12, 0, 0, 0, 0xFFFFFF, 0x000000, TITLE_FONT, 0}, "Echo"},
+    {{BAGL_LABELINE, 0x02, 0, 26, 128, 12, 0, 0, 0, 0xFFFFFF, 0x000000, TEXT_FONT, 0},
+     "is ready"},
+};
+
+static const bagl_element_t ui_approve[] = {
+    {{BAGL_RECTANGLE, 0x00, 0, 0, 128, 32, 0, 0, BAGL_FILL, 0x000000, 0xFFFFFF, 0, 0}, NULL},
+    {{BAGL_LABELINE, 0x01, 0, 12, 128, 12, 0, 0, 0, 0xFFFFFF, 0x000000, TITLE_FONT, 0},
+     "Echo data"},
+    {{BAGL_LABELINE, 0x02, 0, 26, 128, 12, 0, 0, 0, 0xFFFFFF, 0x000000, TEXT_FONT, 0},
+     "Reject    Approve"},
+};
+
+static unsigned int ui_idle_button(unsigned int button_mask, unsigned int button_mask_counter)
+{
+    UNUSED(button_mask);
+    UNUSED(button_mask_counter);
+    return 0;
+}
+
+static unsigned int ui_approve_button(unsigned int button_mask, unsigned int button_mask_counter)
+{
+    UNUSED(button_mask_counter);
+
+    switch (button_mask) {
+        case RELEASED_LEFT:
+            io_send_sw(SW_DENY);
+            break;
+        case RELEASED_RIGHT:
+            io_send_response_pointer(G_approve_data, G_approve_length, SW_OK);
+            // as an app preparing its next screen, the reply being sent
+            memset(G_io_apdu_buffer, 0xFF, sizeof(G_io_apdu_buffer));
+            break;
+        default:
+            return 0;
+    }
+    UX_DISPLAY(ui_idle, NULL);
+    return 0;
+}
+
+static int approve(const uint8_t *data, size_t length)
+{
+    G_approve_data   = data;
+    G_approve_length = length;
+    UX_DISPLAY(ui_approve, NULL);
+    // replied from the button callback
+    return 0;
+}
+
+// Extended APDUs aren't parsed by apdu_parser()
+static bool echo_extended(size_t length)
+{
+    const uint8_t *apdu = G_io_apdu_buffer;
+
+    if ((length <= OFFSET_CDATA + 2) || (apdu[OFFSET_CLA] != CLA_ECHO)
+        || ((apdu[OFFSET_INS] != INS_ECHO) && (apdu[OFFSET_INS] != INS_APPROVE))
+        || (apdu[OFFSET_LC] != 0) || (U2BE(apdu, OFFSET_CDATA) != length - OFFSET_CDATA - 2)) {
+        return false;
+    }
+    if (apdu[OFFSET_INS] == INS_APPROVE) {
+        approve(apdu + OFFSET_CDATA + 2, length - OFFSET_CDATA - 2);
+    }
+    else {
+        io_send_response_pointer(apdu + OFFSET_CDATA + 2, length - OFFSET_CDATA - 2, SW_OK);
+    }
+    return true;
+}
+
+static int dispatch(const command_t *cmd)
+{
+    if (cmd->cla != CLA_ECHO) {
+        return io_send_sw(SW_BAD_CLA);
+    }
+    switch (cmd->ins) {
+        case INS_ECHO:
+            return io_send_response_pointer(cmd->data, cmd->lc, SW_OK);
+        case INS_APPROVE:
+            return approve(cmd->data, cmd->lc);
+        default:
+            return io_send_sw(SW_BAD_INS);
+    }
+}
+
+void app_main(void)
+{
+    int input_len;
+
+    io_init();
+
+    UX_DISPLAY(ui_idle, NULL);
+
+    for (;;) {
+        input_len = io_recv_command();
+        if (input_len < 0) {
+            return;
+        }
+        if (!apdu_parser(&G_cmd, G_io_apdu_buffer, input_len)) {
+            if (!echo_extended(input_len)) {
+                io_send_sw(SW_BAD_LC);
+            }
+            continue;
+        }
+        dispatch(&G_cmd);
+    }
+}
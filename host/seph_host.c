@@ -0,0 +1,382 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include <errno.h>       // errno
+#include <stdbool.h>     // bool
+#include <stdint.h>      // uint*_t
+#include <stdio.h>       // FILE, fopen, fread
+#include <stdlib.h>      // exit
+#include <string.h>      // memcpy, strlen
+#include <sys/socket.h>  // socket, connect
+#include <sys/un.h>      // sockaddr_un
+#include <unistd.h>      // read, write, close
+
+#include "exceptions.h"
+#include "lcx_rng.h"
+#include "os_helpers.h"
+#include "os_id.h"
+#include "os_io_seproxyhal.h"
+#include "os_nvm.h"
+#include "os_pic.h"
+#include "os_pin.h"
+#include "os_registry.h"
+#include "os_seed.h"
+#include "os_task.h"
+#include "os_types.h"
+#include "os_ux.h"
+#include "seproxyhal_protocol.h"
+#include "seph_host.h"
+
+#ifndef APPNAME
+#define APPNAME "Host app"
+#endif  // APPNAME
+#ifndef APPVERSION
+#define APPVERSION "0.0.0"
+#endif  // APPVERSION
+
+// 10 minutes of the device time, without anything else than tickers
+#define SEPH_IDLE_TICKERS_MAX 6000
+
+// Provided by the linker script on the device
+unsigned char G_io_apdu_buffer[IO_APDU_BUFFER_SIZE];
+
+static int            seph_fd = -1;
+static bool           seph_status_sent;
+static uint8_t        seph_status_tag;
+static unsigned int   seph_idle_tickers;
+static uint32_t       seph_ms;
+static try_context_t *seph_try_context;
+
+// Packet being sent, which may be given in several pieces
+static uint8_t  seph_tx_header[3];
+static size_t   seph_tx_header_length;
+static size_t   seph_tx_remaining;
+static bool     seph_tx_dropped;
+static uint8_t  seph_tx_buffer[4096];
+static size_t   seph_tx_length;
+
+__attribute__((noreturn)) static void seph_exit(int status)
+{
+    if (seph_fd >= 0) {
+        close(seph_fd);
+    }
+    exit(status);
+}
+
+static void seph_write(const uint8_t *buffer, size_t length)
+{
+    while (length > 0) {
+        ssize_t written = write(seph_fd, buffer, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // the simulator is gone
+            seph_exit(0);
+        }
+        buffer += written;
+        length -= written;
+    }
+}
+
+static void seph_flush(void)
+{
+    seph_write(seph_tx_buffer, seph_tx_length);
+    seph_tx_length = 0;
+}
+
+static void seph_queue(const uint8_t *buffer, size_t length)
+{
+    if (seph_tx_length + length > sizeof(seph_tx_buffer)) {
+        seph_flush();
+    }
+    if (length > sizeof(seph_tx_buffer)) {
+        seph_write(buffer, length);
+        return;
+    }
+    memcpy(seph_tx_buffer + seph_tx_length, buffer, length);
+    seph_tx_length += length;
+}
+
+static void seph_read(uint8_t *buffer, size_t length)
+{
+    while (length > 0) {
+        ssize_t received = read(seph_fd, buffer, length);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            // end of the session
+            seph_exit(0);
+        }
+        buffer += received;
+        length -= received;
+    }
+}
+
+int seph_host_connect(const char *path)
+{
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    seph_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (seph_fd < 0) {
+        return -1;
+    }
+    if (connect(seph_fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+        close(seph_fd);
+        seph_fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Packets are parsed as they are sent to mimic the OS: once a status has been
+ * sent, nothing is forwarded to the MCU until the next event is received.
+ */
+void io_seph_send(const unsigned char *buffer, unsigned short length)
+{
+    while (length > 0) {
+        if (seph_tx_remaining == 0) {
+            size_t l = MIN(length, sizeof(seph_tx_header) - seph_tx_header_length);
+            memcpy(seph_tx_header + seph_tx_header_length, buffer, l);
+            seph_tx_header_length += l;
+            buffer += l;
+            length -= l;
+            if (seph_tx_header_length < sizeof(seph_tx_header)) {
+                break;
+            }
+            seph_tx_header_length = 0;
+            seph_tx_remaining     = U2BE(seph_tx_header, 1);
+            seph_tx_dropped       = seph_status_sent;
+            if (!seph_tx_dropped && (seph_fd >= 0)) {
+                seph_queue(seph_tx_header, sizeof(seph_tx_header));
+            }
+        }
+        else {
+            size_t l = MIN(length, seph_tx_remaining);
+            if (!seph_tx_dropped && (seph_fd >= 0)) {
+                seph_queue(buffer, l);
+            }
+            seph_tx_remaining -= l;
+            buffer += l;
+            length -= l;
+        }
+        // a status ends the turn of the SE
+        if ((seph_tx_header_length == 0) && (seph_tx_remaining == 0) && !seph_tx_dropped
+            && ((seph_tx_header[0] & 0xE0) == 0x60)) {
+            seph_status_sent = true;
+            seph_status_tag  = seph_tx_header[0];
+        }
+    }
+}
+
+unsigned int io_seph_is_status_sent(void)
+{
+    return seph_status_sent;
+}
+
+/*
+ * Without a simulator, the MCU only acknowledges the display statuses, and
+ * sends ticker events otherwise.
+ */
+static unsigned short seph_loopback_event(unsigned char *buffer, unsigned short maxlength)
+{
+    uint8_t event[7] = {0};
+
+    switch (seph_status_tag) {
+        case SEPROXYHAL_TAG_SCREEN_DISPLAY_STATUS:
+#ifdef SEPROXYHAL_TAG_SCREEN_DISPLAY_BATCH_STATUS
+        case SEPROXYHAL_TAG_SCREEN_DISPLAY_BATCH_STATUS:
+#endif  // SEPROXYHAL_TAG_SCREEN_DISPLAY_BATCH_STATUS
+            seph_idle_tickers = 0;
+            event[0]          = SEPROXYHAL_TAG_DISPLAY_PROCESSED_EVENT;
+            memcpy(buffer, event, MIN(maxlength, 3));
+            return MIN(maxlength, 3);
+
+        default:
+            if (seph_status_tag != SEPROXYHAL_TAG_GENERAL_STATUS) {
+                seph_idle_tickers = 0;
+            }
+            if (++seph_idle_tickers > SEPH_IDLE_TICKERS_MAX) {
+                fprintf(stderr, "the app waits for an event which is not simulated\n");
+                seph_exit(1);
+            }
+            seph_ms += 100;
+            event[0] = SEPROXYHAL_TAG_TICKER_EVENT;
+            event[2] = 4;
+            U4BE_ENCODE(event, 3, seph_ms);
+            memcpy(buffer, event, MIN(maxlength, sizeof(event)));
+            return MIN(maxlength, sizeof(event));
+    }
+}
+
+unsigned short io_seph_recv(unsigned char *buffer, unsigned short maxlength, unsigned int flags)
+{
+    uint8_t  header[3];
+    uint16_t length;
+    uint16_t kept;
+
+    UNUSED(flags);
+
+    if (seph_fd < 0) {
+        seph_status_sent = false;
+        return seph_loopback_event(buffer, maxlength);
+    }
+
+    seph_flush();
+    seph_read(header, sizeof(header));
+    length = U2BE(header, 1);
+    memcpy(buffer, header, MIN(maxlength, sizeof(header)));
+    kept = MIN(length, (maxlength > sizeof(header)) ? maxlength - sizeof(header) : 0);
+    seph_read(buffer + sizeof(header), kept);
+    // drop what doesn't fit, the handlers check the length
+    while (kept < length) {
+        uint8_t drop;
+        seph_read(&drop, 1);
+        length--;
+    }
+    seph_status_sent = false;
+    return MIN(maxlength, sizeof(header) + kept);
+}
+
+/*
+ * The OS services used by the IO and UX code of the SDK.
+ */
+try_context_t *try_context_get(void)
+{
+    return seph_try_context;
+}
+
+try_context_t *try_context_set(try_context_t *context)
+{
+    try_context_t *previous = seph_try_context;
+
+    seph_try_context = context;
+    return previous;
+}
+
+void os_longjmp(unsigned int exception)
+{
+    if (seph_try_context == NULL) {
+        fprintf(stderr, "uncaught exception 0x%04X\n", exception);
+        seph_exit(1);
+    }
+    longjmp(seph_try_context->jmp_buf, exception);
+}
+
+void halt(void)
+{
+    seph_exit(0);
+}
+
+void os_sched_exit(bolos_task_status_t exit_code)
+{
+    seph_exit(exit_code);
+}
+
+void *pic(void *linked_address)
+{
+    return linked_address;
+}
+
+unsigned int os_flags(void)
+{
+    return 0;
+}
+
+bolos_bool_t os_perso_isonboarded(void)
+{
+    return BOLOS_TRUE;
+}
+
+bolos_bool_t os_global_pin_is_validated(void)
+{
+    return BOLOS_TRUE;
+}
+
+bolos_bool_t os_sched_is_running(unsigned int task_idx)
+{
+    UNUSED(task_idx);
+    return BOLOS_FALSE;
+}
+
+// No other task runs on the host
+void os_sched_yield(bolos_task_status_t status)
+{
+    UNUSED(status);
+}
+
+// The dashboard UX never takes the hand over the app
+bolos_task_status_t os_sched_last_status(unsigned int task_idx)
+{
+    UNUSED(task_idx);
+    return BOLOS_UX_OK;
+}
+
+unsigned int os_ux(bolos_ux_params_t *params)
+{
+    UNUSED(params);
+    return 0;
+}
+
+// The NVM is plain RAM on the host
+void nvm_write(void *dst_adr, void *src_adr, unsigned int src_len)
+{
+    if (src_adr == NULL) {
+        memset(dst_adr, 0, src_len);
+    }
+    else {
+        memmove(dst_adr, src_adr, src_len);
+    }
+}
+
+unsigned int os_registry_get_current_app_tag(unsigned int tag, unsigned char *buffer,
+                                             unsigned int maxlen)
+{
+    const char  *value;
+    unsigned int length;
+
+    switch (tag) {
+        case BOLOS_TAG_APPNAME:
+            value = APPNAME;
+            break;
+        case BOLOS_TAG_APPVERSION:
+            value = APPVERSION;
+            break;
+        default:
+            return 0;
+    }
+    length = MIN(strlen(value), maxlen);
+    memcpy(buffer, value, length);
+    return length;
+}
+
+// Overridden by the cx host backend when it is linked too
+__attribute__((weak)) void cx_rng_no_throw(uint8_t *buffer, size_t len)
+{
+    FILE *f = fopen("/dev/urandom", "rb");
+
+    if ((f == NULL) || (fread(buffer, 1, len, f) != len)) {
+        abort();
+    }
+    fclose(f);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+/**
+ * Environment variable naming the Unix socket of the MCU simulator, used when
+ * no path is given to the app.
+ */
+#define SEPH_HOST_SOCKET_ENV "SEPH_HOST_SOCKET"
+
+/**
+ * @brief   Connects the SEPROXYHAL of the app to the MCU simulator.
+ *
+ * @details Once connected, io_seph_send(), io_seph_recv() and
+ *          io_seph_is_status_sent() exchange the SEPROXYHAL packets over the
+ *          socket. The app exits when the simulator closes the connection, as
+ *          a device would be unplugged.
+ *
+ * @param[in] path Path of the Unix socket the simulator is listening on.
+ *
+ * @return  0 on success, -1 on error with errno set.
+ */
+int seph_host_connect(const char *path);
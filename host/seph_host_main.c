@@ -0,0 +1,69 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include <stdio.h>   // fprintf, perror
+#include <stdlib.h>  // getenv
+
+#include "os.h"
+#include "io.h"
+#include "seph_host.h"
+
+ux_state_t        G_ux;
+bolos_ux_params_t G_ux_params;
+
+/*
+ * Entry point of the app on the host, in place of the one of lib_standard_app:
+ * the app is started once connected to the MCU simulator, and runs until the
+ * simulator ends the session.
+ */
+int main(int argc, char *argv[])
+{
+    const char *path = (argc > 1) ? argv[1] : getenv(SEPH_HOST_SOCKET_ENV);
+
+    if (path == NULL) {
+        fprintf(stderr, "usage: %s <socket>, or set %s\n", argv[0], SEPH_HOST_SOCKET_ENV);
+        return 2;
+    }
+    if (seph_host_connect(path) != 0) {
+        perror(path);
+        return 1;
+    }
+
+    try_context_set(NULL);
+
+    BEGIN_TRY
+    {
+        TRY
+        {
+            UX_INIT();
+
+            io_seproxyhal_init();
+
+            USB_power(0);
+            USB_power(1);
+
+            app_main();
+        }
+        CATCH_OTHER(e)
+        {
+            fprintf(stderr, "Exiting following exception: 0x%04X\n", e);
+            return 1;
+        }
+        FINALLY {}
+    }
+    END_TRY;
+
+    return 0;
+}
@@ -0,0 +1,1081 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * MCU simulator of the SEPROXYHAL protocol, for apps built with the seph_host
+ * library. It plays a script of APDUs and button presses, as USB HID frames or
+ * CCID messages and button events, acknowledges the USB transfers and the
+ * display statuses, and sends a ticker event whenever the app waits with nothing
+ * else to process.
+ *
+ * usage: seph_mcu_sim [-n <count>] [-d <display log>] [-b] [-v] <script> <app> [args]
+ *        seph_mcu_sim [-n <count>] [-d <display log>] [-b] [-v] -s <socket> <script>
+ *
+ * With -b, the app is expected to batch its display statuses (HAVE_DISPLAY_BATCH),
+ * and the run fails if no SCREEN_DISPLAY_BATCH_STATUS is received.
+ *
+ * Script lines, '#' starting a comment:
+ *   apdu <hex> [<hex>]   send an APDU, wait for its reply and check it if given
+ *   send <hex>           send an APDU without waiting for its reply
+ *   ccid <hex> [<hex>]   send an APDU in CCID XfrBlock messages, chained if longer
+ *                        than a block, wait for its reply and check it if given
+ *   ccidfirst <hex> [<hex>]
+ *                        same, but only fetch the first block of the reply
+ *   ccidsend <hex> [<hex>]
+ *                        same, without waiting for its reply, checked if given
+ *   ccidempty            send an empty block requesting the next block of a reply,
+ *                        and check that it is refused, no reply being pending
+ *   ccidbusy <hex>       send an APDU in a CCID XfrBlock message, and check that it
+ *                        is refused, the reply of the previous one being pending
+ *   ccidstatus           send a CCID GetSlotStatus message, dropping the reply
+ *                        pending, and wait for the slot status
+ *   reply                wait for the replies of the APDUs sent
+ *   button left|right|both
+ *                        press and release buttons
+ *   ticker [<count>]     send ticker events, 1 by default
+ *   screen <text>        wait for a displayed element containing the text
+ */
+#include <errno.h>       // errno
+#include <getopt.h>      // getopt
+#include <poll.h>        // poll
+#include <signal.h>      // signal
+#include <stdbool.h>     // bool
+#include <stdint.h>      // uint*_t
+#include <stdio.h>       // FILE, fprintf, fgets
+#include <stdlib.h>      // exit, strtoul, mkdtemp
+#include <string.h>      // memcpy, strstr
+#include <sys/socket.h>  // socket, bind, listen, accept
+#include <sys/un.h>      // sockaddr_un
+#include <sys/wait.h>    // waitpid
+#include <time.h>        // clock_gettime
+#include <unistd.h>      // read, write, fork, execvp
+
+#include "bagl.h"
+#include "os_math.h"
+#include "os_utils.h"
+#include "seproxyhal_protocol.h"
+#include "seph_host.h"
+
+#define SIM_APDU_MAX       4096
+#define SIM_HID_REPORT     64
+#define SIM_HID_CHANNEL    0x0101
+#define SIM_HID_TAG_APDU   0x05
+#define SIM_HID_EP_OUT     0x02
+#define SIM_HID_EP_IN      0x82
+#define SIM_CCID_PACKET    64
+#define SIM_CCID_EP_OUT    0x03
+#define SIM_CCID_EP_IN     0x83
+#define SIM_CCID_HEADER    10
+#define SIM_CCID_BLOCK_MAX 261  // dwMaxCCIDMessageLength - 10
+#define SIM_CCID_XFRBLOCK  0x6F
+#define SIM_CCID_GETSTATUS 0x65
+#define SIM_CCID_DATABLOCK 0x80
+#define SIM_CCID_STATUS    0x81
+#define SIM_CCID_FAILED    0x40  // bmCommandStatus of bStatus
+#define SIM_CCID_BUSY      0xE0  // bError of a slot busy
+#define SIM_EVENT_MAX      (3 + 3 + SIM_HID_REPORT)
+#define SIM_QUEUE_SIZE     128
+#define SIM_PACKET_MAX     (3 + 0xFFFF)
+#define SIM_IDLE_MAX       6000  // 10 minutes of the device time, waiting for the app
+#define SIM_BUTTON_LEFT    0x01
+#define SIM_BUTTON_RIGHT   0x02
+
+typedef enum {
+    ACTION_APDU,
+    ACTION_SEND,
+    ACTION_CCID,
+    ACTION_CCID_FIRST,
+    ACTION_CCID_SEND,
+    ACTION_CCID_EMPTY,
+    ACTION_CCID_BUSY,
+    ACTION_CCID_STATUS,
+    ACTION_REPLY,
+    ACTION_BUTTON,
+    ACTION_TICKER,
+    ACTION_SCREEN,
+} action_kind_t;
+
+typedef struct {
+    action_kind_t kind;
+    unsigned int  line;
+    uint8_t       data[SIM_APDU_MAX];  // APDU
+    size_t        length;
+    uint8_t       expected[SIM_APDU_MAX];  // expected reply, if any
+    size_t        expected_length;
+    bool          check;
+    unsigned int  count;     // buttons mask or tickers count
+    char          text[64];  // displayed text
+} action_t;
+
+typedef struct {
+    uint8_t data[SIM_EVENT_MAX];
+    size_t  length;
+    bool    apdu_start;  // first frame of an APDU
+} event_t;
+
+typedef struct {
+    const action_t *action;
+    uint64_t        start_ns;
+} pending_t;
+
+static action_t    *actions;
+static size_t       actions_count;
+static FILE        *display_log;
+static bool         expect_batches;
+static bool         verbose;
+static int          sim_fd = -1;
+static unsigned int failures;
+
+// Events to be sent, one per status of the SE
+static event_t      queue[SIM_QUEUE_SIZE];
+static size_t       queue_head;
+static size_t       queue_count;
+static bool         display_ack;
+static bool         display_new;
+static uint8_t      in_acks[8];
+static size_t       in_acks_count;
+
+// APDUs waiting for their reply, and reply being received
+static pending_t    pending[SIM_QUEUE_SIZE];
+static size_t       pending_head;
+static size_t       pending_count;
+static uint8_t      reply[SIM_APDU_MAX];
+static size_t       reply_length;
+static size_t       reply_offset;
+static uint16_t     reply_seq;
+
+// CCID command being sent in blocks, and message being received
+static const action_t *ccid_command;
+static size_t          ccid_command_offset;
+static uint8_t         ccid_seq;
+static uint8_t         ccid_message[SIM_CCID_HEADER + SIM_CCID_BLOCK_MAX];
+static size_t          ccid_message_length;
+// Empty block, refused APDU or GetSlotStatus sent, replied before the APDUs pending
+static const action_t *ccid_other;
+
+// Script progress
+static size_t       pc;
+static unsigned int repeat = 1;
+static bool         waiting_reply;
+static const char  *waiting_text;
+static char         screen_text[1024];
+static size_t       screen_length;
+static unsigned int idle_tickers;
+static uint32_t     ms;
+
+// Statistics
+static unsigned long stat_statuses;
+static unsigned long stat_tickers;
+static unsigned long stat_displays;
+static unsigned long stat_batches;
+static unsigned long stat_elements;
+static unsigned long stat_apdus;
+static uint64_t      stat_rtt_total;
+static uint64_t      stat_rtt_min = UINT64_MAX;
+static uint64_t      stat_rtt_max;
+static uint64_t      stat_bytes;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+}
+
+static void print_hex(FILE *out, const char *prefix, const uint8_t *data, size_t length)
+{
+    fprintf(out, "%s", prefix);
+    for (size_t i = 0; i < length; i++) {
+        fprintf(out, "%02x", data[i]);
+    }
+    fprintf(out, "\n");
+}
+
+static bool parse_hex(const char *hex, uint8_t *out, size_t max, size_t *length)
+{
+    size_t l = strlen(hex);
+
+    if ((l % 2) || (l / 2 > max)) {
+        return false;
+    }
+    for (size_t i = 0; i < l / 2; i++) {
+        char byte[3] = {hex[2 * i], hex[2 * i + 1], 0};
+        char *end;
+
+        out[i] = strtoul(byte, &end, 16);
+        if (*end != 0) {
+            return false;
+        }
+    }
+    *length = l / 2;
+    return true;
+}
+
+static void load_script(const char *path)
+{
+    FILE        *f = fopen(path, "r");
+    char         line[4 * SIM_APDU_MAX + 64];
+    unsigned int number = 0;
+
+    if (f == NULL) {
+        perror(path);
+        exit(2);
+    }
+    while (fgets(line, sizeof(line), f) != NULL) {
+        char    *word, *arg, *arg2;
+        action_t action = {.line = ++number};
+        bool     ok     = true;
+
+        line[strcspn(line, "#\r\n")] = 0;
+        word = strtok(line, " \t");
+        if (word == NULL) {
+            continue;
+        }
+        arg  = strtok(NULL, " \t");
+        arg2 = strtok(NULL, "");
+        if (!strcmp(word, "apdu") || !strcmp(word, "send") || !strcmp(word, "ccid")
+            || !strcmp(word, "ccidfirst") || !strcmp(word, "ccidsend")
+            || !strcmp(word, "ccidbusy")) {
+            action.kind = !strcmp(word, "apdu")        ? ACTION_APDU
+                          : !strcmp(word, "send")      ? ACTION_SEND
+                          : !strcmp(word, "ccid")      ? ACTION_CCID
+                          : !strcmp(word, "ccidfirst") ? ACTION_CCID_FIRST
+                          : !strcmp(word, "ccidsend")  ? ACTION_CCID_SEND
+                                                       : ACTION_CCID_BUSY;
+            ok          = (arg != NULL) && parse_hex(arg, action.data, SIM_APDU_MAX, &action.length)
+                 && (action.length >= 4);
+            if (ok && (arg2 != NULL)) {
+                arg2 += strspn(arg2, " \t");
+                arg2[strcspn(arg2, " \t")] = 0;
+                action.check               = true;
+                ok = parse_hex(arg2, action.expected, SIM_APDU_MAX, &action.expected_length);
+            }
+        }
+        else if (!strcmp(word, "ccidempty")) {
+            action.kind = ACTION_CCID_EMPTY;
+        }
+        else if (!strcmp(word, "ccidstatus")) {
+            action.kind = ACTION_CCID_STATUS;
+        }
+        else if (!strcmp(word, "reply")) {
+            action.kind = ACTION_REPLY;
+        }
+        else if (!strcmp(word, "button")) {
+            action.kind  = ACTION_BUTTON;
+            action.count = (arg == NULL)              ? 0
+                           : !strcmp(arg, "left")  ? SIM_BUTTON_LEFT
+                           : !strcmp(arg, "right") ? SIM_BUTTON_RIGHT
+                           : !strcmp(arg, "both")  ? SIM_BUTTON_LEFT | SIM_BUTTON_RIGHT
+                                                   : 0;
+            ok           = (action.count != 0);
+        }
+        else if (!strcmp(word, "ticker")) {
+            action.kind  = ACTION_TICKER;
+            action.count = (arg != NULL) ? strtoul(arg, NULL, 0) : 1;
+        }
+        else if (!strcmp(word, "screen")) {
+            action.kind = ACTION_SCREEN;
+            ok          = (arg != NULL);
+            if (ok) {
+                snprintf(action.text,
+                         sizeof(action.text),
+                         "%s%s%s",
+                         arg,
+                         (arg2 != NULL) ? " " : "",
+                         (arg2 != NULL) ? arg2 : "");
+            }
+        }
+        else {
+            ok = false;
+        }
+        if (!ok) {
+            fprintf(stderr, "%s:%u: invalid action\n", path, number);
+            exit(2);
+        }
+        actions = realloc(actions, (actions_count + 1) * sizeof(action_t));
+        actions[actions_count++] = action;
+    }
+    fclose(f);
+}
+
+static event_t *queue_push(void)
+{
+    event_t *event;
+
+    if (queue_count == SIM_QUEUE_SIZE) {
+        fprintf(stderr, "too many events queued\n");
+        exit(1);
+    }
+    event = &queue[(queue_head + queue_count++) % SIM_QUEUE_SIZE];
+    memset(event, 0, sizeof(*event));
+    return event;
+}
+
+static void queue_event(uint8_t tag, const uint8_t *data, size_t length)
+{
+    event_t *event = queue_push();
+
+    event->data[0] = tag;
+    event->data[1] = length >> 8;
+    event->data[2] = length;
+    memcpy(event->data + 3, data, length);
+    event->length = 3 + length;
+}
+
+static void queue_usb_setup(const uint8_t setup[8])
+{
+    uint8_t data[3 + 8] = {0x00, SEPROXYHAL_TAG_USB_EP_XFER_SETUP, 8};
+
+    memcpy(data + 3, setup, 8);
+    queue_event(SEPROXYHAL_TAG_USB_EP_XFER_EVENT, data, sizeof(data));
+}
+
+static void pending_push(const action_t *action)
+{
+    if (pending_count == SIM_QUEUE_SIZE) {
+        fprintf(stderr, "too many APDUs pending\n");
+        exit(1);
+    }
+    pending[(pending_head + pending_count) % SIM_QUEUE_SIZE]
+        = (pending_t){.action = action, .start_ns = 0};
+    pending_count++;
+}
+
+static void queue_apdu(const action_t *action)
+{
+    uint16_t seq    = 0;
+    size_t   offset = 0;
+
+    pending_push(action);
+
+    // Ledger HID framing, as for a host library
+    do {
+        event_t *event  = queue_push();
+        uint8_t *report = event->data + 6;
+        size_t   l      = 0;
+
+        event->data[0] = SEPROXYHAL_TAG_USB_EP_XFER_EVENT;
+        event->data[1] = 0;
+        event->data[2] = 3 + SIM_HID_REPORT;
+        event->data[3] = SIM_HID_EP_OUT;
+        event->data[4] = SEPROXYHAL_TAG_USB_EP_XFER_OUT;
+        event->data[5] = SIM_HID_REPORT;
+        event->length  = 6 + SIM_HID_REPORT;
+        event->apdu_start = (seq == 0);
+
+        report[l++] = SIM_HID_CHANNEL >> 8;
+        report[l++] = SIM_HID_CHANNEL & 0xFF;
+        report[l++] = SIM_HID_TAG_APDU;
+        report[l++] = seq >> 8;
+        report[l++] = seq;
+        if (seq == 0) {
+            report[l++] = action->length >> 8;
+            report[l++] = action->length;
+        }
+        size_t chunk = SIM_HID_REPORT - l;
+        if (chunk > action->length - offset) {
+            chunk = action->length - offset;
+        }
+        memcpy(report + l, action->data + offset, chunk);
+        offset += chunk;
+        seq++;
+    } while (offset < action->length);
+}
+
+/*
+ * Queues a CCID message, in bulk packets.
+ */
+static void queue_ccid_message(uint8_t        type,
+                               const uint8_t *data,
+                               size_t         length,
+                               uint8_t        level,
+                               bool           apdu_start)
+{
+    uint8_t header[SIM_CCID_HEADER] = {type};
+    size_t  total                   = SIM_CCID_HEADER + length;
+    size_t  offset                  = 0;
+
+    U4LE_ENCODE(header, 1, length);
+    header[6] = ccid_seq++;
+    header[8] = level;  // wLevelParameter
+
+    do {
+        event_t *event  = queue_push();
+        uint8_t *packet = event->data + 6;
+        size_t   l      = MIN(total - offset, SIM_CCID_PACKET);
+
+        event->data[0] = SEPROXYHAL_TAG_USB_EP_XFER_EVENT;
+        event->data[1] = 0;
+        event->data[2] = 3 + l;
+        event->data[3] = SIM_CCID_EP_OUT;
+        event->data[4] = SEPROXYHAL_TAG_USB_EP_XFER_OUT;
+        event->data[5] = l;
+        event->length  = 6 + l;
+        event->apdu_start = apdu_start && (offset == 0);
+
+        for (size_t i = 0; i < l; i++, offset++) {
+            packet[i] = (offset < SIM_CCID_HEADER) ? header[offset]
+                                                   : data[offset - SIM_CCID_HEADER];
+        }
+    } while (offset < total);
+}
+
+static void queue_ccid_block(const uint8_t *data, size_t length, uint8_t level, bool apdu_start)
+{
+    queue_ccid_message(SIM_CCID_XFRBLOCK, data, length, level, apdu_start);
+}
+
+/*
+ * Queues the next block of the CCID command, the blocks after the first one
+ * being requested by the reader with an empty block.
+ */
+static void queue_ccid_command(void)
+{
+    const action_t *action = ccid_command;
+    size_t          offset = ccid_command_offset;
+    size_t          length = MIN(action->length - offset, SIM_CCID_BLOCK_MAX);
+    bool            end    = (offset + length == action->length);
+    uint8_t         level;
+
+    if (offset == 0) {
+        level = end ? 0x00 : 0x01;
+    }
+    else {
+        level = end ? 0x02 : 0x03;
+    }
+    queue_ccid_block(action->data + offset, length, level, offset == 0);
+    ccid_command_offset += length;
+}
+
+static void queue_ccid(const action_t *action)
+{
+    pending_push(action);
+    ccid_command        = action;
+    ccid_command_offset = 0;
+    reply_length        = 0;
+    queue_ccid_command();
+}
+
+static void apdu_replied(void)
+{
+    pending_t      *p      = &pending[pending_head];
+    const action_t *action = p->action;
+    uint64_t        rtt    = now_ns() - p->start_ns;
+
+    pending_head = (pending_head + 1) % SIM_QUEUE_SIZE;
+    pending_count--;
+
+    stat_apdus++;
+    stat_bytes += action->length + reply_length;
+    stat_rtt_total += rtt;
+    stat_rtt_min = (rtt < stat_rtt_min) ? rtt : stat_rtt_min;
+    stat_rtt_max = (rtt > stat_rtt_max) ? rtt : stat_rtt_max;
+
+    if (verbose) {
+        print_hex(stdout, "=> ", action->data, action->length);
+        print_hex(stdout, "<= ", reply, reply_length);
+    }
+    if (action->check
+        && ((reply_length != action->expected_length)
+            || memcmp(reply, action->expected, reply_length))) {
+        fprintf(stderr, "line %u: unexpected reply ", action->line);
+        print_hex(stderr, "", reply, reply_length);
+        failures++;
+    }
+}
+
+static void hid_report_sent(const uint8_t *report, size_t length)
+{
+    size_t l = 5;
+
+    if ((length < l) || (U2BE(report, 0) != SIM_HID_CHANNEL) || (report[2] != SIM_HID_TAG_APDU)) {
+        return;
+    }
+    if (U2BE(report, 3) == 0) {
+        if (length < l + 2) {
+            return;
+        }
+        reply_length = U2BE(report, 5);
+        reply_offset = 0;
+        reply_seq    = 0;
+        l += 2;
+    }
+    if ((pending_count == 0) || (U2BE(report, 3) != reply_seq) || (reply_length > SIM_APDU_MAX)) {
+        fprintf(stderr, "unexpected HID report\n");
+        failures++;
+        return;
+    }
+    reply_seq++;
+    length -= l;
+    if (length > reply_length - reply_offset) {
+        length = reply_length - reply_offset;
+    }
+    memcpy(reply + reply_offset, report + l, length);
+    reply_offset += length;
+    if (reply_offset == reply_length) {
+        apdu_replied();
+    }
+}
+
+static void ccid_block_received(void)
+{
+    size_t          length = ccid_message_length - SIM_CCID_HEADER;
+    const action_t *action = (pending_count != 0) ? pending[pending_head].action : NULL;
+
+    if (ccid_other != NULL) {
+        bool failed = (ccid_message[7] & SIM_CCID_FAILED) != 0;
+
+        if ((ccid_other->kind == ACTION_CCID_STATUS)
+                ? ((ccid_message[0] != SIM_CCID_STATUS) || failed)
+                : ((ccid_message[0] != SIM_CCID_DATABLOCK) || !failed
+                   || ((ccid_other->kind == ACTION_CCID_BUSY)
+                       && (ccid_message[8] != SIM_CCID_BUSY)))) {
+            fprintf(stderr,
+                    "line %u: unexpected CCID message %02x, status %02x, error %02x\n",
+                    ccid_other->line,
+                    ccid_message[0],
+                    ccid_message[7],
+                    ccid_message[8]);
+            failures++;
+        }
+        ccid_other = NULL;
+        return;
+    }
+    if ((action == NULL)
+        || ((action->kind != ACTION_CCID) && (action->kind != ACTION_CCID_FIRST)
+            && (action->kind != ACTION_CCID_SEND))
+        || (ccid_message[0] != SIM_CCID_DATABLOCK)) {
+        fprintf(stderr, "unexpected CCID message\n");
+        failures++;
+        return;
+    }
+    if (ccid_message[7] & SIM_CCID_FAILED) {
+        fprintf(stderr, "line %u: CCID error %02x\n", action->line, ccid_message[8]);
+        failures++;
+        reply_length = 0;
+        apdu_replied();
+        return;
+    }
+    if (reply_length + length > SIM_APDU_MAX) {
+        fprintf(stderr, "CCID reply too long\n");
+        exit(1);
+    }
+    memcpy(reply + reply_length, ccid_message + SIM_CCID_HEADER, length);
+    reply_length += length;
+
+    // bChainParameter
+    switch (ccid_message[9]) {
+        case 0x10:
+            queue_ccid_command();
+            break;
+        case 0x01:
+        case 0x03:
+            if (action->kind == ACTION_CCID_FIRST) {
+                apdu_replied();
+                break;
+            }
+            queue_ccid_block(NULL, 0, 0x10, false);
+            break;
+        default:
+            apdu_replied();
+            break;
+    }
+}
+
+static void ccid_packet_sent(const uint8_t *packet, size_t length)
+{
+    size_t total;
+
+    // zero length packet ending a message multiple of the packet size
+    if ((ccid_message_length == 0) && (length == 0)) {
+        return;
+    }
+    if (ccid_message_length + length > sizeof(ccid_message)) {
+        fprintf(stderr, "CCID message too long\n");
+        exit(1);
+    }
+    memcpy(ccid_message + ccid_message_length, packet, length);
+    ccid_message_length += length;
+    if (ccid_message_length < SIM_CCID_HEADER) {
+        return;
+    }
+    total = SIM_CCID_HEADER + U4LE(ccid_message, 1);
+    if (ccid_message_length >= total) {
+        ccid_message_length = total;
+        ccid_block_received();
+        ccid_message_length = 0;
+    }
+}
+
+static void display_element(const uint8_t *data, size_t length)
+{
+    bagl_component_t component;
+    char             text[256];
+
+    // the layout of the components is the same as on the device
+    if (length < sizeof(component)) {
+        return;
+    }
+    memcpy(&component, data, sizeof(component));
+    length -= sizeof(component);
+    stat_elements++;
+    // the icons are followed by their bitmap
+    if ((component.type & ~BAGL_FLAG_TOUCHABLE) == BAGL_ICON) {
+        length = 0;
+    }
+    length = MIN(length, sizeof(text) - 1);
+    memcpy(text, data + sizeof(component), length);
+    text[length] = 0;
+    if (display_log != NULL) {
+        fprintf(display_log,
+                "%u %d %d %u %u %s\n",
+                component.type,
+                component.x,
+                component.y,
+                component.width,
+                component.height,
+                text);
+    }
+    // the texts of the screen, drawn in a row of display statuses
+    if (display_new) {
+        display_new   = false;
+        screen_length = 0;
+    }
+    length = MIN(length, sizeof(screen_text) - 1 - screen_length);
+    memcpy(screen_text + screen_length, text, length);
+    screen_length += length;
+    screen_text[screen_length] = 0;
+    if (screen_length < sizeof(screen_text) - 1) {
+        screen_text[screen_length++] = '\n';
+        screen_text[screen_length]   = 0;
+    }
+}
+
+static void process_packet(const uint8_t *packet, size_t length)
+{
+    const uint8_t *data = packet + 3;
+
+    length -= 3;
+    switch (packet[0]) {
+        case SEPROXYHAL_TAG_USB_EP_PREPARE:
+            if ((length >= 3) && (data[1] == SEPROXYHAL_TAG_USB_EP_PREPARE_DIR_IN)) {
+                if (data[0] == SIM_HID_EP_IN) {
+                    hid_report_sent(data + 3, length - 3);
+                }
+                else if (data[0] == SIM_CCID_EP_IN) {
+                    ccid_packet_sent(data + 3, length - 3);
+                }
+                if (in_acks_count < sizeof(in_acks)) {
+                    in_acks[in_acks_count++] = data[0];
+                }
+            }
+            break;
+
+        case SEPROXYHAL_TAG_SCREEN_DISPLAY_STATUS:
+            stat_displays++;
+            display_element(data, length);
+            display_ack = true;
+            break;
+
+#ifdef SEPROXYHAL_TAG_SCREEN_DISPLAY_BATCH_STATUS
+        case SEPROXYHAL_TAG_SCREEN_DISPLAY_BATCH_STATUS:
+            stat_displays++;
+            stat_batches++;
+            for (size_t offset = 0; offset + 2 <= length;) {
+                size_t l = U2BE(data, offset);
+                offset += 2;
+                if (offset + l > length) {
+                    break;
+                }
+                display_element(data + offset, l);
+                offset += l;
+            }
+            display_ack = true;
+            break;
+#endif  // SEPROXYHAL_TAG_SCREEN_DISPLAY_BATCH_STATUS
+
+        default:
+            break;
+    }
+}
+
+static void queue_ticker(void)
+{
+    uint8_t data[4];
+
+    ms += 100;
+    data[0] = ms >> 24;
+    data[1] = ms >> 16;
+    data[2] = ms >> 8;
+    data[3] = ms;
+    queue_event(SEPROXYHAL_TAG_TICKER_EVENT, data, sizeof(data));
+    stat_tickers++;
+}
+
+/*
+ * Runs the script until an event is queued, returns false at its end.
+ */
+static bool script_step(void)
+{
+    while (queue_count == 0) {
+        if (waiting_reply && (pending_count == 0)) {
+            waiting_reply = false;
+        }
+        if ((waiting_text != NULL) && (strstr(screen_text, waiting_text) != NULL)) {
+            waiting_text = NULL;
+        }
+        if (waiting_reply || (waiting_text != NULL) || (ccid_other != NULL)) {
+            if (++idle_tickers > SIM_IDLE_MAX) {
+                fprintf(stderr, "line %u: timeout\n", actions[pc - 1].line);
+                failures++;
+                return false;
+            }
+            queue_ticker();
+            break;
+        }
+        idle_tickers = 0;
+        if (pc == actions_count) {
+            if (--repeat == 0) {
+                return false;
+            }
+            pc = 0;
+        }
+
+        const action_t *action = &actions[pc++];
+        switch (action->kind) {
+            case ACTION_APDU:
+                queue_apdu(action);
+                waiting_reply = true;
+                break;
+            case ACTION_SEND:
+                queue_apdu(action);
+                break;
+            case ACTION_CCID:
+            case ACTION_CCID_FIRST:
+                queue_ccid(action);
+                waiting_reply = true;
+                break;
+            case ACTION_CCID_SEND:
+                queue_ccid(action);
+                break;
+            case ACTION_CCID_EMPTY:
+                ccid_other = action;
+                queue_ccid_block(NULL, 0, 0x10, false);
+                break;
+            case ACTION_CCID_BUSY:
+                ccid_other = action;
+                queue_ccid_block(action->data, MIN(action->length, SIM_CCID_BLOCK_MAX), 0, false);
+                break;
+            case ACTION_CCID_STATUS:
+                ccid_other = action;
+                queue_ccid_message(SIM_CCID_GETSTATUS, NULL, 0, 0, false);
+                break;
+            case ACTION_REPLY:
+                waiting_reply = true;
+                break;
+            case ACTION_BUTTON: {
+                uint8_t mask = action->count << 1;
+                queue_event(SEPROXYHAL_TAG_BUTTON_PUSH_EVENT, &mask, 1);
+                mask = 0;
+                queue_event(SEPROXYHAL_TAG_BUTTON_PUSH_EVENT, &mask, 1);
+                break;
+            }
+            case ACTION_TICKER:
+                for (unsigned int i = 0; i < action->count; i++) {
+                    queue_ticker();
+                }
+                break;
+            case ACTION_SCREEN:
+                waiting_text = action->text;
+                break;
+        }
+    }
+    return true;
+}
+
+static void sim_write(const uint8_t *data, size_t length)
+{
+    while (length > 0) {
+        ssize_t written = write(sim_fd, data, length);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            fprintf(stderr, "app disconnected\n");
+            exit(1);
+        }
+        data += written;
+        length -= written;
+    }
+}
+
+static bool sim_read(uint8_t *data, size_t length)
+{
+    while (length > 0) {
+        ssize_t received = read(sim_fd, data, length);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        data += received;
+        length -= received;
+    }
+    return true;
+}
+
+/*
+ * Replies to a status of the SE with one event, returns false at the end.
+ */
+static bool send_event(void)
+{
+    uint8_t event[6];
+
+    if (display_ack) {
+        display_ack = false;
+        event[0]    = SEPROXYHAL_TAG_DISPLAY_PROCESSED_EVENT;
+        event[1]    = 0;
+        event[2]    = 0;
+        sim_write(event, 3);
+        return true;
+    }
+    if (in_acks_count > 0) {
+        event[0] = SEPROXYHAL_TAG_USB_EP_XFER_EVENT;
+        event[1] = 0;
+        event[2] = 3;
+        event[3] = in_acks[0];
+        event[4] = SEPROXYHAL_TAG_USB_EP_XFER_IN;
+        event[5] = 0;
+        memmove(in_acks, in_acks + 1, --in_acks_count);
+        sim_write(event, 6);
+        return true;
+    }
+    if (!script_step()) {
+        return false;
+    }
+    display_new = true;
+
+    event_t *e = &queue[queue_head];
+    queue_head = (queue_head + 1) % SIM_QUEUE_SIZE;
+    queue_count--;
+    if (e->apdu_start) {
+        // APDUs are replied in order
+        for (size_t i = 0; i < pending_count; i++) {
+            pending_t *p = &pending[(pending_head + i) % SIM_QUEUE_SIZE];
+            if (p->start_ns == 0) {
+                p->start_ns = now_ns();
+                break;
+            }
+        }
+    }
+    sim_write(e->data, e->length);
+    return true;
+}
+
+static int run(void)
+{
+    static uint8_t    packet[SIM_PACKET_MAX];
+    static const uint8_t reset[]             = {SEPROXYHAL_TAG_USB_EVENT_RESET};
+    static const uint8_t set_address[8]      = {0x00, 0x05, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00};
+    static const uint8_t set_configuration[8] = {0x00, 0x09, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00};
+    uint64_t             start = now_ns();
+
+    // enumeration, as done by the host when the device is plugged
+    queue_event(SEPROXYHAL_TAG_USB_EVENT, reset, sizeof(reset));
+    queue_usb_setup(set_address);
+    queue_usb_setup(set_configuration);
+
+    for (;;) {
+        size_t length;
+
+        if (!sim_read(packet, 3)) {
+            fprintf(stderr, "app disconnected\n");
+            return 1;
+        }
+        length = U2BE(packet, 1);
+        if (!sim_read(packet + 3, length)) {
+            fprintf(stderr, "app disconnected\n");
+            return 1;
+        }
+        process_packet(packet, 3 + length);
+        // 011x xxxx: the turn of the MCU
+        if ((packet[0] & 0xE0) == 0x60) {
+            stat_statuses++;
+            if (!send_event()) {
+                break;
+            }
+        }
+    }
+
+    uint64_t elapsed = now_ns() - start;
+    printf("elapsed %.3f ms, %lu statuses, %lu tickers\n",
+           elapsed / 1e6,
+           stat_statuses,
+           stat_tickers);
+    printf("display: %lu statuses (%lu batched), %lu elements\n",
+           stat_displays,
+           stat_batches,
+           stat_elements);
+    if (expect_batches && (stat_batches == 0)) {
+        fprintf(stderr, "no batched display status\n");
+        failures++;
+    }
+    if (stat_apdus > 0) {
+        printf("apdu: %lu round trips, avg %.1f us, min %.1f us, max %.1f us, %.1f kB/s\n",
+               stat_apdus,
+               stat_rtt_total / 1e3 / stat_apdus,
+               stat_rtt_min / 1e3,
+               stat_rtt_max / 1e3,
+               stat_bytes * 1e6 / stat_rtt_total);
+    }
+    return (failures == 0) ? 0 : 1;
+}
+
+static int listen_on(const char *path)
+{
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    int                fd;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "%s: path too long\n", path);
+        exit(2);
+    }
+    strcpy(addr.sun_path, path);
+    unlink(path);
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if ((fd < 0) || (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0)
+        || (listen(fd, 1) < 0)) {
+        perror(path);
+        exit(2);
+    }
+    return fd;
+}
+
+static int accept_app(int listen_fd, pid_t app)
+{
+    struct pollfd fds = {.fd = listen_fd, .events = POLLIN};
+
+    // don't wait forever for an app which failed to start
+    while (poll(&fds, 1, 100) == 0) {
+        if ((app > 0) && (waitpid(app, NULL, WNOHANG) == app)) {
+            fprintf(stderr, "app exited before connecting\n");
+            exit(1);
+        }
+    }
+    return accept(listen_fd, NULL, NULL);
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [-n <count>] [-d <display log>] [-b] [-v] <script> <app> [args]\n"
+            "       %s [-n <count>] [-d <display log>] [-b] [-v] -s <socket> <script>\n",
+            name,
+            name);
+    exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *socket_path = NULL;
+    char        dir[]       = "/tmp/seph_mcu_sim.XXXXXX";
+    char        path[sizeof(dir) + 16];
+    pid_t       app = -1;
+    int         listen_fd;
+    int         opt;
+    int         ret;
+
+    while ((opt = getopt(argc, argv, "+n:d:s:bv")) != -1) {
+        switch (opt) {
+            case 'n':
+                repeat = strtoul(optarg, NULL, 0);
+                break;
+            case 'd':
+                display_log = !strcmp(optarg, "-") ? stdout : fopen(optarg, "w");
+                if (display_log == NULL) {
+                    perror(optarg);
+                    return 2;
+                }
+                break;
+            case 's':
+                socket_path = optarg;
+                break;
+            case 'b':
+                expect_batches = true;
+                break;
+            case 'v':
+                verbose = true;
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if ((repeat == 0) || (optind >= argc) || ((socket_path == NULL) && (optind + 1 >= argc))) {
+        usage(argv[0]);
+    }
+    load_script(argv[optind]);
+    signal(SIGPIPE, SIG_IGN);
+
+    if (socket_path == NULL) {
+        if (mkdtemp(dir) == NULL) {
+            perror(dir);
+            return 2;
+        }
+        snprintf(path, sizeof(path), "%s/seph", dir);
+        socket_path = path;
+    }
+    listen_fd = listen_on(socket_path);
+
+    if (socket_path == path) {
+        app = fork();
+        if (app == 0) {
+            close(listen_fd);
+            setenv(SEPH_HOST_SOCKET_ENV, socket_path, 1);
+            execvp(argv[optind + 1], &argv[optind + 1]);
+            perror(argv[optind + 1]);
+            _exit(127);
+        }
+    }
+    sim_fd = accept_app(listen_fd, app);
+    close(listen_fd);
+    unlink(socket_path);
+    if (socket_path == path) {
+        rmdir(dir);
+    }
+    if (sim_fd < 0) {
+        perror("accept");
+        return 2;
+    }
+
+    ret = run();
+
+    // the app exits once disconnected
+    close(sim_fd);
+    if (app > 0) {
+        int status;
+        waitpid(app, &status, 0);
+        if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0)) {
+            fprintf(stderr, "app exited abnormally (status 0x%x)\n", status);
+            ret = 1;
+        }
+    }
+    if ((display_log != NULL) && (display_log != stdout)) {
+        fclose(display_log);
+    }
+    return ret;
+}
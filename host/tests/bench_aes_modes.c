@@ -0,0 +1,105 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * AES-128 CTR with cx_aes_ctr_update, against CTR built by hand with one
+ * cx_aes_enc_block call per block, and AES-128 GCM, from 64 bytes to 4 KB.
+ * The key loads in the AES engine are counted: one per cx_aes_enc_block call,
+ * one per cx_aes_ctr_update call, plus one for the hash key of GCM.
+ *
+ * usage: bench_aes_modes [<iterations>]
+ */
+#include "cx.h"
+#include "cx_test.h"
+
+#define MAX_LEN 4096
+
+static cx_aes_key_t key;
+static uint8_t      iv[CX_AES_BLOCK_SIZE];
+static uint8_t      in[MAX_LEN], out[MAX_LEN], expected[MAX_LEN];
+
+static void ctr_by_block(size_t len)
+{
+    uint8_t counter[CX_AES_BLOCK_SIZE], stream[CX_AES_BLOCK_SIZE];
+
+    memcpy(counter, iv, sizeof(counter));
+    for (size_t off = 0; off < len; off += CX_AES_BLOCK_SIZE) {
+        TEST_CHECK(cx_aes_enc_block(&key, counter, stream) == CX_OK);
+        for (size_t i = 0; (i < CX_AES_BLOCK_SIZE) && (off + i < len); i++) {
+            out[off + i] = in[off + i] ^ stream[i];
+        }
+        for (size_t i = CX_AES_BLOCK_SIZE; i-- > 0 && ++counter[i] == 0;) {
+        }
+    }
+}
+
+static void ctr_stream(size_t len)
+{
+    cx_aes_ctr_t ctx;
+
+    TEST_CHECK(cx_aes_ctr_init(&ctx, &key, iv) == CX_OK);
+    TEST_CHECK(cx_aes_ctr_update(&ctx, in, out, len) == CX_OK);
+}
+
+static void gcm(size_t len)
+{
+    cx_aes_gcm_t ctx;
+    uint8_t      tag[CX_AES_BLOCK_SIZE];
+
+    TEST_CHECK(cx_aes_gcm_init(&ctx, &key, CX_ENCRYPT, iv, 12) == CX_OK);
+    TEST_CHECK(cx_aes_gcm_update_aad(&ctx, iv, sizeof(iv)) == CX_OK);
+    TEST_CHECK(cx_aes_gcm_update(&ctx, in, out, len) == CX_OK);
+    TEST_CHECK(cx_aes_gcm_finish(&ctx, tag, sizeof(tag)) == CX_OK);
+}
+
+static void run(const char *name, void (*encrypt)(size_t), size_t len, unsigned long n)
+{
+    uint64_t start, loads;
+
+    cx_host_stats_reset();
+    encrypt(len);
+    loads = test_backend_calls_of("cx_aes_set_key_hw");
+    start = test_now_ns();
+    for (unsigned long i = 0; i < n; i++) {
+        encrypt(len);
+    }
+    printf("%-9s %5zu bytes %8.3f us %8.1f MB/s %4llu key loads\n",
+           name,
+           len,
+           (test_now_ns() - start) / 1e3 / n,
+           (double) len * n * 1e3 / (test_now_ns() - start),
+           (unsigned long long) loads);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long n = bench_iterations(argc, argv, 2000);
+    uint8_t       raw[16];
+
+    cx_rng_no_throw(raw, sizeof(raw));
+    cx_rng_no_throw(iv, sizeof(iv));
+    cx_rng_no_throw(in, sizeof(in));
+    TEST_CHECK(cx_aes_init_key_no_throw(raw, sizeof(raw), &key) == CX_OK);
+
+    for (size_t len = 64; len <= MAX_LEN; len *= 4) {
+        run("ctr block", ctr_by_block, len, n);
+        memcpy(expected, out, len);
+        run("ctr", ctr_stream, len, n);
+        TEST_CHECK(memcmp(expected, out, len) == 0);
+        run("gcm", gcm, len, n);
+    }
+    return test_end("bench_aes_modes");
+}
@@ -0,0 +1,104 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * Cycles per byte of ChaCha20, Poly1305 and ChaCha20-Poly1305, from 64 bytes
+ * to 4 KB. Unlike the other benchmarks, the code runs entirely in the SDK
+ * sources, so the ratios between the primitives carry over to a device, but
+ * not the cycle counts of the host. The cycles are read from the time stamp
+ * counter on x86, and derived from a 1 GHz clock elsewhere.
+ *
+ * usage: bench_chacha_poly [<iterations>]
+ */
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>  // __rdtsc
+#endif
+
+#include "cx.h"
+#include "cx_test.h"
+
+#define MAX_LEN 4096
+
+static uint8_t key[32], nonce[12], in[MAX_LEN], out[MAX_LEN];
+
+static uint64_t cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return test_now_ns();
+#endif
+}
+
+static void chacha20(size_t len)
+{
+    cx_chacha20_t ctx;
+
+    TEST_CHECK(cx_chacha20_init(&ctx, key, nonce, 1) == CX_OK);
+    TEST_CHECK(cx_chacha20_update(&ctx, in, out, len) == CX_OK);
+}
+
+static void poly1305(size_t len)
+{
+    cx_poly1305_t ctx;
+    uint8_t       tag[CX_POLY1305_TAG_SIZE];
+
+    TEST_CHECK(cx_poly1305_init(&ctx, key) == CX_OK);
+    TEST_CHECK(cx_poly1305_update(&ctx, in, len) == CX_OK);
+    TEST_CHECK(cx_poly1305_final(&ctx, tag) == CX_OK);
+}
+
+static void chachapoly(size_t len)
+{
+    cx_chachapoly_t ctx;
+    uint8_t         tag[CX_POLY1305_TAG_SIZE];
+
+    TEST_CHECK(cx_chachapoly_init(&ctx, key, CX_ENCRYPT, nonce) == CX_OK);
+    TEST_CHECK(cx_chachapoly_update_aad(&ctx, nonce, sizeof(nonce)) == CX_OK);
+    TEST_CHECK(cx_chachapoly_update(&ctx, in, out, len) == CX_OK);
+    TEST_CHECK(cx_chachapoly_finish(&ctx, tag) == CX_OK);
+}
+
+static void run(const char *name, void (*process)(size_t), size_t len, unsigned long n)
+{
+    uint64_t start;
+
+    process(len);
+    start = cycles();
+    for (unsigned long i = 0; i < n; i++) {
+        process(len);
+    }
+    printf("%-17s %5zu bytes %7.2f cycles/byte\n",
+           name,
+           len,
+           (double) (cycles() - start) / ((double) len * n));
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long n = bench_iterations(argc, argv, 2000);
+
+    cx_rng_no_throw(key, sizeof(key));
+    cx_rng_no_throw(nonce, sizeof(nonce));
+    cx_rng_no_throw(in, sizeof(in));
+
+    for (size_t len = 64; len <= MAX_LEN; len *= 4) {
+        run("chacha20", chacha20, len, n);
+        run("poly1305", poly1305, len, n);
+        run("chacha20-poly1305", chachapoly, len, n);
+    }
+    return test_end("bench_chacha_poly");
+}
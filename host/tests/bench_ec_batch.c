@@ -0,0 +1,105 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * Batch sizes from 1 to CX_EC_BATCH_MAX_SIZE (set with the CMake variable of
+ * the same name), against one cx_ecdsa_verify_no_throw call per signature.
+ * The timings are those of OpenSSL: on a device, the batch saves the
+ * multiplications of the generator and the modular inversions but performs
+ * its point additions and doublings through syscalls, which are counted.
+ *
+ * usage: bench_ec_batch [<iterations>]
+ */
+#include "cx.h"
+#include "cx_test.h"
+
+#define COUNT CX_EC_BATCH_MAX_SIZE
+
+static cx_ecfp_public_key_t  pukeys[COUNT];
+static cx_ecfp_private_key_t pvkeys[COUNT];
+static uint8_t               hashes[COUNT][CX_SHA256_SIZE];
+static uint8_t               sigs[COUNT][72];
+static cx_ecdsa_batch_item_t items[COUNT];
+
+static bool verify_batch(size_t count)
+{
+    bool verified = false;
+
+    TEST_CHECK(cx_ecdsa_batch_verify_no_throw(items, count, &verified) == CX_OK);
+    return verified;
+}
+
+static bool verify_each(size_t count)
+{
+    bool verified = true;
+
+    for (size_t i = 0; i < count; i++) {
+        verified &= cx_ecdsa_verify_no_throw(
+            items[i].pukey, items[i].hash, items[i].hash_len, items[i].sig, items[i].sig_len);
+    }
+    return verified;
+}
+
+static void run(const char *name, bool (*verify)(size_t), size_t count, unsigned long n)
+{
+    uint64_t start, calls;
+
+    cx_host_stats_reset();
+    TEST_CHECK(verify(count));
+    calls = test_backend_calls();
+    start = test_now_ns();
+    for (unsigned long i = 0; i < n; i++) {
+        TEST_CHECK(verify(count));
+    }
+    printf("%2zu %-6s %8.1f us per batch, %5llu calls\n",
+           count,
+           name,
+           (test_now_ns() - start) / 1e3 / n,
+           (unsigned long long) calls);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long n = bench_iterations(argc, argv, 20);
+
+    for (size_t i = 0; i < COUNT; i++) {
+        size_t   sig_len = sizeof(sigs[i]);
+        uint32_t info;
+
+        TEST_CHECK(cx_ecfp_generate_pair_no_throw(
+                       CX_CURVE_SECP256K1, &pukeys[i], &pvkeys[i], false)
+                   == CX_OK);
+        cx_rng_no_throw(hashes[i], sizeof(hashes[i]));
+        TEST_CHECK(cx_ecdsa_sign_no_throw(
+                       &pvkeys[i], CX_RND_TRNG, CX_SHA256, hashes[i], 32, sigs[i], &sig_len, &info)
+                   == CX_OK);
+        items[i] = (cx_ecdsa_batch_item_t){
+            .pukey    = &pukeys[i],
+            .hash     = hashes[i],
+            .hash_len = sizeof(hashes[i]),
+            .sig      = sigs[i],
+            .sig_len  = sig_len,
+            .info     = info | CX_ECDSA_BATCH_PARITY_KNOWN,
+        };
+    }
+
+    printf("ECDSA verification on secp256k1\n");
+    for (size_t count = 1; count <= COUNT; count++) {
+        run("batch", verify_batch, count, n);
+        run("single", verify_each, count, n);
+    }
+    return test_end("bench_ec_batch");
+}
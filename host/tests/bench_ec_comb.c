@@ -0,0 +1,125 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * Sweep of the comb parameters, teeth (window size) and blocks, for a random
+ * base point of secp256k1, against cx_ecpoint_scalarmul. The point additions
+ * and doublings are counted, each being a syscall on a device, along with the
+ * size of the table. Tables larger than 64 KB are skipped.
+ *
+ * usage: bench_ec_comb [<iterations>]
+ */
+#include "cx.h"
+#include "cx_test.h"
+
+#define SIZE          32
+#define MAX_TABLE_LEN 0x10000
+
+static uint8_t table[MAX_TABLE_LEN];
+
+// The tables are in RAM, this is only to link
+void nvm_write(void *dst_adr, void *src_adr, unsigned int src_len)
+{
+    memmove(dst_adr, src_adr, src_len);
+}
+
+static void run(uint8_t teeth, uint8_t blocks, const cx_ecpoint_t *P, unsigned long n)
+{
+    cx_ecpoint_comb_t comb;
+    cx_ecpoint_t      R, Q;
+    uint8_t           k[SIZE];
+    uint8_t           rx[SIZE], ry[SIZE], qx[SIZE], qy[SIZE];
+    uint64_t          start, precompute_ns, adds, doublings;
+    size_t            table_len = cx_ecpoint_comb_table_len(CX_CURVE_SECP256K1, teeth, blocks);
+
+    if ((table_len == 0) || (table_len > MAX_TABLE_LEN)) {
+        return;
+    }
+    TEST_CHECK(cx_ecpoint_comb_init(&comb, CX_CURVE_SECP256K1, teeth, blocks, table, table_len)
+               == CX_OK);
+    TEST_CHECK(cx_ecpoint_alloc(&R, CX_CURVE_SECP256K1) == CX_OK);
+    TEST_CHECK(cx_ecpoint_alloc(&Q, CX_CURVE_SECP256K1) == CX_OK);
+
+    start = test_now_ns();
+    TEST_CHECK(cx_ecpoint_comb_precompute(&comb, P, false) == CX_OK);
+    precompute_ns = test_now_ns() - start;
+
+    cx_rng_no_throw(k, SIZE);
+    k[0] &= 0x7F;
+    cx_host_stats_reset();
+    TEST_CHECK(cx_ecpoint_comb_scalarmul(&comb, &R, k, SIZE) == CX_OK);
+    adds      = test_backend_calls_of("cx_ecpoint_add");
+    doublings = test_backend_calls_of("cx_ecpoint_scalarmul");
+
+    // Same result as the generic multiplication
+    TEST_CHECK(cx_bn_copy(Q.x, P->x) == CX_OK);
+    TEST_CHECK(cx_bn_copy(Q.y, P->y) == CX_OK);
+    TEST_CHECK(cx_bn_copy(Q.z, P->z) == CX_OK);
+    TEST_CHECK(cx_ecpoint_scalarmul(&Q, k, SIZE) == CX_OK);
+    TEST_CHECK(cx_ecpoint_export(&R, rx, SIZE, ry, SIZE) == CX_OK);
+    TEST_CHECK(cx_ecpoint_export(&Q, qx, SIZE, qy, SIZE) == CX_OK);
+    TEST_CHECK((memcmp(rx, qx, SIZE) == 0) && (memcmp(ry, qy, SIZE) == 0));
+
+    start = test_now_ns();
+    for (unsigned long i = 0; i < n; i++) {
+        TEST_CHECK(cx_ecpoint_comb_scalarmul(&comb, &R, k, SIZE) == CX_OK);
+    }
+    printf("%5u %6u %7zu %8.1f %9llu %9llu %10.1f\n",
+           teeth,
+           blocks,
+           table_len,
+           precompute_ns / 1e3,
+           (unsigned long long) doublings,
+           (unsigned long long) adds,
+           (test_now_ns() - start) / 1e3 / n);
+
+    TEST_CHECK(cx_ecpoint_destroy(&R) == CX_OK);
+    TEST_CHECK(cx_ecpoint_destroy(&Q) == CX_OK);
+}
+
+int main(int argc, char *argv[])
+{
+    static const uint8_t blocks[] = {1, 2, 4, 8, 16, 32, 64};
+    unsigned long        n        = bench_iterations(argc, argv, 20);
+    cx_ecpoint_t         P;
+    uint8_t              d[SIZE];
+    uint64_t             start;
+
+    TEST_CHECK(cx_bn_lock(SIZE, 0) == CX_OK);
+    TEST_CHECK(cx_ecpoint_alloc(&P, CX_CURVE_SECP256K1) == CX_OK);
+    TEST_CHECK(cx_ecdomain_generator_bn(CX_CURVE_SECP256K1, &P) == CX_OK);
+    cx_rng_no_throw(d, SIZE);
+    d[0] &= 0x7F;
+    TEST_CHECK(cx_ecpoint_scalarmul(&P, d, SIZE) == CX_OK);
+
+    start = test_now_ns();
+    for (unsigned long i = 0; i < n; i++) {
+        TEST_CHECK(cx_ecpoint_scalarmul(&P, d, SIZE) == CX_OK);
+    }
+    printf("cx_ecpoint_scalarmul: %.1f us\n\n", (test_now_ns() - start) / 1e3 / n);
+
+    printf("teeth blocks   table   precomp doublings additions  scalarmul\n");
+    printf("                 (B)      (us)                           (us)\n");
+    for (uint8_t teeth = 1; teeth <= CX_ECPOINT_COMB_MAX_TEETH; teeth++) {
+        for (size_t i = 0; i < sizeof(blocks); i++) {
+            run(teeth, blocks[i], &P, n);
+        }
+    }
+
+    TEST_CHECK(cx_ecpoint_destroy(&P) == CX_OK);
+    cx_bn_unlock();
+    return test_end("bench_ec_comb");
+}
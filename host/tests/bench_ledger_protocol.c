@@ -0,0 +1,202 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * Loopback of src/ledger_protocol.c: the host side of the exchange is played
+ * here, a command being split in frames given to LEDGER_PROTOCOL_rx, and the
+ * reply being read back from the frames built by LEDGER_PROTOCOL_tx.
+ *
+ * The MTU negotiation is checked first, then the frames per exchange and the
+ * throughput are printed for MTUs from the 23 bytes of the default BLE ATT MTU
+ * to LEDGER_PROTOCOL_CHUNK_SIZE, with the link bounded by
+ * LEDGER_PROTOCOL_set_mtu_max as a BLE transport would.
+ *
+ * usage: bench_ledger_protocol [<iterations>]
+ */
+#include "cx_test.h"
+#include "ledger_protocol.h"
+#include "os_math.h"
+#include "os_utils.h"
+
+#define TAG_APDU 0x05
+#define TAG_MTU  0x08
+#define MAX_APDU 512
+
+static const uint16_t mtus[] = {23, 64, 156, 247, LEDGER_PROTOCOL_CHUNK_SIZE};
+static const uint16_t apdu_lens[] = {5, 64, 255, MAX_APDU};
+
+static ledger_protocol_t lp;
+static uint8_t           rx_buffer[MAX_APDU];
+static uint8_t           command[MAX_APDU], reply[MAX_APDU], received[MAX_APDU];
+
+static void lp_init(uint16_t mtu, uint16_t mtu_max)
+{
+    memset(&lp, 0, sizeof(lp));
+    lp.rx_apdu_buffer            = rx_buffer;
+    lp.rx_apdu_buffer_max_length = sizeof(rx_buffer);
+    lp.mtu                       = mtu;
+    lp.mtu_max                   = mtu_max;
+    LEDGER_PROTOCOL_init(&lp);
+}
+
+// Sends a TAG_MTU request, with a proposal if not 0, and returns the MTU replied. Without a
+// proposal, the request is the one of the legacy hosts: 08 00 00 00 00, after the channel.
+static uint16_t negotiate(uint16_t proposal)
+{
+    uint8_t frame[7] = {0x00, 0x00, TAG_MTU};
+
+    U2BE_ENCODE(frame, 3, proposal);
+    LEDGER_PROTOCOL_rx(frame, sizeof(frame));
+    if (lp.chunk[6] == 1) {
+        TEST_CHECK(proposal < LEDGER_PROTOCOL_MTU_MIN);
+        TEST_CHECK(lp.chunk_length == 8);
+        return lp.chunk[7];
+    }
+    // two bytes only when the proposal was accepted, or the MTU doesn't fit in one
+    TEST_CHECK((proposal >= LEDGER_PROTOCOL_MTU_MIN) || (lp.mtu > 0xFF));
+    TEST_CHECK(lp.chunk_length == 9);
+    return U2BE(lp.chunk, 7);
+}
+
+static void test_negotiation(void)
+{
+    // legacy hosts get the MTU of the transport on one byte
+    lp_init(156, 0);
+    TEST_CHECK(negotiate(0) == 156);
+    TEST_CHECK(!lp.mtu_negotiated);
+
+    // proposals too small to hold a frame header are ignored
+    TEST_CHECK(negotiate(LEDGER_PROTOCOL_MTU_MIN - 1) == 156);
+    TEST_CHECK(negotiate(LEDGER_PROTOCOL_MTU_MIN) == LEDGER_PROTOCOL_MTU_MIN);
+    TEST_CHECK(lp.mtu_negotiated);
+    // and a legacy request still gets the one byte reply
+    TEST_CHECK(negotiate(0) == LEDGER_PROTOCOL_MTU_MIN);
+
+    // bounded by the chunk buffer, then by the link
+    TEST_CHECK(negotiate(0xFFFF) == LEDGER_PROTOCOL_CHUNK_SIZE);
+    LEDGER_PROTOCOL_set_mtu_max(100);
+    TEST_CHECK(lp.mtu == 100);
+    TEST_CHECK(negotiate(0xFFFF) == 100);
+
+    // a link or transport MTU below the frame header is raised to it
+    LEDGER_PROTOCOL_set_mtu_max(3);
+    TEST_CHECK(lp.mtu_max == LEDGER_PROTOCOL_MTU_MIN);
+    TEST_CHECK(negotiate(0xFFFF) == LEDGER_PROTOCOL_MTU_MIN);
+    lp_init(0, 1);
+    TEST_CHECK(lp.mtu == LEDGER_PROTOCOL_MTU_MIN);
+    TEST_CHECK(lp.mtu_max == LEDGER_PROTOCOL_MTU_MIN);
+}
+
+// Returns the number of frames of the exchange
+static unsigned int exchange(uint16_t len)
+{
+    uint8_t      frame[LEDGER_PROTOCOL_CHUNK_SIZE];
+    uint16_t     seq = 0, offset = 0, total = 0;
+    unsigned int frames = 0;
+
+    // host to device
+    while (offset < len) {
+        uint16_t o = 0, n;
+
+        frame[o++] = 0x00;
+        frame[o++] = 0x00;
+        frame[o++] = TAG_APDU;
+        U2BE_ENCODE(frame, o, seq);
+        o += 2;
+        if (seq == 0) {
+            U2BE_ENCODE(frame, o, len);
+            o += 2;
+        }
+        n = MIN(len - offset, lp.mtu - o);
+        memcpy(frame + o, command + offset, n);
+        LEDGER_PROTOCOL_rx(frame, o + n);
+        offset += n;
+        seq++;
+        frames++;
+    }
+    TEST_CHECK(lp.rx_apdu_status == APDU_STATUS_COMPLETE);
+    TEST_CHECK(memcmp(rx_buffer, command, len) == 0);
+    lp.rx_apdu_status          = APDU_STATUS_WAITING;
+    lp.rx_apdu_sequence_number = 0;
+
+    // device to host
+    offset = 0;
+    LEDGER_PROTOCOL_tx(reply, len);
+    for (;;) {
+        uint16_t o = 5;
+
+        TEST_CHECK(lp.chunk_length <= lp.mtu);
+        if (U2BE(lp.chunk, 3) == 0) {
+            total = U2BE(lp.chunk, 5);
+            o     = 7;
+        }
+        memcpy(received + offset, lp.chunk + o, lp.chunk_length - o);
+        offset += lp.chunk_length - o;
+        frames++;
+        if (lp.tx_apdu_buffer == NULL) {
+            break;
+        }
+        LEDGER_PROTOCOL_tx(NULL, 0);
+    }
+    TEST_CHECK((offset == len) && (total == len));
+    TEST_CHECK(memcmp(received, reply, len) == 0);
+    return frames;
+}
+
+static void bench(unsigned long iterations)
+{
+    printf("%5s %5s %8s %10s %8s\n", "mtu", "apdu", "frames", "MB/s", "payload");
+    for (size_t m = 0; m < ARRAYLEN(mtus); m++) {
+        if (mtus[m] > LEDGER_PROTOCOL_CHUNK_SIZE) {
+            continue;
+        }
+        for (size_t a = 0; a < ARRAYLEN(apdu_lens); a++) {
+            uint16_t     len    = apdu_lens[a];
+            unsigned int frames = 0;
+            uint64_t     start;
+            double       ns;
+
+            lp_init(23, 0);
+            LEDGER_PROTOCOL_set_mtu_max(mtus[m]);
+            TEST_CHECK(negotiate(0xFFFF) == mtus[m]);
+            start = test_now_ns();
+            for (unsigned long i = 0; i < iterations; i++) {
+                frames = exchange(len);
+            }
+            ns = (double) (test_now_ns() - start) / iterations;
+            // payload: share of the frames bytes, as sent at the MTU, which are APDU bytes
+            printf("%5u %5u %8u %10.1f %7.0f%%\n",
+                   mtus[m],
+                   len,
+                   frames,
+                   2e3 * len / ns,
+                   100.0 * 2 * len / (frames * mtus[m]));
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long iterations = bench_iterations(argc, argv, 20000);
+
+    for (size_t i = 0; i < sizeof(command); i++) {
+        command[i] = i * 7;
+        reply[i]   = i * 13;
+    }
+    test_negotiation();
+    bench(iterations);
+    return test_end("bench_ledger_protocol");
+}
@@ -0,0 +1,139 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * 100 steps of x = x * a + b mod p, p being the secp256k1 field prime, with a
+ * cx_math_session_t and with one lock, import, computation, export and unlock
+ * per operation, as done by the cx_math_xxx_no_throw syscalls.
+ *
+ * usage: bench_math_session [<iterations>]
+ */
+#include "cx.h"
+#include "cx_test.h"
+
+#define STEPS 100
+#define SIZE  32
+
+static const uint8_t P[SIZE] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                                0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                                0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE, 0xFF, 0xFF, 0xFC, 0x2F};
+
+static uint8_t x0[SIZE], a[SIZE], b[SIZE];
+
+// What cx_math_multm_no_throw and cx_math_addm_no_throw do on every call
+static cx_err_t per_call_op(uint8_t *r, const uint8_t *u, const uint8_t *v, bool mul)
+{
+    cx_err_t error;
+    cx_bn_t  bn_r, bn_u, bn_v, bn_m;
+
+    CX_CHECK(cx_bn_lock(SIZE, 0));
+    CX_CHECK(cx_bn_alloc_init(&bn_m, SIZE, P, SIZE));
+    CX_CHECK(cx_bn_alloc_init(&bn_u, SIZE, u, SIZE));
+    CX_CHECK(cx_bn_alloc_init(&bn_v, SIZE, v, SIZE));
+    CX_CHECK(cx_bn_alloc(&bn_r, SIZE));
+    if (mul) {
+        CX_CHECK(cx_bn_mod_mul(bn_r, bn_u, bn_v, bn_m));
+    }
+    else {
+        CX_CHECK(cx_bn_mod_add(bn_r, bn_u, bn_v, bn_m));
+    }
+    CX_CHECK(cx_bn_export(bn_r, r, SIZE));
+
+end:
+    cx_bn_unlock();
+    return error;
+}
+
+static cx_err_t loop_per_call(uint8_t *x)
+{
+    cx_err_t error = CX_OK;
+
+    memcpy(x, x0, SIZE);
+    for (int i = 0; i < STEPS; i++) {
+        CX_CHECK(per_call_op(x, x, a, true));
+        CX_CHECK(per_call_op(x, x, b, false));
+    }
+
+end:
+    return error;
+}
+
+static cx_err_t loop_steps(cx_math_session_t *session, uint8_t *x)
+{
+    cx_err_t error;
+    cx_bn_t  bn_x, bn_a, bn_b;
+
+    CX_CHECK(cx_math_session_load(session, &bn_x, x0, SIZE));
+    CX_CHECK(cx_math_session_load(session, &bn_a, a, SIZE));
+    CX_CHECK(cx_math_session_load(session, &bn_b, b, SIZE));
+    for (int i = 0; i < STEPS; i++) {
+        CX_CHECK(cx_math_session_multm(session, bn_x, bn_x, bn_a));
+        CX_CHECK(cx_math_session_addm(session, bn_x, bn_x, bn_b));
+    }
+    CX_CHECK(cx_math_session_store(session, x, bn_x));
+
+end:
+    return error;
+}
+
+static cx_err_t loop_session(uint8_t *x)
+{
+    cx_math_session_t session;
+    cx_err_t          error;
+
+    // A session which failed to start is already closed, and must not be ended
+    CX_CHECK(cx_math_session_start(&session, P, SIZE));
+    error = loop_steps(&session, x);
+    cx_math_session_end(&session);
+
+end:
+    return error;
+}
+
+static void run(const char *name, cx_err_t (*loop)(uint8_t *), uint8_t *x, unsigned long n)
+{
+    uint64_t start, calls;
+
+    cx_host_stats_reset();
+    TEST_CHECK(loop(x) == CX_OK);
+    calls = test_backend_calls();
+    start = test_now_ns();
+    for (unsigned long i = 0; i < n; i++) {
+        TEST_CHECK(loop(x) == CX_OK);
+    }
+    printf("%-10s %8.1f us per loop, %5llu BN calls\n",
+           name,
+           (test_now_ns() - start) / 1e3 / n,
+           (unsigned long long) calls);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long n = bench_iterations(argc, argv, 200);
+    uint8_t       x_per_call[SIZE], x_session[SIZE];
+
+    cx_rng_no_throw(x0, SIZE);
+    cx_rng_no_throw(a, SIZE);
+    cx_rng_no_throw(b, SIZE);
+    // below the modulus
+    x0[0] = a[0] = b[0] = 0x7F;
+
+    printf("%d steps of x = x * a + b mod p, 256 bits\n", STEPS);
+    run("per call", loop_per_call, x_per_call, n);
+    run("session", loop_session, x_session, n);
+    TEST_CHECK(memcmp(x_per_call, x_session, SIZE) == 0);
+    return test_end("bench_math_session");
+}
@@ -0,0 +1,226 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * os_xor, os_secure_memcmp and cx_memxor on 32 to 4096-byte buffers, against
+ * the byte-wise code they replace.
+ *
+ * Then a dudect test of os_secure_memcmp and os_xor: the execution times with
+ * equal buffers and with random ones are measured in random order, and a Welch
+ * t-test tells whether they differ. The measurements above the 90th percentile
+ * are dropped, as they are mostly interrupts. |t| above 4.5 is a leak.
+ *
+ * usage: bench_os_mem [<measurements>]
+ */
+#include <math.h>  // fabs, sqrt
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>  // __rdtsc
+#endif
+
+#include "cx.h"
+#include "cx_test.h"
+#include "lib_cxng/src/cx_utils.h"
+#include "os_utils.h"
+
+#define MAX_LEN   4096
+#define T_LEAK    4.5
+#define KEEP_PCT  90
+#define TIME_REPS 2000
+
+static const size_t dudect_lens[] = {32, 256, MAX_LEN};
+
+static uint8_t a[MAX_LEN] __attribute__((aligned(4)));
+static uint8_t b[MAX_LEN] __attribute__((aligned(4)));
+static uint8_t d[MAX_LEN] __attribute__((aligned(4)));
+static uint8_t out[MAX_LEN] __attribute__((aligned(4)));
+
+static uint64_t cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return test_now_ns();
+#endif
+}
+
+/*
+ * The byte-wise code of the SDK before the word versions, without the glitch
+ * checks. It is not vectorized, as the devices have no SIMD unit.
+ */
+#define BYTE_WISE __attribute__((noinline, optimize("no-tree-vectorize")))
+
+static BYTE_WISE void byte_xor(void *dst, void *src1, void *src2, size_t len)
+{
+    while (len--) {
+        ((uint8_t *) dst)[len] = ((const uint8_t *) src1)[len] ^ ((const uint8_t *) src2)[len];
+    }
+}
+
+static BYTE_WISE char byte_secure_memcmp(void *src1, void *src2, size_t len)
+{
+    uint8_t xoracc = 0;
+
+    while (len--) {
+        xoracc |= ((const uint8_t *) src1)[len] ^ ((const uint8_t *) src2)[len];
+    }
+    return (char) xoracc;
+}
+
+static BYTE_WISE void byte_memxor(uint8_t *buf1, const uint8_t *buf2, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        buf1[i] ^= buf2[i];
+    }
+}
+
+static volatile char sink;
+
+static double time_ns(int op, bool words, size_t len)
+{
+    uint64_t start = test_now_ns();
+
+    for (int i = 0; i < TIME_REPS; i++) {
+        switch (op) {
+            case 0:
+                if (words) {
+                    os_xor(d, a, b, len);
+                }
+                else {
+                    byte_xor(d, a, b, len);
+                }
+                break;
+            case 1:
+                sink = words ? os_secure_memcmp(a, b, len) : byte_secure_memcmp(a, b, len);
+                break;
+            default:
+                if (words) {
+                    cx_memxor(d, a, len);
+                }
+                else {
+                    byte_memxor(d, a, len);
+                }
+                break;
+        }
+    }
+    return (double) (test_now_ns() - start) / TIME_REPS;
+}
+
+static void bench(void)
+{
+    static const char *names[] = {"os_xor", "os_secure_memcmp", "cx_memxor"};
+
+    cx_rng_no_throw(a, sizeof(a));
+    cx_rng_no_throw(b, sizeof(b));
+    printf("%-18s %5s %10s %10s %8s\n", "", "bytes", "bytes ns", "words ns", "speedup");
+    for (int op = 0; op < 3; op++) {
+        for (size_t len = 32; len <= MAX_LEN; len *= 2) {
+            double t_bytes = time_ns(op, false, len);
+            double t_words = time_ns(op, true, len);
+
+            printf("%-18s %5zu %10.1f %10.1f %7.1fx\n",
+                   names[op],
+                   len,
+                   t_bytes,
+                   t_words,
+                   t_bytes / t_words);
+        }
+    }
+}
+
+static int cmp_u64(const void *x, const void *y)
+{
+    uint64_t u = *(const uint64_t *) x, v = *(const uint64_t *) y;
+
+    return (u > v) - (u < v);
+}
+
+/*
+ * Welch's t statistic of the two classes, keeping the measurements below the
+ * KEEP_PCT percentile of both classes together.
+ */
+static double welch_t(const uint64_t *t, const uint8_t *cls, size_t n, uint64_t *sorted)
+{
+    double   sum[2] = {0}, sum2[2] = {0}, cnt[2] = {0};
+    uint64_t cut;
+
+    memcpy(sorted, t, n * sizeof(uint64_t));
+    qsort(sorted, n, sizeof(uint64_t), cmp_u64);
+    cut = sorted[n * KEEP_PCT / 100];
+    for (size_t i = 0; i < n; i++) {
+        if (t[i] < cut) {
+            sum[cls[i]] += t[i];
+            sum2[cls[i]] += (double) t[i] * t[i];
+            cnt[cls[i]]++;
+        }
+    }
+    double mean0 = sum[0] / cnt[0], mean1 = sum[1] / cnt[1];
+    double var0 = sum2[0] / cnt[0] - mean0 * mean0, var1 = sum2[1] / cnt[1] - mean1 * mean1;
+
+    return (mean0 - mean1) / sqrt(var0 / cnt[0] + var1 / cnt[1]);
+}
+
+static void dudect(bool memcmp_op, size_t len, size_t n)
+{
+    uint64_t *t      = malloc(n * sizeof(uint64_t));
+    uint64_t *sorted = malloc(n * sizeof(uint64_t));
+    uint8_t  *cls    = malloc(n);
+    uint64_t  start;
+    double    tstat;
+
+    // The inputs of both classes are ready and in the cache before measuring
+    cx_rng_no_throw(a, len);
+    memcpy(b, a, len);
+    cx_rng_no_throw(d, len);
+    cx_rng_no_throw(cls, n);
+    for (size_t i = 0; i < n; i++) {
+        // class 0: equal buffers, class 1: random ones
+        const uint8_t *other = (cls[i] & 1) ? d : b;
+
+        cls[i] &= 1;
+        start = cycles();
+        if (memcmp_op) {
+            sink = os_secure_memcmp(a, (void *) other, len);
+        }
+        else {
+            os_xor(out, a, (void *) other, len);
+        }
+        t[i] = cycles() - start;
+    }
+    tstat = welch_t(t, cls, n, sorted);
+    printf("%-18s %5zu %8zu measurements, t = %6.2f\n",
+           memcmp_op ? "os_secure_memcmp" : "os_xor",
+           len,
+           n,
+           tstat);
+    TEST_CHECK(fabs(tstat) < T_LEAK);
+    free(t);
+    free(sorted);
+    free(cls);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long n = bench_iterations(argc, argv, 100000);
+
+    bench();
+    printf("\n");
+    for (size_t i = 0; i < ARRAYLEN(dudect_lens); i++) {
+        dudect(true, dudect_lens[i], n);
+        dudect(false, dudect_lens[i], n);
+    }
+    return test_end("bench_os_mem");
+}
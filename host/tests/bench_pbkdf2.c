@@ -0,0 +1,144 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * PBKDF2 with 2048 iterations, as for a BIP39 seed, with an HMAC initialized
+ * from the raw password at each iteration, as done by the OS, and with the
+ * precomputed pads of cx_hmac_key_init used by the cx_pbkdf2_no_throw of
+ * ENABLE_APP_HMAC_KDF. Both are checked against OpenSSL, and the hash
+ * compressions are counted.
+ *
+ * usage: bench_pbkdf2 [<iterations>]
+ */
+#include <openssl/evp.h>
+
+#include "cx.h"
+#include "cx_test.h"
+#include "os_math.h"
+#include "os_utils.h"
+
+#define ITERATIONS 2048
+
+static const char PASSWORD[] = "abandon abandon abandon abandon abandon abandon abandon abandon "
+                               "abandon abandon abandon about";
+static uint8_t    SALT[]     = "mnemonicTREZOR";
+
+static cx_err_t pbkdf2_raw_key(cx_md_t md_type, uint8_t *out, size_t out_len)
+{
+    // large enough for both hashes
+    cx_hmac_sha512_t ctx;
+    cx_hmac_t       *hmac = (cx_hmac_t *) &ctx;
+    cx_err_t         error;
+    uint8_t          u[CX_SHA512_SIZE];
+    uint8_t          t[CX_SHA512_SIZE];
+    uint8_t          counter[4];
+    size_t           mac_len = (md_type == CX_SHA512) ? CX_SHA512_SIZE : CX_SHA256_SIZE;
+    size_t           len;
+
+    for (uint32_t block = 1; out_len > 0; block++) {
+        U4BE_ENCODE(counter, 0, block);
+        CX_CHECK(cx_hmac_init(hmac, md_type, (const uint8_t *) PASSWORD, strlen(PASSWORD)));
+        CX_CHECK(cx_hmac_update(hmac, SALT, sizeof(SALT) - 1));
+        CX_CHECK(cx_hmac_update(hmac, counter, sizeof(counter)));
+        len = sizeof(u);
+        CX_CHECK(cx_hmac_final(hmac, u, &len));
+        memcpy(t, u, mac_len);
+        for (uint32_t j = 1; j < ITERATIONS; j++) {
+            CX_CHECK(cx_hmac_init(hmac, md_type, (const uint8_t *) PASSWORD, strlen(PASSWORD)));
+            CX_CHECK(cx_hmac_update(hmac, u, mac_len));
+            len = sizeof(u);
+            CX_CHECK(cx_hmac_final(hmac, u, &len));
+            for (size_t i = 0; i < mac_len; i++) {
+                t[i] ^= u[i];
+            }
+        }
+        len = MIN(out_len, mac_len);
+        memcpy(out, t, len);
+        out += len;
+        out_len -= len;
+    }
+
+end:
+    return error;
+}
+
+static cx_err_t pbkdf2_key(cx_md_t md_type, uint8_t *out, size_t out_len)
+{
+    return cx_pbkdf2_no_throw(md_type,
+                              (const uint8_t *) PASSWORD,
+                              strlen(PASSWORD),
+                              SALT,
+                              sizeof(SALT) - 1,
+                              ITERATIONS,
+                              out,
+                              out_len);
+}
+
+static void run(const char *name,
+                cx_err_t (*pbkdf2)(cx_md_t, uint8_t *, size_t),
+                cx_md_t        md_type,
+                const uint8_t *expected,
+                size_t         len,
+                unsigned long  n)
+{
+    uint8_t  out[CX_SHA512_SIZE];
+    uint64_t start, blocks;
+
+    blocks = cx_host_hash_blocks();
+    TEST_CHECK(pbkdf2(md_type, out, len) == CX_OK);
+    blocks = cx_host_hash_blocks() - blocks;
+    TEST_CHECK(memcmp(out, expected, len) == 0);
+    start = test_now_ns();
+    for (unsigned long i = 0; i < n; i++) {
+        TEST_CHECK(pbkdf2(md_type, out, len) == CX_OK);
+    }
+    printf("%-20s %8.2f ms, %6llu compressions\n",
+           name,
+           (test_now_ns() - start) / 1e6 / n,
+           (unsigned long long) blocks);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long n = bench_iterations(argc, argv, 20);
+    uint8_t       expected[CX_SHA512_SIZE];
+
+    printf("PBKDF2, %d iterations\n", ITERATIONS);
+
+    PKCS5_PBKDF2_HMAC(PASSWORD,
+                      strlen(PASSWORD),
+                      SALT,
+                      sizeof(SALT) - 1,
+                      ITERATIONS,
+                      EVP_sha512(),
+                      CX_SHA512_SIZE,
+                      expected);
+    run("sha512 raw key", pbkdf2_raw_key, CX_SHA512, expected, CX_SHA512_SIZE, n);
+    run("sha512 precomputed", pbkdf2_key, CX_SHA512, expected, CX_SHA512_SIZE, n);
+
+    PKCS5_PBKDF2_HMAC(PASSWORD,
+                      strlen(PASSWORD),
+                      SALT,
+                      sizeof(SALT) - 1,
+                      ITERATIONS,
+                      EVP_sha256(),
+                      CX_SHA256_SIZE,
+                      expected);
+    run("sha256 raw key", pbkdf2_raw_key, CX_SHA256, expected, CX_SHA256_SIZE, n);
+    run("sha256 precomputed", pbkdf2_key, CX_SHA256, expected, CX_SHA256_SIZE, n);
+
+    return test_end("bench_pbkdf2");
+}
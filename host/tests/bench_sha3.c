@@ -0,0 +1,87 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * SHA3-256 of 1 to 10 KB messages received in 255-byte chunks, as from APDUs,
+ * with the in-app Keccak (cx_sha3_update) and through the generic cx_hash API,
+ * which is the syscall path of apps built without ENABLE_APP_KECCAK. Both end
+ * in the same code on the host: the time is that of the in-app permutation,
+ * and the syscalls that the other path would make are counted.
+ *
+ * usage: bench_sha3 [<iterations>]
+ */
+#include "cx.h"
+#include "cx_test.h"
+#include "lib_cxng/src/cx_sha3.h"
+#include "os_math.h"
+
+#define MAX_LEN 10240
+#define CHUNK   255
+
+static uint8_t msg[MAX_LEN];
+
+static void in_app(size_t len, uint8_t *digest)
+{
+    cx_sha3_t hash;
+
+    TEST_CHECK(cx_sha3_init_no_throw(&hash, 256) == CX_OK);
+    for (size_t off = 0; off < len; off += CHUNK) {
+        TEST_CHECK(cx_sha3_update(&hash, msg + off, MIN(CHUNK, len - off)) == CX_OK);
+    }
+    TEST_CHECK(cx_sha3_final(&hash, digest) == CX_OK);
+}
+
+static void syscalls(size_t len, uint8_t *digest)
+{
+    cx_sha3_t hash;
+
+    TEST_CHECK(cx_hash_init_ex(&hash.header, CX_SHA3, CX_SHA3_256_SIZE) == CX_OK);
+    for (size_t off = 0; off < len; off += CHUNK) {
+        TEST_CHECK(cx_hash_update(&hash.header, msg + off, MIN(CHUNK, len - off)) == CX_OK);
+    }
+    TEST_CHECK(cx_hash_final(&hash.header, digest) == CX_OK);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long n = bench_iterations(argc, argv, 200);
+    uint8_t       digest[2][CX_SHA3_256_SIZE];
+    uint64_t      start, elapsed, calls;
+
+    cx_rng_no_throw(msg, sizeof(msg));
+
+    printf(" size  in-app (us)  cycles/byte at 1 GHz  syscalls without ENABLE_APP_KECCAK\n");
+    for (size_t len = 1024; len <= MAX_LEN; len += 1024) {
+        cx_host_stats_reset();
+        syscalls(len, digest[1]);
+        calls = test_backend_calls_of("cx_hash_init_ex") + test_backend_calls_of("cx_hash_update")
+                + test_backend_calls_of("cx_hash_final");
+
+        start = test_now_ns();
+        for (unsigned long i = 0; i < n; i++) {
+            in_app(len, digest[0]);
+        }
+        elapsed = test_now_ns() - start;
+        TEST_CHECK(memcmp(digest[0], digest[1], sizeof(digest[0])) == 0);
+
+        printf("%5zu %12.1f %21.1f %35llu\n",
+               len,
+               elapsed / 1e3 / n,
+               (double) elapsed / n / len,
+               (unsigned long long) calls);
+    }
+    return test_end("bench_sha3");
+}
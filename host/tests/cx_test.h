@@ -0,0 +1,130 @@
+#pragma once
+
+/*
+ * Helpers of the host tests and benchmarks of the SDK crypto code, linked
+ * with the cx_host backend.
+ */
+#include <stdbool.h>  // bool
+#include <stdint.h>   // uint*_t
+#include <stdio.h>    // printf, fprintf
+#include <stdlib.h>   // exit, strtoul
+#include <string.h>   // memcmp, strlen
+#include <time.h>     // clock_gettime
+
+#include "cx_host.h"
+
+static unsigned int test_failures;
+
+#define TEST_CHECK(cond)                                                         \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            fprintf(stderr, "%s:%d: failed: %s\n", __FILE__, __LINE__, #cond);   \
+            test_failures++;                                                     \
+        }                                                                        \
+    } while (0)
+
+/**
+ * @brief   Decodes a hex string, exits if it is invalid or too long.
+ *
+ * @return  Number of bytes decoded.
+ */
+static inline size_t test_unhex(const char *hex, uint8_t *out, size_t max)
+{
+    size_t len = strlen(hex);
+
+    if ((len % 2) || (len / 2 > max)) {
+        fprintf(stderr, "invalid hex string: %s\n", hex);
+        exit(2);
+    }
+    for (size_t i = 0; i < len / 2; i++) {
+        char  byte[3] = {hex[2 * i], hex[2 * i + 1], 0};
+        char *end;
+
+        out[i] = strtoul(byte, &end, 16);
+        if (*end != 0) {
+            fprintf(stderr, "invalid hex string: %s\n", hex);
+            exit(2);
+        }
+    }
+    return len / 2;
+}
+
+/**
+ * @brief   Compares a result with the expected hex string, and reports it.
+ */
+static inline void test_expect(const char *name, const uint8_t *result, size_t len, const char *hex)
+{
+    uint8_t expected[1024];
+    size_t  expected_len = test_unhex(hex, expected, sizeof(expected));
+
+    if ((len != expected_len) || memcmp(result, expected, len)) {
+        fprintf(stderr, "%s: unexpected result ", name);
+        for (size_t i = 0; i < len; i++) {
+            fprintf(stderr, "%02x", result[i]);
+        }
+        fprintf(stderr, "\n");
+        test_failures++;
+    }
+}
+
+/**
+ * @brief   Prints the outcome of the test.
+ *
+ * @return  Exit status of the test program.
+ */
+static inline int test_end(const char *name)
+{
+    if (test_failures != 0) {
+        printf("%s: %u failure(s)\n", name, test_failures);
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
+
+static inline uint64_t test_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * @brief   Returns the number of calls to the entry points of the backend,
+ *          i.e. of syscalls on a device, since the last reset of the
+ *          statistics.
+ */
+static inline uint64_t test_backend_calls(void)
+{
+    uint64_t calls = 0;
+
+    for (const cx_host_stat_t *stat = cx_host_stats_first(); stat != NULL; stat = stat->next) {
+        calls += stat->calls;
+    }
+    return calls;
+}
+
+/**
+ * @brief   Returns the number of calls to one entry point of the backend since
+ *          the last reset of the statistics.
+ */
+static inline uint64_t test_backend_calls_of(const char *name)
+{
+    for (const cx_host_stat_t *stat = cx_host_stats_first(); stat != NULL; stat = stat->next) {
+        if (strcmp(stat->name, name) == 0) {
+            return stat->calls;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief   Iterations of a benchmark, from the first argument of the program.
+ */
+static inline unsigned long bench_iterations(int argc, char *argv[], unsigned long fallback)
+{
+    unsigned long n = (argc > 1) ? strtoul(argv[1], NULL, 0) : fallback;
+
+    return (n == 0) ? fallback : n;
+}
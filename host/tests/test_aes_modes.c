@@ -0,0 +1,216 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * AES-CTR vectors of NIST SP 800-38A (F.5) and AES-GCM vectors of the GCM
+ * specification submitted to NIST (test cases 1 to 6 and 13 to 16), processed
+ * at once and in chunks.
+ */
+#include "cx.h"
+#include "cx_test.h"
+#include "os_math.h"
+
+#define MAX_LEN 64
+
+typedef struct {
+    const char *key;
+    const char *iv;
+    const char *plain;
+    const char *cipher;
+} ctr_vector_t;
+
+typedef struct {
+    const char *key;
+    const char *iv;
+    const char *aad;
+    const char *plain;
+    const char *cipher;
+    const char *tag;
+} gcm_vector_t;
+
+#define SP800_38A_PLAIN                                                                          \
+    "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e5130c81c46a35ce411e5fbc1191a0a" \
+    "52eff69f2445df4f9b17ad2b417be66c3710"
+
+static const ctr_vector_t ctr_vectors[] = {
+    // F.5.1 CTR-AES128
+    {"2b7e151628aed2a6abf7158809cf4f3c",
+     "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff",
+     SP800_38A_PLAIN,
+     "874d6191b620e3261bef6864990db6ce9806f66b7970fdff8617187bb9fffdff5ae4df3edbd5d35e5b4f09020db0"
+     "3eab1e031dda2fbe03d1792170a0f3009cee"},
+    // F.5.3 CTR-AES192
+    {"8e73b0f7da0e6452c810f32b809079e562f8ead2522c6b7b",
+     "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff",
+     SP800_38A_PLAIN,
+     "1abc932417521ca24f2b0459fe7e6e0b090339ec0aa6faefd5ccc2c6f4ce8e941e36b26bd1ebc670d1bd1d665620"
+     "abf74f78a7f6d29809585a97daec58c6b050"},
+    // F.5.5 CTR-AES256
+    {"603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4",
+     "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff",
+     SP800_38A_PLAIN,
+     "601ec313775789a5b7a7f504bbf3d228f443e3ca4d62b59aca84e990cacaf5c52b0930daa23de94ce87017ba2d84"
+     "988ddfc9c58db67aada613c2dd08457941a6"},
+};
+
+#define GCM_K  "feffe9928665731c6d6a8f9467308308"
+#define GCM_IV "cafebabefacedbaddecaf888"
+#define GCM_P                                                                                    \
+    "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a721c3c0c95956809532fcf0e2449a6" \
+    "b525b16aedf5aa0de657ba637b391aafd255"
+#define GCM_P60                                                                                  \
+    "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a721c3c0c95956809532fcf0e2449a6" \
+    "b525b16aedf5aa0de657ba637b39"
+#define GCM_A     "feedfacedeadbeeffeedfacedeadbeefabaddad2"
+#define GCM_IV8   "cafebabefacedbad"
+#define GCM_IV60                                                                                 \
+    "9313225df88406e555909c5aff5269aa6a7a9538534f7da1e4c303d2a318a728c3c0c95156809539fcf0e2429a6b" \
+    "525416aedbf5a0de6a57a637b39b"
+#define GCM_ZERO_K  "00000000000000000000000000000000"
+#define GCM_ZERO_IV "000000000000000000000000"
+
+static const gcm_vector_t gcm_vectors[] = {
+    // Test cases 1 to 6, AES-128
+    {GCM_ZERO_K, GCM_ZERO_IV, "", "", "", "58e2fccefa7e3061367f1d57a4e7455a"},
+    {GCM_ZERO_K,
+     GCM_ZERO_IV,
+     "",
+     "00000000000000000000000000000000",
+     "0388dace60b6a392f328c2b971b2fe78",
+     "ab6e47d42cec13bdf53a67b21257bddf"},
+    {GCM_K,
+     GCM_IV,
+     "",
+     GCM_P,
+     "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e21d514b25466931c7d8f6a5aac84"
+     "aa051ba30b396a0aac973d58e091473f5985",
+     "4d5c2af327cd64a62cf35abd2ba6fab4"},
+    {GCM_K,
+     GCM_IV,
+     GCM_A,
+     GCM_P60,
+     "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e21d514b25466931c7d8f6a5aac84"
+     "aa051ba30b396a0aac973d58e091",
+     "5bc94fbc3221a5db94fae95ae7121a47"},
+    {GCM_K,
+     GCM_IV8,
+     GCM_A,
+     GCM_P60,
+     "61353b4c2806934a777ff51fa22a4755699b2a714fcdc6f83766e5f97b6c742373806900e49f24b22b097544d489"
+     "6b424989b5e1ebac0f07c23f4598",
+     "3612d2e79e3b0785561be14aaca2fccb"},
+    {GCM_K,
+     GCM_IV60,
+     GCM_A,
+     GCM_P60,
+     "8ce24998625615b603a033aca13fb894be9112a5c3a211a8ba262a3cca7e2ca701e4a9a4fba43c90ccdcb281d48c"
+     "7c6fd62875d2aca417034c34aee5",
+     "619cc5aefffe0bfa462af43c1699d050"},
+    // Test cases 13 to 16, AES-256
+    {GCM_ZERO_K GCM_ZERO_K, GCM_ZERO_IV, "", "", "", "530f8afbc74536b9a963b4f1c4cb738b"},
+    {GCM_ZERO_K GCM_ZERO_K,
+     GCM_ZERO_IV,
+     "",
+     "00000000000000000000000000000000",
+     "cea7403d4d606b6e074ec5d3baf39d18",
+     "d0d1c8a799996bf0265b98b5d48ab919"},
+    {GCM_K GCM_K,
+     GCM_IV,
+     "",
+     GCM_P,
+     "522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa8cb08e48590dbb3da7b08b1056828"
+     "838c5f61e6393ba7a0abcc9f662898015ad",
+     "b094dac5d93471bdec1a502270e3cc6c"},
+    {GCM_K GCM_K,
+     GCM_IV,
+     GCM_A,
+     GCM_P60,
+     "522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa8cb08e48590dbb3da7b08b1056828"
+     "838c5f61e6393ba7a0abcc9f662",
+     "76fc6ece0f4e1768cddf8853bb2d551b"},
+};
+
+static void test_ctr(const ctr_vector_t *v, size_t chunk)
+{
+    cx_aes_key_t key;
+    cx_aes_ctr_t ctx;
+    uint8_t      raw[32], iv[CX_AES_BLOCK_SIZE], in[MAX_LEN], out[MAX_LEN];
+    size_t       len = test_unhex(v->plain, in, sizeof(in));
+
+    TEST_CHECK(cx_aes_init_key_no_throw(raw, test_unhex(v->key, raw, sizeof(raw)), &key) == CX_OK);
+    test_unhex(v->iv, iv, sizeof(iv));
+    TEST_CHECK(cx_aes_ctr_init(&ctx, &key, iv) == CX_OK);
+    for (size_t off = 0; off < len; off += chunk) {
+        TEST_CHECK(cx_aes_ctr_update(&ctx, in + off, out + off, MIN(chunk, len - off)) == CX_OK);
+    }
+    test_expect("aes-ctr", out, len, v->cipher);
+
+    // Decryption, in place
+    TEST_CHECK(cx_aes_ctr_init(&ctx, &key, iv) == CX_OK);
+    for (size_t off = 0; off < len; off += chunk) {
+        TEST_CHECK(cx_aes_ctr_update(&ctx, out + off, out + off, MIN(chunk, len - off)) == CX_OK);
+    }
+    test_expect("aes-ctr decryption", out, len, v->plain);
+}
+
+static void test_gcm(const gcm_vector_t *v, size_t chunk)
+{
+    cx_aes_key_t key;
+    cx_aes_gcm_t ctx;
+    uint8_t      raw[32], iv[MAX_LEN], aad[MAX_LEN], in[MAX_LEN], out[MAX_LEN];
+    uint8_t      tag[CX_AES_BLOCK_SIZE];
+    size_t       iv_len  = test_unhex(v->iv, iv, sizeof(iv));
+    size_t       aad_len = test_unhex(v->aad, aad, sizeof(aad));
+    size_t       len     = test_unhex(v->plain, in, sizeof(in));
+
+    TEST_CHECK(cx_aes_init_key_no_throw(raw, test_unhex(v->key, raw, sizeof(raw)), &key) == CX_OK);
+    TEST_CHECK(cx_aes_gcm_init(&ctx, &key, CX_ENCRYPT, iv, iv_len) == CX_OK);
+    for (size_t off = 0; off < aad_len; off += chunk) {
+        TEST_CHECK(cx_aes_gcm_update_aad(&ctx, aad + off, MIN(chunk, aad_len - off)) == CX_OK);
+    }
+    for (size_t off = 0; off < len; off += chunk) {
+        TEST_CHECK(cx_aes_gcm_update(&ctx, in + off, out + off, MIN(chunk, len - off)) == CX_OK);
+    }
+    TEST_CHECK(cx_aes_gcm_finish(&ctx, tag, sizeof(tag)) == CX_OK);
+    test_expect("aes-gcm", out, len, v->cipher);
+    test_expect("aes-gcm tag", tag, sizeof(tag), v->tag);
+
+    // Decryption, with the right tag and a wrong one
+    for (int wrong = 0; wrong < 2; wrong++) {
+        tag[sizeof(tag) - 1] ^= wrong;
+        TEST_CHECK(cx_aes_gcm_init(&ctx, &key, CX_DECRYPT, iv, iv_len) == CX_OK);
+        TEST_CHECK(cx_aes_gcm_update_aad(&ctx, aad, aad_len) == CX_OK);
+        TEST_CHECK(cx_aes_gcm_update(&ctx, out, in, len) == CX_OK);
+        TEST_CHECK(cx_aes_gcm_check_tag(&ctx, tag, sizeof(tag))
+                   == (wrong ? CX_INVALID_PARAMETER_VALUE : CX_OK));
+        test_expect("aes-gcm decryption", in, len, v->plain);
+    }
+}
+
+int main(void)
+{
+    static const size_t chunks[] = {1, 5, 16, 17, MAX_LEN};
+
+    for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+        for (size_t i = 0; i < sizeof(ctr_vectors) / sizeof(ctr_vectors[0]); i++) {
+            test_ctr(&ctr_vectors[i], chunks[c]);
+        }
+        for (size_t i = 0; i < sizeof(gcm_vectors) / sizeof(gcm_vectors[0]); i++) {
+            test_gcm(&gcm_vectors[i], chunks[c]);
+        }
+    }
+    return test_end("test_aes_modes");
+}
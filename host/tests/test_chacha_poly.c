@@ -0,0 +1,200 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * ChaCha20, Poly1305 and ChaCha20-Poly1305 against the vectors of RFC 8439
+ * (2.4.2, 2.5.2 and 2.8.2), then against OpenSSL for random lengths and
+ * chunks, and for Poly1305 keys and messages of all-ones limbs which
+ * maximize the carries.
+ */
+#include <openssl/evp.h>
+
+#include "cx.h"
+#include "cx_test.h"
+#include "os_math.h"
+
+#define MAX_LEN 1024
+
+static const char sunscreen[]
+    = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the future, "
+      "sunscreen would be it.";
+
+static void test_rfc8439(void)
+{
+    cx_chacha20_t   chacha;
+    cx_poly1305_t   poly;
+    cx_chachapoly_t aead;
+    uint8_t         key[32], nonce[12], aad[12], out[sizeof(sunscreen) - 1];
+    uint8_t         tag[CX_POLY1305_TAG_SIZE];
+    const size_t    len = sizeof(out);
+
+    // 2.4.2
+    test_unhex("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f", key, 32);
+    test_unhex("000000000000004a00000000", nonce, 12);
+    TEST_CHECK(cx_chacha20_init(&chacha, key, nonce, 1) == CX_OK);
+    TEST_CHECK(cx_chacha20_update(&chacha, (const uint8_t *) sunscreen, out, len) == CX_OK);
+    test_expect("chacha20",
+                out,
+                len,
+                "6e2e359a2568f98041ba0728dd0d6981e97e7aec1d4360c20a27afccfd9fae0bf91b65c5524733ab8f"
+                "593dabcd62b3571639d624e65152ab8f530c359f0861d807ca0dbf500d6a6156a38e088a22b65e52bc"
+                "514d16ccf806818ce91ab77937365af90bbf74a35be6b40b8eedf2785e42874d");
+
+    // 2.5.2
+    test_unhex("85d6be7857556d337f4452fe42d506a80103808afb0db2fd4abff6af4149f51b", key, 32);
+    TEST_CHECK(cx_poly1305_init(&poly, key) == CX_OK);
+    TEST_CHECK(cx_poly1305_update(&poly, (const uint8_t *) "Cryptographic Forum Research Group", 34)
+               == CX_OK);
+    TEST_CHECK(cx_poly1305_final(&poly, tag) == CX_OK);
+    test_expect("poly1305", tag, sizeof(tag), "a8061dc1305136c6c22b8baf0c0127a9");
+
+    // 2.8.2
+    test_unhex("808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f", key, 32);
+    test_unhex("070000004041424344454647", nonce, 12);
+    test_unhex("50515253c0c1c2c3c4c5c6c7", aad, 12);
+    TEST_CHECK(cx_chachapoly_init(&aead, key, CX_ENCRYPT, nonce) == CX_OK);
+    TEST_CHECK(cx_chachapoly_update_aad(&aead, aad, sizeof(aad)) == CX_OK);
+    TEST_CHECK(cx_chachapoly_update(&aead, (const uint8_t *) sunscreen, out, len) == CX_OK);
+    TEST_CHECK(cx_chachapoly_finish(&aead, tag) == CX_OK);
+    test_expect("chacha20-poly1305",
+                out,
+                len,
+                "d31a8d34648e60db7b86afbc53ef7ec2a4aded51296e08fea9e2b5a736ee62d63dbea45e8ca96712"
+                "82fafb69da92728b1a71de0a9e060b2905d6a5b67ecd3b3692ddbd7f2d778b8c9803aee328091b58"
+                "fab324e4fad675945585808b4831d7bc3ff4def08e4b7a9de576d26586cec64b6116");
+    test_expect("chacha20-poly1305 tag", tag, sizeof(tag), "1ae10b594f09e26a7e902ecbd0600691");
+
+    // Decryption, with the right tag and a wrong one
+    for (int wrong = 0; wrong < 2; wrong++) {
+        tag[0] ^= wrong;
+        TEST_CHECK(cx_chachapoly_init(&aead, key, CX_DECRYPT, nonce) == CX_OK);
+        TEST_CHECK(cx_chachapoly_update_aad(&aead, aad, sizeof(aad)) == CX_OK);
+        TEST_CHECK(cx_chachapoly_update(&aead, out, out, len) == CX_OK);
+        TEST_CHECK(cx_chachapoly_check_tag(&aead, tag)
+                   == (wrong ? CX_INVALID_PARAMETER_VALUE : CX_OK));
+        TEST_CHECK(memcmp(out, sunscreen, len) == 0);
+        TEST_CHECK(cx_chachapoly_init(&aead, key, CX_ENCRYPT, nonce) == CX_OK);
+        TEST_CHECK(cx_chachapoly_update(&aead, out, out, len) == CX_OK);
+        TEST_CHECK(cx_chachapoly_finish(&aead, tag) == CX_OK);
+    }
+}
+
+static void openssl_poly1305(const uint8_t *key, const uint8_t *msg, size_t len, uint8_t *tag)
+{
+    EVP_MAC     *mac = EVP_MAC_fetch(NULL, "POLY1305", NULL);
+    EVP_MAC_CTX *ctx = EVP_MAC_CTX_new(mac);
+    size_t       tag_len;
+
+    TEST_CHECK(EVP_MAC_init(ctx, key, 32, NULL) == 1);
+    TEST_CHECK(EVP_MAC_update(ctx, msg, len) == 1);
+    TEST_CHECK(EVP_MAC_final(ctx, tag, &tag_len, CX_POLY1305_TAG_SIZE) == 1);
+    EVP_MAC_CTX_free(ctx);
+    EVP_MAC_free(mac);
+}
+
+static void openssl_chachapoly(const uint8_t *key,
+                               const uint8_t *nonce,
+                               const uint8_t *aad,
+                               size_t         aad_len,
+                               const uint8_t *in,
+                               size_t         len,
+                               uint8_t       *out,
+                               uint8_t       *tag)
+{
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    int             n;
+
+    TEST_CHECK(EVP_EncryptInit_ex(ctx, EVP_chacha20_poly1305(), NULL, key, nonce) == 1);
+    TEST_CHECK(EVP_EncryptUpdate(ctx, NULL, &n, aad, (int) aad_len) == 1);
+    TEST_CHECK(EVP_EncryptUpdate(ctx, out, &n, in, (int) len) == 1);
+    TEST_CHECK(EVP_EncryptFinal_ex(ctx, out + n, &n) == 1);
+    TEST_CHECK(EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, CX_POLY1305_TAG_SIZE, tag) == 1);
+    EVP_CIPHER_CTX_free(ctx);
+}
+
+static size_t random_len(size_t max)
+{
+    uint32_t r;
+
+    cx_rng_no_throw((uint8_t *) &r, sizeof(r));
+    return r % (max + 1);
+}
+
+static void test_poly1305_carries(void)
+{
+    cx_poly1305_t poly;
+    uint8_t       key[32], msg[MAX_LEN], tag[CX_POLY1305_TAG_SIZE], expected[CX_POLY1305_TAG_SIZE];
+
+    // Largest clamped r and s, and messages of 0xFF bytes
+    memset(key, 0xFF, sizeof(key));
+    memset(msg, 0xFF, sizeof(msg));
+    for (size_t len = 0; len <= 4 * 16 + 1; len++) {
+        openssl_poly1305(key, msg, len, expected);
+        TEST_CHECK(cx_poly1305_init(&poly, key) == CX_OK);
+        TEST_CHECK(cx_poly1305_update(&poly, msg, len) == CX_OK);
+        TEST_CHECK(cx_poly1305_final(&poly, tag) == CX_OK);
+        TEST_CHECK(memcmp(tag, expected, sizeof(tag)) == 0);
+    }
+}
+
+static void test_random(void)
+{
+    cx_chachapoly_t aead;
+    cx_poly1305_t   poly;
+    uint8_t         key[32], nonce[12], aad[64], in[MAX_LEN], out[MAX_LEN], expected[MAX_LEN];
+    uint8_t         tag[CX_POLY1305_TAG_SIZE], expected_tag[CX_POLY1305_TAG_SIZE];
+
+    for (int i = 0; i < 200; i++) {
+        size_t len     = random_len(MAX_LEN);
+        size_t aad_len = random_len(sizeof(aad));
+        size_t chunk   = 1 + random_len(100);
+
+        cx_rng_no_throw(key, sizeof(key));
+        cx_rng_no_throw(nonce, sizeof(nonce));
+        cx_rng_no_throw(aad, sizeof(aad));
+        cx_rng_no_throw(in, sizeof(in));
+
+        openssl_chachapoly(key, nonce, aad, aad_len, in, len, expected, expected_tag);
+        TEST_CHECK(cx_chachapoly_init(&aead, key, CX_ENCRYPT, nonce) == CX_OK);
+        for (size_t off = 0; off < aad_len; off += chunk) {
+            TEST_CHECK(cx_chachapoly_update_aad(&aead, aad + off, MIN(chunk, aad_len - off))
+                       == CX_OK);
+        }
+        for (size_t off = 0; off < len; off += chunk) {
+            TEST_CHECK(cx_chachapoly_update(&aead, in + off, out + off, MIN(chunk, len - off))
+                       == CX_OK);
+        }
+        TEST_CHECK(cx_chachapoly_finish(&aead, tag) == CX_OK);
+        TEST_CHECK(memcmp(out, expected, len) == 0);
+        TEST_CHECK(memcmp(tag, expected_tag, sizeof(tag)) == 0);
+
+        openssl_poly1305(key, in, len, expected_tag);
+        TEST_CHECK(cx_poly1305_init(&poly, key) == CX_OK);
+        for (size_t off = 0; off < len; off += chunk) {
+            TEST_CHECK(cx_poly1305_update(&poly, in + off, MIN(chunk, len - off)) == CX_OK);
+        }
+        TEST_CHECK(cx_poly1305_final(&poly, tag) == CX_OK);
+        TEST_CHECK(memcmp(tag, expected_tag, sizeof(tag)) == 0);
+    }
+}
+
+int main(void)
+{
+    test_rfc8439();
+    test_poly1305_carries();
+    test_random();
+    return test_end("test_chacha_poly");
+}
@@ -0,0 +1,89 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * Byte swaps of lib_cxng/src/cx_utils.c, built on the compiler builtins, or
+ * with CX_UTILS_GENERIC for test_cx_utils_generic, against the portable
+ * shifts and masks, for random words and buffers of 0 to 39 words.
+ */
+#include "cx.h"
+#include "cx_test.h"
+#include "lib_cxng/src/cx_utils.h"
+
+#define MAX_WORDS 40
+
+static uint32_t ref_swap_uint32(uint32_t v)
+{
+    return ((v << 24) & 0xFF000000U) | ((v << 8) & 0x00FF0000U) | ((v >> 8) & 0x0000FF00U)
+           | ((v >> 24) & 0x000000FFU);
+}
+
+static uint64_t ref_swap_uint64(uint64_t v)
+{
+    uint32_t h = (uint32_t) (v >> 32);
+    uint32_t l = (uint32_t) v;
+
+    return ((uint64_t) ref_swap_uint32(l) << 32) | ref_swap_uint32(h);
+}
+
+static void test_words(void)
+{
+    uint32_t u32;
+    uint64_t u64;
+
+    TEST_CHECK(cx_swap_uint32(0x01020304) == 0x04030201);
+    TEST_CHECK(cx_swap_uint64(0x0102030405060708ULL) == 0x0807060504030201ULL);
+    for (int i = 0; i < 10000; i++) {
+        cx_rng_no_throw((uint8_t *) &u32, sizeof(u32));
+        cx_rng_no_throw((uint8_t *) &u64, sizeof(u64));
+        TEST_CHECK(cx_swap_uint32(u32) == ref_swap_uint32(u32));
+        TEST_CHECK(cx_swap_uint64(u64) == ref_swap_uint64(u64));
+    }
+}
+
+static void test_buffers(void)
+{
+    uint32_t b32[MAX_WORDS], r32[MAX_WORDS];
+    uint64_t b64[MAX_WORDS], r64[MAX_WORDS];
+
+    for (size_t len = 0; len < MAX_WORDS; len++) {
+        cx_rng_no_throw((uint8_t *) b32, sizeof(b32));
+        cx_rng_no_throw((uint8_t *) b64, sizeof(b64));
+        memcpy(r32, b32, sizeof(b32));
+        memcpy(r64, b64, sizeof(b64));
+        for (size_t i = 0; i < len; i++) {
+            r32[i] = ref_swap_uint32(r32[i]);
+            r64[i] = ref_swap_uint64(r64[i]);
+        }
+        cx_swap_buffer32(b32, len);
+        cx_swap_buffer64(b64, (int) len);
+        if (memcmp(b32, r32, sizeof(b32))) {
+            fprintf(stderr, "cx_swap_buffer32: mismatch for %zu words\n", len);
+            test_failures++;
+        }
+        if (memcmp(b64, r64, sizeof(b64))) {
+            fprintf(stderr, "cx_swap_buffer64: mismatch for %zu words\n", len);
+            test_failures++;
+        }
+    }
+}
+
+int main(void)
+{
+    test_words();
+    test_buffers();
+    return test_end("test_cx_utils");
+}
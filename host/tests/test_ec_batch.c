@@ -0,0 +1,115 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * Batch verification of ECDSA signatures, with and without the parity of R,
+ * against the verification of each signature.
+ */
+#include "cx.h"
+#include "cx_test.h"
+
+#define COUNT CX_EC_BATCH_MAX_SIZE
+
+static cx_ecfp_public_key_t  pukeys[COUNT];
+static cx_ecfp_private_key_t pvkeys[COUNT];
+static uint8_t               hashes[COUNT][CX_SHA256_SIZE];
+static uint8_t               sigs[COUNT][72];
+static cx_ecdsa_batch_item_t items[COUNT];
+
+static void sign(cx_curve_t curve)
+{
+    for (size_t i = 0; i < COUNT; i++) {
+        size_t   sig_len = sizeof(sigs[i]);
+        uint32_t info;
+
+        TEST_CHECK(cx_ecfp_generate_pair_no_throw(curve, &pukeys[i], &pvkeys[i], false) == CX_OK);
+        cx_rng_no_throw(hashes[i], sizeof(hashes[i]));
+        TEST_CHECK(cx_ecdsa_sign_no_throw(
+                       &pvkeys[i], CX_RND_TRNG, CX_SHA256, hashes[i], 32, sigs[i], &sig_len, &info)
+                   == CX_OK);
+        items[i] = (cx_ecdsa_batch_item_t){
+            .pukey    = &pukeys[i],
+            .hash     = hashes[i],
+            .hash_len = sizeof(hashes[i]),
+            .sig      = sigs[i],
+            .sig_len  = sig_len,
+            .info     = info | CX_ECDSA_BATCH_PARITY_KNOWN,
+        };
+    }
+}
+
+static bool batch_verify(size_t count)
+{
+    bool verified = true;
+
+    TEST_CHECK(cx_ecdsa_batch_verify_no_throw(items, count, &verified) == CX_OK);
+    return verified;
+}
+
+static void test_curve(cx_curve_t curve)
+{
+    const cx_ecfp_public_key_t *pukey;
+    bool                        verified;
+
+    sign(curve);
+    for (size_t n = 1; n <= COUNT; n++) {
+        TEST_CHECK(batch_verify(n));
+    }
+
+    // Parity unknown: the signature is verified alone
+    items[0].info &= ~CX_ECDSA_BATCH_PARITY_KNOWN;
+    TEST_CHECK(batch_verify(COUNT));
+    items[COUNT - 1].info = 0;
+    TEST_CHECK(batch_verify(COUNT));
+    for (size_t i = 0; i < COUNT; i++) {
+        items[i].info = 0;
+    }
+    TEST_CHECK(batch_verify(COUNT));
+
+    // Wrong parity
+    sign(curve);
+    items[COUNT - 1].info ^= CX_ECCINFO_PARITY_ODD;
+    TEST_CHECK(!batch_verify(COUNT));
+    items[COUNT - 1].info &= ~CX_ECDSA_BATCH_PARITY_KNOWN;
+    TEST_CHECK(batch_verify(COUNT));
+
+    // Invalid signatures, batched or verified alone
+    hashes[0][0] ^= 1;
+    TEST_CHECK(!batch_verify(COUNT));
+    items[0].info = 0;
+    TEST_CHECK(!batch_verify(COUNT));
+    hashes[0][0] ^= 1;
+    TEST_CHECK(batch_verify(COUNT));
+    sigs[COUNT - 1][items[COUNT - 1].sig_len - 1] ^= 1;
+    TEST_CHECK(!batch_verify(COUNT));
+
+    // Invalid parameters
+    pukey          = items[1].pukey;
+    items[1].pukey = NULL;
+    TEST_CHECK(cx_ecdsa_batch_verify_no_throw(items, COUNT, &verified) == CX_INVALID_PARAMETER);
+    items[1].pukey = pukey;
+    items[0].pukey = NULL;
+    TEST_CHECK(cx_ecdsa_batch_verify_no_throw(items, 1, &verified) == CX_INVALID_PARAMETER);
+    TEST_CHECK(cx_ecdsa_batch_verify_no_throw(items, COUNT + 1, &verified)
+               == CX_INVALID_PARAMETER);
+}
+
+int main(void)
+{
+    test_curve(CX_CURVE_SECP256K1);
+    test_curve(CX_CURVE_SECP256R1);
+    return test_end("test_ec_batch");
+}
@@ -0,0 +1,194 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * Streaming Ed25519 signatures of src/cx_eddsa_stream.c, on the RFC 8032
+ * section 7.1 test vectors, with both passes split at random. The signatures
+ * are also compared with cx_eddsa_sign_no_throw, which the host backend
+ * computes with OpenSSL, and the signature must be refused when the second
+ * pass differs from the first one by a byte or by its length.
+ */
+#include "cx.h"
+#include "cx_test.h"
+#include "os_utils.h"
+
+#define MAX_MSG_LEN 1023
+#define MAX_CHUNKS  5
+
+typedef struct {
+    const char *secret_key;
+    const char *public_key;
+    const char *message;
+    const char *signature;
+} eddsa_vector_t;
+
+static const eddsa_vector_t vectors[] = {
+    {"9d61b19deffd5a60ba844af492ec2cc44449c5697b326919703bac031cae7f60",
+     "d75a980182b10ab7d54bfed3c964073a0ee172f3daa62325af021a68f707511a",
+     "",
+     "e5564300c360ac729086e2cc806e828a84877f1eb8e5d974d873e06522490155"
+     "5fb8821590a33bacc61e39701cf9b46bd25bf5f0595bbe24655141438e7a100b"},
+    {"4ccd089b28ff96da9db6c346ec114e0f5b8a319f35aba624da8cf6ed4fb8a6fb",
+     "3d4017c3e843895a92b70aa74d1b7ebc9c982ccf2ec4968cc0cd55f12af4660c",
+     "72",
+     "92a009a9f0d4cab8720e820b5f642540a2b27b5416503f8fb3762223ebdb69da"
+     "085ac1e43e15996e458f3613d0f11d8c387b2eaeb4302aeeb00d291612bb0c00"},
+    {"c5aa8df43f9f837bedb7442f31dcb7b166d38535076f094b85ce3a2e0b4458f7",
+     "fc51cd8e6218a1a38da47ed00230f0580816ed13ba3303ac5deb911548908025",
+     "af82",
+     "6291d657deec24024827e69c3abe01a30ce548a284743a445e3680d7db5ac3ac"
+     "18ff9b538d16f290ae67f760984dc6594a7c15e9716ed28dc027beceea1ec40a"},
+    {"f5e5767cf153319517630f226876b86c8160cc583bc013744c6bf255f5cc0ee5",
+     "278117fc144c72340f67d0f2316e8386ceffbf2b2428c9c51fef7c597f1d426e",
+     "08b8b2b733424243760fe426a4b54908632110a66c2f6591eabd3345e3e4eb98fa6e264bf09efe12"
+     "ee50f8f54e9f77b1e355f6c50544e23fb1433ddf73be84d879de7c0046dc4996d9e773f4bc9efe57"
+     "38829adb26c81b37c93a1b270b20329d658675fc6ea534e0810a4432826bf58c941efb65d57a338b"
+     "bd2e26640f89ffbc1a858efcb8550ee3a5e1998bd177e93a7363c344fe6b199ee5d02e82d522c4fe"
+     "ba15452f80288a821a579116ec6dad2b3b310da903401aa62100ab5d1a36553e06203b33890cc9b8"
+     "32f79ef80560ccb9a39ce767967ed628c6ad573cb116dbefefd75499da96bd68a8a97b928a8bbc10"
+     "3b6621fcde2beca1231d206be6cd9ec7aff6f6c94fcd7204ed3455c68c83f4a41da4af2b74ef5c53"
+     "f1d8ac70bdcb7ed185ce81bd84359d44254d95629e9855a94a7c1958d1f8ada5d0532ed8a5aa3fb2"
+     "d17ba70eb6248e594e1a2297acbbb39d502f1a8c6eb6f1ce22b3de1a1f40cc24554119a831a9aad6"
+     "079cad88425de6bde1a9187ebb6092cf67bf2b13fd65f27088d78b7e883c8759d2c4f5c65adb7553"
+     "878ad575f9fad878e80a0c9ba63bcbcc2732e69485bbc9c90bfbd62481d9089beccf80cfe2df16a2"
+     "cf65bd92dd597b0707e0917af48bbb75fed413d238f5555a7a569d80c3414a8d0859dc65a46128ba"
+     "b27af87a71314f318c782b23ebfe808b82b0ce26401d2e22f04d83d1255dc51addd3b75a2b1ae078"
+     "4504df543af8969be3ea7082ff7fc9888c144da2af58429ec96031dbcad3dad9af0dcbaaaf268cb8"
+     "fcffead94f3c7ca495e056a9b47acdb751fb73e666c6c655ade8297297d07ad1ba5e43f1bca32301"
+     "651339e22904cc8c42f58c30c04aafdb038dda0847dd988dcda6f3bfd15c4b4c4525004aa06eeff8"
+     "ca61783aacec57fb3d1f92b0fe2fd1a85f6724517b65e614ad6808d6f6ee34dff7310fdc82aebfd9"
+     "04b01e1dc54b2927094b2db68d6f903b68401adebf5a7e08d78ff4ef5d63653a65040cf9bfd4aca7"
+     "984a74d37145986780fc0b16ac451649de6188a7dbdf191f64b5fc5e2ab47b57f7f7276cd419c17a"
+     "3ca8e1b939ae49e488acba6b965610b5480109c8b17b80e1b7b750dfc7598d5d5011fd2dcc5600a3"
+     "2ef5b52a1ecc820e308aa342721aac0943bf6686b64b2579376504ccc493d97e6aed3fb0f9cd71a4"
+     "3dd497f01f17c0e2cb3797aa2a2f256656168e6c496afc5fb93246f6b1116398a346f1a641f3b041"
+     "e989f7914f90cc2c7fff357876e506b50d334ba77c225bc307ba537152f3f1610e4eafe595f6d9d9"
+     "0d11faa933a15ef1369546868a7f3a45a96768d40fd9d03412c091c6315cf4fde7cb68606937380d"
+     "b2eaaa707b4c4185c32eddcdd306705e4dc1ffc872eeee475a64dfac86aba41c0618983f8741c5ef"
+     "68d3a101e8a3b8cac60c905c15fc910840b94c00a0b9d0",
+     "0aab4c900501b3e24d7cdf4663326a3a87df5e4843b2cbdb67cbf6e460fec350"
+     "aa5371b1508f9f4528ecea23c436d94b5e8fcd4f681e30a6ac00a9704a188a03"},
+};
+
+typedef cx_err_t (*eddsa_update_t)(cx_eddsa_sign_ctx_t *ctx, const uint8_t *data, size_t len);
+
+// Feeds the message in up to MAX_CHUNKS chunks of random lengths, some of them empty
+static cx_err_t update_split(cx_eddsa_sign_ctx_t *ctx,
+                             eddsa_update_t       update,
+                             const uint8_t       *msg,
+                             size_t               len)
+{
+    cx_err_t error  = CX_OK;
+    size_t   count  = 1 + rand() % MAX_CHUNKS;
+    size_t   offset = 0;
+
+    for (size_t i = 0; (i < count) && (error == CX_OK); i++) {
+        size_t n = (i == count - 1) ? len - offset : (size_t) rand() % (len - offset + 1);
+
+        error = update(ctx, msg + offset, n);
+        offset += n;
+    }
+    return error;
+}
+
+static cx_err_t sign_stream(const cx_ecfp_private_key_t *key,
+                            const uint8_t               *nonce_msg,
+                            size_t                       nonce_len,
+                            const uint8_t               *challenge_msg,
+                            size_t                       challenge_len,
+                            uint8_t                     *sig)
+{
+    cx_err_t            error;
+    cx_eddsa_sign_ctx_t ctx;
+
+    CX_CHECK(cx_eddsa_sign_init_no_throw(&ctx, key, CX_SHA512));
+    CX_CHECK(update_split(&ctx, cx_eddsa_sign_update_nonce_no_throw, nonce_msg, nonce_len));
+    CX_CHECK(update_split(
+        &ctx, cx_eddsa_sign_update_challenge_no_throw, challenge_msg, challenge_len));
+    CX_CHECK(cx_eddsa_sign_final_no_throw(&ctx, sig, 64));
+
+end:
+    return error;
+}
+
+static void test_vector(const eddsa_vector_t *v)
+{
+    static uint8_t        msg[MAX_MSG_LEN], other[MAX_MSG_LEN + 1];
+    cx_ecfp_private_key_t key = {.curve = CX_CURVE_Ed25519, .d_len = 32};
+    cx_ecfp_public_key_t  pukey;
+    uint8_t               sig[64], encoded[32];
+    size_t                len = test_unhex(v->message, msg, sizeof(msg));
+
+    test_unhex(v->secret_key, key.d, sizeof(key.d));
+    TEST_CHECK(cx_eddsa_get_public_key_no_throw(&key, CX_SHA512, &pukey, NULL, 0, NULL, 0)
+               == CX_OK);
+    for (size_t i = 0; i < sizeof(encoded); i++) {
+        encoded[i] = pukey.W[64 - i];
+    }
+    encoded[31] |= (pukey.W[32] & 1) << 7;
+    test_expect("public key", encoded, sizeof(encoded), v->public_key);
+
+    for (int i = 0; i < 8; i++) {
+        memset(sig, 0, sizeof(sig));
+        TEST_CHECK(sign_stream(&key, msg, len, msg, len, sig) == CX_OK);
+        test_expect("streamed signature", sig, sizeof(sig), v->signature);
+    }
+    TEST_CHECK(cx_eddsa_sign_no_throw(&key, CX_SHA512, msg, len, sig, sizeof(sig)) == CX_OK);
+    test_expect("one-shot signature", sig, sizeof(sig), v->signature);
+
+    // One more byte in the second pass
+    memcpy(other, msg, len);
+    other[len] = 0;
+    TEST_CHECK(sign_stream(&key, msg, len, other, len + 1, sig) == CX_INVALID_PARAMETER_VALUE);
+    if (len == 0) {
+        return;
+    }
+    // One byte less, then one bit flipped
+    TEST_CHECK(sign_stream(&key, msg, len, msg, len - 1, sig) == CX_INVALID_PARAMETER_VALUE);
+    other[rand() % len] ^= 1 << (rand() % 8);
+    TEST_CHECK(sign_stream(&key, msg, len, other, len, sig) == CX_INVALID_PARAMETER_VALUE);
+}
+
+static void test_misuse(void)
+{
+    cx_ecfp_private_key_t key = {.curve = CX_CURVE_Ed25519, .d_len = 32};
+    cx_eddsa_sign_ctx_t   ctx;
+    uint8_t               sig[64] = {0};
+
+    TEST_CHECK(cx_eddsa_sign_init_no_throw(&ctx, &key, CX_SHA256) == CX_INVALID_PARAMETER);
+    key.curve = CX_CURVE_SECP256K1;
+    TEST_CHECK(cx_eddsa_sign_init_no_throw(&ctx, &key, CX_SHA512) == CX_EC_INVALID_CURVE);
+    key.curve = CX_CURVE_Ed25519;
+
+    // No nonce update after the second pass has started
+    TEST_CHECK(cx_eddsa_sign_init_no_throw(&ctx, &key, CX_SHA512) == CX_OK);
+    TEST_CHECK(cx_eddsa_sign_update_challenge_no_throw(&ctx, sig, 1) == CX_OK);
+    TEST_CHECK(cx_eddsa_sign_update_nonce_no_throw(&ctx, sig, 1) == CX_INVALID_PARAMETER);
+    TEST_CHECK(cx_eddsa_sign_final_no_throw(&ctx, sig, sizeof(sig) - 1)
+               == CX_INVALID_PARAMETER_SIZE);
+    // The context is erased by final
+    TEST_CHECK(cx_eddsa_sign_update_challenge_no_throw(&ctx, sig, 1) == CX_INVALID_PARAMETER);
+}
+
+int main(void)
+{
+    srand(1);
+    for (size_t i = 0; i < ARRAYLEN(vectors); i++) {
+        test_vector(&vectors[i]);
+    }
+    test_misuse();
+    return test_end("test_eddsa_stream");
+}
@@ -0,0 +1,232 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * Streaming HKDF-Expand against the SHA-256 test cases of RFC 5869, read in
+ * chunks of every size, then against OpenSSL for SHA-384 and SHA-512 with
+ * random chunks, and the limit of 255 blocks. The memory used by the reader
+ * on the host is printed at the end.
+ */
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#include <openssl/kdf.h>
+
+#include "cx.h"
+#include "cx_test.h"
+#include "lib_cxng/src/cx_hkdf.h"
+#include "os_math.h"
+#include "os_utils.h"
+
+#define MAX_LEN     (255 * CX_SHA512_SIZE)
+#define STACK_PAINT 16384
+
+typedef struct {
+    const char *ikm;
+    const char *salt;
+    const char *info;
+    const char *prk;
+    const char *okm;
+} hkdf_vector_t;
+
+// RFC 5869, appendix A, test cases 1 to 3
+static const hkdf_vector_t vectors[] = {
+    {"0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b",
+     "000102030405060708090a0b0c",
+     "f0f1f2f3f4f5f6f7f8f9",
+     "077709362c2e32df0ddc3f0dc47bba6390b6c73bb50f9c3122ec844ad7c2b3e5",
+     "3cb25f25faacd57a90434f64d0362f2a2d2d0a90cf1a5a4c5db02d56ecc4c5bf34007208d5b887185865"},
+    {"000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f202122232425262728292a2b2c2d"
+     "2e2f303132333435363738393a3b3c3d3e3f404142434445464748494a4b4c4d4e4f",
+     "606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f808182838485868788898a8b8c8d"
+     "8e8f909192939495969798999a9b9c9d9e9fa0a1a2a3a4a5a6a7a8a9aaabacadaeaf",
+     "b0b1b2b3b4b5b6b7b8b9babbbcbdbebfc0c1c2c3c4c5c6c7c8c9cacbcccdcecfd0d1d2d3d4d5d6d7d8d9dadbdcdd"
+     "dedfe0e1e2e3e4e5e6e7e8e9eaebecedeeeff0f1f2f3f4f5f6f7f8f9fafbfcfdfeff",
+     "06a6b88c5853361a06104c9ceb35b45cef760014904671014a193f40c15fc244",
+     "b11e398dc80327a1c8e7f78c596a49344f012eda2d4efad8a050cc4c19afa97c59045a99cac7827271cb41c65e59"
+     "0e09da3275600c2f09b8367793a9aca3db71cc30c58179ec3e87c14c01d5c1f3434f1d87"},
+    {"0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b",
+     "",
+     "",
+     "19ef24a32c717b167f33a91d6f648bdf96596776afdb6377ac434c1c293ccb04",
+     "8da4e775a563c18f715f802a063c5a31b8a11f5c5ee1879ec3454e5f3c738d2d9d201395faa4b61a96c8"},
+};
+
+static uint8_t okm[MAX_LEN];
+static uint8_t expected[MAX_LEN];
+
+static void test_vector(const hkdf_vector_t *v)
+{
+    cx_hkdf_expand_t ctx;
+    cx_hmac_key_t    salt_key;
+    uint8_t          ikm[128], salt[128], info[128], prk[CX_SHA256_SIZE];
+    size_t           ikm_len  = test_unhex(v->ikm, ikm, sizeof(ikm));
+    size_t           salt_len = test_unhex(v->salt, salt, sizeof(salt));
+    size_t           info_len = test_unhex(v->info, info, sizeof(info));
+    size_t           okm_len  = test_unhex(v->okm, expected, sizeof(expected));
+
+    // HKDF-Extract, an empty salt being a block of zeros
+    TEST_CHECK(cx_hmac_key_init(&salt_key, CX_SHA256, salt, salt_len) == CX_OK);
+    TEST_CHECK(cx_hmac_key_compute(&salt_key, ikm, ikm_len, prk) == CX_OK);
+    test_expect("prk", prk, sizeof(prk), v->prk);
+
+    for (size_t chunk = 1; chunk <= okm_len; chunk++) {
+        TEST_CHECK(
+            cx_hkdf_expand_init(&ctx, CX_SHA256, prk, sizeof(prk), info, info_len) == CX_OK);
+        for (size_t off = 0; off < okm_len; off += chunk) {
+            TEST_CHECK(cx_hkdf_expand_read(&ctx, okm + off, MIN(chunk, okm_len - off)) == CX_OK);
+        }
+        if (memcmp(okm, expected, okm_len)) {
+            fprintf(stderr, "okm: mismatch with chunks of %zu bytes\n", chunk);
+            test_failures++;
+        }
+    }
+
+    // One-shot override of the OS function
+    memset(okm, 0, okm_len);
+    cx_hkdf_expand(CX_SHA256, prk, sizeof(prk), info, info_len, okm, okm_len);
+    test_expect("cx_hkdf_expand", okm, okm_len, v->okm);
+}
+
+static void openssl_hkdf_expand(const char    *md,
+                                const uint8_t *prk,
+                                size_t         prk_len,
+                                const uint8_t *info,
+                                size_t         info_len,
+                                uint8_t       *out,
+                                size_t         out_len)
+{
+    EVP_KDF     *kdf  = EVP_KDF_fetch(NULL, "HKDF", NULL);
+    EVP_KDF_CTX *kctx = EVP_KDF_CTX_new(kdf);
+    int          mode = EVP_KDF_HKDF_MODE_EXPAND_ONLY;
+    OSSL_PARAM   params[]
+        = {OSSL_PARAM_construct_utf8_string(OSSL_KDF_PARAM_DIGEST, (char *) md, 0),
+           OSSL_PARAM_construct_int(OSSL_KDF_PARAM_MODE, &mode),
+           OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_KEY, (void *) prk, prk_len),
+           OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_INFO, (void *) info, info_len),
+           OSSL_PARAM_construct_end()};
+
+    TEST_CHECK(EVP_KDF_derive(kctx, out, out_len, params) == 1);
+    EVP_KDF_CTX_free(kctx);
+    EVP_KDF_free(kdf);
+}
+
+static void test_random(cx_md_t md_type, const char *md, size_t mac_len)
+{
+    cx_hkdf_expand_t ctx;
+    uint8_t          prk[CX_SHA512_SIZE], info[64], len[2];
+    size_t           okm_len, chunk;
+
+    for (int i = 0; i < 50; i++) {
+        cx_rng_no_throw(prk, sizeof(prk));
+        cx_rng_no_throw(info, sizeof(info));
+        cx_rng_no_throw(len, sizeof(len));
+        okm_len = 1 + U2BE(len, 0) % (255 * mac_len);
+        openssl_hkdf_expand(md, prk, mac_len, info, i, expected, okm_len);
+
+        TEST_CHECK(cx_hkdf_expand_init(&ctx, md_type, prk, mac_len, info, i) == CX_OK);
+        for (size_t off = 0; off < okm_len; off += chunk) {
+            cx_rng_no_throw(len, 1);
+            chunk = MIN((size_t) len[0] + 1, okm_len - off);
+            TEST_CHECK(cx_hkdf_expand_read(&ctx, okm + off, chunk) == CX_OK);
+        }
+        if (memcmp(okm, expected, okm_len)) {
+            fprintf(stderr, "%s: mismatch for %zu bytes\n", md, okm_len);
+            test_failures++;
+        }
+    }
+}
+
+static void test_limits(void)
+{
+    cx_hkdf_expand_t ctx;
+    uint8_t          prk[CX_SHA256_SIZE] = {0};
+
+    TEST_CHECK(cx_hkdf_expand_init(&ctx, CX_SHA256, prk, sizeof(prk), NULL, 0) == CX_OK);
+    TEST_CHECK(cx_hkdf_expand_read(&ctx, okm, 255 * CX_SHA256_SIZE + 1) == CX_INVALID_PARAMETER);
+    TEST_CHECK(cx_hkdf_expand_read(&ctx, okm, 255 * CX_SHA256_SIZE - 1) == CX_OK);
+    TEST_CHECK(cx_hkdf_expand_read(&ctx, okm, 2) == CX_INVALID_PARAMETER);
+    TEST_CHECK(cx_hkdf_expand_read(&ctx, okm, 1) == CX_OK);
+    TEST_CHECK(cx_hkdf_expand_read(&ctx, okm, 1) == CX_INVALID_PARAMETER);
+    TEST_CHECK(cx_hkdf_expand_read(&ctx, okm, 0) == CX_OK);
+
+    TEST_CHECK(cx_hkdf_expand_init(&ctx, CX_SHA3, prk, sizeof(prk), NULL, 0)
+               == CX_INVALID_PARAMETER);
+    TEST_CHECK(cx_hkdf_expand_init(&ctx, CX_SHA256, prk, sizeof(prk), NULL, 1)
+               == CX_INVALID_PARAMETER);
+    TEST_CHECK(cx_hkdf_expand_init(NULL, CX_SHA256, prk, sizeof(prk), NULL, 0)
+               == CX_INVALID_PARAMETER);
+    TEST_CHECK(cx_hkdf_expand_read(NULL, okm, 1) == CX_INVALID_PARAMETER);
+}
+
+/*
+ * The stack used by a call is estimated by filling the area below the frame
+ * of the caller with a pattern, then looking for the deepest byte changed.
+ */
+static uintptr_t stack_area;
+
+static __attribute__((noinline)) void stack_paint(void)
+{
+    volatile uint8_t area[STACK_PAINT];
+
+    for (size_t i = 0; i < STACK_PAINT; i++) {
+        area[i] = 0xA5;
+    }
+    stack_area = (uintptr_t) area;
+}
+
+static size_t stack_used(void)
+{
+    const volatile uint8_t *area = (const volatile uint8_t *) stack_area;
+    size_t                  i    = 0;
+
+    while ((i < STACK_PAINT) && (area[i] == 0xA5)) {
+        i++;
+    }
+    return STACK_PAINT - i;
+}
+
+static void report_footprint(void)
+{
+    cx_hkdf_expand_t ctx;
+    uint8_t          prk[CX_SHA512_SIZE] = {0};
+    uint8_t          out[1];
+    size_t           init_stack, read_stack;
+
+    stack_paint();
+    TEST_CHECK(cx_hkdf_expand_init(&ctx, CX_SHA512, prk, sizeof(prk), NULL, 0) == CX_OK);
+    init_stack = stack_used();
+    stack_paint();
+    TEST_CHECK(cx_hkdf_expand_read(&ctx, out, sizeof(out)) == CX_OK);
+    read_stack = stack_used();
+
+    printf("memory footprint on this host, SHA-512:\n");
+    printf("  cx_hkdf_expand_t     %4zu bytes\n", sizeof(cx_hkdf_expand_t));
+    printf("  cx_hmac_key_t        %4zu bytes\n", sizeof(cx_hmac_key_t));
+    printf("  cx_hkdf_expand_init  %4zu bytes of stack\n", init_stack);
+    printf("  cx_hkdf_expand_read  %4zu bytes of stack per block\n", read_stack);
+}
+
+int main(void)
+{
+    for (size_t i = 0; i < ARRAYLEN(vectors); i++) {
+        test_vector(&vectors[i]);
+    }
+    test_random(CX_SHA384, "SHA384", CX_SHA384_SIZE);
+    test_random(CX_SHA512, "SHA512", CX_SHA512_SIZE);
+    test_limits();
+    report_footprint();
+    return test_end("test_hkdf");
+}
@@ -0,0 +1,147 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * Replies gathered from several buffers (HAVE_IO_SCATTER_GATHER): the HID
+ * reports built by io_usb_hid_send_iov and the ledger protocol frames built by
+ * LEDGER_PROTOCOL_tx_iov must be the ones built from the concatenated reply,
+ * for random replies split at random, empty and NULL buffers included.
+ */
+#include "cx_test.h"
+#include "ledger_protocol.h"
+#include "os_io_seproxyhal.h"
+#include "os_io_usb.h"
+#include "ux.h"
+
+#define ITERATIONS 20000
+#define MAX_REPLY  600
+#define MAX_OUTPUT 8192
+
+// The UX state of the app, to which the IO code of lib_standard_app refers
+ux_state_t        G_ux;
+bolos_ux_params_t G_ux_params;
+
+static ledger_protocol_t lp;
+static uint8_t           reply[MAX_REPLY];
+static uint8_t           output[2][MAX_OUTPUT];
+static size_t            output_length[2];
+static int               current;
+
+static void output_append(const uint8_t *buffer, size_t length)
+{
+    if (output_length[current] + length > MAX_OUTPUT) {
+        fprintf(stderr, "output overflow\n");
+        exit(1);
+    }
+    memcpy(output[current] + output_length[current], buffer, length);
+    output_length[current] += length;
+}
+
+static void hid_send(unsigned char *buffer, unsigned short length)
+{
+    output_append(buffer, length);
+}
+
+static void lp_frames(void)
+{
+    for (;;) {
+        output_append(lp.chunk, lp.chunk_length);
+        if (lp.tx_apdu_buffer == NULL) {
+            break;
+        }
+        LEDGER_PROTOCOL_tx(NULL, 0);
+    }
+}
+
+static bool outputs_equal(void)
+{
+    return (output_length[0] == output_length[1])
+           && (memcmp(output[0], output[1], output_length[0]) == 0);
+}
+
+// Splits the reply in count buffers at random, some of them empty
+static void split(io_iovec_t *iov, uint8_t count, size_t length)
+{
+    size_t offset = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        size_t n = (i == count - 1) ? length - offset
+                   : (rand() % 3 == 0) ? 0
+                                       : (size_t) rand() % (length - offset + 1);
+
+        iov[i].ptr = (n == 0 && rand() % 2) ? NULL : reply + offset;
+        iov[i].len = n;
+        offset += n;
+    }
+}
+
+int main(void)
+{
+    io_iovec_t iov[IO_IOVEC_MAX];
+
+    srand(1);
+    for (int it = 0; it < ITERATIONS; it++) {
+        size_t  length = rand() % MAX_REPLY;
+        uint8_t count  = 1 + rand() % IO_IOVEC_MAX;
+
+        for (size_t i = 0; i < length; i++) {
+            reply[i] = rand();
+        }
+        split(iov, count, length);
+
+        // ledger protocol, for any MTU
+        memset(&lp, 0, sizeof(lp));
+        lp.mtu = LEDGER_PROTOCOL_MTU_MIN
+                 + rand() % (LEDGER_PROTOCOL_CHUNK_SIZE - LEDGER_PROTOCOL_MTU_MIN + 1);
+        LEDGER_PROTOCOL_init(&lp);
+        output_length[0] = output_length[1] = 0;
+        current                             = 0;
+        LEDGER_PROTOCOL_tx(reply, length);
+        lp_frames();
+        current = 1;
+        LEDGER_PROTOCOL_tx_iov(iov, count);
+        lp_frames();
+        if (!outputs_equal()) {
+            fprintf(
+                stderr, "ledger protocol: mismatch for %zu bytes in %u buffers\n", length, count);
+            test_failures++;
+        }
+
+        // USB HID, which never sends empty replies
+        if (length == 0) {
+            continue;
+        }
+        output_length[0] = output_length[1] = 0;
+        for (current = 0; current < 2; current++) {
+            io_usb_hid_init();
+            G_io_app.apdu_state = APDU_USB_HID;
+            if (current == 0) {
+                io_usb_hid_send(hid_send, length, reply);
+            }
+            else {
+                io_usb_hid_send_iov(hid_send, iov, count);
+            }
+            while (G_io_app.apdu_state != APDU_IDLE) {
+                io_usb_hid_sent(hid_send);
+            }
+        }
+        if (!outputs_equal()) {
+            fprintf(stderr, "usb hid: mismatch for %zu bytes in %u buffers\n", length, count);
+            test_failures++;
+        }
+    }
+    return test_end("test_io_iovec");
+}
@@ -0,0 +1,173 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * LZSS decompression of src/lzss.c, on streams produced by compress() of
+ * host/apdu_compress.py: literals only, a run copied by overlapping references,
+ * an APDU, and a reference 280 bytes back. Each stream is fed in chunks split
+ * at random, some of them empty, and must be finished only once entirely fed.
+ *
+ * Then the invalid streams are refused: a reference before the start of the
+ * output, an output overrunning the announced length, which is left as is
+ * past it, and a stream truncated in the middle of a reference is unfinished.
+ */
+#include "cx_test.h"
+#include "lzss.h"
+#include "os_utils.h"
+
+#define MAX_LENGTH 320
+#define GUARD      16
+#define ROUNDS     32
+
+typedef struct {
+    const char *name;
+    const char *data;
+    const char *stream;  // compress(data)
+} lzss_vector_t;
+
+static const lzss_vector_t vectors[] = {
+    {"literals",
+     "E001000003616263",
+     "FFE001000003616263"},
+    {"run",
+     "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA",
+     "01AA000F000F0000"},
+    {"apdu",
+     "E0040000950000000000000000000000000000000000000000000000000000000000000000000102030405060708"
+     "090A0B0C0D0E0F10111213000000000000000000000000000102030405060708090A0B0C0D0E0F10111213546865"
+     "20717569636B2062726F776E20666F78206A756D7073206F76657220746865206C617A7920646F672C2074686520"
+     "717569636B2062726F776E20666F7821",
+     "3FE00400009500000F000BFF0102030405060708FF090A0B0C0D0E0F10E711121301FF01FB546865FF2071756963"
+     "6B2062FF726F776E20666F78FF206A756D7073206FDF766572207401E06C617F7A7920646F672C00D20202CC21"},
+    {"far reference",
+     "404142434445464748494A4B4C4D4E4F50515253C67E816B4BFBE2FB54F6BDDF7C1CE18701BF31DE56720F476766"
+     "8759AA883C59EA56137BD285A1D83C54552F37AE655BDA027998CCE31A768E5FD9998F1F3F36EE43784D0DFABEA6"
+     "DAE4868EDC296D4EFF56E17020FB8FB1580590C509DC53CDAA3B489952D3529D069FEAB5C206139849B2011EAC32"
+     "88319C52469571368F57F6391D16FA8874F5987C175C41BB6D718E0F7059C7011B2F333D91C01DA50D0DAB338D7E"
+     "5E8F3EE66874A63AB1C39311A864C7DBCAE060E1F3BF090067A2E325A0213187D562C5A84F7E2E096B949FB06DA9"
+     "9E5A0B467080B6CF470CA6A52AD8ACFBA0EBB779247223924880C5A6A785B7D78C90E4AB63445266E39C3325F95E"
+     "AABA7360404142434445464748494A4B4C4D4E4F50515253",
+     "FF4041424344454647FF48494A4B4C4D4E4FFF50515253C67E816BFF4BFBE2FB54F6BDDFFF7C1CE18701BF31DEFF"
+     "56720F4767668759FFAA883C59EA56137BFFD285A1D83C54552FFF37AE655BDA027998FFCCE31A768E5FD999FF8F"
+     "1F3F36EE43784DFF0DFABEA6DAE4868EFFDC296D4EFF56E170FF20FB8FB1580590C5FF09DC53CDAA3B4899FF52D3"
+     "529D069FEAB5FFC206139849B2011EFFAC3288319C524695FF71368F57F6391D16FFFA8874F5987C175CFF41BB6D"
+     "718E0F7059FFC7011B2F333D91C0FF1DA50D0DAB338D7EFF5E8F3EE66874A63AFFB1C39311A864C7DBFFCAE060E1"
+     "F3BF0900FF67A2E325A0213187FFD562C5A84F7E2E09FF6B949FB06DA99E5AFF0B467080B6CF470CFFA6A52AD8AC"
+     "FBA0EBFFB779247223924880FFC5A6A785B7D78C90FFE4AB63445266E39CFF3325F95EAABA736006117F5253"},
+};
+
+static uint8_t out[MAX_LENGTH + GUARD];
+
+/*
+ * Decompresses a stream fed in random chunks into out, filled with a guard
+ * pattern beforehand. Returns false as soon as a chunk is refused, and
+ * otherwise whether the decompression is finished, and only at the end.
+ */
+static bool decode(const uint8_t *stream, size_t len, uint16_t out_length, bool *finished)
+{
+    lzss_ctx_t ctx;
+    size_t     offset = 0;
+    bool       early  = false;
+
+    memset(out, 0x5A, sizeof(out));
+    lzss_init(&ctx, out, out_length);
+    do {
+        size_t chunk = (size_t) rand() % (len - offset + 1);
+
+        if (!lzss_decompress(&ctx, stream + offset, chunk)) {
+            return false;
+        }
+        offset += chunk;
+        early = early || ((offset < len) && lzss_finished(&ctx));
+    } while (offset < len);
+    *finished = lzss_finished(&ctx) && !early;
+    return true;
+}
+
+static bool guard_intact(uint16_t out_length)
+{
+    for (size_t i = out_length; i < sizeof(out); i++) {
+        if (out[i] != 0x5A) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void test_vector(const lzss_vector_t *v)
+{
+    uint8_t    data[MAX_LENGTH], stream[LZSS_MAX_COMPRESSED_LENGTH(MAX_LENGTH)];
+    size_t     data_len   = test_unhex(v->data, data, sizeof(data));
+    size_t     stream_len = test_unhex(v->stream, stream, sizeof(stream));
+    lzss_ctx_t ctx;
+    bool       finished;
+
+    for (size_t round = 0; round < ROUNDS; round++) {
+        TEST_CHECK(decode(stream, stream_len, data_len, &finished) && finished);
+        if (memcmp(out, data, data_len) || !guard_intact(data_len)) {
+            fprintf(stderr, "%s: mismatch\n", v->name);
+            test_failures++;
+        }
+
+        // The announced length one byte short, on a literal or a reference
+        TEST_CHECK(!decode(stream, stream_len, data_len - 1, &finished));
+        TEST_CHECK(guard_intact(data_len - 1));
+    }
+
+    // Every strict prefix is accepted, but unfinished, then completed
+    for (size_t len = 0; len < stream_len; len++) {
+        lzss_init(&ctx, out, data_len);
+        TEST_CHECK(lzss_decompress(&ctx, stream, len));
+        TEST_CHECK(!lzss_finished(&ctx));
+        TEST_CHECK(lzss_decompress(&ctx, stream + len, stream_len - len));
+        TEST_CHECK(lzss_finished(&ctx));
+    }
+}
+
+static void test_invalid(void)
+{
+    uint8_t stream[8];
+    bool    finished;
+
+    // A reference before the start of the output, from the first item
+    test_unhex("000000", stream, sizeof(stream));
+    TEST_CHECK(!decode(stream, 3, 3, &finished));
+    test_unhex("00FFFF", stream, sizeof(stream));
+    TEST_CHECK(!decode(stream, 3, MAX_LENGTH, &finished));
+
+    // Two literals, then a reference 3 bytes back is refused, but not 2
+    test_unhex("0361620020", stream, sizeof(stream));
+    TEST_CHECK(!decode(stream, 5, 5, &finished));
+    test_unhex("0361620010", stream, sizeof(stream));
+    TEST_CHECK(decode(stream, 5, 5, &finished) && finished);
+    test_expect("overlapping reference", out, 5, "6162616261");
+
+    // A reference truncated at the end of the stream leaves it unfinished, even
+    // once the announced length is reached
+    test_unhex("0361620010", stream, sizeof(stream));
+    TEST_CHECK(decode(stream, 4, 5, &finished) && !finished);
+    TEST_CHECK(decode(stream, 4, 2, &finished) && !finished);
+}
+
+int main(void)
+{
+    srand(1);
+    for (size_t i = 0; i < ARRAYLEN(vectors); i++) {
+        test_vector(&vectors[i]);
+    }
+    test_invalid();
+    return test_end("test_lzss");
+}
@@ -0,0 +1,206 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * Merkle trees of lib_standard_app/merkle.c against the recursive
+ * definitions of RFC 6962 section 2.1, with the SHA-256 of OpenSSL and the
+ * 0x00 and 0x01 prefixes, for 0 to MAX_LEAVES leaves: the root of the
+ * builder, and every inclusion proof, which must be accepted as is and
+ * refused once altered.
+ *
+ * An RFC 9162 proof binds the index and the tree size only through the
+ * positions of the siblings: another index or size is refused when these
+ * positions differ, and accepted otherwise.
+ */
+#include <openssl/evp.h>
+
+#include "cx.h"
+#include "cx_test.h"
+#include "merkle.h"
+
+#define MAX_LEAVES 33
+#define MAX_PROOF  7
+
+typedef struct {
+    uint8_t hash[MAX_PROOF][CX_SHA256_SIZE];
+    bool    left[MAX_PROOF];  // Whether the sibling is on the left
+    size_t  len;
+} proof_t;
+
+static const uint8_t leaf_tag[] = {0x00};
+static const uint8_t node_tag[] = {0x01};
+
+static merkle_params_t params = {
+    .hash         = cx_sha256_hash_iovec,
+    .hash_len     = CX_SHA256_SIZE,
+    .leaf_tag     = leaf_tag,
+    .leaf_tag_len = sizeof(leaf_tag),
+    .node_tag     = node_tag,
+    .node_tag_len = sizeof(node_tag),
+};
+
+static uint8_t leaves[MAX_LEAVES][CX_SHA256_SIZE];
+
+static void sha256(uint8_t prefix, const uint8_t *a, size_t a_len, const uint8_t *b, uint8_t *out)
+{
+    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+
+    TEST_CHECK(EVP_DigestInit_ex(ctx, EVP_sha256(), NULL) == 1);
+    TEST_CHECK(EVP_DigestUpdate(ctx, &prefix, 1) == 1);
+    TEST_CHECK(EVP_DigestUpdate(ctx, a, a_len) == 1);
+    if (b != NULL) {
+        TEST_CHECK(EVP_DigestUpdate(ctx, b, CX_SHA256_SIZE) == 1);
+    }
+    TEST_CHECK(EVP_DigestFinal_ex(ctx, out, NULL) == 1);
+    EVP_MD_CTX_free(ctx);
+}
+
+// Largest power of two smaller than n
+static size_t split_point(size_t n)
+{
+    size_t k = 1;
+
+    while (2 * k < n) {
+        k *= 2;
+    }
+    return k;
+}
+
+// MTH(D[first:first + n]), n > 0
+static void naive_root(size_t first, size_t n, uint8_t *root)
+{
+    uint8_t left[CX_SHA256_SIZE], right[CX_SHA256_SIZE];
+    size_t  k;
+
+    if (n == 1) {
+        memcpy(root, leaves[first], CX_SHA256_SIZE);
+        return;
+    }
+    k = split_point(n);
+    naive_root(first, k, left);
+    naive_root(first + k, n - k, right);
+    sha256(0x01, left, CX_SHA256_SIZE, right, root);
+}
+
+// PATH(m, D[first:first + n]), from the leaf to the root, or only the sides of its siblings
+static void naive_proof(size_t m, size_t first, size_t n, proof_t *proof, bool hashes)
+{
+    size_t k;
+
+    if (n == 1) {
+        proof->len = 0;
+        return;
+    }
+    k = split_point(n);
+    if (m < k) {
+        naive_proof(m, first, k, proof, hashes);
+        if (hashes) {
+            naive_root(first + k, n - k, proof->hash[proof->len]);
+        }
+        proof->left[proof->len] = false;
+    }
+    else {
+        naive_proof(m - k, first + k, n - k, proof, hashes);
+        if (hashes) {
+            naive_root(first, k, proof->hash[proof->len]);
+        }
+        proof->left[proof->len] = true;
+    }
+    proof->len++;
+}
+
+static bool same_shape(const proof_t *a, const proof_t *b)
+{
+    return (a->len == b->len) && !memcmp(a->left, b->left, a->len * sizeof(bool));
+}
+
+static cx_err_t verify(size_t m, size_t n, const proof_t *proof, size_t len, const uint8_t *root)
+{
+    return merkle_verify_proof(&params, leaves[m], m, n, proof->hash[0], len, root);
+}
+
+static void test_proofs(size_t n, const uint8_t *root)
+{
+    proof_t proof, other;
+
+    for (size_t m = 0; m < n; m++) {
+        naive_proof(m, 0, n, &proof, true);
+        TEST_CHECK(verify(m, n, &proof, proof.len, root) == CX_OK);
+
+        // Altered siblings, and a proof one hash too long or too short
+        for (size_t i = 0; i < proof.len; i++) {
+            proof.hash[i][rand() % CX_SHA256_SIZE] ^= 1 << (rand() % 8);
+            TEST_CHECK(verify(m, n, &proof, proof.len, root) == CX_INVALID_PARAMETER_VALUE);
+            naive_proof(m, 0, n, &proof, true);
+        }
+        memcpy(proof.hash[proof.len], leaves[m], CX_SHA256_SIZE);
+        TEST_CHECK(verify(m, n, &proof, proof.len + 1, root) == CX_INVALID_PARAMETER_VALUE);
+        if (proof.len > 0) {
+            TEST_CHECK(verify(m, n, &proof, proof.len - 1, root) == CX_INVALID_PARAMETER_VALUE);
+        }
+
+        // Other indexes in the same tree, then other tree sizes
+        for (size_t i = 0; i < n + MAX_LEAVES; i++) {
+            size_t   index = (i < n) ? i : m;
+            size_t   count = (i < n) ? n : i - n + 1;
+            cx_err_t error;
+
+            if (((index == m) && (count == n)) || (index >= count)) {
+                continue;
+            }
+            naive_proof(index, 0, count, &other, false);
+            error = merkle_verify_proof(
+                &params, leaves[m], index, count, proof.hash[0], proof.len, root);
+            TEST_CHECK(error
+                       == (same_shape(&proof, &other) ? CX_OK : CX_INVALID_PARAMETER_VALUE));
+        }
+        TEST_CHECK(merkle_verify_proof(&params, leaves[m], n, n, proof.hash[0], proof.len, root)
+                   == CX_INVALID_PARAMETER);
+    }
+}
+
+int main(void)
+{
+    merkle_builder_t builder;
+    uint8_t          root[CX_SHA256_SIZE], expected[CX_SHA256_SIZE];
+
+    srand(1);
+    TEST_CHECK(merkle_builder_init(&builder, &params) == CX_OK);
+    for (size_t n = 0; n <= MAX_LEAVES; n++) {
+        TEST_CHECK(merkle_builder_root(&builder, root) == CX_OK);
+        if (n == 0) {
+            test_expect("empty tree",
+                        root,
+                        sizeof(root),
+                        "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+        }
+        else {
+            naive_root(0, n, expected);
+            if (memcmp(root, expected, sizeof(root))) {
+                fprintf(stderr, "root mismatch for %zu leaves\n", n);
+                test_failures++;
+            }
+            test_proofs(n, root);
+        }
+        if (n < MAX_LEAVES) {
+            uint8_t data[4] = {n, n >> 8, 0xA5, 0x5A};
+
+            sha256(0x00, data, sizeof(data), NULL, leaves[n]);
+            TEST_CHECK(merkle_builder_add_leaf(&builder, data, sizeof(data)) == CX_OK);
+        }
+    }
+    return test_end("test_merkle");
+}
@@ -0,0 +1,143 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * os_xor, os_secure_memcmp and cx_memxor, which work on 32-bit words, against
+ * the byte-wise code they replace, for every alignment of the buffers and every
+ * length up to 70 bytes. os_xor is also checked with overlapping buffers, since
+ * it goes from the end to the start.
+ */
+#include "cx.h"
+#include "cx_test.h"
+#include "lib_cxng/src/cx_utils.h"
+#include "os_utils.h"
+
+#define MAX_LEN 70
+#define ALIGNS  4
+#define ALIGNED __attribute__((aligned(ALIGNS)))
+
+static uint8_t a[MAX_LEN + 2 * ALIGNS] ALIGNED, b[MAX_LEN + 2 * ALIGNS] ALIGNED;
+static uint8_t d[MAX_LEN + 2 * ALIGNS] ALIGNED, ref[MAX_LEN + 2 * ALIGNS] ALIGNED;
+
+static void ref_xor(uint8_t *dst, const uint8_t *src1, const uint8_t *src2, size_t len)
+{
+    while (len--) {
+        dst[len] = src1[len] ^ src2[len];
+    }
+}
+
+static char ref_secure_memcmp(const uint8_t *src1, const uint8_t *src2, size_t len)
+{
+    uint8_t xoracc = 0;
+
+    while (len--) {
+        xoracc |= src1[len] ^ src2[len];
+    }
+    return (char) xoracc;
+}
+
+static void test_xor(void)
+{
+    for (size_t len = 0; len <= MAX_LEN; len++) {
+        for (int i = 0; i < ALIGNS * ALIGNS * ALIGNS; i++) {
+            size_t od = i % ALIGNS, o1 = (i / ALIGNS) % ALIGNS, o2 = i / (ALIGNS * ALIGNS);
+
+            cx_rng_no_throw(a, sizeof(a));
+            cx_rng_no_throw(b, sizeof(b));
+            cx_rng_no_throw(d, sizeof(d));
+            memcpy(ref, d, sizeof(d));
+            os_xor(d + od, a + o1, b + o2, len);
+            ref_xor(ref + od, a + o1, b + o2, len);
+            if (memcmp(d, ref, sizeof(d))) {
+                fprintf(stderr, "os_xor: %zu bytes at %zu, %zu, %zu\n", len, od, o1, o2);
+                test_failures++;
+            }
+        }
+    }
+}
+
+static void test_xor_overlap(void)
+{
+    uint8_t buf[MAX_LEN + 4 * ALIGNS] ALIGNED, buf_ref[MAX_LEN + 4 * ALIGNS];
+    size_t  o1 = 2 * ALIGNS;
+
+    for (size_t len = 0; len <= MAX_LEN; len++) {
+        // dst = src1 + shift
+        for (int shift = -2 * ALIGNS; shift <= 2 * ALIGNS; shift++) {
+            cx_rng_no_throw(buf, sizeof(buf));
+            cx_rng_no_throw(b, sizeof(b));
+            memcpy(buf_ref, buf, sizeof(buf));
+            os_xor(buf + o1 + shift, buf + o1, b, len);
+            ref_xor(buf_ref + o1 + shift, buf_ref + o1, b, len);
+            if (memcmp(buf, buf_ref, sizeof(buf))) {
+                fprintf(stderr, "os_xor: %zu bytes shifted by %d\n", len, shift);
+                test_failures++;
+            }
+        }
+    }
+}
+
+static void test_secure_memcmp(void)
+{
+    for (size_t len = 0; len <= MAX_LEN; len++) {
+        for (int i = 0; i < ALIGNS * ALIGNS; i++) {
+            size_t o1 = i % ALIGNS, o2 = i / ALIGNS;
+
+            cx_rng_no_throw(a, sizeof(a));
+            memcpy(b + o2, a + o1, len);
+            TEST_CHECK(os_secure_memcmp(a + o1, b + o2, len) == 0);
+            for (size_t pos = 0; pos < len; pos++) {
+                cx_rng_no_throw(b + o2 + pos, 1);
+                TEST_CHECK(os_secure_memcmp(a + o1, b + o2, len)
+                           == ref_secure_memcmp(a + o1, b + o2, len));
+                b[o2 + pos] = a[o1 + pos];
+            }
+            cx_rng_no_throw(b, sizeof(b));
+            TEST_CHECK(os_secure_memcmp(a + o1, b + o2, len)
+                       == ref_secure_memcmp(a + o1, b + o2, len));
+        }
+    }
+}
+
+static void test_memxor(void)
+{
+    for (size_t len = 0; len <= MAX_LEN; len++) {
+        for (int i = 0; i < ALIGNS * ALIGNS; i++) {
+            size_t o1 = i % ALIGNS, o2 = i / ALIGNS;
+
+            cx_rng_no_throw(a, sizeof(a));
+            cx_rng_no_throw(b, sizeof(b));
+            memcpy(ref, a, sizeof(a));
+            cx_memxor(a + o1, b + o2, len);
+            for (size_t j = 0; j < len; j++) {
+                ref[o1 + j] ^= b[o2 + j];
+            }
+            if (memcmp(a, ref, sizeof(a))) {
+                fprintf(stderr, "cx_memxor: %zu bytes at %zu, %zu\n", len, o1, o2);
+                test_failures++;
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    test_xor();
+    test_xor_overlap();
+    test_secure_memcmp();
+    test_memxor();
+    return test_end("test_os_mem");
+}
@@ -0,0 +1,235 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * Tagged hashes of src/cx_sha256_tagged.c against the plain
+ * SHA-256(SHA-256(tag) || SHA-256(tag) || m) of OpenSSL: the precomputed
+ * midstates, cx_sha256_tag_init for them and for custom tags, then
+ * cx_sha256_tagged_hash_iovec for messages of 0 to 200 bytes split at random,
+ * and cx_sha256_tagged_init followed by cx_hash_no_throw.
+ *
+ * Then the BIP340 test vectors 0 and 1 are signed with the three BIP0340 tags,
+ * the curve arithmetic being done by OpenSSL.
+ */
+#include <openssl/bn.h>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/obj_mac.h>
+
+#include "cx.h"
+#include "cx_test.h"
+#include "os_utils.h"
+
+#define MAX_LEN    200
+#define MAX_CHUNKS 4
+
+typedef struct {
+    const char            *name;
+    const cx_sha256_tag_t *tag;
+} tag_vector_t;
+
+static const tag_vector_t tags[] = {
+    {"BIP0340/aux", &cx_sha256_tag_bip340_aux},
+    {"BIP0340/nonce", &cx_sha256_tag_bip340_nonce},
+    {"BIP0340/challenge", &cx_sha256_tag_bip340_challenge},
+    {"TapLeaf", &cx_sha256_tag_tapleaf},
+    {"TapBranch", &cx_sha256_tag_tapbranch},
+    {"TapTweak", &cx_sha256_tag_taptweak},
+    {"TapSighash", &cx_sha256_tag_tapsighash},
+    {"", NULL},
+    {"my/custom tag", NULL},
+};
+
+static const size_t lengths[] = {0, 1, 31, 32, 55, 56, 63, 64, 65, 127, 128, 129, MAX_LEN};
+
+typedef struct {
+    const char *secret_key;
+    const char *public_key;
+    const char *aux_rand;
+    const char *message;
+    const char *signature;
+} bip340_vector_t;
+
+static const bip340_vector_t bip340_vectors[] = {
+    {"0000000000000000000000000000000000000000000000000000000000000003",
+     "F9308A019258C31049344F85F89D5229B531C845836F99B08601F113BCE036F9",
+     "0000000000000000000000000000000000000000000000000000000000000000",
+     "0000000000000000000000000000000000000000000000000000000000000000",
+     "E907831F80848D1069A5371B402410364BDF1C5F8307B0084C55F1CE2DCA8215"
+     "25F66A4A85EA8B71E482A74F382D2CE5EBEEE8FDB2172F477DF4900D310536C0"},
+    {"B7E151628AED2A6ABF7158809CF4F3C762E7160F38B4DA56A784D9045190CFEF",
+     "DFF1D77F2A671C5F36183726DB2341BE58FEAE1DA2DECED843240F7B502BA659",
+     "0000000000000000000000000000000000000000000000000000000000000001",
+     "243F6A8885A308D313198A2E03707344A4093822299F31D0082EFA98EC4E6C89",
+     "6896BD60EEAE296DB48A229FF71DFE071BDE413E6D43F917DC8DCF8C78DE3341"
+     "8906D11AC976ABCCB20B091292BFF4EA897EFCB639EA871CFA95F6DE339E4B0A"},
+};
+
+static void ref_tagged_hash(const char *name, const uint8_t *msg, size_t len, uint8_t *digest)
+{
+    uint8_t     tag_hash[CX_SHA256_SIZE];
+    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+
+    TEST_CHECK(EVP_Digest(name, strlen(name), tag_hash, NULL, EVP_sha256(), NULL) == 1);
+    TEST_CHECK(EVP_DigestInit_ex(ctx, EVP_sha256(), NULL) == 1);
+    TEST_CHECK(EVP_DigestUpdate(ctx, tag_hash, sizeof(tag_hash)) == 1);
+    TEST_CHECK(EVP_DigestUpdate(ctx, tag_hash, sizeof(tag_hash)) == 1);
+    TEST_CHECK(EVP_DigestUpdate(ctx, msg, len) == 1);
+    TEST_CHECK(EVP_DigestFinal_ex(ctx, digest, NULL) == 1);
+    EVP_MD_CTX_free(ctx);
+}
+
+// Splits the message in count buffers at random, some of them empty
+static void split(cx_iovec_t *iov, size_t count, const uint8_t *msg, size_t len)
+{
+    size_t offset = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        size_t n = (i == count - 1) ? len - offset : (size_t) rand() % (len - offset + 1);
+
+        iov[i].iov_base = msg + offset;
+        iov[i].iov_len  = n;
+        offset += n;
+    }
+}
+
+static void test_tags(void)
+{
+    uint8_t    msg[MAX_LEN];
+    uint8_t    digest[CX_SHA256_SIZE], expected[CX_SHA256_SIZE];
+    cx_iovec_t iov[MAX_CHUNKS];
+
+    for (size_t t = 0; t < ARRAYLEN(tags); t++) {
+        const char     *name = tags[t].name;
+        cx_sha256_tag_t tag;
+
+        TEST_CHECK(cx_sha256_tag_init(&tag, (const uint8_t *) name, strlen(name)) == CX_OK);
+        if ((tags[t].tag != NULL) && memcmp(&tag, tags[t].tag, sizeof(tag))) {
+            fprintf(stderr, "%s: precomputed midstate mismatch\n", name);
+            test_failures++;
+        }
+        for (size_t l = 0; l < ARRAYLEN(lengths); l++) {
+            size_t len   = lengths[l];
+            size_t count = 1 + rand() % MAX_CHUNKS;
+
+            cx_rng_no_throw(msg, len);
+            ref_tagged_hash(name, msg, len, expected);
+            split(iov, count, msg, len);
+            TEST_CHECK(cx_sha256_tagged_hash_iovec(&tag, iov, count, digest) == CX_OK);
+            if (memcmp(digest, expected, sizeof(digest))) {
+                fprintf(stderr, "%s: mismatch for %zu bytes in %zu buffers\n", name, len, count);
+                test_failures++;
+            }
+
+            // Same message through a tagged context and the generic hash API
+            cx_sha256_t hash;
+            TEST_CHECK(cx_sha256_tagged_init(&hash, &tag) == CX_OK);
+            TEST_CHECK(cx_hash_no_throw(&hash.header, CX_LAST, msg, len, digest, sizeof(digest))
+                       == CX_OK);
+            if (memcmp(digest, expected, sizeof(digest))) {
+                fprintf(stderr, "%s: tagged context mismatch for %zu bytes\n", name, len);
+                test_failures++;
+            }
+        }
+    }
+    TEST_CHECK(cx_sha256_tag_init(NULL, NULL, 0) == CX_INVALID_PARAMETER);
+}
+
+static BIGNUM *tagged_hash_bn(const cx_sha256_tag_t *tag, const cx_iovec_t *iov, size_t count)
+{
+    uint8_t digest[CX_SHA256_SIZE];
+
+    TEST_CHECK(cx_sha256_tagged_hash_iovec(tag, iov, count, digest) == CX_OK);
+    return BN_bin2bn(digest, sizeof(digest), NULL);
+}
+
+// Signs as in the BIP340 reference code, and compares with the signature of the vector
+static void test_bip340(const bip340_vector_t *v)
+{
+    EC_GROUP *group = EC_GROUP_new_by_curve_name(NID_secp256k1);
+    BN_CTX   *ctx   = BN_CTX_new();
+    EC_POINT *P = EC_POINT_new(group), *R = EC_POINT_new(group);
+    BIGNUM   *n = BN_new(), *d = BN_new(), *k, *e, *s = BN_new(), *y = BN_new(), *x = BN_new();
+    uint8_t   sk[32], pk[32], aux[32], msg[32], sig[64], t[32], rx[32], aux_hash[32];
+
+    test_unhex(v->secret_key, sk, sizeof(sk));
+    test_unhex(v->aux_rand, aux, sizeof(aux));
+    test_unhex(v->message, msg, sizeof(msg));
+    EC_GROUP_get_order(group, n, ctx);
+
+    // d = sk, negated if P = d.G has an odd y
+    BN_bin2bn(sk, sizeof(sk), d);
+    EC_POINT_mul(group, P, d, NULL, NULL, ctx);
+    EC_POINT_get_affine_coordinates(group, P, x, y, ctx);
+    if (BN_is_odd(y)) {
+        BN_sub(d, n, d);
+    }
+    BN_bn2binpad(x, pk, sizeof(pk));
+    test_expect("bip340 public key", pk, sizeof(pk), v->public_key);
+
+    // t = d xor hash_aux(a), k = hash_nonce(t || P || m) mod n
+    cx_iovec_t aux_iov = {aux, sizeof(aux)};
+    TEST_CHECK(cx_sha256_tagged_hash_iovec(&cx_sha256_tag_bip340_aux, &aux_iov, 1, aux_hash)
+               == CX_OK);
+    BN_bn2binpad(d, t, sizeof(t));
+    for (size_t i = 0; i < sizeof(t); i++) {
+        t[i] ^= aux_hash[i];
+    }
+    cx_iovec_t nonce_iov[] = {{t, sizeof(t)}, {pk, sizeof(pk)}, {msg, sizeof(msg)}};
+    k = tagged_hash_bn(&cx_sha256_tag_bip340_nonce, nonce_iov, ARRAYLEN(nonce_iov));
+    BN_mod(k, k, n, ctx);
+
+    // R = k.G, k negated if R has an odd y
+    EC_POINT_mul(group, R, k, NULL, NULL, ctx);
+    EC_POINT_get_affine_coordinates(group, R, x, y, ctx);
+    if (BN_is_odd(y)) {
+        BN_sub(k, n, k);
+    }
+    BN_bn2binpad(x, rx, sizeof(rx));
+
+    // e = hash_challenge(R || P || m) mod n, s = k + e.d mod n
+    cx_iovec_t challenge_iov[] = {{rx, sizeof(rx)}, {pk, sizeof(pk)}, {msg, sizeof(msg)}};
+    e = tagged_hash_bn(&cx_sha256_tag_bip340_challenge, challenge_iov, ARRAYLEN(challenge_iov));
+    BN_mod(e, e, n, ctx);
+    BN_mod_mul(s, e, d, n, ctx);
+    BN_mod_add(s, s, k, n, ctx);
+
+    memcpy(sig, rx, sizeof(rx));
+    BN_bn2binpad(s, sig + 32, 32);
+    test_expect("bip340 signature", sig, sizeof(sig), v->signature);
+
+    BN_free(n);
+    BN_free(d);
+    BN_free(k);
+    BN_free(e);
+    BN_free(s);
+    BN_free(x);
+    BN_free(y);
+    EC_POINT_free(P);
+    EC_POINT_free(R);
+    BN_CTX_free(ctx);
+    EC_GROUP_free(group);
+}
+
+int main(void)
+{
+    srand(1);
+    test_tags();
+    for (size_t i = 0; i < ARRAYLEN(bip340_vectors); i++) {
+        test_bip340(&bip340_vectors[i]);
+    }
+    return test_end("test_sha256_tagged");
+}
@@ -0,0 +1,223 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * In-app SHA3, Keccak and SHAKE (HAVE_APP_KECCAK) against the FIPS 202
+ * examples of NIST for the empty message, "abc" and 200 bytes of 0xA3, then
+ * against OpenSSL for random lengths, chunks and SHAKE output lengths.
+ */
+#include <openssl/evp.h>
+
+#include "cx.h"
+#include "cx_test.h"
+#include "lib_cxng/src/cx_sha3.h"
+#include "os_math.h"
+
+#define MAX_LEN 1024
+
+typedef struct {
+    cx_md_t     md;
+    size_t      size;  // bits for SHA3 and Keccak, bytes for SHAKE
+    const char *msg;   // NULL for 200 bytes of 0xA3
+    const char *digest;
+} sha3_vector_t;
+
+static const sha3_vector_t vectors[] = {
+    {CX_SHA3, 224, "", "6b4e03423667dbb73b6e15454f0eb1abd4597f9a1b078e3f5b5a6bc7"},
+    {CX_SHA3, 256, "", "a7ffc6f8bf1ed76651c14756a061d662f580ff4de43b49fa82d80a4b80f8434a"},
+    {CX_SHA3,
+     384,
+     "",
+     "0c63a75b845e4f7d01107d852e4c2485c51a50aaaa94fc61995e71bbee983a2ac3713831264adb47fb6bd1e058d5"
+     "f004"},
+    {CX_SHA3,
+     512,
+     "",
+     "a69f73cca23a9ac5c8b567dc185a756e97c982164fe25859e0d1dcc1475c80a615b2123af1f5f94c11e3e9402c3a"
+     "c558f500199d95b6d3e301758586281dcd26"},
+    {CX_SHA3, 224, "abc", "e642824c3f8cf24ad09234ee7d3c766fc9a3a5168d0c94ad73b46fdf"},
+    {CX_SHA3, 256, "abc", "3a985da74fe225b2045c172d6bd390bd855f086e3e9d525b46bfe24511431532"},
+    {CX_SHA3,
+     384,
+     "abc",
+     "ec01498288516fc926459f58e2c6ad8df9b473cb0fc08c2596da7cf0e49be4b298d88cea927ac7f539f1edf22837"
+     "6d25"},
+    {CX_SHA3,
+     512,
+     "abc",
+     "b751850b1a57168a5693cd924b6b096e08f621827444f70d884f5d0240d2712e10e116e9192af3c91a7ec57647e3"
+     "934057340b4cf408d5a56592f8274eec53f0"},
+    {CX_SHA3, 224, NULL, "9376816aba503f72f96ce7eb65ac095deee3be4bf9bbc2a1cb7e11e0"},
+    {CX_SHA3, 256, NULL, "79f38adec5c20307a98ef76e8324afbfd46cfd81b22e3973c65fa1bd9de31787"},
+    {CX_SHA3,
+     384,
+     NULL,
+     "1881de2ca7e41ef95dc4732b8f5f002b189cc1e42b74168ed1732649ce1dbcdd76197a31fd55ee989f2d7050dd47"
+     "3e8f"},
+    {CX_SHA3,
+     512,
+     NULL,
+     "e76dfad22084a8b1467fcf2ffa58361bec7628edf5f3fdc0e4805dc48caeeca81b7c13c30adf52a3659584739a2d"
+     "f46be589c51ca1a4a8416df6545a1ce8ba00"},
+    {CX_SHAKE128, 32, "", "7f9c2ba4e88f827d616045507605853ed73b8093f6efbc88eb1a6eacfa66ef26"},
+    {CX_SHAKE128, 32, NULL, "131ab8d2b594946b9c81333f9bb6e0ce75c3b93104fa3469d3917457385da037"},
+    {CX_SHAKE256,
+     64,
+     "",
+     "46b9dd2b0ba88d13233b3feb743eeb243fcd52ea62b81b82b50c27646ed5762fd75dc4ddd8c0f200cb05019d67b5"
+     "92f6fc821c49479ab48640292eacb3b7c4be"},
+    {CX_SHAKE256, 32, NULL, "cd8a920ed141aa0407a22d59288652e9d9f1a7ee0c1e7c1ca699424da84a904d"},
+    // Keccak-256, as used by Ethereum
+    {CX_KECCAK, 256, "", "c5d2460186f7233c927e7db2dcc703c0e500b653ca82273b7bfad8045d85a470"},
+    {CX_KECCAK, 256, "abc", "4e03657aea45a94fc7d47ba826c8d667c0d1e6e33a64a036ec44f58fa12d6c45"},
+};
+
+static cx_err_t sha3_init(cx_sha3_t *hash, cx_md_t md, size_t size)
+{
+    switch (md) {
+        case CX_SHA3:
+            return cx_sha3_init_no_throw(hash, size);
+        case CX_KECCAK:
+            return cx_keccak_init_no_throw(hash, size);
+        case CX_SHAKE128:
+            return cx_sha3_xof_init_no_throw(hash, 128, size);
+        default:
+            return cx_sha3_xof_init_no_throw(hash, 256, size);
+    }
+}
+
+static void sha3_chunked(cx_md_t        md,
+                         size_t         size,
+                         const uint8_t *msg,
+                         size_t         len,
+                         size_t         chunk,
+                         uint8_t       *digest)
+{
+    cx_sha3_t hash;
+
+    TEST_CHECK(sha3_init(&hash, md, size) == CX_OK);
+    for (size_t off = 0; off < len; off += chunk) {
+        TEST_CHECK(cx_sha3_update(&hash, msg + off, MIN(chunk, len - off)) == CX_OK);
+    }
+    TEST_CHECK(cx_sha3_final(&hash, digest) == CX_OK);
+}
+
+static void test_vectors(void)
+{
+    static const size_t chunks[] = {1, 7, 136, MAX_LEN};
+    uint8_t             a3[200], digest[64];
+
+    memset(a3, 0xA3, sizeof(a3));
+    for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+        const sha3_vector_t *v   = &vectors[i];
+        const uint8_t       *msg = (v->msg != NULL) ? (const uint8_t *) v->msg : a3;
+        size_t               len = (v->msg != NULL) ? strlen(v->msg) : sizeof(a3);
+
+        for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+            sha3_chunked(v->md, v->size, msg, len, chunks[c], digest);
+            test_expect("sha3", digest, strlen(v->digest) / 2, v->digest);
+        }
+    }
+
+    // One-shot helpers
+    {
+        const cx_iovec_t iovec[] = {
+            {.iov_base = a3, .iov_len = 100},
+            {.iov_base = a3 + 100, .iov_len = 100},
+        };
+
+        TEST_CHECK(cx_sha3_256_hash_iovec(iovec, 2, digest) == CX_OK);
+        test_expect("cx_sha3_256_hash_iovec", digest, 32, vectors[9].digest);
+        TEST_CHECK(cx_shake128_hash_iovec(iovec, 2, digest, 32) == CX_OK);
+        test_expect("cx_shake128_hash_iovec", digest, 32, vectors[13].digest);
+    }
+}
+
+static const EVP_MD *openssl_md(cx_md_t md, size_t size)
+{
+    switch (md) {
+        case CX_SHA3:
+            return (size == 224)   ? EVP_sha3_224()
+                   : (size == 256) ? EVP_sha3_256()
+                   : (size == 384) ? EVP_sha3_384()
+                                   : EVP_sha3_512();
+        case CX_SHAKE128:
+            return EVP_shake128();
+        default:
+            return EVP_shake256();
+    }
+}
+
+static size_t random_len(size_t max)
+{
+    uint32_t r;
+
+    cx_rng_no_throw((uint8_t *) &r, sizeof(r));
+    return r % (max + 1);
+}
+
+static void test_random(void)
+{
+    static const cx_md_t mds[]   = {CX_SHA3, CX_SHA3, CX_SHA3, CX_SHA3, CX_SHAKE128, CX_SHAKE256};
+    static const size_t  sizes[] = {224, 256, 384, 512, 0, 0};
+    uint8_t              msg[MAX_LEN], digest[600], expected[600];
+
+    for (int i = 0; i < 300; i++) {
+        size_t      k     = i % 6;
+        size_t      len   = random_len(MAX_LEN);
+        size_t      chunk = 1 + random_len(300);
+        // SHAKE outputs longer than the rate need several squeezes
+        size_t      size  = sizes[k] ? sizes[k] : 1 + random_len(sizeof(digest) - 1);
+        size_t      out   = sizes[k] ? sizes[k] / 8 : size;
+        EVP_MD_CTX *ctx   = EVP_MD_CTX_new();
+
+        cx_rng_no_throw(msg, len);
+        TEST_CHECK(EVP_DigestInit_ex(ctx, openssl_md(mds[k], sizes[k]), NULL) == 1);
+        TEST_CHECK(EVP_DigestUpdate(ctx, msg, len) == 1);
+        if (sizes[k]) {
+            TEST_CHECK(EVP_DigestFinal_ex(ctx, expected, NULL) == 1);
+        }
+        else {
+            TEST_CHECK(EVP_DigestFinalXOF(ctx, expected, out) == 1);
+        }
+        EVP_MD_CTX_free(ctx);
+
+        sha3_chunked(mds[k], size, msg, len, chunk, digest);
+        TEST_CHECK(memcmp(digest, expected, out) == 0);
+    }
+}
+
+static void test_parameters(void)
+{
+    cx_sha3_t hash;
+    uint8_t   digest[32];
+
+    TEST_CHECK(cx_sha3_init_no_throw(&hash, 255) == CX_INVALID_PARAMETER);
+    TEST_CHECK(cx_sha3_update(NULL, digest, 0) == CX_INVALID_PARAMETER);
+    TEST_CHECK(cx_sha3_final(NULL, digest) == CX_INVALID_PARAMETER);
+    TEST_CHECK(cx_sha3_init_no_throw(&hash, 256) == CX_OK);
+    TEST_CHECK(cx_sha3_final(&hash, NULL) == CX_INVALID_PARAMETER);
+    memset(&hash, 0, sizeof(hash));
+    TEST_CHECK(cx_sha3_final(&hash, digest) == CX_INVALID_PARAMETER);
+}
+
+int main(void)
+{
+    test_vectors();
+    test_random();
+    test_parameters();
+    return test_end("test_sha3");
+}
@@ -0,0 +1,135 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef HAVE_IO_LATENCY
+
+/**
+ * Number of slots: IO_LATENCY_SLOTS - 1 INS whose latencies are recorded, the
+ * last slot gathering the commands of any other INS once they are all used.
+ */
+#ifndef IO_LATENCY_SLOTS
+#define IO_LATENCY_SLOTS 4
+#endif
+
+/**
+ * States of a slot, the INS of the last one being 0xFF when it gathers other
+ * INS, which tells it apart from a slot of the INS 0xFF.
+ */
+#define IO_LATENCY_SLOT_FREE  0
+#define IO_LATENCY_SLOT_INS   1
+#define IO_LATENCY_SLOT_OTHER 2
+
+/**
+ * Number of buckets of each histogram: the bucket 0 counts the durations of
+ * 0 tick, and the bucket i > 0 the ones in [2^(i-1), 2^i[ ticks, the last one
+ * having no upper bound.
+ *
+ * The default ticks are the milliseconds of the SEPROXYHAL ticker, which are
+ * counted in steps of 100 ms: the durations under 100 ms then all fall in the
+ * bucket 0, and the longer ones in the buckets 7 ([64, 128[ ms) and above.
+ * io_latency_get_ticks must be overridden by a finer counter to tell apart
+ * the durations of most commands.
+ */
+#ifndef IO_LATENCY_BUCKETS
+#define IO_LATENCY_BUCKETS 12
+#endif
+
+/// Size of a slot in the dump APDU response
+#define IO_LATENCY_SLOT_SIZE (2 + IO_LATENCY_PHASES * IO_LATENCY_BUCKETS * 2)
+
+/**
+ * Phases of an APDU whose durations are recorded.
+ */
+typedef enum {
+    IO_LATENCY_RECEPTION,  /// From the first chunk of the command until it is returned
+    IO_LATENCY_HANDLER,    /// From the command being returned to the app until the reply
+    IO_LATENCY_REPLY,      /// Transmission of the reply
+    IO_LATENCY_PHASES
+} io_latency_phase_t;
+
+/**
+ * Histograms of the commands of one INS.
+ */
+typedef struct io_latency_slot_s {
+    uint8_t  used;                                                /// IO_LATENCY_SLOT_*
+    uint8_t  ins;                                                 /// INS of the commands
+    uint16_t histograms[IO_LATENCY_PHASES][IO_LATENCY_BUCKETS];  /// Saturated counters
+} io_latency_slot_t;
+
+/**
+ * @brief   Returns the current tick count used to time the phases.
+ *
+ * @details The default implementation returns the milliseconds counted by the
+ *          SEPROXYHAL ticker events, i.e. with a resolution of 100 ms, see
+ *          IO_LATENCY_BUCKETS. It is defined as a weak symbol, to be overridden
+ *          by a finer counter when one is available.
+ *
+ * @return  Tick count.
+ */
+uint32_t io_latency_get_ticks(void);
+
+/**
+ * @brief   Records the reception of the first chunk of a command.
+ */
+void io_latency_rx_start(void);
+
+/**
+ * @brief   Records the complete reception of a command, which is returned to
+ *          the app.
+ *
+ * @param[in] ins INS of the command.
+ */
+void io_latency_rx_done(uint8_t ins);
+
+/**
+ * @brief   Records the start of the reply, once the app handled the command.
+ */
+void io_latency_tx_start(void);
+
+/**
+ * @brief   Records the end of the reply transmission.
+ */
+void io_latency_tx_done(void);
+
+/**
+ * @brief   Clears the histograms.
+ */
+void io_latency_clear(void);
+
+/**
+ * @brief   Serializes one slot for the dump APDU.
+ *
+ * @details The output is:
+ *          <slot count (1B)> <bucket count (1B)> <state (1B)> <ins (1B)>
+ *          followed by the reception, handler and reply histograms, each one
+ *          being bucket count counters of 2 bytes, big endian.
+ *
+ * @param[in]  slot    Index of the slot.
+ *
+ * @param[out] out     Output buffer.
+ *
+ * @param[in]  out_len Size of the output buffer.
+ *
+ * @return  Number of bytes written, 0 if the slot doesn't exist or the buffer
+ *          is too small.
+ */
+uint16_t io_latency_dump(uint8_t slot, uint8_t *out, uint16_t out_len);
+
+#endif  // HAVE_IO_LATENCY
@@ -21,6 +21,14 @@
 /* Includes ------------------------------------------------------------------*/
 #include <stdint.h>
 
+#ifdef HAVE_IO_SCATTER_GATHER
+#include "os_io.h"
+#endif  // HAVE_IO_SCATTER_GATHER
+
+#ifdef HAVE_APDU_COMPRESSION
+#include "lzss.h"
+#endif  // HAVE_APDU_COMPRESSION
+
 /* Exported enumerations -----------------------------------------------------*/
 enum {
     APDU_STATUS_WAITING,
@@ -28,15 +36,30 @@ enum {
     APDU_STATUS_COMPLETE,
 };
 
+/* Exported defines   --------------------------------------------------------*/
+// Size of the frames buffer, i.e. the largest MTU which can be negotiated
+#ifndef LEDGER_PROTOCOL_CHUNK_SIZE
+#define LEDGER_PROTOCOL_CHUNK_SIZE (156 + 2)
+#endif  // LEDGER_PROTOCOL_CHUNK_SIZE
+
+// Smallest MTU accepted from the host: the first APDU frame header and one byte of data
+#define LEDGER_PROTOCOL_MTU_MIN (2 + 1 + 2 + 2 + 1)
+
 /* Exported types, structures, unions ----------------------------------------*/
 typedef struct ledger_protocol_s {
     uint8_t *tx_apdu_buffer;
     uint16_t tx_apdu_length;
     uint16_t tx_apdu_sequence_number;
     uint16_t tx_apdu_offset;
+#ifdef HAVE_IO_SCATTER_GATHER
+    io_iovec_t tx_iov[IO_IOVEC_MAX];  // non empty buffers of the reply, when gathered
+    uint8_t    tx_iov_count;          // 0 if the reply is read from tx_apdu_buffer
+    uint8_t    tx_iov_index;          // current buffer
+    uint16_t   tx_iov_offset;         // offset in the current buffer
+#endif  // HAVE_IO_SCATTER_GATHER
 
-    uint8_t chunk[156 + 2];
-    uint8_t chunk_length;
+    uint8_t  chunk[LEDGER_PROTOCOL_CHUNK_SIZE];
+    uint16_t chunk_length;
 
     uint8_t *rx_apdu_buffer;
     uint16_t rx_apdu_buffer_max_length;
@@ -44,12 +67,16 @@ typedef struct ledger_protocol_s {
     uint16_t rx_apdu_sequence_number;
     uint16_t rx_apdu_length;
     uint16_t rx_apdu_offset;
+#ifdef HAVE_APDU_COMPRESSION
+    lzss_ctx_t rx_lzss;               // decompression of the command being received
+    uint16_t   rx_compressed_length;  // 0 if the command being received is not compressed
+    uint16_t   rx_compressed_offset;  // compressed length received so far
+#endif  // HAVE_APDU_COMPRESSION
     uint16_t mtu;
     uint8_t  mtu_negotiated;
+    uint16_t mtu_max;  // largest MTU of the link, 0 if unknown, see LEDGER_PROTOCOL_set_mtu_max
 } ledger_protocol_t;
 
-/* Exported defines   --------------------------------------------------------*/
-
 /* Exported macros------------------------------------------------------------*/
 
 /* Exported variables --------------------------------------------------------*/
@@ -58,3 +85,11 @@ typedef struct ledger_protocol_s {
 void LEDGER_PROTOCOL_init(ledger_protocol_t *data);
 void LEDGER_PROTOCOL_rx(uint8_t *buffer, uint16_t length);
 void LEDGER_PROTOCOL_tx(uint8_t *buffer, uint16_t length);
+// To be called by the transport when the largest MTU of the link is known or changes, e.g. on a
+// BLE ATT MTU exchange: the MTU which can be negotiated by the host is then bounded by it
+void LEDGER_PROTOCOL_set_mtu_max(uint16_t mtu_max);
+#ifdef HAVE_IO_SCATTER_GATHER
+// Same as LEDGER_PROTOCOL_tx with a reply gathered from several buffers, the next chunks being
+// built by LEDGER_PROTOCOL_tx(NULL, 0). The buffers must remain valid until the reply is sent.
+void LEDGER_PROTOCOL_tx_iov(const io_iovec_t *iov, uint8_t count);
+#endif  // HAVE_IO_SCATTER_GATHER
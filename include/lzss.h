@@ -0,0 +1,94 @@
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef HAVE_APDU_COMPRESSION
+
+/**
+ * LZSS decompression of the compressed APDUs.
+ *
+ * The stream is made of groups of up to 8 items, each group being preceded by
+ * a flags byte whose bits, LSB first, give the type of its items:
+ * - 1: a literal byte,
+ * - 0: a 2-byte big endian reference to the data already decompressed,
+ *   encoded as ((offset - 1) << 4) | (length - LZSS_MIN_MATCH).
+ *
+ * References are resolved within the output buffer, hence no window is
+ * needed, and the stream can be fed in chunks of any size.
+ */
+
+/// Bit of the compression capabilities reported to the host
+#define LZSS_CAPABILITY 0x01
+
+#define LZSS_MIN_MATCH  3
+#define LZSS_MAX_MATCH  (LZSS_MIN_MATCH + 0x0F)
+#define LZSS_MAX_OFFSET 4096
+
+/// Largest valid stream for a decompressed length, i.e. made of literals only
+#define LZSS_MAX_COMPRESSED_LENGTH(length) ((length) + ((length) + 7) / 8)
+
+/**
+ * Decompression context.
+ */
+typedef struct lzss_ctx_s {
+    uint8_t *out;          /// Output buffer
+    uint16_t out_length;   /// Announced decompressed length, at most the buffer size
+    uint16_t out_offset;   /// Length decompressed so far
+    uint8_t  flags;        /// Flags of the current group, shifted for each item
+    uint8_t  flags_count;  /// Number of items left in the current group
+    uint8_t  reference;    /// First byte of a reference split over two chunks
+    bool     pending;      /// Whether reference holds a byte
+} lzss_ctx_t;
+
+/**
+ * @brief   Initializes a decompression.
+ *
+ * @param[out] ctx        Context.
+ * @param[out] out        Output buffer.
+ * @param[in]  out_length Announced decompressed length, which must not exceed
+ *                        the size of the output buffer.
+ */
+void lzss_init(lzss_ctx_t *ctx, uint8_t *out, uint16_t out_length);
+
+/**
+ * @brief   Decompresses the next chunk of the stream.
+ *
+ * @details The output never exceeds the announced length, which bounds both
+ *          the memory and the time spent on a malicious stream.
+ *
+ * @param[in,out] ctx       Context.
+ * @param[in]     in        Chunk of the compressed stream.
+ * @param[in]     in_length Chunk length.
+ *
+ * @return  false if the stream is invalid: a reference before the start of
+ *          the output, or an output exceeding the announced length.
+ */
+bool lzss_decompress(lzss_ctx_t *ctx, const uint8_t *in, uint16_t in_length);
+
+/**
+ * @brief   Tells whether the announced length has been decompressed.
+ *
+ * @param[in] ctx Context.
+ *
+ * @return  true once the whole output has been produced.
+ */
+bool lzss_finished(const lzss_ctx_t *ctx);
+
+#endif  // HAVE_APDU_COMPRESSION
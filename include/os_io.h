@@ -28,6 +28,18 @@ typedef struct apdu_buffer_s {
 
 extern unsigned char G_io_apdu_buffer[IO_APDU_BUFFER_SIZE];
 
+#ifdef HAVE_IO_SCATTER_GATHER
+// maximum number of buffers a reply can be gathered from
+#ifndef IO_IOVEC_MAX
+#define IO_IOVEC_MAX 8
+#endif  // IO_IOVEC_MAX
+
+typedef struct io_iovec_s {
+    const uint8_t *ptr;
+    uint16_t       len;
+} io_iovec_t;
+#endif  // HAVE_IO_SCATTER_GATHER
+
 // send tx_len bytes (atr or rapdu) and retrieve the length of the next command
 // apdu (over the requested channel)
 #define CHANNEL_APDU           0
@@ -38,7 +50,12 @@ extern unsigned char G_io_apdu_buffer[IO_APDU_BUFFER_SIZE];
 #define IO_RETURN_AFTER_TX     0x20
 #define IO_ASYNCH_REPLY        0x10  // avoid apdu state reset if tx_len == 0 when we're expected to reply
 #define IO_FINISHED            0x08  // inter task communication value
-#define IO_FLAGS               0xF8
+#ifdef HAVE_IO_PIPELINE
+#define IO_PIPELINE 0x04  // receive the next command while the current one is processed
+#define IO_FLAGS    0xFC
+#else  // HAVE_IO_PIPELINE
+#define IO_FLAGS 0xF8
+#endif  // HAVE_IO_PIPELINE
 unsigned short io_exchange(unsigned char channel_and_flags, unsigned short tx_len);
 
 typedef enum {
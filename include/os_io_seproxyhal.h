@@ -220,6 +220,18 @@ typedef struct io_seph_s {
 
     unsigned int ms;
 
+#ifdef HAVE_IO_PIPELINE
+    bool            pipeline;            // next commands are received in G_io_apdu_buffer_next
+    unsigned short  pipeline_length;     // length of the next command, 0 until fully received
+    io_apdu_media_t pipeline_media;      // media of the next command
+    unsigned char   pipeline_paused_ep;  // OUT endpoint left unarmed while it is pending, or 0
+#endif  // HAVE_IO_PIPELINE
+
+#ifdef HAVE_IO_SCATTER_GATHER
+    const io_iovec_t *tx_iov;        // buffers of the next reply, instead of G_io_apdu_buffer
+    unsigned char     tx_iov_count;  // number of buffers of the next reply, 0 if not gathered
+#endif  // HAVE_IO_SCATTER_GATHER
+
 #ifdef HAVE_IO_USB
     unsigned char usb_ep_xfer_len[IO_USB_MAX_ENDPOINTS];
     struct {
@@ -244,6 +256,11 @@ typedef struct io_seph_s {
 
 extern io_seph_app_t G_io_app;
 
+#ifdef HAVE_IO_PIPELINE
+// buffer of the next command, received while the current one is processed and replied
+extern unsigned char G_io_apdu_buffer_next[IO_APDU_BUFFER_SIZE];
+#endif  // HAVE_IO_PIPELINE
+
 // deprecated
 #define G_io_apdu_media G_io_app.apdu_media
 // deprecated
@@ -279,6 +296,19 @@ void io_seproxyhal_io_heartbeat(void);
 // IO task related function
 unsigned int os_io_seph_recv_and_process(unsigned int dont_process_ux_events);
 
+#ifdef DEBUG_APDU_REPLAY
+/**
+ * Hooks of an APDU replay harness, used by io_exchange() with DEBUG_APDU in
+ * place of the compiled-in APDUs:
+ * - debug_apdu_next() copies the next APDU into buffer, and returns its length,
+ *   or 0 to go on with the actual IO
+ * - debug_apdu_replied() is called with the length of the reply of the
+ *   previous APDU, available in G_io_apdu_buffer
+ */
+unsigned short debug_apdu_next(unsigned char *buffer, unsigned short max_length);
+void           debug_apdu_replied(unsigned short tx_len);
+#endif  // DEBUG_APDU_REPLAY
+
 #ifdef HAVE_PRINTF
 // Sends a character to the MCU and waits for the MCU acknowledgement.
 void mcu_usb_prints(const char *str, unsigned int charcount);
@@ -51,6 +51,19 @@ io_usb_hid_receive_status_t io_usb_hid_receive(io_send_t      sndfct,
                                                unsigned short l,
                                                apdu_buffer_t *apdu_buffer);
 
+#ifdef HAVE_IO_PIPELINE
+/**
+ * Receive next HID transport packet of the next command, in G_io_apdu_buffer_next.
+ * G_io_app.pipeline_length is set when it has been completely received, the OUT
+ * endpoint then being left unarmed until io_exchange takes the command.
+ * To be called upon USB OUT event once io_exchange has been called with IO_PIPELINE
+ */
+void io_usb_hid_receive_next(io_send_t       sndfct,
+                             unsigned char  *buffer,
+                             unsigned short  l,
+                             io_apdu_media_t media);
+#endif  // HAVE_IO_PIPELINE
+
 /**
  * Mark the last chunk transmitted as sent.
  * To be called typically upon USB IN ACK event
@@ -63,6 +76,15 @@ void io_usb_hid_sent(io_send_t sndfct);
  */
 void io_usb_hid_send(io_send_t sndfct, unsigned short sndlength, unsigned char *apdu_buffer);
 
+#ifdef HAVE_IO_SCATTER_GATHER
+/**
+ * Request transmission of an APDU gathered from several buffers using the HID
+ * transport protocol. The buffers must remain valid until the reply has been
+ * sent, the array itself can be released upon return.
+ */
+void io_usb_hid_send_iov(io_send_t sndfct, const io_iovec_t *iov, unsigned char count);
+#endif  // HAVE_IO_SCATTER_GATHER
+
 #endif  // HAVE_USB_APDU
 
 #endif
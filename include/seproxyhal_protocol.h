@@ -217,5 +217,8 @@
 #endif
 
 #define SEPROXYHAL_TAG_BOOTLOADER_CAPDU_STATUS 0x6A  // <CAPDU to the bootloader>
+#define SEPROXYHAL_TAG_SCREEN_DISPLAY_BATCH_STATUS \
+    0x6B  // { <length(2BE)> <SCREEN_DISPLAY_STATUS content> }* replied with a
+          // single display processed event when all are drawn
 
 #endif
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef HAVE_SYSCALL_TRACE
+
+/**
+ * Number of entries of the trace ring buffer, the oldest entries being
+ * overwritten. Each entry uses 12 bytes of RAM, and the dump APDU addresses
+ * at most 256 entries.
+ */
+#ifndef SYSCALL_TRACE_ENTRIES
+#define SYSCALL_TRACE_ENTRIES 32
+#endif
+
+/// Duration of a syscall which did not return, because it threw an exception
+#define SYSCALL_TRACE_NO_RETURN 0xFFFF
+
+/// Size of an entry in the dump APDU response
+#define SYSCALL_TRACE_ENTRY_SIZE 12
+
+/**
+ * Trace of one syscall.
+ */
+typedef struct syscall_trace_entry_s {
+    uint32_t seq;       /// Sequence number of the syscall
+    uint32_t id;        /// Syscall ID, SYSCALL_xxx_ID_IN
+    uint32_t start;     /// Tick count when the syscall was issued
+    uint16_t duration;  /// Ticks spent in the syscall, or SYSCALL_TRACE_NO_RETURN
+    uint16_t apdu;      /// Sequence number of the APDU being processed
+} syscall_trace_entry_t;
+
+/**
+ * @brief   Returns the current tick count used to timestamp the syscalls.
+ *
+ * @details The default implementation returns the milliseconds counted by the
+ *          SEPROXYHAL ticker events, i.e. with a resolution of 100 ms. It is
+ *          defined as a weak symbol, to be overridden by a finer counter when
+ *          one is available. It must not issue any syscall.
+ *
+ * @return  Tick count.
+ */
+uint32_t syscall_trace_get_ticks(void);
+
+/**
+ * @brief   Records the start of a syscall.
+ *
+ * @param[in] id Syscall ID.
+ *
+ * @return  Sequence number of the syscall, to be given to syscall_trace_end.
+ */
+uint32_t syscall_trace_begin(uint32_t id);
+
+/**
+ * @brief   Records the end of a syscall.
+ *
+ * @details Nothing is recorded if the entry of the syscall has been reused in
+ *          the meantime, e.g. by the syscalls issued by a callback.
+ *
+ * @param[in] seq Sequence number returned by syscall_trace_begin.
+ */
+void syscall_trace_end(uint32_t seq);
+
+/**
+ * @brief   Starts a new APDU: the following syscalls are attributed to it.
+ */
+void syscall_trace_apdu_start(void);
+
+/**
+ * @brief   Clears the trace.
+ */
+void syscall_trace_clear(void);
+
+/**
+ * @brief   Serializes the trace for the dump APDU.
+ *
+ * @details The output is:
+ *          <total syscall count (4B)> <retained entries (2B)> <count (1B)>
+ *          followed by count entries, each one being
+ *          <id (4B)> <start (4B)> <duration (2B)> <apdu (2B)>,
+ *          all big endian. The entries are ordered from the oldest one.
+ *
+ * @param[in]  first   Index of the first entry to serialize, 0 being the
+ *                     oldest retained entry.
+ *
+ * @param[out] out     Output buffer.
+ *
+ * @param[in]  out_len Size of the output buffer.
+ *
+ * @return  Number of bytes written.
+ */
+uint16_t syscall_trace_dump(uint16_t first, uint8_t *out, uint16_t out_len);
+
+#endif  // HAVE_SYSCALL_TRACE
@@ -240,6 +240,64 @@ WARN_UNUSED_RESULT cx_err_t cx_aes_dec_block(const cx_aes_key_t *key,
                                              const uint8_t      *inblock,
                                              uint8_t            *outblock);
 
+/**
+ * @brief AES-CTR context.
+ *
+ * @details The key is loaded in hardware once per update, and the
+ *          counter blocks are then encrypted back to back.
+ */
+typedef struct {
+    const cx_aes_key_t *key;                         ///< AES key
+    uint8_t             counter[CX_AES_BLOCK_SIZE];  ///< Next counter block
+    uint8_t             stream[CX_AES_BLOCK_SIZE];   ///< Current key stream block
+    size_t              offset;                      ///< Used bytes of the key stream block
+    size_t              counter_len;                 ///< Incremented rightmost bytes
+} cx_aes_ctr_t;
+
+/**
+ * @brief   Initializes an AES-CTR context.
+ *
+ * @details The whole 16-byte counter block is incremented, as a big-endian
+ *          integer, as specified by NIST SP 800-38A.
+ *
+ * @param[out] ctx Pointer to the context.
+ *
+ * @param[in]  key Pointer to the AES key. It must remain valid while
+ *                 the context is used.
+ *
+ * @param[in]  iv  Initial counter block.
+ *
+ * @return         Error code:
+ *                 - CX_OK on success
+ *                 - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_aes_ctr_init(cx_aes_ctr_t       *ctx,
+                                            const cx_aes_key_t *key,
+                                            const uint8_t       iv[static CX_AES_BLOCK_SIZE]);
+
+/**
+ * @brief   Encrypts or decrypts data with AES-CTR.
+ *
+ * @details Encryption and decryption are the same operation. Data can be
+ *          processed in chunks of any length.
+ *
+ * @param[in, out] ctx Pointer to the context.
+ *
+ * @param[in]      in  Input data.
+ *
+ * @param[out]     out Output data. It may be equal to *in*.
+ *
+ * @param[in]      len Length of the data.
+ *
+ * @return             Error code:
+ *                     - CX_OK on success
+ *                     - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_aes_ctr_update(cx_aes_ctr_t  *ctx,
+                                              const uint8_t *in,
+                                              uint8_t       *out,
+                                              size_t         len);
+
 #endif  // HAVE_AES
 
 #endif  // LCX_AES_H
@@ -0,0 +1,151 @@
+
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/**
+ * @file    lcx_aes_gcm.h
+ * @brief   AES in Galois/Counter Mode (AES-GCM)
+ *
+ * Authenticated encryption with associated data. The authentication is
+ * computed with GHASH, a polynomial hash over GF(2^128), using a 4-bit
+ * table precomputed from the hash key.
+ *
+ * Refer to <a href = "https://csrc.nist.gov/publications/detail/sp/800-38d/final"> NIST SP
+ * 800-38D </a> for more details.
+ */
+
+#ifndef LCX_AES_GCM_H
+#define LCX_AES_GCM_H
+
+#ifdef HAVE_AES
+
+#include <stdint.h>
+#include "lcx_aes.h"
+
+/** AES-GCM context */
+typedef struct {
+    cx_aes_ctr_t ctr;                          ///< Encryption of the data
+    uint64_t     HL[16];                       ///< GHASH table, low halves
+    uint64_t     HH[16];                       ///< GHASH table, high halves
+    uint8_t      ghash[CX_AES_BLOCK_SIZE];     ///< GHASH accumulator
+    size_t       ghash_offset;                 ///< Bytes of the pending GHASH block
+    uint8_t      tag_mask[CX_AES_BLOCK_SIZE];  ///< Encrypted initial counter block
+    uint64_t     aad_len;                      ///< Length of the additional data
+    uint64_t     data_len;                     ///< Length of the data
+    uint32_t     mode;                         ///< CX_ENCRYPT or CX_DECRYPT
+} cx_aes_gcm_t;
+
+/**
+ * @brief   Starts an AES-GCM encryption or decryption.
+ *
+ * @param[out] ctx    Pointer to the context.
+ *
+ * @param[in]  key    Pointer to the AES key. It must remain valid while
+ *                    the context is used.
+ *
+ * @param[in]  mode   CX_ENCRYPT or CX_DECRYPT.
+ *
+ * @param[in]  iv     Initialization vector. 12 bytes are recommended.
+ *
+ * @param[in]  iv_len Length of the initialization vector.
+ *
+ * @return            Error code:
+ *                    - CX_OK on success
+ *                    - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_aes_gcm_init(cx_aes_gcm_t       *ctx,
+                                            const cx_aes_key_t *key,
+                                            uint32_t            mode,
+                                            const uint8_t      *iv,
+                                            size_t              iv_len);
+
+/**
+ * @brief   Authenticates additional data.
+ *
+ * @details All the additional data must be given before the data.
+ *
+ * @param[in, out] ctx Pointer to the context.
+ *
+ * @param[in]      aad Additional data.
+ *
+ * @param[in]      len Length of the additional data.
+ *
+ * @return             Error code:
+ *                     - CX_OK on success
+ *                     - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_aes_gcm_update_aad(cx_aes_gcm_t  *ctx,
+                                                  const uint8_t *aad,
+                                                  size_t         len);
+
+/**
+ * @brief   Encrypts or decrypts data.
+ *
+ * @param[in, out] ctx Pointer to the context.
+ *
+ * @param[in]      in  Input data.
+ *
+ * @param[out]     out Output data. It may be equal to *in*.
+ *
+ * @param[in]      len Length of the data.
+ *
+ * @return             Error code:
+ *                     - CX_OK on success
+ *                     - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_aes_gcm_update(cx_aes_gcm_t  *ctx,
+                                              const uint8_t *in,
+                                              uint8_t       *out,
+                                              size_t         len);
+
+/**
+ * @brief   Computes the authentication tag.
+ *
+ * @param[in, out] ctx     Pointer to the context. It is erased.
+ *
+ * @param[out]     tag     Buffer where to store the tag.
+ *
+ * @param[in]      tag_len Length of the tag, from 4 to 16 bytes.
+ *
+ * @return                 Error code:
+ *                         - CX_OK on success
+ *                         - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_aes_gcm_finish(cx_aes_gcm_t *ctx, uint8_t *tag, size_t tag_len);
+
+/**
+ * @brief   Checks the authentication tag of decrypted data.
+ *
+ * @details The decrypted data must not be used if the tag is invalid.
+ *
+ * @param[in, out] ctx     Pointer to the context. It is erased.
+ *
+ * @param[in]      tag     Expected tag.
+ *
+ * @param[in]      tag_len Length of the tag, from 4 to 16 bytes.
+ *
+ * @return                 Error code:
+ *                         - CX_OK on success
+ *                         - CX_INVALID_PARAMETER
+ *                         - CX_INVALID_PARAMETER_VALUE if the tag is invalid
+ */
+WARN_UNUSED_RESULT cx_err_t cx_aes_gcm_check_tag(cx_aes_gcm_t  *ctx,
+                                                 const uint8_t *tag,
+                                                 size_t         tag_len);
+
+#endif  // HAVE_AES
+
+#endif  // LCX_AES_GCM_H
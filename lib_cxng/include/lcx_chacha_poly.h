@@ -0,0 +1,263 @@
+
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/**
+ * @file    lcx_chacha_poly.h
+ * @brief   ChaCha20, Poly1305 and the ChaCha20-Poly1305 AEAD.
+ *
+ * Software implementations running in the application context, written
+ * for 32-bit cores: the ChaCha20 quarter round only uses 32-bit additions,
+ * xors and rotations, and Poly1305 works on 26-bit limbs whose 64-bit
+ * products are built from 16x16-bit multiplications, so that no runtime
+ * helper is called on Cortex-M0. Both run in constant time.
+ *
+ * They are only built when the application is built with ENABLE_CHACHA_POLY=1.
+ *
+ * Refer to <a href = "https://tools.ietf.org/html/rfc8439"> RFC 8439 </a>
+ * for more details.
+ */
+
+#ifndef LCX_CHACHA_POLY_H
+#define LCX_CHACHA_POLY_H
+
+#ifdef HAVE_CHACHA_POLY
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "cx_errors.h"
+#include "lcx_wrappers.h"
+#include "lcx_common.h"
+
+/** ChaCha20 key size in bytes */
+#define CX_CHACHA20_KEY_SIZE 32
+/** ChaCha20 nonce size in bytes */
+#define CX_CHACHA20_NONCE_SIZE 12
+/** ChaCha20 block size in bytes */
+#define CX_CHACHA20_BLOCK_SIZE 64
+/** Poly1305 key size in bytes */
+#define CX_POLY1305_KEY_SIZE 32
+/** Poly1305 tag size in bytes */
+#define CX_POLY1305_TAG_SIZE 16
+
+/** ChaCha20 context */
+typedef struct {
+    uint32_t state[16];                          ///< Constants, key, counter and nonce
+    uint8_t  keystream[CX_CHACHA20_BLOCK_SIZE];  ///< Current key stream block
+    size_t   offset;                             ///< Used bytes of the key stream block
+} cx_chacha20_t;
+
+/** Poly1305 context */
+typedef struct {
+    uint32_t r[5];        ///< Clamped key, 26-bit limbs
+    uint32_t h[5];        ///< Accumulator, 26-bit limbs
+    uint32_t pad[4];      ///< Second half of the key
+    uint8_t  buffer[16];  ///< Pending partial block
+    size_t   leftover;    ///< Length of the pending partial block
+} cx_poly1305_t;
+
+/** ChaCha20-Poly1305 context */
+typedef struct {
+    cx_chacha20_t chacha;    ///< Encryption of the data
+    cx_poly1305_t poly;      ///< Authentication
+    uint64_t      aad_len;   ///< Length of the additional data
+    uint64_t      data_len;  ///< Length of the data
+    uint32_t      mode;      ///< CX_ENCRYPT or CX_DECRYPT
+    bool          started;   ///< Whether the context is initialized
+} cx_chachapoly_t;
+
+/**
+ * @brief   Initializes a ChaCha20 context.
+ *
+ * @param[out] ctx     Pointer to the context.
+ *
+ * @param[in]  key     32-byte key.
+ *
+ * @param[in]  nonce   12-byte nonce.
+ *
+ * @param[in]  counter Initial block counter.
+ *
+ * @return             Error code:
+ *                     - CX_OK on success
+ *                     - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_chacha20_init(cx_chacha20_t *ctx,
+                                             const uint8_t  key[static CX_CHACHA20_KEY_SIZE],
+                                             const uint8_t  nonce[static CX_CHACHA20_NONCE_SIZE],
+                                             uint32_t       counter);
+
+/**
+ * @brief   Encrypts or decrypts data with ChaCha20.
+ *
+ * @param[in, out] ctx Pointer to the context.
+ *
+ * @param[in]      in  Input data.
+ *
+ * @param[out]     out Output data. It may be equal to *in*.
+ *
+ * @param[in]      len Length of the data.
+ *
+ * @return             Error code:
+ *                     - CX_OK on success
+ *                     - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_chacha20_update(cx_chacha20_t *ctx,
+                                               const uint8_t *in,
+                                               uint8_t       *out,
+                                               size_t         len);
+
+/**
+ * @brief   Initializes a Poly1305 context.
+ *
+ * @details A Poly1305 key must be used for one message only.
+ *
+ * @param[out] ctx Pointer to the context.
+ *
+ * @param[in]  key 32-byte one-time key.
+ *
+ * @return         Error code:
+ *                 - CX_OK on success
+ *                 - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_poly1305_init(cx_poly1305_t *ctx,
+                                             const uint8_t  key[static CX_POLY1305_KEY_SIZE]);
+
+/**
+ * @brief   Adds data to the Poly1305 authenticator.
+ *
+ * @param[in, out] ctx  Pointer to the context.
+ *
+ * @param[in]      data Input data.
+ *
+ * @param[in]      len  Length of the data.
+ *
+ * @return              Error code:
+ *                      - CX_OK on success
+ *                      - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_poly1305_update(cx_poly1305_t *ctx,
+                                               const uint8_t *data,
+                                               size_t         len);
+
+/**
+ * @brief   Computes the Poly1305 tag.
+ *
+ * @param[in, out] ctx Pointer to the context. It is erased.
+ *
+ * @param[out]     tag Buffer where to store the 16-byte tag.
+ *
+ * @return             Error code:
+ *                     - CX_OK on success
+ *                     - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_poly1305_final(cx_poly1305_t *ctx,
+                                              uint8_t        tag[static CX_POLY1305_TAG_SIZE]);
+
+/**
+ * @brief   Starts a ChaCha20-Poly1305 encryption or decryption.
+ *
+ * @param[out] ctx   Pointer to the context.
+ *
+ * @param[in]  key   32-byte key.
+ *
+ * @param[in]  mode  CX_ENCRYPT or CX_DECRYPT.
+ *
+ * @param[in]  nonce 12-byte nonce. It must never be reused with the same key.
+ *
+ * @return           Error code:
+ *                   - CX_OK on success
+ *                   - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t
+cx_chachapoly_init(cx_chachapoly_t *ctx,
+                   const uint8_t    key[static CX_CHACHA20_KEY_SIZE],
+                   uint32_t         mode,
+                   const uint8_t    nonce[static CX_CHACHA20_NONCE_SIZE]);
+
+/**
+ * @brief   Authenticates additional data.
+ *
+ * @details All the additional data must be given before the data.
+ *
+ * @param[in, out] ctx Pointer to the context.
+ *
+ * @param[in]      aad Additional data.
+ *
+ * @param[in]      len Length of the additional data.
+ *
+ * @return             Error code:
+ *                     - CX_OK on success
+ *                     - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_chachapoly_update_aad(cx_chachapoly_t *ctx,
+                                                     const uint8_t   *aad,
+                                                     size_t           len);
+
+/**
+ * @brief   Encrypts or decrypts data.
+ *
+ * @param[in, out] ctx Pointer to the context.
+ *
+ * @param[in]      in  Input data.
+ *
+ * @param[out]     out Output data. It may be equal to *in*.
+ *
+ * @param[in]      len Length of the data.
+ *
+ * @return             Error code:
+ *                     - CX_OK on success
+ *                     - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_chachapoly_update(cx_chachapoly_t *ctx,
+                                                 const uint8_t   *in,
+                                                 uint8_t         *out,
+                                                 size_t           len);
+
+/**
+ * @brief   Computes the authentication tag.
+ *
+ * @param[in, out] ctx Pointer to the context. It is erased.
+ *
+ * @param[out]     tag Buffer where to store the 16-byte tag.
+ *
+ * @return             Error code:
+ *                     - CX_OK on success
+ *                     - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_chachapoly_finish(cx_chachapoly_t *ctx,
+                                                 uint8_t          tag[static CX_POLY1305_TAG_SIZE]);
+
+/**
+ * @brief   Checks the authentication tag of decrypted data.
+ *
+ * @details The decrypted data must not be used if the tag is invalid.
+ *
+ * @param[in, out] ctx Pointer to the context. It is erased.
+ *
+ * @param[in]      tag Expected 16-byte tag.
+ *
+ * @return             Error code:
+ *                     - CX_OK on success
+ *                     - CX_INVALID_PARAMETER
+ *                     - CX_INVALID_PARAMETER_VALUE if the tag is invalid
+ */
+WARN_UNUSED_RESULT cx_err_t
+cx_chachapoly_check_tag(cx_chachapoly_t *ctx, const uint8_t tag[static CX_POLY1305_TAG_SIZE]);
+
+#endif  // HAVE_CHACHA_POLY
+
+#endif  // LCX_CHACHA_POLY_H
@@ -203,6 +203,60 @@ DEPRECATED static inline bool cx_ecdsa_verify(const cx_ecfp_public_key_t *pukey,
     return cx_ecdsa_verify_no_throw(pukey, hash, hash_len, sig, sig_len);
 }
 
+/**
+ * Set in the *info* of a #cx_ecdsa_batch_item_t, together with the flags
+ * returned by #cx_ecdsa_sign_no_throw, when the parity of **[k].G** is known.
+ */
+#define CX_ECDSA_BATCH_PARITY_KNOWN (1 << 8)
+
+/**
+ * @brief Signature to verify in a batch.
+ */
+typedef struct {
+    const cx_ecfp_public_key_t *pukey;     ///< Uncompressed public key
+    const uint8_t              *hash;      ///< Digest of the signed message
+    size_t                      hash_len;  ///< Length of the digest
+    const uint8_t              *sig;       ///< Signature, encoded in TLV
+    size_t                      sig_len;   ///< Length of the signature
+    uint32_t                    info;      ///< Flags returned by #cx_ecdsa_sign_no_throw
+                                           ///< with CX_ECDSA_BATCH_PARITY_KNOWN, 0 if
+                                           ///< unknown, e.g. for a DER signature
+} cx_ecdsa_batch_item_t;
+
+/**
+ * @brief   Verifies several ECDSA signatures at once.
+ *
+ * @details The signatures are combined with random coefficients *a_i*
+ *          and checked with a single multi-scalar multiplication:
+ *          **[sum(a_i.u1_i)]G + sum([a_i.u2_i]Q_i) - sum([a_i]R_i) = O**.
+ *          The generator is thus multiplied once for the whole batch.
+ *          The point *R_i* is recovered from *r_i* and the parity given
+ *          in *info*. The signatures without CX_ECDSA_BATCH_PARITY_KNOWN,
+ *          or flagged with CX_ECCINFO_xGTn, cannot be batched and are
+ *          verified alone with #cx_ecdsa_verify_no_throw.
+ *          If the batch is rejected, the caller can fall back to
+ *          #cx_ecdsa_verify_no_throw to find the invalid signatures.
+ *
+ * @param[in]  items    Signatures to verify. All the public keys must
+ *                      belong to the same 256-bit Weierstrass curve.
+ *
+ * @param[in]  count    Number of signatures, at most #CX_EC_BATCH_MAX_SIZE.
+ *
+ * @param[out] verified Set to true if all the signatures are valid.
+ *
+ * @return              Error code:
+ *                      - CX_OK on success
+ *                      - CX_INVALID_PARAMETER
+ *                      - CX_EC_INVALID_CURVE
+ *                      - CX_NOT_UNLOCKED
+ *                      - CX_NOT_LOCKED
+ *                      - CX_MEMORY_FULL
+ *                      - CX_EC_INVALID_POINT
+ */
+WARN_UNUSED_RESULT cx_err_t cx_ecdsa_batch_verify_no_throw(const cx_ecdsa_batch_item_t *items,
+                                                           size_t                       count,
+                                                           bool                        *verified);
+
 #endif  // HAVE_ECDSA
 
 #endif  // LCX_ECDSA_H
@@ -404,6 +404,194 @@ DEPRECATED static inline int cx_ecfp_generate_pair2(cx_curve_t             curve
     return 0;
 }
 
+/**
+ * @brief   Performs a multi-scalar multiplication.
+ *
+ * @details Computes **R = [k_0]P_0 + [k_1]P_1 + ... + [k_(n-1)]P_(n-1)**
+ *          with Straus' interleaved method: the doublings are shared
+ *          between all the points, which makes it much cheaper than
+ *          *n* independent scalar multiplications.
+ *          This should be used only for non-secret computations.
+ *          The BN processor must be locked, and the points allocated,
+ *          by the caller.
+ *
+ * @param[out] R      Pointer to the result point, allocated on the curve
+ *                    of the points.
+ *
+ * @param[in]  P      Array of *n* points.
+ *
+ * @param[in]  k      Array of *n* scalars, each of *k_len* bytes
+ *                    in big-endian order, stored contiguously.
+ *
+ * @param[in]  k_len  Length of each scalar.
+ *
+ * @param[in]  n      Number of points.
+ *
+ * @return            Error code:
+ *                    - CX_OK on success
+ *                    - CX_EC_INFINITE_POINT if the result is the point at infinity
+ *                    - CX_NOT_LOCKED
+ *                    - CX_INVALID_PARAMETER
+ *                    - CX_EC_INVALID_POINT
+ *                    - CX_EC_INVALID_CURVE
+ *                    - CX_MEMORY_FULL
+ */
+WARN_UNUSED_RESULT cx_err_t cx_ecpoint_multi_scalarmul(cx_ecpoint_t       *R,
+                                                       const cx_ecpoint_t *P,
+                                                       const uint8_t      *k,
+                                                       size_t              k_len,
+                                                       size_t              n);
+
+/**
+ * @brief Maximum number of signatures verified by one batch verification.
+ *
+ * @details Bounds the BN memory and the stack used by
+ *          #cx_ecdsa_batch_verify_no_throw and
+ *          #cx_ecschnorr_bip340_batch_verify_no_throw.
+ */
+#ifndef CX_EC_BATCH_MAX_SIZE
+#define CX_EC_BATCH_MAX_SIZE 4
+#endif
+
+/** Maximum number of teeth of a comb table. */
+#define CX_ECPOINT_COMB_MAX_TEETH 8
+
+/**
+ * @brief Fixed-base comb table.
+ *
+ * @details Lim-Lee comb for a fixed point P: the scalar bits are split into
+ *          *teeth* rows, each row being cut into *blocks* blocks of
+ *          *spacing* = ceil(ceil(bits / teeth) / blocks) bits, so that a row
+ *          is *a* = *blocks* x *spacing* bits long.
+ *          The table holds, for each block j and each non-zero b < 2^teeth,
+ *          the affine point [2^(j.spacing) . sum(b_i.2^(i.a))]P.
+ *
+ *          A multiplication costs *spacing* - 1 doublings and at most
+ *          *blocks* x *spacing* additions, for a table of
+ *          *blocks* x (2^teeth - 1) points. On a 256-bit curve:
+ *
+ *          | teeth | blocks | doublings | additions | table size   |
+ *          |-------|--------|-----------|-----------|--------------|
+ *          | 4     | 1      | 63        | 64        | 960 bytes    |
+ *          | 4     | 4      | 15        | 64        | 3840 bytes   |
+ *          | 6     | 1      | 42        | 43        | 4032 bytes   |
+ *          | 4     | 64     | 0         | 64        | 61440 bytes  |
+ *          | 8     | 32     | 0         | 32        | 522240 bytes |
+ *
+ *          With *blocks* = ceil(bits / teeth), the multiplication is made of
+ *          additions only.
+ */
+typedef struct {
+    uint8_t   *table;       ///< Table of affine points x || y, in RAM or NVM
+    size_t     domain_len;  ///< Length of a coordinate
+    cx_curve_t curve;       ///< Curve of the base point
+    uint16_t   rows;        ///< Number of bits per row (a)
+    uint16_t   spacing;     ///< Number of bits per block (spacing)
+    uint8_t    teeth;       ///< Number of rows
+    uint8_t    blocks;      ///< Number of blocks per row
+} cx_ecpoint_comb_t;
+
+/**
+ * @brief   Gets the size of a comb table.
+ *
+ * @param[in] curve  Curve identifier.
+ *
+ * @param[in] teeth  Number of teeth, from 1 to #CX_ECPOINT_COMB_MAX_TEETH.
+ *
+ * @param[in] blocks Number of blocks, at least 1.
+ *
+ * @return           Size of the table in bytes, 0 if the parameters are invalid.
+ */
+size_t cx_ecpoint_comb_table_len(cx_curve_t curve, uint8_t teeth, uint8_t blocks);
+
+/**
+ * @brief   Initializes a comb over a table buffer.
+ *
+ * @details The table is neither read nor written. It can be filled afterwards
+ *          with #cx_ecpoint_comb_precompute, or already hold a table computed
+ *          with the same parameters, for instance in NVM.
+ *
+ * @param[out] comb      Pointer to the comb.
+ *
+ * @param[in]  curve     Curve identifier.
+ *
+ * @param[in]  teeth     Number of teeth, from 1 to #CX_ECPOINT_COMB_MAX_TEETH.
+ *
+ * @param[in]  blocks    Number of blocks, at least 1.
+ *
+ * @param[in]  table     Table buffer.
+ *
+ * @param[in]  table_len Length of the table buffer, at least the value returned by
+ *                       #cx_ecpoint_comb_table_len.
+ *
+ * @return               Error code:
+ *                       - CX_OK on success
+ *                       - CX_INVALID_PARAMETER
+ *                       - CX_INVALID_PARAMETER_SIZE
+ *                       - CX_EC_INVALID_CURVE
+ */
+WARN_UNUSED_RESULT cx_err_t cx_ecpoint_comb_init(cx_ecpoint_comb_t *comb,
+                                                 cx_curve_t         curve,
+                                                 uint8_t            teeth,
+                                                 uint8_t            blocks,
+                                                 uint8_t           *table,
+                                                 size_t             table_len);
+
+/**
+ * @brief   Fills a comb table for a base point.
+ *
+ * @details The BN processor must be locked, and the point allocated,
+ *          by the caller. The base point must not have a small order.
+ *
+ * @param[in] comb Pointer to an initialized comb.
+ *
+ * @param[in] P    Base point.
+ *
+ * @param[in] nvm  Whether the table lies in NVM, in which case it is
+ *                 written with *nvm_write*.
+ *
+ * @return         Error code:
+ *                 - CX_OK on success
+ *                 - CX_NOT_LOCKED
+ *                 - CX_INVALID_PARAMETER
+ *                 - CX_EC_INVALID_POINT
+ *                 - CX_EC_INFINITE_POINT
+ *                 - CX_MEMORY_FULL
+ */
+WARN_UNUSED_RESULT cx_err_t cx_ecpoint_comb_precompute(const cx_ecpoint_comb_t *comb,
+                                                       const cx_ecpoint_t      *P,
+                                                       bool                     nvm);
+
+/**
+ * @brief   Performs a fixed-base scalar multiplication.
+ *
+ * @details Computes **R = [k]P** where P is the base point of the comb.
+ *          This should be used only for non-secret computations.
+ *          The BN processor must be locked, and the point allocated,
+ *          by the caller.
+ *
+ * @param[in]  comb  Pointer to a comb whose table is filled.
+ *
+ * @param[out] R     Pointer to the result point.
+ *
+ * @param[in]  k     Scalar, in big-endian order.
+ *
+ * @param[in]  k_len Length of the scalar, at most the length of the domain.
+ *
+ * @return           Error code:
+ *                   - CX_OK on success
+ *                   - CX_EC_INFINITE_POINT if the result is the point at infinity
+ *                   - CX_NOT_LOCKED
+ *                   - CX_INVALID_PARAMETER
+ *                   - CX_INVALID_PARAMETER_SIZE
+ *                   - CX_EC_INVALID_POINT
+ *                   - CX_MEMORY_FULL
+ */
+WARN_UNUSED_RESULT cx_err_t cx_ecpoint_comb_scalarmul(const cx_ecpoint_comb_t *comb,
+                                                      cx_ecpoint_t            *R,
+                                                      const uint8_t           *k,
+                                                      size_t                   k_len);
+
 #ifdef HAVE_ECC_TWISTED_EDWARDS
 
 /**
@@ -136,6 +136,45 @@ WARN_UNUSED_RESULT bool cx_ecschnorr_verify(const cx_ecfp_public_key_t *pukey,
                                             const uint8_t              *sig,
                                             size_t                      sig_len);
 
+/**
+ * @brief BIP340 signature to verify in a batch.
+ */
+typedef struct {
+    const uint8_t *pubkey;   ///< 32-byte x-only public key
+    const uint8_t *msg;      ///< Signed message
+    size_t         msg_len;  ///< Length of the message
+    const uint8_t *sig;      ///< 64-byte signature **r || s**
+} cx_ecschnorr_bip340_batch_item_t;
+
+/**
+ * @brief   Verifies several BIP340 signatures on secp256k1 at once.
+ *
+ * @details Implements the batch verification of BIP340: the
+ *          signatures are combined with random coefficients *a_i*
+ *          and checked with a single multi-scalar multiplication:
+ *          **[sum(a_i.s_i)]G = sum([a_i]R_i) + sum([a_i.e_i]P_i)**.
+ *          If the batch is rejected, the caller can fall back to
+ *          #cx_ecschnorr_verify to find the invalid signatures.
+ *
+ * @param[in]  items    Signatures to verify.
+ *
+ * @param[in]  count    Number of signatures, at most #CX_EC_BATCH_MAX_SIZE.
+ *
+ * @param[out] verified Set to true if all the signatures are valid.
+ *
+ * @return              Error code:
+ *                      - CX_OK on success
+ *                      - CX_INVALID_PARAMETER
+ *                      - CX_NOT_UNLOCKED
+ *                      - CX_NOT_LOCKED
+ *                      - CX_MEMORY_FULL
+ *                      - CX_EC_INVALID_POINT
+ */
+WARN_UNUSED_RESULT cx_err_t
+cx_ecschnorr_bip340_batch_verify_no_throw(const cx_ecschnorr_bip340_batch_item_t *items,
+                                          size_t                                  count,
+                                          bool                                   *verified);
+
 #endif
 
 #endif  // HAVE_ECSHCNORR
@@ -29,6 +29,8 @@
 #define LCX_EDDSA_H
 
 #include "lcx_ecfp.h"
+#include "lcx_sha256.h"
+#include "lcx_sha512.h"
 #include "lcx_wrappers.h"
 
 #ifdef HAVE_EDDSA
@@ -211,6 +213,130 @@ void cx_encode_coord(uint8_t *coord, int len, int sign);
  */
 int cx_decode_coord(uint8_t *coord, int len);
 
+#if defined(HAVE_SHA512) && defined(HAVE_SHA256)
+
+/**
+ * @brief Streaming EDDSA signature context.
+ *
+ * @details Ed25519 hashes the message twice: once for the nonce
+ *          **r = H(prefix || M)** and once for the challenge
+ *          **k = H(R || A || M)**. The streaming API lets the message go
+ *          through the context twice instead of holding it in RAM:
+ *            - #cx_eddsa_sign_init_no_throw
+ *            - #cx_eddsa_sign_update_nonce_no_throw for each chunk of the first pass
+ *            - #cx_eddsa_sign_update_challenge_no_throw for each chunk of the second pass
+ *            - #cx_eddsa_sign_final_no_throw
+ *
+ *          Both passes must carry the same message: a SHA-256 digest of each
+ *          pass is checked before the signature is released, since signing two
+ *          different messages with the same nonce would leak the private key.
+ */
+typedef struct {
+    cx_sha512_t hash;        ///< Nonce then challenge hash
+    cx_sha256_t check;       ///< Message digest of the current pass
+    uint8_t     a[32];       ///< Private scalar, big-endian
+    uint8_t     r[32];       ///< Nonce, big-endian
+    uint8_t     A[32];       ///< Encoded public key
+    uint8_t     R[32];       ///< Encoded nonce point
+    uint8_t     digest[32];  ///< Message digest of the first pass
+    uint8_t     state;       ///< Current pass
+} cx_eddsa_sign_ctx_t;
+
+/**
+ * @brief   Starts a streaming EDDSA signature.
+ *
+ * @param[out] ctx    Pointer to the context.
+ *
+ * @param[in]  pvkey  Private key on the Ed25519 curve.
+ *                    This shall be initialized with #cx_ecfp_init_private_key_no_throw.
+ *
+ * @param[in]  hashID Message digest algorithm identifier. Only SHA512 is supported.
+ *
+ * @return            Error code:
+ *                    - CX_OK on success
+ *                    - CX_EC_INVALID_CURVE
+ *                    - CX_INVALID_PARAMETER
+ *                    - CX_NOT_UNLOCKED
+ *                    - CX_INVALID_PARAMETER_SIZE
+ *                    - CX_MEMORY_FULL
+ *                    - CX_NOT_LOCKED
+ *                    - CX_EC_INVALID_POINT
+ *                    - CX_EC_INFINITE_POINT
+ *                    - CX_INTERNAL_ERROR
+ */
+WARN_UNUSED_RESULT cx_err_t cx_eddsa_sign_init_no_throw(cx_eddsa_sign_ctx_t         *ctx,
+                                                        const cx_ecfp_private_key_t *pvkey,
+                                                        cx_md_t                      hashID);
+
+/**
+ * @brief   Hashes a chunk of the message for the nonce (first pass).
+ *
+ * @param[in, out] ctx  Pointer to the context.
+ *
+ * @param[in]      data Message chunk.
+ *
+ * @param[in]      len  Length of the chunk.
+ *
+ * @return              Error code:
+ *                      - CX_OK on success
+ *                      - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_eddsa_sign_update_nonce_no_throw(cx_eddsa_sign_ctx_t *ctx,
+                                                                const uint8_t       *data,
+                                                                size_t               len);
+
+/**
+ * @brief   Hashes a chunk of the message for the challenge (second pass).
+ *
+ * @details The first call ends the first pass and computes the nonce point R.
+ *
+ * @param[in, out] ctx  Pointer to the context.
+ *
+ * @param[in]      data Message chunk.
+ *
+ * @param[in]      len  Length of the chunk.
+ *
+ * @return              Error code:
+ *                      - CX_OK on success
+ *                      - CX_INVALID_PARAMETER
+ *                      - CX_NOT_UNLOCKED
+ *                      - CX_MEMORY_FULL
+ *                      - CX_NOT_LOCKED
+ *                      - CX_EC_INVALID_POINT
+ *                      - CX_EC_INFINITE_POINT
+ */
+WARN_UNUSED_RESULT cx_err_t cx_eddsa_sign_update_challenge_no_throw(cx_eddsa_sign_ctx_t *ctx,
+                                                                    const uint8_t       *data,
+                                                                    size_t               len);
+
+/**
+ * @brief   Ends a streaming EDDSA signature.
+ *
+ * @details The context is erased, whatever the result.
+ *
+ * @param[in, out] ctx     Pointer to the context.
+ *
+ * @param[out]     sig     Buffer where to store the signature R || S.
+ *
+ * @param[in]      sig_len Length of the signature buffer, at least 64 bytes.
+ *
+ * @return                 Error code:
+ *                         - CX_OK on success
+ *                         - CX_INVALID_PARAMETER
+ *                         - CX_INVALID_PARAMETER_SIZE
+ *                         - CX_INVALID_PARAMETER_VALUE if the two passes differ
+ *                         - CX_NOT_UNLOCKED
+ *                         - CX_MEMORY_FULL
+ *                         - CX_NOT_LOCKED
+ *                         - CX_EC_INVALID_POINT
+ *                         - CX_EC_INFINITE_POINT
+ */
+WARN_UNUSED_RESULT cx_err_t cx_eddsa_sign_final_no_throw(cx_eddsa_sign_ctx_t *ctx,
+                                                         uint8_t             *sig,
+                                                         size_t               sig_len);
+
+#endif  // HAVE_SHA512 && HAVE_SHA256
+
 #endif  // HAVE_EDDSA
 
 #endif  // LCX_EDDSA_H
@@ -428,6 +428,177 @@ WARN_UNUSED_RESULT cx_err_t cx_hmac_update(cx_hmac_t *hmac, const uint8_t *in, s
  */
 WARN_UNUSED_RESULT cx_err_t cx_hmac_final(cx_hmac_t *ctx, uint8_t *out, size_t *out_len);
 
+#if defined(HAVE_SHA224) || defined(HAVE_SHA256) || defined(HAVE_SHA384) || defined(HAVE_SHA512)
+
+/**
+ * @brief Hash state of a HMAC key
+ */
+typedef union {
+    cx_hash_t header;  ///< Generic hash context
+#if defined(HAVE_SHA224) || defined(HAVE_SHA256)
+    cx_sha256_t sha256;  ///< SHA-224/SHA-256 context
+#endif
+#if defined(HAVE_SHA384) || defined(HAVE_SHA512)
+    cx_sha512_t sha512;  ///< SHA-384/SHA-512 context
+#endif
+} cx_hmac_state_t;
+
+/**
+ * @brief HMAC key with precomputed pads
+ *
+ * @details The hash states after absorbing the key xored with the inner
+ *          and the outer pads are computed once, then copied for each
+ *          message. This saves two compressions per HMAC when the same key
+ *          is used many times, as in PBKDF2 or HKDF.
+ */
+typedef struct {
+    cx_hmac_state_t inner;    ///< State after absorbing key ^ ipad
+    cx_hmac_state_t outer;    ///< State after absorbing key ^ opad
+    size_t          mac_len;  ///< Size of the HMAC value
+} cx_hmac_key_t;
+
+/**
+ * @brief   Precomputes a HMAC key.
+ *
+ * @details The key shall be erased with explicit_bzero once it is no longer used.
+ *
+ * @param[out] hkey    Pointer to the precomputed key.
+ *
+ * @param[in]  hash_id The message digest algorithm identifier:
+ *                     CX_SHA224, CX_SHA256, CX_SHA384 or CX_SHA512.
+ *
+ * @param[in]  key     Pointer to the HMAC key value.
+ *
+ * @param[in]  key_len Length of the key. A key longer than the hash block
+ *                     is hashed first.
+ *
+ * @return             Error code:
+ *                     - CX_OK on success
+ *                     - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_hmac_key_init(cx_hmac_key_t *hkey,
+                                             cx_md_t        hash_id,
+                                             const uint8_t *key,
+                                             size_t         key_len);
+
+/**
+ * @brief   Computes a HMAC value with a precomputed key.
+ *
+ * @param[in]  hkey      Pointer to the precomputed key. It is not modified.
+ *
+ * @param[in]  iovec     Input data in the form of an array of cx_iovec_t.
+ *
+ * @param[in]  iovec_len Length of the iovec array.
+ *
+ * @param[out] mac       Buffer where to store the hkey->mac_len bytes HMAC value.
+ *                       It may overlap with the input data.
+ *
+ * @return               Error code:
+ *                       - CX_OK on success
+ *                       - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_hmac_key_compute_iovec(const cx_hmac_key_t *hkey,
+                                                      const cx_iovec_t    *iovec,
+                                                      size_t               iovec_len,
+                                                      uint8_t             *mac);
+
+/**
+ * @brief   Computes a HMAC value with a precomputed key.
+ *
+ * @param[in]  hkey   Pointer to the precomputed key. It is not modified.
+ *
+ * @param[in]  in     Input data.
+ *
+ * @param[in]  in_len Length of the input data.
+ *
+ * @param[out] mac    Buffer where to store the hkey->mac_len bytes HMAC value.
+ *                    It may overlap with the input data.
+ *
+ * @return            Error code:
+ *                    - CX_OK on success
+ *                    - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT static inline cx_err_t cx_hmac_key_compute(const cx_hmac_key_t *hkey,
+                                                              const uint8_t       *in,
+                                                              size_t               in_len,
+                                                              uint8_t             *mac)
+{
+    const cx_iovec_t iovec = {.iov_base = in, .iov_len = in_len};
+
+    return cx_hmac_key_compute_iovec(hkey, &iovec, 1, mac);
+}
+
+/** Maximum size of an HKDF output block */
+#define CX_HKDF_MAX_BLOCK_SIZE 64
+
+/**
+ * @brief Streaming HKDF-Expand context
+ *
+ * @details Each block T(i) is computed once, when the output reaches it.
+ *          With SHA-512 enabled, the context takes 492 bytes on a 32-bit
+ *          target, and each block computation uses about 280 more bytes
+ *          of stack.
+ */
+typedef struct {
+    cx_hmac_key_t  hkey;                           ///< Precomputed PRK
+    const uint8_t *info;                           ///< Context information
+    size_t         info_len;                       ///< Length of the context information
+    uint8_t        block[CX_HKDF_MAX_BLOCK_SIZE];  ///< Current block T(i)
+    size_t         offset;                         ///< Bytes of the block already output
+    uint8_t        counter;                        ///< Index i of the current block
+} cx_hkdf_expand_t;
+
+/**
+ * @brief   Starts an HKDF-Expand.
+ *
+ * @details It follows <a href="https://tools.ietf.org/html/rfc5869"> RFC 5869 </a>.
+ *          The context shall be erased with explicit_bzero once it is no longer used.
+ *
+ * @param[out] ctx      Pointer to the context.
+ *
+ * @param[in]  hash_id  The message digest algorithm identifier:
+ *                      CX_SHA224, CX_SHA256, CX_SHA384 or CX_SHA512.
+ *
+ * @param[in]  prk      Pseudorandom key, usually the output of HKDF-Extract.
+ *
+ * @param[in]  prk_len  Length of the pseudorandom key.
+ *
+ * @param[in]  info     Context information. It is not copied and shall stay
+ *                      valid while the context is used.
+ *
+ * @param[in]  info_len Length of the context information.
+ *
+ * @return              Error code:
+ *                      - CX_OK on success
+ *                      - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_hkdf_expand_init(cx_hkdf_expand_t *ctx,
+                                                cx_md_t           hash_id,
+                                                const uint8_t    *prk,
+                                                size_t            prk_len,
+                                                const uint8_t    *info,
+                                                size_t            info_len);
+
+/**
+ * @brief   Reads the next bytes of the HKDF-Expand output.
+ *
+ * @details Successive reads return the same bytes as a single HKDF-Expand
+ *          of the total length. At most 255 blocks can be produced.
+ *
+ * @param[in, out] ctx Pointer to the context.
+ *
+ * @param[out]     out Buffer where to store the output.
+ *
+ * @param[in]      len Number of bytes to read.
+ *
+ * @return             Error code:
+ *                     - CX_OK on success
+ *                     - CX_INVALID_PARAMETER, also if the output would exceed 255 blocks
+ */
+WARN_UNUSED_RESULT cx_err_t cx_hkdf_expand_read(cx_hkdf_expand_t *ctx, uint8_t *out, size_t len);
+
+#endif  // HAVE_SHA224 || HAVE_SHA256 || HAVE_SHA384 || HAVE_SHA512
+
 #endif  // HAVE_HMAC
 
 #endif  // LCX_HMAC_H
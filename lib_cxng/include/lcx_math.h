@@ -577,6 +577,232 @@ static inline bool cx_math_is_zero(const uint8_t *a, size_t len)
     return 1;
 }
 
+/**
+ * @brief   Modular arithmetic session.
+ *
+ * @details A session keeps the BN processor locked and the Montgomery
+ *          context of the modulus alive between operations. Operands
+ *          are imported once with #cx_math_session_load, stay resident
+ *          as BN indexes in Montgomery representation and are exported
+ *          with #cx_math_session_store when the sequence is complete.
+ *          This avoids the lock, allocation, import, Montgomery setup,
+ *          export and unlock that each *cx_math_xxx_no_throw* call pays.
+ *
+ *          While a session is open, no other function locking the BN
+ *          processor (ECDSA, EdDSA, *cx_math_xxx_no_throw*, ...) can be
+ *          called.
+ */
+typedef struct {
+    cx_bn_mont_ctx_t mont;    ///< Montgomery context of the modulus
+    size_t           nbytes;  ///< Size in bytes of the modulus and of the operands
+} cx_math_session_t;
+
+/**
+ * @brief   Opens a modular arithmetic session.
+ *
+ * @details Locks the BN processor and computes the Montgomery
+ *          constants of the modulus once for the whole session.
+ *          On failure, nothing is left locked, and
+ *          #cx_math_session_end must not be called.
+ *
+ * @param[out] session Pointer to the session.
+ *
+ * @param[in]  m       Modulus. Must be odd.
+ *
+ * @param[in]  len     Number of bytes of the modulus.
+ *
+ * @return             Error code:
+ *                     - CX_OK on success
+ *                     - CX_LOCKED
+ *                     - CX_INVALID_PARAMETER_SIZE
+ *                     - CX_MEMORY_FULL
+ *                     - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_math_session_start(cx_math_session_t *session,
+                                                  const uint8_t     *m,
+                                                  size_t             len);
+
+/**
+ * @brief   Allocates a BN initialized to 0 in the session.
+ *
+ * @param[in]  session Pointer to the session.
+ *
+ * @param[out] x       BN index of the new operand.
+ *
+ * @return             Error code:
+ *                     - CX_OK on success
+ *                     - CX_NOT_LOCKED
+ *                     - CX_MEMORY_FULL
+ */
+WARN_UNUSED_RESULT cx_err_t cx_math_session_alloc(const cx_math_session_t *session, cx_bn_t *x);
+
+/**
+ * @brief   Imports an integer into the session.
+ *
+ * @details The integer is converted into Montgomery representation
+ *          and kept in a newly allocated BN.
+ *
+ * @param[in]  session Pointer to the session.
+ *
+ * @param[out] x       BN index of the new operand.
+ *
+ * @param[in]  a       Pointer to the integer. Must be strictly smaller
+ *                     than the modulus.
+ *
+ * @param[in]  len     Number of bytes of the integer. Must not exceed
+ *                     the size of the modulus.
+ *
+ * @return             Error code:
+ *                     - CX_OK on success
+ *                     - CX_NOT_LOCKED
+ *                     - CX_INVALID_PARAMETER_SIZE
+ *                     - CX_MEMORY_FULL
+ *                     - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_math_session_load(const cx_math_session_t *session,
+                                                 cx_bn_t                 *x,
+                                                 const uint8_t           *a,
+                                                 size_t                   len);
+
+/**
+ * @brief   Exports an operand of the session.
+ *
+ * @param[in]  session Pointer to the session.
+ *
+ * @param[out] r       Buffer for the result, of the size of the modulus.
+ *
+ * @param[in]  x       BN index of the operand, in Montgomery representation.
+ *
+ * @return             Error code:
+ *                     - CX_OK on success
+ *                     - CX_NOT_LOCKED
+ *                     - CX_MEMORY_FULL
+ *                     - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_math_session_store(const cx_math_session_t *session,
+                                                  uint8_t                 *r,
+                                                  const cx_bn_t            x);
+
+/**
+ * @brief   Performs a modular addition **r = a + b mod m** in the session.
+ *
+ * @param[in]  session Pointer to the session.
+ *
+ * @param[out] r       BN index for the result.
+ *
+ * @param[in]  a       BN index of the first operand.
+ *
+ * @param[in]  b       BN index of the second operand.
+ *
+ * @return             Error code:
+ *                     - CX_OK on success
+ *                     - CX_NOT_LOCKED
+ *                     - CX_MEMORY_FULL
+ *                     - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_math_session_addm(const cx_math_session_t *session,
+                                                 cx_bn_t                  r,
+                                                 const cx_bn_t            a,
+                                                 const cx_bn_t            b);
+
+/**
+ * @brief   Performs a modular subtraction **r = a - b mod m** in the session.
+ *
+ * @param[in]  session Pointer to the session.
+ *
+ * @param[out] r       BN index for the result.
+ *
+ * @param[in]  a       BN index of the first operand.
+ *
+ * @param[in]  b       BN index of the second operand.
+ *
+ * @return             Error code:
+ *                     - CX_OK on success
+ *                     - CX_NOT_LOCKED
+ *                     - CX_MEMORY_FULL
+ *                     - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_math_session_subm(const cx_math_session_t *session,
+                                                 cx_bn_t                  r,
+                                                 const cx_bn_t            a,
+                                                 const cx_bn_t            b);
+
+/**
+ * @brief   Performs a modular multiplication **r = a * b mod m** in the session.
+ *
+ * @param[in]  session Pointer to the session.
+ *
+ * @param[out] r       BN index for the result.
+ *
+ * @param[in]  a       BN index of the first operand.
+ *
+ * @param[in]  b       BN index of the second operand.
+ *
+ * @return             Error code:
+ *                     - CX_OK on success
+ *                     - CX_NOT_LOCKED
+ *                     - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_math_session_multm(const cx_math_session_t *session,
+                                                  cx_bn_t                  r,
+                                                  const cx_bn_t            a,
+                                                  const cx_bn_t            b);
+
+/**
+ * @brief   Performs a modular exponentiation **r = a^e mod m** in the session.
+ *
+ * @param[in]  session Pointer to the session.
+ *
+ * @param[out] r       BN index for the result.
+ *
+ * @param[in]  a       BN index of the base.
+ *
+ * @param[in]  e       Pointer to the exponent.
+ *
+ * @param[in]  len_e   Number of bytes of the exponent.
+ *
+ * @return             Error code:
+ *                     - CX_OK on success
+ *                     - CX_NOT_LOCKED
+ *                     - CX_MEMORY_FULL
+ *                     - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_math_session_powm(const cx_math_session_t *session,
+                                                 cx_bn_t                  r,
+                                                 const cx_bn_t            a,
+                                                 const uint8_t           *e,
+                                                 size_t                   len_e);
+
+/**
+ * @brief   Computes the modular inverse **r = a^(-1) mod m** in the session,
+ *          for a prime modulus.
+ *
+ * @param[in]  session Pointer to the session.
+ *
+ * @param[out] r       BN index for the result.
+ *
+ * @param[in]  a       BN index of the value to be inverted.
+ *
+ * @return             Error code:
+ *                     - CX_OK on success
+ *                     - CX_NOT_LOCKED
+ *                     - CX_MEMORY_FULL
+ *                     - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_math_session_invprimem(const cx_math_session_t *session,
+                                                      cx_bn_t                  r,
+                                                      const cx_bn_t            a);
+
+/**
+ * @brief   Closes a modular arithmetic session.
+ *
+ * @details Releases the BN processor, which erases all the operands
+ *          of the session.
+ *
+ * @param[in, out] session Pointer to the session.
+ */
+void cx_math_session_end(cx_math_session_t *session);
+
 #endif  // HAVE_MATH
 
 #endif  // LCX_MATH_H
@@ -39,6 +39,9 @@
  *
  * @details It computes the bytes sequence according to
  *          <a href="https://tools.ietf.org/html/rfc2898"> RFC 2898 </a>.
+ *          When the application is built with ENABLE_APP_HMAC_KDF=1, it runs
+ *          in the application on top of #cx_hmac_key_init, which halves the
+ *          number of hash compressions per iteration.
  *
  * @param[in]  md_type     Message digest algorithm identifier.
  *
@@ -200,6 +200,119 @@ static inline cx_err_t cx_sha256_hash(const uint8_t *in,
  */
 size_t cx_hash_sha256(const uint8_t *in, size_t len, uint8_t *out, size_t out_len);
 
+#ifdef HAVE_SHA256
+
+/**
+ * @brief Tagged hash midstate.
+ *
+ * @details A tagged hash, as defined in BIP340, is
+ *          **SHA-256(SHA-256(tag) || SHA-256(tag) || m)**. The 64-byte prefix
+ *          fills exactly one block: starting from the state reached after this
+ *          block saves one compression per hash, and the hash of the tag.
+ */
+typedef struct {
+    uint32_t acc[8];  ///< SHA-256 state after the prefix block
+} cx_sha256_tag_t;
+
+/** "BIP0340/aux" tag */
+extern const cx_sha256_tag_t cx_sha256_tag_bip340_aux;
+/** "BIP0340/nonce" tag */
+extern const cx_sha256_tag_t cx_sha256_tag_bip340_nonce;
+/** "BIP0340/challenge" tag */
+extern const cx_sha256_tag_t cx_sha256_tag_bip340_challenge;
+/** "TapLeaf" tag */
+extern const cx_sha256_tag_t cx_sha256_tag_tapleaf;
+/** "TapBranch" tag */
+extern const cx_sha256_tag_t cx_sha256_tag_tapbranch;
+/** "TapTweak" tag */
+extern const cx_sha256_tag_t cx_sha256_tag_taptweak;
+/** "TapSighash" tag */
+extern const cx_sha256_tag_t cx_sha256_tag_tapsighash;
+
+/**
+ * @brief   Computes the midstate of a custom tag.
+ *
+ * @details The result can be kept by the application, for instance in a static
+ *          variable, and then used as many times as needed.
+ *
+ * @param[out] tag      Pointer to the midstate.
+ *
+ * @param[in]  name     Tag name.
+ *
+ * @param[in]  name_len Length of the tag name.
+ *
+ * @return              Error code:
+ *                      - CX_OK on success
+ *                      - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_sha256_tag_init(cx_sha256_tag_t *tag,
+                                               const uint8_t   *name,
+                                               size_t           name_len);
+
+/**
+ * @brief   Initializes a SHA-256 context for a tagged hash.
+ *
+ * @details The context is ready to be updated with the message.
+ *
+ * @param[out] hash Pointer to the context.
+ *                  The context shall be in RAM.
+ *
+ * @param[in]  tag  Tag midstate.
+ *
+ * @return          Error code:
+ *                  - CX_OK on success
+ */
+// No need to add WARN_UNUSED_RESULT to cx_sha256_tagged_init(), it always returns CX_OK
+cx_err_t cx_sha256_tagged_init(cx_sha256_t *hash, const cx_sha256_tag_t *tag);
+
+/**
+ * @brief   Computes a standalone one shot tagged hash.
+ *
+ * @param[in]  tag       Tag midstate.
+ *
+ * @param[in]  iovec     Input data in the form of an array of cx_iovec_t.
+ *
+ * @param[in]  iovec_len Length of the iovec array.
+ *
+ * @param[out] digest    Buffer where to store the digest.
+ *
+ * @return               Error code:
+ *                       - CX_OK on success
+ *                       - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t cx_sha256_tagged_hash_iovec(const cx_sha256_tag_t *tag,
+                                                        const cx_iovec_t      *iovec,
+                                                        size_t                 iovec_len,
+                                                        uint8_t digest[static CX_SHA256_SIZE]);
+
+/**
+ * @brief   Computes a standalone one shot tagged hash.
+ *
+ * @param[in]  tag     Tag midstate.
+ *
+ * @param[in]  in      Input data.
+ *
+ * @param[in]  len     Length of the input data.
+ *
+ * @param[out] digest  Buffer where to store the digest.
+ *
+ * @return             Error code:
+ *                     - CX_OK on success
+ *                     - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT static inline cx_err_t cx_sha256_tagged_hash(
+    const cx_sha256_tag_t *tag,
+    const uint8_t         *in,
+    size_t                 in_len,
+    uint8_t                digest[static CX_SHA256_SIZE])
+{
+    const cx_iovec_t iovec = {.iov_base = in, .iov_len = in_len};
+
+    return cx_sha256_tagged_hash_iovec(tag, &iovec, 1, digest);
+}
+
+#endif  // HAVE_SHA256
+
 #endif  // defined(HAVE_SHA256) || defined(HAVE_SHA224)
 
 #endif  // LCX_SHA256_H
@@ -24,6 +24,11 @@
  * based on an instance of the KECCAK algorithm.
  * Refer to <a href="https://csrc.nist.gov/publications/detail/fips/202/final">  FIPS 202 </a>
  * for more details.
+ *
+ * When the application is built with ENABLE_APP_KECCAK=1, the KECCAK, SHA3
+ * and SHA3-XOF init, update and final functions run in the application
+ * instead of the OS, which avoids a syscall per update. Contexts keep the
+ * same layout in both cases.
  */
 
 #ifndef LCX_SHA3_H
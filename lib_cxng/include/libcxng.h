@@ -91,6 +91,13 @@
 /* ======================================================================= */
 
 #include "lcx_aes.h"
+#include "lcx_aes_gcm.h"
+
+/* ======================================================================= */
+/*                            CHACHA20-POLY1305                            */
+/* ======================================================================= */
+
+#include "lcx_chacha_poly.h"
 
 /* ======================================================================= */
 /*                                   RSA                                   */
@@ -38,16 +38,29 @@ unsigned long int cx_shr(unsigned long int x, unsigned char n)
 }
 #endif
 
+/*
+ * The byte swaps use the compiler builtins, a single REV instruction on
+ * Thumb. Defining CX_UTILS_GENERIC builds the portable shifts and masks
+ * instead, for the compilers without the builtins.
+ */
+#ifdef CX_UTILS_GENERIC
 uint32_t cx_swap_uint32(uint32_t v)
 {
     return (((v) << 24) & 0xFF000000U) | (((v) << 8) & 0x00FF0000U) | (((v) >> 8) & 0x0000FF00U)
            | (((v) >> 24) & 0x000000FFU);
 }
+#else   // CX_UTILS_GENERIC
+uint32_t cx_swap_uint32(uint32_t v)
+{
+    return __builtin_bswap32(v);
+}
+#endif  // CX_UTILS_GENERIC
 
 void cx_swap_buffer32(uint32_t *v, size_t len)
 {
     while (len--) {
 #ifdef ST31
+        // no word access, the buffer may not be aligned
         unsigned int tmp;
         tmp                                = ((unsigned char *) v)[len * 4 + 3];
         ((unsigned char *) v)[len * 4 + 3] = ((unsigned char *) v)[len * 4];
@@ -125,7 +138,7 @@ void cx_swap_uint64(uint64bits_t *v)
     v->h = l;
     v->l = h;
 }
-#else   // HAVE_SYS_UINT64_SUPPORT
+#elif defined(CX_UTILS_GENERIC)
 uint64bits_t cx_swap_uint64(uint64bits_t v)
 {
     uint32_t h, l;
@@ -135,6 +148,11 @@ uint64bits_t cx_swap_uint64(uint64bits_t v)
     h = cx_swap_uint32(h);
     return (((uint64bits_t) l) << 32) | ((uint64bits_t) h);
 }
+#else   // HAVE_SYS_UINT64_SUPPORT
+uint64bits_t cx_swap_uint64(uint64bits_t v)
+{
+    return __builtin_bswap64(v);
+}
 #endif  // HAVE_SYS_UINT64_SUPPORT
 
 void cx_swap_buffer64(uint64bits_t *v, int len)
@@ -170,10 +188,22 @@ void cx_add_64(uint64bits_t *x, uint64bits_t *y)
 }
 #endif
 
+typedef uint32_t __attribute__((may_alias)) cx_word_t;
+
 void cx_memxor(uint8_t *buf1, const uint8_t *buf2, size_t len)
 {
-    size_t i;
-    for (i = 0; i < len; i++) {
+    size_t i = 0;
+
+    // Words are used when both buffers have the same alignment
+    if ((((uintptr_t) buf1 ^ (uintptr_t) buf2) & (sizeof(cx_word_t) - 1)) == 0) {
+        for (; (i < len) && (((uintptr_t) (buf1 + i) & (sizeof(cx_word_t) - 1)) != 0); i++) {
+            buf1[i] ^= buf2[i];
+        }
+        for (; len - i >= sizeof(cx_word_t); i += sizeof(cx_word_t)) {
+            *(cx_word_t *) (buf1 + i) ^= *(const cx_word_t *) (buf2 + i);
+        }
+    }
+    for (; i < len; i++) {
         buf1[i] ^= buf2[i];
     }
 }
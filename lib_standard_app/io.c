@@ -30,6 +30,13 @@
 #define SW_OK                    0x9000
 #define SW_WRONG_RESPONSE_LENGTH 0xB000
 
+#ifdef HAVE_IO_PIPELINE
+// Receive the next command while processing and replying to the current one
+#define IO_RECV_FLAGS IO_PIPELINE
+#else
+#define IO_RECV_FLAGS 0
+#endif  // HAVE_IO_PIPELINE
+
 uint8_t G_io_seproxyhal_spi_buffer[IO_SEPROXYHAL_BUFFER_SIZE_B];
 
 /**
@@ -137,11 +144,11 @@ WEAK int io_recv_command()
     switch (G_io_state) {
         case READY:
             G_io_state = RECEIVED;
-            ret        = io_exchange(CHANNEL_APDU, G_output_len);
+            ret        = io_exchange(CHANNEL_APDU | IO_RECV_FLAGS, G_output_len);
             break;
         case RECEIVED:
             G_io_state = WAITING;
-            ret        = io_exchange(CHANNEL_APDU | IO_ASYNCH_REPLY, G_output_len);
+            ret        = io_exchange(CHANNEL_APDU | IO_ASYNCH_REPLY | IO_RECV_FLAGS, G_output_len);
             G_io_state = RECEIVED;
             break;
         case WAITING:
@@ -153,10 +160,70 @@ WEAK int io_recv_command()
     return ret;
 }
 
+#ifdef HAVE_IO_SCATTER_GATHER
+/**
+ * Send APDU response straight from the response data buffers, without
+ * concatenating them in G_io_apdu_buffer. This is only possible over the
+ * transports framing the reply from a list of buffers, and the response is
+ * then sent immediately as the buffers may not outlive the call.
+ *
+ * @return true if the response has been sent, false if it must be copied
+ *   to G_io_apdu_buffer.
+ */
+static bool io_send_response_iov(const buffer_t *rdatalist, size_t count, uint16_t sw, int *ret)
+{
+    static uint8_t sw_buffer[2];
+    io_iovec_t     iov[IO_IOVEC_MAX];
+    size_t         length = 0;
+
+    if ((G_io_state == READY) || (count >= IO_IOVEC_MAX)
+        || ((G_io_app.apdu_state != APDU_USB_HID) && (G_io_app.apdu_state != APDU_USB_WEBUSB))) {
+        return false;
+    }
+#ifdef HAVE_SWAP
+    if (G_called_from_swap) {
+        return false;
+    }
+#endif  // HAVE_SWAP
+
+    for (size_t i = 0; i < count; i++) {
+        if (rdatalist[i].offset > rdatalist[i].size) {
+            return false;
+        }
+        iov[i].ptr = rdatalist[i].ptr + rdatalist[i].offset;
+        iov[i].len = rdatalist[i].size - rdatalist[i].offset;
+        length += iov[i].len;
+        if (length > sizeof(G_io_apdu_buffer) - 2) {
+            // let the copy fail the same way
+            return false;
+        }
+    }
+    write_u16_be(sw_buffer, 0, sw);
+    iov[count].ptr = sw_buffer;
+    iov[count].len = sizeof(sw_buffer);
+    PRINTF("<= SW=%04X | RData gathered from %u buffers (%u bytes)\n", sw, count, length);
+
+    // taken, and cleared, by io_exchange
+    G_io_app.tx_iov       = iov;
+    G_io_app.tx_iov_count = count + 1;
+    *ret                  = io_exchange(CHANNEL_APDU | IO_RETURN_AFTER_TX, length + 2);
+    G_output_len          = 0;
+    G_io_state            = READY;
+
+    return true;
+}
+#endif  // HAVE_IO_SCATTER_GATHER
+
 WEAK int io_send_response_buffers(const buffer_t *rdatalist, size_t count, uint16_t sw)
 {
     int ret = -1;
 
+#ifdef HAVE_IO_SCATTER_GATHER
+    if (rdatalist && count > 0 && io_send_response_iov(rdatalist, count, sw, &ret)) {
+        return ret;
+    }
+#endif  // HAVE_IO_SCATTER_GATHER
+
     G_output_len = 0;
     if (rdatalist && count > 0) {
         for (size_t i = 0; i < count; i++) {
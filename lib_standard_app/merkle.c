@@ -0,0 +1,217 @@
+/*****************************************************************************
+ *   Ledger SDK.
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+#include <stdint.h>   // uint*_t
+#include <string.h>   // memcmp, memcpy, explicit_bzero
+#include <stdbool.h>  // bool
+
+#include "merkle.h"
+
+static bool merkle_params_valid(const merkle_params_t *params)
+{
+    return (params != NULL) && (params->hash != NULL) && (params->hash_len != 0)
+           && (params->hash_len <= MERKLE_MAX_HASH_SIZE)
+           && ((params->leaf_tag != NULL) || (params->leaf_tag_len == 0))
+           && ((params->node_tag != NULL) || (params->node_tag_len == 0));
+}
+
+cx_err_t merkle_hash_leaf(const merkle_params_t *params,
+                          const uint8_t         *data,
+                          size_t                 len,
+                          uint8_t               *hash)
+{
+    cx_iovec_t iovec[2];
+
+    if (!merkle_params_valid(params) || ((data == NULL) && (len != 0)) || (hash == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+    iovec[0].iov_base = params->leaf_tag;
+    iovec[0].iov_len  = params->leaf_tag_len;
+    iovec[1].iov_base = data;
+    iovec[1].iov_len  = len;
+    return params->hash(iovec, 2, hash);
+}
+
+cx_err_t merkle_hash_node(const merkle_params_t *params,
+                          const uint8_t         *left,
+                          const uint8_t         *right,
+                          uint8_t               *hash)
+{
+    cx_iovec_t iovec[3];
+
+    if (!merkle_params_valid(params) || (left == NULL) || (right == NULL) || (hash == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+    if (params->sorted_pairs && (memcmp(left, right, params->hash_len) > 0)) {
+        const uint8_t *tmp = left;
+
+        left  = right;
+        right = tmp;
+    }
+    iovec[0].iov_base = params->node_tag;
+    iovec[0].iov_len  = params->node_tag_len;
+    iovec[1].iov_base = left;
+    iovec[1].iov_len  = params->hash_len;
+    iovec[2].iov_base = right;
+    iovec[2].iov_len  = params->hash_len;
+    // The hash functions read all their input before writing the digest
+    return params->hash(iovec, 3, hash);
+}
+
+cx_err_t merkle_builder_init(merkle_builder_t *builder, const merkle_params_t *params)
+{
+    if ((builder == NULL) || !merkle_params_valid(params)) {
+        return CX_INVALID_PARAMETER;
+    }
+    explicit_bzero(builder, sizeof(merkle_builder_t));
+    builder->params = params;
+    return CX_OK;
+}
+
+cx_err_t merkle_builder_add_leaf(merkle_builder_t *builder, const uint8_t *data, size_t len)
+{
+    cx_err_t error;
+    uint8_t  leaf_hash[MERKLE_MAX_HASH_SIZE];
+
+    if (builder == NULL) {
+        return CX_INVALID_PARAMETER;
+    }
+    CX_CHECK(merkle_hash_leaf(builder->params, data, len, leaf_hash));
+    CX_CHECK(merkle_builder_add_leaf_hash(builder, leaf_hash));
+
+end:
+    return error;
+}
+
+cx_err_t merkle_builder_add_leaf_hash(merkle_builder_t *builder, const uint8_t *leaf_hash)
+{
+    cx_err_t error = CX_OK;
+    uint8_t  node[MERKLE_MAX_HASH_SIZE];
+    size_t   level;
+    size_t   hash_len;
+
+    if ((builder == NULL) || (leaf_hash == NULL) || !merkle_params_valid(builder->params)) {
+        return CX_INVALID_PARAMETER;
+    }
+    if (builder->count >= (1UL << MERKLE_MAX_DEPTH)) {
+        return CX_MEMORY_FULL;
+    }
+    hash_len = builder->params->hash_len;
+
+    // Merges the complete subtrees of the same size, like a binary counter
+    memcpy(node, leaf_hash, hash_len);
+    for (level = 0; (builder->count >> level) & 1; level++) {
+        CX_CHECK(merkle_hash_node(builder->params, builder->frontier[level], node, node));
+    }
+    memcpy(builder->frontier[level], node, hash_len);
+    builder->count++;
+
+end:
+    return error;
+}
+
+cx_err_t merkle_builder_root(const merkle_builder_t *builder, uint8_t *root)
+{
+    cx_err_t error = CX_OK;
+    uint8_t  node[MERKLE_MAX_HASH_SIZE];
+    size_t   level;
+    size_t   hash_len;
+
+    if ((builder == NULL) || (root == NULL) || !merkle_params_valid(builder->params)) {
+        return CX_INVALID_PARAMETER;
+    }
+    // RFC 6962: the root of the empty tree is the hash of the empty string
+    if (builder->count == 0) {
+        return builder->params->hash(NULL, 0, root);
+    }
+    hash_len = builder->params->hash_len;
+
+    // Folds the complete subtrees from the smallest one, which is the rightmost
+    level = 0;
+    while (((builder->count >> level) & 1) == 0) {
+        level++;
+    }
+    memcpy(node, builder->frontier[level], hash_len);
+    for (level++; level <= MERKLE_MAX_DEPTH; level++) {
+        if ((builder->count >> level) & 1) {
+            CX_CHECK(merkle_hash_node(builder->params, builder->frontier[level], node, node));
+        }
+    }
+    memcpy(root, node, hash_len);
+
+end:
+    return error;
+}
+
+cx_err_t merkle_verify_proof(const merkle_params_t *params,
+                             const uint8_t         *leaf_hash,
+                             uint32_t               index,
+                             uint32_t               count,
+                             const uint8_t         *proof,
+                             size_t                 proof_len,
+                             const uint8_t         *root)
+{
+    cx_err_t error = CX_OK;
+    uint8_t  node[MERKLE_MAX_HASH_SIZE];
+    uint32_t fn = index;
+    uint32_t sn;
+    size_t   hash_len;
+
+    if (!merkle_params_valid(params) || (leaf_hash == NULL) || (root == NULL)
+        || ((proof == NULL) && (proof_len != 0))) {
+        return CX_INVALID_PARAMETER;
+    }
+    if (!params->sorted_pairs && (index >= count)) {
+        return CX_INVALID_PARAMETER;
+    }
+    hash_len = params->hash_len;
+    sn       = count - 1;
+
+    // RFC 9162, section 2.1.3.2, iterating over the proof from the leaf
+    memcpy(node, leaf_hash, hash_len);
+    for (size_t i = 0; i < proof_len; i++) {
+        const uint8_t *sibling = proof + i * hash_len;
+
+        if (params->sorted_pairs) {
+            CX_CHECK(merkle_hash_node(params, sibling, node, node));
+            continue;
+        }
+        if (sn == 0) {
+            error = CX_INVALID_PARAMETER_VALUE;
+            goto end;
+        }
+        if ((fn & 1) || (fn == sn)) {
+            CX_CHECK(merkle_hash_node(params, sibling, node, node));
+            // Skips the levels where the node has no right sibling
+            while (((fn & 1) == 0) && (fn != 0)) {
+                fn >>= 1;
+                sn >>= 1;
+            }
+        }
+        else {
+            CX_CHECK(merkle_hash_node(params, node, sibling, node));
+        }
+        fn >>= 1;
+        sn >>= 1;
+    }
+
+    if ((!params->sorted_pairs && (sn != 0)) || (memcmp(node, root, hash_len) != 0)) {
+        error = CX_INVALID_PARAMETER_VALUE;
+    }
+
+end:
+    return error;
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <stdint.h>   // uint*_t
+#include <stddef.h>   // size_t
+#include <stdbool.h>  // bool
+
+#include "cx.h"
+
+/**
+ * Maximum depth of a tree, i.e. up to 2^MERKLE_MAX_DEPTH leaves.
+ * The builder keeps one node per level, so it can be lowered to save RAM.
+ */
+#ifndef MERKLE_MAX_DEPTH
+#define MERKLE_MAX_DEPTH 16
+#endif
+
+/**
+ * Maximum size of the node hashes.
+ */
+#ifndef MERKLE_MAX_HASH_SIZE
+#define MERKLE_MAX_HASH_SIZE 32
+#endif
+
+/**
+ * One shot hash function over an iovec, such as cx_sha256_hash_iovec().
+ */
+typedef cx_err_t (*merkle_hash_iovec_t)(const cx_iovec_t *iovec,
+                                        size_t            iovec_len,
+                                        uint8_t          *digest);
+
+/**
+ * Description of a Merkle tree.
+ *
+ * A leaf is hashed as H(leaf_tag || data) and a node as
+ * H(node_tag || left || right). With sorted_pairs, the two children
+ * are sorted before being hashed, as in Taproot script trees.
+ */
+typedef struct {
+    merkle_hash_iovec_t hash;          /// Hash function
+    size_t              hash_len;      /// Digest size of the hash function
+    const uint8_t      *leaf_tag;      /// Prefix of the leaves, can be NULL
+    size_t              leaf_tag_len;  /// Length of the leaf prefix
+    const uint8_t      *node_tag;      /// Prefix of the nodes, can be NULL
+    size_t              node_tag_len;  /// Length of the node prefix
+    bool                sorted_pairs;  /// Whether children are sorted before hashing
+} merkle_params_t;
+
+/**
+ * Incremental Merkle tree builder.
+ *
+ * Only the roots of the complete subtrees seen so far are kept, one per
+ * set bit of the number of leaves. The resulting tree has the shape of
+ * RFC 6962: the left subtree of a node is the largest complete tree.
+ */
+typedef struct {
+    const merkle_params_t *params;  /// Tree description
+    uint32_t               count;   /// Number of leaves added
+    /// Roots of the complete subtrees, indexed by height
+    uint8_t                frontier[MERKLE_MAX_DEPTH + 1][MERKLE_MAX_HASH_SIZE];
+} merkle_builder_t;
+
+/**
+ * @brief   Computes the hash of a leaf.
+ *
+ * @param[in]  params Tree description.
+ *
+ * @param[in]  data   Leaf data.
+ *
+ * @param[in]  len    Length of the leaf data.
+ *
+ * @param[out] hash   Buffer where to store the params->hash_len bytes hash.
+ *
+ * @return            Error code:
+ *                    - CX_OK on success
+ *                    - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t merkle_hash_leaf(const merkle_params_t *params,
+                                             const uint8_t         *data,
+                                             size_t                 len,
+                                             uint8_t               *hash);
+
+/**
+ * @brief   Computes the hash of a node from its children.
+ *
+ * @param[in]  params Tree description.
+ *
+ * @param[in]  left   Hash of the left child.
+ *
+ * @param[in]  right  Hash of the right child.
+ *
+ * @param[out] hash   Buffer where to store the hash. It may be equal to *left* or *right*.
+ *
+ * @return            Error code:
+ *                    - CX_OK on success
+ *                    - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t merkle_hash_node(const merkle_params_t *params,
+                                             const uint8_t         *left,
+                                             const uint8_t         *right,
+                                             uint8_t               *hash);
+
+/**
+ * @brief   Initializes a Merkle tree builder.
+ *
+ * @param[out] builder Pointer to the builder.
+ *
+ * @param[in]  params  Tree description. It must stay valid while the builder is used.
+ *
+ * @return             Error code:
+ *                     - CX_OK on success
+ *                     - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t merkle_builder_init(merkle_builder_t      *builder,
+                                                const merkle_params_t *params);
+
+/**
+ * @brief   Appends a leaf to the tree.
+ *
+ * @param[in, out] builder Pointer to the builder.
+ *
+ * @param[in]      data    Leaf data. It is hashed with the leaf tag.
+ *
+ * @param[in]      len     Length of the leaf data.
+ *
+ * @return                 Error code:
+ *                         - CX_OK on success
+ *                         - CX_INVALID_PARAMETER
+ *                         - CX_MEMORY_FULL if the tree already has 2^MERKLE_MAX_DEPTH leaves
+ */
+WARN_UNUSED_RESULT cx_err_t merkle_builder_add_leaf(merkle_builder_t *builder,
+                                                    const uint8_t    *data,
+                                                    size_t            len);
+
+/**
+ * @brief   Appends an already hashed leaf to the tree.
+ *
+ * @param[in, out] builder   Pointer to the builder.
+ *
+ * @param[in]      leaf_hash Hash of the leaf.
+ *
+ * @return                   Error code:
+ *                           - CX_OK on success
+ *                           - CX_INVALID_PARAMETER
+ *                           - CX_MEMORY_FULL if the tree already has 2^MERKLE_MAX_DEPTH leaves
+ */
+WARN_UNUSED_RESULT cx_err_t merkle_builder_add_leaf_hash(merkle_builder_t *builder,
+                                                         const uint8_t    *leaf_hash);
+
+/**
+ * @brief   Computes the root of the leaves added so far.
+ *
+ * @details The builder is not modified, so more leaves can be added afterwards.
+ *          As in RFC 6962, the root of an empty tree is the hash of the
+ *          empty string, without tag.
+ *
+ * @param[in]  builder Pointer to the builder.
+ *
+ * @param[out] root    Buffer where to store the root.
+ *
+ * @return             Error code:
+ *                     - CX_OK on success
+ *                     - CX_INVALID_PARAMETER
+ */
+WARN_UNUSED_RESULT cx_err_t merkle_builder_root(const merkle_builder_t *builder, uint8_t *root);
+
+/**
+ * @brief   Verifies an inclusion proof.
+ *
+ * @details The proof lists the sibling hashes from the leaf up to the root,
+ *          as produced for the RFC 6962 tree shape. With sorted_pairs, the
+ *          position of the leaf does not matter and *index* and *count* are
+ *          ignored.
+ *
+ * @param[in] params    Tree description.
+ *
+ * @param[in] leaf_hash Hash of the leaf.
+ *
+ * @param[in] index     Index of the leaf.
+ *
+ * @param[in] count     Number of leaves of the tree.
+ *
+ * @param[in] proof     Concatenated sibling hashes.
+ *
+ * @param[in] proof_len Number of hashes in the proof.
+ *
+ * @param[in] root      Expected root.
+ *
+ * @return              Error code:
+ *                      - CX_OK on success
+ *                      - CX_INVALID_PARAMETER
+ *                      - CX_INVALID_PARAMETER_VALUE if the proof does not match the root
+ */
+WARN_UNUSED_RESULT cx_err_t merkle_verify_proof(const merkle_params_t *params,
+                                                const uint8_t         *leaf_hash,
+                                                uint32_t               index,
+                                                uint32_t               count,
+                                                const uint8_t         *proof,
+                                                size_t                 proof_len,
+                                                const uint8_t         *root);
@@ -106,6 +106,14 @@
 #define CCID_STATE_DATAIN                    4
 #define CCID_STATE_UNCORRECT_LENGTH          5
 
+/* wLevelParameter of PC_to_RDR_XfrBlock and bChainParameter of RDR_to_PC_DataBlock,
+   at the extended APDU level */
+#define CCID_CHAIN_BEGIN_END                 0x00    /* APDU begins and ends in this block */
+#define CCID_CHAIN_BEGIN_CONTINUE            0x01    /* APDU begins, and continues in the next block */
+#define CCID_CHAIN_CONTINUE_END              0x02    /* APDU continues, and ends in this block */
+#define CCID_CHAIN_CONTINUE                  0x03    /* APDU continues, and goes on in the next block */
+#define CCID_CHAIN_EMPTY                     0x10    /* empty block, the next one is requested */
+
 #define DIR_IN                        0
 #define DIR_OUT                       1
 #define BOTH_DIR                      2
@@ -199,6 +207,14 @@ typedef struct usb_class_ccid_s {
 
   uint8_t* pUsbMessageBuffer;
   uint32_t UsbMessageLength;
+  uint16_t ResponseOffset;  /* offset of the block being sent in G_io_ccid_data_buffer */
+  uint8_t  ApduResponse;    /* the message being sent is the response of the APDU */
+  uint8_t  ApduSeq;         /* bSeq of the message of the APDU, for its response */
+  #ifdef HAVE_CCID_EXTENDED_APDU
+  uint16_t CommandLength;   /* data of the chained command blocks already received */
+  uint16_t ResponseLength;  /* data of the response being sent */
+  uint16_t ResponseNext;    /* offset of the next block of the response to send */
+  #endif // HAVE_CCID_EXTENDED_APDU
   Ccid_SlotStatus_t Ccid_SlotStatus;
   Protocol0_DataStructure_t Protocol0_DataStructure;
   //Ccid_bulk_data_t Ccid_bulk_data;
@@ -229,6 +245,10 @@ void CCID_SetIntrTransferStatus (uint8_t );
 void Transfer_Data_Request(void);
 void Set_CSW (uint8_t CSW_Status, uint8_t Send_Permission);
 
+#ifdef HAVE_CCID_EXTENDED_APDU
+uint8_t CCID_Prepare_NextBlock(void);
+#endif // HAVE_CCID_EXTENDED_APDU
+
 void io_usb_ccid_set_card_inserted(unsigned int inserted);
 
 void io_usb_ccid_configure_pinpad(uint8_t enabled);
@@ -223,11 +223,19 @@ uint8_t  PC_to_RDR_XfrBlock(void)
   
       uint8_t error;
 
+#ifdef HAVE_CCID_EXTENDED_APDU
+  /* abRFU 3 : bBWI and wLevelParameter, the latter chaining the APDUs */
+  error = CCID_CheckCommandParams(CHK_PARAM_SLOT |\
+                                  CHK_PARAM_CARD_PRESENT |\
+                                  CHK_PARAM_ABORT |\
+                                  CHK_ACTIVE_STATE );
+#else // HAVE_CCID_EXTENDED_APDU
   error = CCID_CheckCommandParams(CHK_PARAM_SLOT |\
                                   CHK_PARAM_CARD_PRESENT |\
                                   CHK_PARAM_abRFU3 |\
                                   CHK_PARAM_ABORT |\
                                   CHK_ACTIVE_STATE );
+#endif // HAVE_CCID_EXTENDED_APDU
   if (error != 0) 
     return error;
 
@@ -245,7 +253,61 @@ uint8_t  PC_to_RDR_XfrBlock(void)
 
   reqlen = G_io_ccid.bulk_header.bulkout.dwLength;
 
+#ifdef HAVE_CCID_EXTENDED_APDU
+  /* the previous APDU is in progress until its chained response is fetched */
+  if ((expectedLength != CCID_CHAIN_EMPTY) &&
+      (G_io_ccid.ResponseNext < G_io_ccid.ResponseLength))
+  {
+    CCID_UpdateCommandStatus(BM_COMMAND_STATUS_FAILED, BM_ICC_PRESENT_ACTIVE);
+    return SLOTERROR_CMD_SLOT_BUSY;
+  }
+
+  /* wLevelParameter = position of the block in the command APDU, or request of
+                        the next block of the response APDU */
+  switch (expectedLength)
+  {
+  case CCID_CHAIN_BEGIN_END:
+    break;
+
+  case CCID_CHAIN_CONTINUE_END:
+    /* last block, received after the previous ones */
+    reqlen += G_io_ccid.CommandLength;
+    break;
+
+  case CCID_CHAIN_BEGIN_CONTINUE:
+  case CCID_CHAIN_CONTINUE:
+    if (expectedLength == CCID_CHAIN_BEGIN_CONTINUE)
+    {
+      G_io_ccid.CommandLength = 0;
+    }
+    G_io_ccid.CommandLength += reqlen;
+    /* acknowledge with an empty block, requesting the next one */
+    G_io_ccid.bulk_header.bulkin.dwLength = 0;
+    RDR_to_PC_DataBlock(SLOT_NO_ERROR);
+    G_io_ccid.bulk_header.bulkin.bSpecific = CCID_CHAIN_EMPTY;
+    CCID_UpdateCommandStatus(BM_COMMAND_STATUS_NO_ERROR, BM_ICC_PRESENT_ACTIVE);
+    return SLOT_NO_ERROR;
+
+  case CCID_CHAIN_EMPTY:
+    /* next block of a chained response, the APDU has already been processed */
+    error = CCID_Prepare_NextBlock();
+    if (error != SLOT_NO_ERROR)
+    {
+      CCID_UpdateCommandStatus(BM_COMMAND_STATUS_FAILED, BM_ICC_PRESENT_ACTIVE);
+      return error;
+    }
+    CCID_UpdateCommandStatus(BM_COMMAND_STATUS_NO_ERROR, BM_ICC_PRESENT_ACTIVE);
+    return SLOT_NO_ERROR;
+
+  default:
+    G_io_ccid.CommandLength = 0;
+    CCID_UpdateCommandStatus(BM_COMMAND_STATUS_FAILED, BM_ICC_PRESENT_ACTIVE);
+    return SLOTERROR_BAD_LEVELPARAMETER;
+  }
+  G_io_ccid.CommandLength = 0;
+#else // HAVE_CCID_EXTENDED_APDU
   G_io_ccid.bulk_header.bulkin.dwLength = (uint16_t)expectedLength;
+#endif // HAVE_CCID_EXTENDED_APDU
 
   error = SC_XferBlock(&G_io_ccid_data_buffer[0], reqlen);
 
@@ -108,7 +108,7 @@ void CCID_BulkMessage_In (USBD_HandleTypeDef  *pdev,
       if (G_io_ccid.pUsbMessageBuffer == (uint8_t *)&G_io_ccid.bulk_header) {
         // first part of the bulk in sent.
         // advance in the data buffer to transmit. (mixed source leap)
-        G_io_ccid.pUsbMessageBuffer = G_io_ccid_data_buffer+MIN(CCID_BULK_EPIN_SIZE, G_io_ccid.UsbMessageLength)-CCID_HEADER_SIZE;
+        G_io_ccid.pUsbMessageBuffer = G_io_ccid_data_buffer+G_io_ccid.ResponseOffset+MIN(CCID_BULK_EPIN_SIZE, G_io_ccid.UsbMessageLength)-CCID_HEADER_SIZE;
       }
       else {
         G_io_ccid.pUsbMessageBuffer += MIN(CCID_BULK_EPIN_SIZE, G_io_ccid.UsbMessageLength);
@@ -137,8 +137,17 @@ void CCID_BulkMessage_In (USBD_HandleTypeDef  *pdev,
         /* Prepare EP to Receive First Cmd */
         // not timeout compliant // USBD_LL_PrepareReceive(pdev, CCID_BULK_OUT_EP, CCID_BULK_EPOUT_SIZE);
 
-        // mark transfer as completed
-        G_io_app.apdu_state = APDU_IDLE;
+        // mark transfer as completed, unless the message answered another command received
+        // while the APDU is processed
+#ifdef HAVE_CCID_EXTENDED_APDU
+        // or a chained response is not sent entirely: the host fetches the next blocks from
+        // G_io_ccid_data_buffer, which the application can't reuse until then
+        if (G_io_ccid.ApduResponse && (G_io_ccid.ResponseNext >= G_io_ccid.ResponseLength)) {
+#else // HAVE_CCID_EXTENDED_APDU
+        if (G_io_ccid.ApduResponse) {
+#endif // HAVE_CCID_EXTENDED_APDU
+          G_io_app.apdu_state = APDU_IDLE;
+        }
       }
 
       // if remaining length is < EPIN_SIZE: send packet and prepare to receive a new command
@@ -178,7 +187,7 @@ void CCID_Send_Reply(USBD_HandleTypeDef  *pdev) {
     memcpy(G_io_usb_ep_buffer, &G_io_ccid.bulk_header, CCID_HEADER_SIZE);
     if (G_io_ccid.UsbMessageLength>CCID_HEADER_SIZE) {
       // copy start of data if bigger size than a header
-      memmove(G_io_usb_ep_buffer+CCID_HEADER_SIZE, G_io_ccid_data_buffer, MIN(CCID_BULK_EPIN_SIZE, G_io_ccid.UsbMessageLength)-CCID_HEADER_SIZE);
+      memmove(G_io_usb_ep_buffer+CCID_HEADER_SIZE, G_io_ccid_data_buffer+G_io_ccid.ResponseOffset, MIN(CCID_BULK_EPIN_SIZE, G_io_ccid.UsbMessageLength)-CCID_HEADER_SIZE);
     }
     // send the first mixed source chunk
     CCID_Response_SendData(pdev, G_io_usb_ep_buffer, 
@@ -187,6 +196,26 @@ void CCID_Send_Reply(USBD_HandleTypeDef  *pdev) {
   }
 }
 
+#ifdef HAVE_CCID_EXTENDED_APDU
+/**
+  * @brief  CCID_DataOffset
+  *         Offset of the data of the received command in G_io_ccid_data_buffer:
+  *         the blocks continuing a command APDU follow the previous ones
+  * @param  None
+  * @retval uint16_t offset
+  */
+static uint16_t CCID_DataOffset(void)
+{
+  if ((G_io_ccid.bulk_header.bulkout.bMessageType == PC_TO_RDR_XFRBLOCK) &&
+      (G_io_ccid.bulk_header.bulkout.bSpecific_2 == 0) &&
+      ((G_io_ccid.bulk_header.bulkout.bSpecific_1 == CCID_CHAIN_CONTINUE_END) ||
+       (G_io_ccid.bulk_header.bulkout.bSpecific_1 == CCID_CHAIN_CONTINUE))) {
+    return G_io_ccid.CommandLength;
+  }
+  return 0;
+}
+#endif // HAVE_CCID_EXTENDED_APDU
+
 /**
   * @brief  CCID_BulkMessage_Out
   *         Proccess CCID OUT data
@@ -217,28 +246,32 @@ void CCID_BulkMessage_Out (USBD_HandleTypeDef  *pdev,
       }
       else  if (dataLen >= CCID_HEADER_SIZE)
       {
+        uint16_t offset = 0;
+
         G_io_ccid.UsbMessageLength = dataLen;   /* Store for future use */
         
         /* Expected Data Length Packet Received */
         // endianness is little :) useful for our ARM convention
-        G_io_ccid.pUsbMessageBuffer = (uint8_t*) &G_io_ccid.bulk_header;
-        
         // copy the ccid bulk header only
-        memcpy(G_io_ccid.pUsbMessageBuffer, buffer, CCID_HEADER_SIZE); 
-        // copy remaining part in the data buffer (split from the ccid to allow for overlaying with another ressource buffer)
-        if (dataLen>CCID_HEADER_SIZE) {
-          memmove(G_io_ccid_data_buffer, buffer+CCID_HEADER_SIZE, dataLen-CCID_HEADER_SIZE);
-          // we're now receiving in the data buffer (all subsequent calls)
-          G_io_ccid.pUsbMessageBuffer = G_io_ccid_data_buffer;
-        }
+        memcpy(&G_io_ccid.bulk_header, buffer, CCID_HEADER_SIZE); 
+#ifdef HAVE_CCID_EXTENDED_APDU
+        offset = CCID_DataOffset();
+#endif // HAVE_CCID_EXTENDED_APDU
         
-        if (G_io_ccid.bulk_header.bulkout.dwLength > IO_CCID_DATA_BUFFER_SIZE)
+        if ((G_io_ccid.bulk_header.bulkout.dwLength > (uint32_t)(IO_CCID_DATA_BUFFER_SIZE - offset)) ||
+            ((uint32_t)(dataLen - CCID_HEADER_SIZE) > G_io_ccid.bulk_header.bulkout.dwLength))
         { /* Check if length of data to be sent by host is > buffer size */
           
           /* Too long data received.... Error ! */
           G_io_ccid.Ccid_BulkState = CCID_STATE_UNCORRECT_LENGTH;
+          break;
         }
-        else
+
+        // copy remaining part in the data buffer (split from the ccid to allow for overlaying with another ressource buffer)
+        // we're now receiving in the data buffer (all subsequent calls)
+        G_io_ccid.pUsbMessageBuffer = G_io_ccid_data_buffer + offset;
+        memmove(G_io_ccid.pUsbMessageBuffer, buffer+CCID_HEADER_SIZE, dataLen-CCID_HEADER_SIZE);
+        
         // everything received in the first packet
         if (G_io_ccid.UsbMessageLength == (G_io_ccid.bulk_header.bulkout.dwLength + CCID_HEADER_SIZE)) {
           /* Short message, less than the EP Out Size, execute the command,
@@ -260,7 +293,12 @@ void CCID_BulkMessage_Out (USBD_HandleTypeDef  *pdev,
       
       G_io_ccid.UsbMessageLength += dataLen;
       
-      if (dataLen < CCID_BULK_EPOUT_SIZE)
+      if (G_io_ccid.UsbMessageLength > (G_io_ccid.bulk_header.bulkout.dwLength + CCID_HEADER_SIZE))
+      {
+        /* Too long data received.... Error ! */
+        G_io_ccid.Ccid_BulkState = CCID_STATE_UNCORRECT_LENGTH;
+      }
+      else if (dataLen < CCID_BULK_EPOUT_SIZE)
       {/* Short message, less than the EP Out Size, execute the command,
           if parameter like dwLength is too big, the appropriate command will 
           give an error */
@@ -318,6 +356,23 @@ void CCID_CmdDecode(USBD_HandleTypeDef  *pdev)
 {
   uint8_t errorCode;
   
+  // the responses start at the beginning of the data buffer, but the next blocks of a chained one
+  G_io_ccid.ResponseOffset = 0;
+  // the response of the APDU is sent later, by io_usb_ccid_reply
+  G_io_ccid.ApduResponse = 0;
+#ifdef HAVE_CCID_EXTENDED_APDU
+  // a chained response is continued by the empty blocks requesting it, the APDU being in
+  // progress until then: another one is refused by PC_to_RDR_XfrBlock, and any other command
+  // drops what is left of the response, completing the APDU
+  if (G_io_ccid.bulk_header.bulkout.bMessageType != PC_TO_RDR_XFRBLOCK) {
+    if (G_io_ccid.ResponseNext < G_io_ccid.ResponseLength) {
+      G_io_app.apdu_state = APDU_IDLE;
+    }
+    G_io_ccid.ResponseLength = 0;
+    G_io_ccid.ResponseNext = 0;
+  }
+#endif // HAVE_CCID_EXTENDED_APDU
+
   switch (G_io_ccid.bulk_header.bulkout.bMessageType)
   {
   case PC_TO_RDR_ICCPOWERON:
@@ -333,8 +388,11 @@ void CCID_CmdDecode(USBD_HandleTypeDef  *pdev)
     RDR_to_PC_SlotStatus(errorCode);
     break;
   case PC_TO_RDR_XFRBLOCK:
-    PC_to_RDR_XfrBlock();
-    // asynchronous // RDR_to_PC_DataBlock(errorCode);
+    errorCode = PC_to_RDR_XfrBlock();
+    // asynchronous, once the APDU is processed, unless refused
+    if (errorCode != SLOT_NO_ERROR) {
+      RDR_to_PC_DataBlock(errorCode);
+    }
     break;
   case PC_TO_RDR_GETPARAMETERS:
     errorCode = PC_to_RDR_GetParameters();
@@ -580,8 +638,12 @@ uint8_t SC_XferBlock (uint8_t* ptrBlock, uint32_t blockLen) {
     return SLOTERROR_BAD_LENTGH;
   }
   
-  // copy received apdu // if G_io_ccid_data_buffer is the buffer apdu, then the memmove will do nothing
-  memmove(G_io_apdu_buffer, ptrBlock, blockLen);
+  // copy received apdu, unless received in place (G_io_ccid_data_buffer being the apdu buffer)
+  if (ptrBlock != G_io_apdu_buffer) {
+    memmove(G_io_apdu_buffer, ptrBlock, blockLen);
+  }
+  // the response is sent once the APDU is processed, other commands being answered meanwhile
+  G_io_ccid.ApduSeq = G_io_ccid.bulk_header.bulkout.bSeq;
   G_io_app.apdu_length = blockLen;
   G_io_app.apdu_media = IO_APDU_MEDIA_USB_CCID;  // for application code
   G_io_app.apdu_state = APDU_USB_CCID; // for next call to io_exchange
@@ -589,29 +651,86 @@ uint8_t SC_XferBlock (uint8_t* ptrBlock, uint32_t blockLen) {
   return SLOT_NO_ERROR;
 }
 
-void io_usb_ccid_reply(unsigned char* buffer, unsigned short length) {
-  // avoid memory overflow
-  if (length > IO_CCID_DATA_BUFFER_SIZE) {
-    THROW(SWO_IOL_OFW_05);
+#ifdef HAVE_CCID_EXTENDED_APDU
+/**
+  * @brief  CCID_Prepare_ResponseBlock
+  *         Forge the RDR_to_PC_DataBlock of the next block of the response, the
+  *         blocks being chained when the response doesn't fit in one
+  * @param  None
+  * @retval None
+  */
+static void CCID_Prepare_ResponseBlock(void) {
+  uint16_t offset = G_io_ccid.ResponseNext;
+  uint16_t length = MIN(G_io_ccid.ResponseLength - offset, CCID_MAX_BLOCK_SIZE);
+  uint8_t  chain;
+
+  if (offset + length == G_io_ccid.ResponseLength) {
+    chain = (offset == 0) ? CCID_CHAIN_BEGIN_END : CCID_CHAIN_CONTINUE_END;
+  }
+  else {
+    chain = (offset == 0) ? CCID_CHAIN_BEGIN_CONTINUE : CCID_CHAIN_CONTINUE;
   }
-  // copy the responde apdu
-  memmove(G_io_ccid_data_buffer, buffer, length);
+  G_io_ccid.ResponseOffset = offset;
+  G_io_ccid.ResponseNext = offset + length;
+
   G_io_ccid.bulk_header.bulkin.dwLength = length;
-  // forge reply
   RDR_to_PC_DataBlock(SLOT_NO_ERROR);
-
-  // start sending rpely
-  CCID_Send_Reply(&USBD_Device);
+  G_io_ccid.bulk_header.bulkin.bSpecific = chain;
 }
 
-void io_usb_ccid_reply_bare(unsigned short length) {
+/**
+  * @brief  CCID_Prepare_NextBlock
+  *         Forge the next block of a chained response, requested by the host.
+  *         Refused when no response is pending, as while an APDU is processed.
+  *         The APDU is completed once the last block is sent
+  * @param  None
+  * @retval uint8_t status of the command execution
+  */
+uint8_t CCID_Prepare_NextBlock(void) {
+  if (G_io_ccid.ResponseNext >= G_io_ccid.ResponseLength) {
+    return SLOTERROR_BAD_LEVELPARAMETER;
+  }
+  G_io_ccid.ApduResponse = 1;
+  CCID_Prepare_ResponseBlock();
+  return SLOT_NO_ERROR;
+}
+#endif // HAVE_CCID_EXTENDED_APDU
+
+// send the response of the apdu, from G_io_ccid_data_buffer
+static void CCID_Send_Response(unsigned short length) {
+  G_io_ccid.ApduResponse = 1;
+  G_io_ccid.bulk_header.bulkin.bSeq = G_io_ccid.ApduSeq;
+  G_io_ccid.bulk_header.bulkin.bStatus = BM_COMMAND_STATUS_NO_ERROR | BM_ICC_PRESENT_ACTIVE;
+#ifdef HAVE_CCID_EXTENDED_APDU
+  G_io_ccid.ResponseLength = length;
+  G_io_ccid.ResponseNext = 0;
+  CCID_Prepare_ResponseBlock();
+#else // HAVE_CCID_EXTENDED_APDU
   G_io_ccid.bulk_header.bulkin.dwLength = length;
   // forge reply
   RDR_to_PC_DataBlock(SLOT_NO_ERROR);
+#endif // HAVE_CCID_EXTENDED_APDU
+
   // start sending rpely
   CCID_Send_Reply(&USBD_Device);
 }
 
+void io_usb_ccid_reply(unsigned char* buffer, unsigned short length) {
+  // avoid memory overflow
+  if (length > IO_CCID_DATA_BUFFER_SIZE) {
+    THROW(SWO_IOL_OFW_05);
+  }
+  // copy the responde apdu, unless already in place
+  if (buffer != G_io_ccid_data_buffer) {
+    memmove(G_io_ccid_data_buffer, buffer, length);
+  }
+  CCID_Send_Response(length);
+}
+
+void io_usb_ccid_reply_bare(unsigned short length) {
+  CCID_Send_Response(length);
+}
+
 // ask for power on
 void io_usb_ccid_set_card_inserted(unsigned int inserted) {
   G_io_ccid.ccid_card_inserted = inserted;
@@ -29,7 +29,15 @@
 #define EXTENDED_APDU_EXCHANGE 0x04
 #define CHARACTER_EXCHANGE     0x00
 
+#ifdef HAVE_CCID_EXTENDED_APDU
+// APDUs longer than a block are chained, see wLevelParameter and bChainParameter
+#define EXCHANGE_LEVEL_FEATURE EXTENDED_APDU_EXCHANGE
+#else  // HAVE_CCID_EXTENDED_APDU
 #define EXCHANGE_LEVEL_FEATURE SHORT_APDU_EXCHANGE
+#endif  // HAVE_CCID_EXTENDED_APDU
+
+// Maximum size of the data of a message, dwMaxCCIDMessageLength being 10 more
+#define CCID_MAX_BLOCK_SIZE 261
 
 #define CCID_INTF            2
 #define CCID_BULK_IN_EP      0x83
@@ -532,8 +532,7 @@ static __ALIGN_BEGIN uint8_t const USBD_CfgDesc[] __ALIGN_END =
   0x00,0x00,0x00,0x00,   /* dwSynchProtocols  */
   0x00,0x00,0x00,0x00,   /* dwMechanical: no special characteristics */
   
-  0xBA, 0x06, 0x02, 0x00,
-  //0x38,0x00,EXCHANGE_LEVEL_FEATURE,0x00,   
+  0xBA, 0x06, EXCHANGE_LEVEL_FEATURE, 0x00,
                          /* dwFeatures: clk, baud rate, voltage : automatic */
                          /* 00000008h Automatic ICC voltage selection 
                          00000010h Automatic ICC clock frequency change
@@ -548,8 +547,8 @@ static __ALIGN_BEGIN uint8_t const USBD_CfgDesc[] __ALIGN_END =
                          00020000h Short APDU level exchange with CCID
                          00040000h Short and Extended APDU level exchange 
                          If none of those values : character level of exchange*/
-  0x0F,0x01,0x00,0x00,  /* dwMaxCCIDMessageLength: Maximum block size + header*/
-                        /* 261 + 10   */
+  ARRAY_U2LE(CCID_MAX_BLOCK_SIZE+10),0x00,0x00,
+                        /* dwMaxCCIDMessageLength: Maximum block size + header*/
 
   0x00,     /* bClassGetResponse*/
   0x00,     /* bClassEnvelope */
@@ -1013,6 +1012,23 @@ uint8_t USBD_HID_DataIn_impl(USBD_HandleTypeDef *pdev, uint8_t epnum)
     return USBD_OK;
 }
 
+#ifdef HAVE_IO_PIPELINE
+/**
+ * Prepare receiving the next chunk of the next command, unless it has been completely received:
+ * the endpoint is then left unarmed, the host being NAKed until io_exchange takes the command.
+ * A chunk received on the other interface meanwhile is dropped, the HID transport state being
+ * shared by both.
+ */
+static void io_usb_pipeline_prepare_receive(USBD_HandleTypeDef *pdev, uint8_t ep, uint16_t size)
+{
+    if ((G_io_app.pipeline_length != 0) && (G_io_app.pipeline_paused_ep == 0)) {
+        G_io_app.pipeline_paused_ep = ep;
+        return;
+    }
+    USBD_LL_PrepareReceive(pdev, ep, size);
+}
+#endif  // HAVE_IO_PIPELINE
+
 uint8_t USBD_HID_DataOut_impl(USBD_HandleTypeDef *pdev,
                               uint8_t             epnum,
 #ifndef HAVE_USB_HIDKBD
@@ -1028,6 +1044,17 @@ uint8_t USBD_HID_DataOut_impl(USBD_HandleTypeDef *pdev,
     switch (epnum) {
         // HID gen endpoint
         case (HID_EPOUT_ADDR & 0x7F):
+#if defined(HAVE_IO_PIPELINE) && !defined(HAVE_USB_HIDKBD)
+            // the next command is received while the current one is processed
+            if (G_io_app.pipeline) {
+                io_usb_hid_receive_next(io_usb_send_apdu_data,
+                                        buffer,
+                                        io_seproxyhal_get_ep_rx_size(HID_EPOUT_ADDR),
+                                        IO_APDU_MEDIA_USB_HID);
+                io_usb_pipeline_prepare_receive(pdev, HID_EPOUT_ADDR, HID_EPOUT_SIZE);
+                break;
+            }
+#endif  // HAVE_IO_PIPELINE && !HAVE_USB_HIDKBD
             // prepare receiving the next chunk (masked time)
             USBD_LL_PrepareReceive(pdev, HID_EPOUT_ADDR, HID_EPOUT_SIZE);
 
@@ -1109,6 +1136,17 @@ uint8_t USBD_WEBUSB_DataOut(USBD_HandleTypeDef *pdev,
     switch (epnum) {
         // HID gen endpoint
         case (WEBUSB_EPOUT_ADDR & 0x7F):
+#ifdef HAVE_IO_PIPELINE
+            // the next command is received while the current one is processed
+            if (G_io_app.pipeline) {
+                io_usb_hid_receive_next(io_usb_send_apdu_data_ep0x83,
+                                        buffer,
+                                        io_seproxyhal_get_ep_rx_size(WEBUSB_EPOUT_ADDR),
+                                        IO_APDU_MEDIA_USB_WEBUSB);
+                io_usb_pipeline_prepare_receive(pdev, WEBUSB_EPOUT_ADDR, WEBUSB_EPOUT_SIZE);
+                break;
+            }
+#endif  // HAVE_IO_PIPELINE
             // prepare receiving the next chunk (masked time)
             USBD_LL_PrepareReceive(pdev, WEBUSB_EPOUT_ADDR, WEBUSB_EPOUT_SIZE);
 
@@ -129,6 +129,17 @@ unsigned int bagl_label_roundtrip_duration_ms_buf(const bagl_element_t *e,
 // default version to be called by ::io_seproxyhal_display if nothing to be done by the application
 void io_seproxyhal_display_default(const bagl_element_t *element);
 
+#ifdef HAVE_DISPLAY_BATCH
+// pack the elements displayed in between in as few SEPROXYHAL statuses as possible
+void io_seproxyhal_display_batch_start(void);
+void io_seproxyhal_display_batch_end(void);
+#define UX_DISPLAY_BATCH_START() io_seproxyhal_display_batch_start()
+#define UX_DISPLAY_BATCH_END()   io_seproxyhal_display_batch_end()
+#else  // HAVE_DISPLAY_BATCH
+#define UX_DISPLAY_BATCH_START()
+#define UX_DISPLAY_BATCH_END()
+#endif  // HAVE_DISPLAY_BATCH
+
 #ifndef UX_STACK_SLOT_COUNT
 #define UX_STACK_SLOT_COUNT 1
 #endif  // UX_STACK_SLOT_COUNT
@@ -393,24 +404,30 @@ extern bolos_ux_params_t G_ux_params;
     }
 #else  // HAVE_SE_SCREEN
 #define UX_DISPLAY_NEXT_ELEMENT()                                                                  \
-    while (G_ux.stack[0].element_arrays[0].element_array                                           \
-           && G_ux.stack[0].element_index < G_ux.stack[0].element_arrays[0].element_array_count    \
-           && !io_seproxyhal_spi_is_status_sent()                                                  \
-           && (os_perso_isonboarded() != BOLOS_UX_OK                                               \
-               || os_global_pin_is_validated() == BOLOS_UX_OK)) {                                  \
-        const bagl_element_t *element                                                              \
-            = &G_ux.stack[0].element_arrays[0].element_array[G_ux.stack[0].element_index];         \
-        if (!G_ux.stack[0].screen_before_element_display_callback                                  \
-            || (element = G_ux.stack[0].screen_before_element_display_callback(element))) {        \
-            if ((unsigned int) element                                                             \
-                == 1) { /*backward compat with coding to avoid smashing everything*/               \
-                element                                                                            \
-                    = &G_ux.stack[0].element_arrays[0].element_array[G_ux.stack[0].element_index]; \
+    do {                                                                                           \
+        UX_DISPLAY_BATCH_START();                                                                  \
+        while (G_ux.stack[0].element_arrays[0].element_array                                       \
+               && G_ux.stack[0].element_index                                                  \
+                      < G_ux.stack[0].element_arrays[0].element_array_count                        \
+               && !io_seproxyhal_spi_is_status_sent()                                              \
+               && (os_perso_isonboarded() != BOLOS_UX_OK                                           \
+                   || os_global_pin_is_validated() == BOLOS_UX_OK)) {                              \
+            const bagl_element_t *element                                                          \
+                = &G_ux.stack[0].element_arrays[0].element_array[G_ux.stack[0].element_index];     \
+            if (!G_ux.stack[0].screen_before_element_display_callback                              \
+                || (element = G_ux.stack[0].screen_before_element_display_callback(element))) {    \
+                if ((uintptr_t) element                                                            \
+                    == 1) { /*backward compat with coding to avoid smashing everything*/           \
+                    element = &G_ux.stack[0]                                                       \
+                                   .element_arrays[0]                                              \
+                                   .element_array[G_ux.stack[0].element_index];                    \
+                }                                                                                  \
+                io_seproxyhal_display(element);                                                    \
             }                                                                                      \
-            io_seproxyhal_display(element);                                                        \
+            G_ux.stack[0].element_index++;                                                         \
         }                                                                                          \
-        G_ux.stack[0].element_index++;                                                             \
-    }
+        UX_DISPLAY_BATCH_END();                                                                    \
+    } while (0)
 #endif  // HAVE_SE_SCREEN
 
 #ifdef HAVE_BLE
@@ -310,6 +310,7 @@ void ux_stack_al_display_next_element(unsigned int stack_slot)
 {
     unsigned int status = os_sched_last_status(TASK_BOLOS_UX);
     if (status != BOLOS_UX_IGNORE && status != BOLOS_UX_CONTINUE) {
+        UX_DISPLAY_BATCH_START();
         while (G_ux.stack[stack_slot].element_arrays[0].element_array
                && G_ux.stack[stack_slot].element_index
                       < G_ux.stack[stack_slot].element_arrays[0].element_array_count
@@ -333,6 +334,7 @@ void ux_stack_al_display_next_element(unsigned int stack_slot)
             }
             G_ux.stack[stack_slot].element_index++;
         }
+        UX_DISPLAY_BATCH_END();
     }
 }
 #endif  // UX_STACK_SLOT_ARRAY_COUNT == 1
@@ -0,0 +1,90 @@
+
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include <stdint.h>  // uint*_t
+#include <string.h>  // memcpy, explicit_bzero
+
+#include "cx.h"
+
+#ifdef HAVE_AES
+
+cx_err_t cx_aes_ctr_init(cx_aes_ctr_t       *ctx,
+                         const cx_aes_key_t *key,
+                         const uint8_t       iv[static CX_AES_BLOCK_SIZE])
+{
+    if ((ctx == NULL) || (key == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+    ctx->key = key;
+    memcpy(ctx->counter, iv, CX_AES_BLOCK_SIZE);
+    // No key stream block yet
+    ctx->offset      = CX_AES_BLOCK_SIZE;
+    ctx->counter_len = CX_AES_BLOCK_SIZE;
+    return CX_OK;
+}
+
+static void aes_ctr_increment(cx_aes_ctr_t *ctx)
+{
+    for (size_t i = CX_AES_BLOCK_SIZE; i > CX_AES_BLOCK_SIZE - ctx->counter_len; i--) {
+        if (++ctx->counter[i - 1] != 0) {
+            break;
+        }
+    }
+}
+
+cx_err_t cx_aes_ctr_update(cx_aes_ctr_t *ctx, const uint8_t *in, uint8_t *out, size_t len)
+{
+    cx_err_t error = CX_OK;
+
+    if ((ctx == NULL) || (ctx->key == NULL) || ((len != 0) && ((in == NULL) || (out == NULL)))) {
+        return CX_INVALID_PARAMETER;
+    }
+
+    // Remaining bytes of the current key stream block
+    while ((len > 0) && (ctx->offset < CX_AES_BLOCK_SIZE)) {
+        *out++ = *in++ ^ ctx->stream[ctx->offset++];
+        len--;
+    }
+    if (len == 0) {
+        return CX_OK;
+    }
+
+    // The key is loaded once, then the blocks are chained
+    CX_CHECK(cx_aes_set_key_hw(ctx->key, CX_ENCRYPT));
+    while (len >= CX_AES_BLOCK_SIZE) {
+        CX_CHECK(cx_aes_block_hw(ctx->counter, ctx->stream));
+        aes_ctr_increment(ctx);
+        for (size_t i = 0; i < CX_AES_BLOCK_SIZE; i++) {
+            out[i] = in[i] ^ ctx->stream[i];
+        }
+        in += CX_AES_BLOCK_SIZE;
+        out += CX_AES_BLOCK_SIZE;
+        len -= CX_AES_BLOCK_SIZE;
+    }
+    if (len > 0) {
+        CX_CHECK(cx_aes_block_hw(ctx->counter, ctx->stream));
+        aes_ctr_increment(ctx);
+        for (ctx->offset = 0; ctx->offset < len; ctx->offset++) {
+            out[ctx->offset] = in[ctx->offset] ^ ctx->stream[ctx->offset];
+        }
+    }
+
+end:
+    cx_aes_reset_hw();
+    return error;
+}
+
+#endif  // HAVE_AES
@@ -0,0 +1,302 @@
+
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include <stdint.h>  // uint*_t
+#include <string.h>  // memset, memcpy, explicit_bzero
+
+#include "cx.h"
+
+#ifdef HAVE_AES
+
+#define GCM_IV_LEN      12
+#define GCM_TAG_MIN_LEN 4
+
+// Reduction of the 4 bits shifted out, by the GCM polynomial
+static const uint16_t gcm_last4[16] = {0x0000,
+                                       0x1c20,
+                                       0x3840,
+                                       0x2460,
+                                       0x7080,
+                                       0x6ca0,
+                                       0x48c0,
+                                       0x54e0,
+                                       0xe100,
+                                       0xfd20,
+                                       0xd940,
+                                       0xc560,
+                                       0x9180,
+                                       0x8da0,
+                                       0xa9c0,
+                                       0xb5e0};
+
+static uint64_t gcm_get_u64_be(const uint8_t *p)
+{
+    uint64_t v = 0;
+
+    for (size_t i = 0; i < 8; i++) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+static void gcm_put_u64_be(uint8_t *p, uint64_t v)
+{
+    for (size_t i = 8; i > 0; i--) {
+        p[i - 1] = v & 0xff;
+        v >>= 8;
+    }
+}
+
+/**
+ * Precomputes the multiples of the hash key H by the 4-bit
+ * polynomials, in the bit-reflected GCM representation.
+ */
+static void gcm_gen_table(cx_aes_gcm_t *ctx, const uint8_t H[static CX_AES_BLOCK_SIZE])
+{
+    uint64_t vh = gcm_get_u64_be(H);
+    uint64_t vl = gcm_get_u64_be(H + 8);
+    uint32_t T;
+
+    ctx->HH[0] = 0;
+    ctx->HL[0] = 0;
+    ctx->HH[8] = vh;
+    ctx->HL[8] = vl;
+    for (size_t i = 4; i > 0; i >>= 1) {
+        T          = (vl & 1) * 0xe1000000U;
+        vl         = (vh << 63) | (vl >> 1);
+        vh         = (vh >> 1) ^ ((uint64_t) T << 32);
+        ctx->HH[i] = vh;
+        ctx->HL[i] = vl;
+    }
+    for (size_t i = 2; i <= 8; i *= 2) {
+        for (size_t j = 1; j < i; j++) {
+            ctx->HH[i + j] = ctx->HH[i] ^ ctx->HH[j];
+            ctx->HL[i + j] = ctx->HL[i] ^ ctx->HL[j];
+        }
+    }
+}
+
+/**
+ * Multiplies the GHASH accumulator by H, 4 bits at a time.
+ */
+static void gcm_mult(cx_aes_gcm_t *ctx)
+{
+    uint8_t *x = ctx->ghash;
+    uint64_t zh, zl;
+    uint8_t  lo, hi, rem;
+
+    lo = x[15] & 0xf;
+    zh = ctx->HH[lo];
+    zl = ctx->HL[lo];
+    for (size_t i = CX_AES_BLOCK_SIZE; i > 0; i--) {
+        lo = x[i - 1] & 0xf;
+        hi = x[i - 1] >> 4;
+        if (i != CX_AES_BLOCK_SIZE) {
+            rem = zl & 0xf;
+            zl  = (zh << 60) | (zl >> 4);
+            zh  = (zh >> 4) ^ ((uint64_t) gcm_last4[rem] << 48);
+            zh ^= ctx->HH[lo];
+            zl ^= ctx->HL[lo];
+        }
+        rem = zl & 0xf;
+        zl  = (zh << 60) | (zl >> 4);
+        zh  = (zh >> 4) ^ ((uint64_t) gcm_last4[rem] << 48);
+        zh ^= ctx->HH[hi];
+        zl ^= ctx->HL[hi];
+    }
+    gcm_put_u64_be(x, zh);
+    gcm_put_u64_be(x + 8, zl);
+}
+
+static void gcm_ghash_update(cx_aes_gcm_t *ctx, const uint8_t *data, size_t len)
+{
+    while (len > 0) {
+        ctx->ghash[ctx->ghash_offset++] ^= *data++;
+        len--;
+        if (ctx->ghash_offset == CX_AES_BLOCK_SIZE) {
+            gcm_mult(ctx);
+            ctx->ghash_offset = 0;
+        }
+    }
+}
+
+// Pads the pending block with zeros
+static void gcm_ghash_flush(cx_aes_gcm_t *ctx)
+{
+    if (ctx->ghash_offset != 0) {
+        gcm_mult(ctx);
+        ctx->ghash_offset = 0;
+    }
+}
+
+cx_err_t cx_aes_gcm_init(cx_aes_gcm_t       *ctx,
+                         const cx_aes_key_t *key,
+                         uint32_t            mode,
+                         const uint8_t      *iv,
+                         size_t              iv_len)
+{
+    cx_err_t error;
+    uint8_t  block[CX_AES_BLOCK_SIZE];
+
+    if ((ctx == NULL) || (key == NULL) || (iv == NULL) || (iv_len == 0)
+        || ((mode != CX_ENCRYPT) && (mode != CX_DECRYPT))) {
+        return CX_INVALID_PARAMETER;
+    }
+
+    explicit_bzero(ctx, sizeof(cx_aes_gcm_t));
+    ctx->mode = mode;
+
+    // H = E(K, 0^128)
+    memset(block, 0, sizeof(block));
+    CX_CHECK(cx_aes_set_key_hw(key, CX_ENCRYPT));
+    CX_CHECK(cx_aes_block_hw(block, block));
+    gcm_gen_table(ctx, block);
+
+    // Initial counter block J0
+    if (iv_len == GCM_IV_LEN) {
+        memset(block, 0, sizeof(block));
+        memcpy(block, iv, GCM_IV_LEN);
+        block[CX_AES_BLOCK_SIZE - 1] = 1;
+    }
+    else {
+        gcm_ghash_update(ctx, iv, iv_len);
+        gcm_ghash_flush(ctx);
+        memset(block, 0, sizeof(block));
+        gcm_put_u64_be(block + 8, (uint64_t) iv_len * 8);
+        gcm_ghash_update(ctx, block, sizeof(block));
+        memcpy(block, ctx->ghash, sizeof(block));
+        memset(ctx->ghash, 0, sizeof(ctx->ghash));
+    }
+    CX_CHECK(cx_aes_block_hw(block, ctx->tag_mask));
+
+    // The data is encrypted from J0 + 1, with a 32-bit counter
+    CX_CHECK(cx_aes_ctr_init(&ctx->ctr, key, block));
+    ctx->ctr.counter_len = 4;
+    for (size_t i = CX_AES_BLOCK_SIZE; i > CX_AES_BLOCK_SIZE - 4; i--) {
+        if (++ctx->ctr.counter[i - 1] != 0) {
+            break;
+        }
+    }
+
+end:
+    cx_aes_reset_hw();
+    explicit_bzero(block, sizeof(block));
+    if (error != CX_OK) {
+        explicit_bzero(ctx, sizeof(cx_aes_gcm_t));
+    }
+    return error;
+}
+
+cx_err_t cx_aes_gcm_update_aad(cx_aes_gcm_t *ctx, const uint8_t *aad, size_t len)
+{
+    if ((ctx == NULL) || (ctx->ctr.key == NULL) || (ctx->data_len != 0)
+        || ((len != 0) && (aad == NULL))) {
+        return CX_INVALID_PARAMETER;
+    }
+    gcm_ghash_update(ctx, aad, len);
+    ctx->aad_len += len;
+    return CX_OK;
+}
+
+cx_err_t cx_aes_gcm_update(cx_aes_gcm_t *ctx, const uint8_t *in, uint8_t *out, size_t len)
+{
+    cx_err_t error;
+
+    if ((ctx == NULL) || (ctx->ctr.key == NULL)
+        || ((len != 0) && ((in == NULL) || (out == NULL)))) {
+        return CX_INVALID_PARAMETER;
+    }
+    if (len == 0) {
+        return CX_OK;
+    }
+    if (ctx->data_len == 0) {
+        gcm_ghash_flush(ctx);
+    }
+
+    // GHASH is computed over the ciphertext
+    if (ctx->mode == CX_DECRYPT) {
+        gcm_ghash_update(ctx, in, len);
+    }
+    CX_CHECK(cx_aes_ctr_update(&ctx->ctr, in, out, len));
+    if (ctx->mode == CX_ENCRYPT) {
+        gcm_ghash_update(ctx, out, len);
+    }
+    ctx->data_len += len;
+
+end:
+    return error;
+}
+
+static cx_err_t gcm_compute_tag(cx_aes_gcm_t *ctx, uint8_t tag[static CX_AES_BLOCK_SIZE])
+{
+    uint8_t block[CX_AES_BLOCK_SIZE];
+
+    if ((ctx == NULL) || (ctx->ctr.key == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+    gcm_ghash_flush(ctx);
+    gcm_put_u64_be(block, ctx->aad_len * 8);
+    gcm_put_u64_be(block + 8, ctx->data_len * 8);
+    gcm_ghash_update(ctx, block, sizeof(block));
+    for (size_t i = 0; i < CX_AES_BLOCK_SIZE; i++) {
+        tag[i] = ctx->ghash[i] ^ ctx->tag_mask[i];
+    }
+    return CX_OK;
+}
+
+cx_err_t cx_aes_gcm_finish(cx_aes_gcm_t *ctx, uint8_t *tag, size_t tag_len)
+{
+    cx_err_t error;
+    uint8_t  computed[CX_AES_BLOCK_SIZE];
+
+    if ((tag == NULL) || (tag_len < GCM_TAG_MIN_LEN) || (tag_len > CX_AES_BLOCK_SIZE)) {
+        return CX_INVALID_PARAMETER;
+    }
+    CX_CHECK(gcm_compute_tag(ctx, computed));
+    memcpy(tag, computed, tag_len);
+
+end:
+    if (ctx != NULL) {
+        explicit_bzero(ctx, sizeof(cx_aes_gcm_t));
+    }
+    return error;
+}
+
+cx_err_t cx_aes_gcm_check_tag(cx_aes_gcm_t *ctx, const uint8_t *tag, size_t tag_len)
+{
+    cx_err_t error;
+    uint8_t  computed[CX_AES_BLOCK_SIZE];
+    uint8_t  diff = 0;
+
+    if ((tag == NULL) || (tag_len < GCM_TAG_MIN_LEN) || (tag_len > CX_AES_BLOCK_SIZE)) {
+        return CX_INVALID_PARAMETER;
+    }
+    CX_CHECK(gcm_compute_tag(ctx, computed));
+    for (size_t i = 0; i < tag_len; i++) {
+        diff |= computed[i] ^ tag[i];
+    }
+    if (diff != 0) {
+        error = CX_INVALID_PARAMETER_VALUE;
+    }
+
+end:
+    if (ctx != NULL) {
+        explicit_bzero(ctx, sizeof(cx_aes_gcm_t));
+    }
+    return error;
+}
+
+#endif  // HAVE_AES
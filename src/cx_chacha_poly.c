@@ -0,0 +1,494 @@
+
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include <stdint.h>   // uint*_t
+#include <string.h>   // memset, memcpy, explicit_bzero
+#include <stdbool.h>  // bool
+
+#include "cx.h"
+#include "os_math.h"
+
+#ifdef HAVE_CHACHA_POLY
+
+#define U8TO32_LE(p)                                                            \
+    (((uint32_t) (p)[0]) | ((uint32_t) (p)[1] << 8) | ((uint32_t) (p)[2] << 16) \
+     | ((uint32_t) (p)[3] << 24))
+
+#define U32TO8_LE(p, v)                 \
+    do {                                \
+        (p)[0] = (uint8_t) ((v));       \
+        (p)[1] = (uint8_t) ((v) >> 8);  \
+        (p)[2] = (uint8_t) ((v) >> 16); \
+        (p)[3] = (uint8_t) ((v) >> 24); \
+    } while (0)
+
+#define ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+
+#define CHACHA20_QUARTER_ROUND(a, b, c, d) \
+    do {                                   \
+        a += b;                            \
+        d = ROTL32(d ^ a, 16);             \
+        c += d;                            \
+        b = ROTL32(b ^ c, 12);             \
+        a += b;                            \
+        d = ROTL32(d ^ a, 8);              \
+        c += d;                            \
+        b = ROTL32(b ^ c, 7);              \
+    } while (0)
+
+#define POLY1305_MASK26 0x3ffffff
+
+/* ======================================================================= */
+/*                                 CHACHA20                                */
+/* ======================================================================= */
+
+cx_err_t cx_chacha20_init(cx_chacha20_t *ctx,
+                          const uint8_t  key[static CX_CHACHA20_KEY_SIZE],
+                          const uint8_t  nonce[static CX_CHACHA20_NONCE_SIZE],
+                          uint32_t       counter)
+{
+    if (ctx == NULL) {
+        return CX_INVALID_PARAMETER;
+    }
+
+    // "expand 32-byte k"
+    ctx->state[0] = 0x61707865;
+    ctx->state[1] = 0x3320646e;
+    ctx->state[2] = 0x79622d32;
+    ctx->state[3] = 0x6b206574;
+    for (size_t i = 0; i < 8; i++) {
+        ctx->state[4 + i] = U8TO32_LE(key + 4 * i);
+    }
+    ctx->state[12] = counter;
+    for (size_t i = 0; i < 3; i++) {
+        ctx->state[13 + i] = U8TO32_LE(nonce + 4 * i);
+    }
+    ctx->offset = CX_CHACHA20_BLOCK_SIZE;
+    return CX_OK;
+}
+
+static void chacha20_block(cx_chacha20_t *ctx)
+{
+    uint32_t x[16];
+
+    memcpy(x, ctx->state, sizeof(x));
+    for (size_t i = 0; i < 10; i++) {
+        // Column round
+        CHACHA20_QUARTER_ROUND(x[0], x[4], x[8], x[12]);
+        CHACHA20_QUARTER_ROUND(x[1], x[5], x[9], x[13]);
+        CHACHA20_QUARTER_ROUND(x[2], x[6], x[10], x[14]);
+        CHACHA20_QUARTER_ROUND(x[3], x[7], x[11], x[15]);
+        // Diagonal round
+        CHACHA20_QUARTER_ROUND(x[0], x[5], x[10], x[15]);
+        CHACHA20_QUARTER_ROUND(x[1], x[6], x[11], x[12]);
+        CHACHA20_QUARTER_ROUND(x[2], x[7], x[8], x[13]);
+        CHACHA20_QUARTER_ROUND(x[3], x[4], x[9], x[14]);
+    }
+    for (size_t i = 0; i < 16; i++) {
+        x[i] += ctx->state[i];
+        U32TO8_LE(ctx->keystream + 4 * i, x[i]);
+    }
+    ctx->state[12]++;
+    ctx->offset = 0;
+    explicit_bzero(x, sizeof(x));
+}
+
+cx_err_t cx_chacha20_update(cx_chacha20_t *ctx, const uint8_t *in, uint8_t *out, size_t len)
+{
+    if ((ctx == NULL) || ((len != 0) && ((in == NULL) || (out == NULL)))) {
+        return CX_INVALID_PARAMETER;
+    }
+
+    while (len > 0) {
+        if (ctx->offset == CX_CHACHA20_BLOCK_SIZE) {
+            chacha20_block(ctx);
+        }
+        *out++ = *in++ ^ ctx->keystream[ctx->offset++];
+        len--;
+    }
+    return CX_OK;
+}
+
+/* ======================================================================= */
+/*                                 POLY1305                                */
+/* ======================================================================= */
+
+cx_err_t cx_poly1305_init(cx_poly1305_t *ctx, const uint8_t key[static CX_POLY1305_KEY_SIZE])
+{
+    if (ctx == NULL) {
+        return CX_INVALID_PARAMETER;
+    }
+
+    // r &= 0xffffffc0ffffffc0ffffffc0fffffff
+    ctx->r[0] = (U8TO32_LE(key + 0)) & 0x3ffffff;
+    ctx->r[1] = (U8TO32_LE(key + 3) >> 2) & 0x3ffff03;
+    ctx->r[2] = (U8TO32_LE(key + 6) >> 4) & 0x3ffc0ff;
+    ctx->r[3] = (U8TO32_LE(key + 9) >> 6) & 0x3f03fff;
+    ctx->r[4] = (U8TO32_LE(key + 12) >> 8) & 0x00fffff;
+    memset(ctx->h, 0, sizeof(ctx->h));
+    for (size_t i = 0; i < 4; i++) {
+        ctx->pad[i] = U8TO32_LE(key + 16 + 4 * i);
+    }
+    ctx->leftover = 0;
+    return CX_OK;
+}
+
+/**
+ * 32x32 -> 64-bit product from 16-bit halves. Cortex-M0 has no UMULL, and
+ * the __aeabi_lmul helper called for a 64-bit product is not guaranteed to
+ * run in constant time, while MULS and the carries below are.
+ */
+static inline uint64_t poly1305_mul(uint32_t a, uint32_t b)
+{
+    uint32_t ll  = (a & 0xFFFF) * (b & 0xFFFF);
+    uint32_t lh  = (a & 0xFFFF) * (b >> 16);
+    uint32_t hl  = (a >> 16) * (b & 0xFFFF);
+    uint32_t hh  = (a >> 16) * (b >> 16);
+    uint32_t mid = (ll >> 16) + (lh & 0xFFFF) + (hl & 0xFFFF);
+
+    return ((uint64_t) (hh + (lh >> 16) + (hl >> 16) + (mid >> 16)) << 32)
+           | (mid << 16) | (ll & 0xFFFF);
+}
+
+/**
+ * Processes full 16-byte blocks: h = (h + m) * r mod 2^130 - 5.
+ * hibit is the 2^128 bit appended to each block, except for the
+ * padded last one.
+ */
+static void poly1305_blocks(cx_poly1305_t *ctx, const uint8_t *m, size_t len, uint32_t hibit)
+{
+    const uint32_t r0 = ctx->r[0], r1 = ctx->r[1], r2 = ctx->r[2], r3 = ctx->r[3], r4 = ctx->r[4];
+    const uint32_t s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+    uint32_t       h0 = ctx->h[0], h1 = ctx->h[1], h2 = ctx->h[2], h3 = ctx->h[3], h4 = ctx->h[4];
+    uint64_t       d0, d1, d2, d3, d4;
+    uint32_t       c;
+
+    while (len >= 16) {
+        h0 += (U8TO32_LE(m + 0)) & POLY1305_MASK26;
+        h1 += (U8TO32_LE(m + 3) >> 2) & POLY1305_MASK26;
+        h2 += (U8TO32_LE(m + 6) >> 4) & POLY1305_MASK26;
+        h3 += (U8TO32_LE(m + 9) >> 6) & POLY1305_MASK26;
+        h4 += (U8TO32_LE(m + 12) >> 8) | hibit;
+
+        d0 = poly1305_mul(h0, r0) + poly1305_mul(h1, s4) + poly1305_mul(h2, s3)
+             + poly1305_mul(h3, s2) + poly1305_mul(h4, s1);
+        d1 = poly1305_mul(h0, r1) + poly1305_mul(h1, r0) + poly1305_mul(h2, s4)
+             + poly1305_mul(h3, s3) + poly1305_mul(h4, s2);
+        d2 = poly1305_mul(h0, r2) + poly1305_mul(h1, r1) + poly1305_mul(h2, r0)
+             + poly1305_mul(h3, s4) + poly1305_mul(h4, s3);
+        d3 = poly1305_mul(h0, r3) + poly1305_mul(h1, r2) + poly1305_mul(h2, r1)
+             + poly1305_mul(h3, r0) + poly1305_mul(h4, s4);
+        d4 = poly1305_mul(h0, r4) + poly1305_mul(h1, r3) + poly1305_mul(h2, r2)
+             + poly1305_mul(h3, r1) + poly1305_mul(h4, r0);
+
+        // Partial carry propagation
+        c  = (uint32_t) (d0 >> 26);
+        h0 = (uint32_t) d0 & POLY1305_MASK26;
+        d1 += c;
+        c  = (uint32_t) (d1 >> 26);
+        h1 = (uint32_t) d1 & POLY1305_MASK26;
+        d2 += c;
+        c  = (uint32_t) (d2 >> 26);
+        h2 = (uint32_t) d2 & POLY1305_MASK26;
+        d3 += c;
+        c  = (uint32_t) (d3 >> 26);
+        h3 = (uint32_t) d3 & POLY1305_MASK26;
+        d4 += c;
+        c  = (uint32_t) (d4 >> 26);
+        h4 = (uint32_t) d4 & POLY1305_MASK26;
+        h0 += c * 5;
+        c  = h0 >> 26;
+        h0 = h0 & POLY1305_MASK26;
+        h1 += c;
+
+        m += 16;
+        len -= 16;
+    }
+
+    ctx->h[0] = h0;
+    ctx->h[1] = h1;
+    ctx->h[2] = h2;
+    ctx->h[3] = h3;
+    ctx->h[4] = h4;
+}
+
+cx_err_t cx_poly1305_update(cx_poly1305_t *ctx, const uint8_t *data, size_t len)
+{
+    size_t want;
+
+    if ((ctx == NULL) || ((len != 0) && (data == NULL))) {
+        return CX_INVALID_PARAMETER;
+    }
+
+    if (ctx->leftover != 0) {
+        want = MIN(sizeof(ctx->buffer) - ctx->leftover, len);
+        memcpy(ctx->buffer + ctx->leftover, data, want);
+        ctx->leftover += want;
+        data += want;
+        len -= want;
+        if (ctx->leftover < sizeof(ctx->buffer)) {
+            return CX_OK;
+        }
+        poly1305_blocks(ctx, ctx->buffer, sizeof(ctx->buffer), 1 << 24);
+        ctx->leftover = 0;
+    }
+    if (len >= 16) {
+        want = len & ~(size_t) 15;
+        poly1305_blocks(ctx, data, want, 1 << 24);
+        data += want;
+        len -= want;
+    }
+    if (len != 0) {
+        memcpy(ctx->buffer, data, len);
+        ctx->leftover = len;
+    }
+    return CX_OK;
+}
+
+cx_err_t cx_poly1305_final(cx_poly1305_t *ctx, uint8_t tag[static CX_POLY1305_TAG_SIZE])
+{
+    uint32_t h0, h1, h2, h3, h4, c;
+    uint32_t g0, g1, g2, g3, g4;
+    uint32_t mask;
+    uint64_t f;
+
+    if (ctx == NULL) {
+        return CX_INVALID_PARAMETER;
+    }
+
+    // Last block, padded with 1 then zeros
+    if (ctx->leftover != 0) {
+        ctx->buffer[ctx->leftover] = 1;
+        memset(ctx->buffer + ctx->leftover + 1, 0, sizeof(ctx->buffer) - ctx->leftover - 1);
+        poly1305_blocks(ctx, ctx->buffer, sizeof(ctx->buffer), 0);
+    }
+
+    // Full carry propagation
+    h0 = ctx->h[0];
+    h1 = ctx->h[1];
+    h2 = ctx->h[2];
+    h3 = ctx->h[3];
+    h4 = ctx->h[4];
+    c  = h1 >> 26;
+    h1 &= POLY1305_MASK26;
+    h2 += c;
+    c = h2 >> 26;
+    h2 &= POLY1305_MASK26;
+    h3 += c;
+    c = h3 >> 26;
+    h3 &= POLY1305_MASK26;
+    h4 += c;
+    c = h4 >> 26;
+    h4 &= POLY1305_MASK26;
+    h0 += c * 5;
+    c = h0 >> 26;
+    h0 &= POLY1305_MASK26;
+    h1 += c;
+
+    // g = h + -p = h - (2^130 - 5)
+    g0 = h0 + 5;
+    c  = g0 >> 26;
+    g0 &= POLY1305_MASK26;
+    g1 = h1 + c;
+    c  = g1 >> 26;
+    g1 &= POLY1305_MASK26;
+    g2 = h2 + c;
+    c  = g2 >> 26;
+    g2 &= POLY1305_MASK26;
+    g3 = h3 + c;
+    c  = g3 >> 26;
+    g3 &= POLY1305_MASK26;
+    g4 = h4 + c - (1UL << 26);
+
+    // Selects h if h < p, g otherwise, without branching
+    mask = (g4 >> 31) - 1;
+    g0 &= mask;
+    g1 &= mask;
+    g2 &= mask;
+    g3 &= mask;
+    g4 &= mask;
+    mask = ~mask;
+    h0   = (h0 & mask) | g0;
+    h1   = (h1 & mask) | g1;
+    h2   = (h2 & mask) | g2;
+    h3   = (h3 & mask) | g3;
+    h4   = (h4 & mask) | g4;
+
+    // h = h mod 2^128, as 32-bit words
+    h0 = h0 | (h1 << 26);
+    h1 = (h1 >> 6) | (h2 << 20);
+    h2 = (h2 >> 12) | (h3 << 14);
+    h3 = (h3 >> 18) | (h4 << 8);
+
+    // tag = h + pad mod 2^128
+    f  = (uint64_t) h0 + ctx->pad[0];
+    h0 = (uint32_t) f;
+    f  = (uint64_t) h1 + ctx->pad[1] + (f >> 32);
+    h1 = (uint32_t) f;
+    f  = (uint64_t) h2 + ctx->pad[2] + (f >> 32);
+    h2 = (uint32_t) f;
+    f  = (uint64_t) h3 + ctx->pad[3] + (f >> 32);
+    h3 = (uint32_t) f;
+
+    U32TO8_LE(tag + 0, h0);
+    U32TO8_LE(tag + 4, h1);
+    U32TO8_LE(tag + 8, h2);
+    U32TO8_LE(tag + 12, h3);
+
+    explicit_bzero(ctx, sizeof(cx_poly1305_t));
+    return CX_OK;
+}
+
+/* ======================================================================= */
+/*                            CHACHA20-POLY1305                            */
+/* ======================================================================= */
+
+static const uint8_t chachapoly_zeros[16] = {0};
+
+// Pads the authenticated data to a multiple of 16 bytes
+static cx_err_t chachapoly_pad16(cx_chachapoly_t *ctx, uint64_t len)
+{
+    if ((len % 16) == 0) {
+        return CX_OK;
+    }
+    return cx_poly1305_update(&ctx->poly, chachapoly_zeros, 16 - (len % 16));
+}
+
+cx_err_t cx_chachapoly_init(cx_chachapoly_t *ctx,
+                            const uint8_t    key[static CX_CHACHA20_KEY_SIZE],
+                            uint32_t         mode,
+                            const uint8_t    nonce[static CX_CHACHA20_NONCE_SIZE])
+{
+    cx_err_t error;
+    uint8_t  poly_key[CX_CHACHA20_BLOCK_SIZE] = {0};
+
+    if ((ctx == NULL) || ((mode != CX_ENCRYPT) && (mode != CX_DECRYPT))) {
+        return CX_INVALID_PARAMETER;
+    }
+
+    explicit_bzero(ctx, sizeof(cx_chachapoly_t));
+    // The one-time Poly1305 key is the first block of key stream
+    CX_CHECK(cx_chacha20_init(&ctx->chacha, key, nonce, 0));
+    CX_CHECK(cx_chacha20_update(&ctx->chacha, poly_key, poly_key, sizeof(poly_key)));
+    CX_CHECK(cx_poly1305_init(&ctx->poly, poly_key));
+    ctx->mode    = mode;
+    ctx->started = true;
+
+end:
+    explicit_bzero(poly_key, sizeof(poly_key));
+    return error;
+}
+
+cx_err_t cx_chachapoly_update_aad(cx_chachapoly_t *ctx, const uint8_t *aad, size_t len)
+{
+    cx_err_t error;
+
+    if ((ctx == NULL) || !ctx->started || (ctx->data_len != 0)) {
+        return CX_INVALID_PARAMETER;
+    }
+    CX_CHECK(cx_poly1305_update(&ctx->poly, aad, len));
+    ctx->aad_len += len;
+
+end:
+    return error;
+}
+
+cx_err_t cx_chachapoly_update(cx_chachapoly_t *ctx, const uint8_t *in, uint8_t *out, size_t len)
+{
+    cx_err_t error;
+
+    if ((ctx == NULL) || !ctx->started || ((len != 0) && ((in == NULL) || (out == NULL)))) {
+        return CX_INVALID_PARAMETER;
+    }
+    if (len == 0) {
+        return CX_OK;
+    }
+    if (ctx->data_len == 0) {
+        CX_CHECK(chachapoly_pad16(ctx, ctx->aad_len));
+    }
+
+    // The tag is computed over the ciphertext
+    if (ctx->mode == CX_DECRYPT) {
+        CX_CHECK(cx_poly1305_update(&ctx->poly, in, len));
+    }
+    CX_CHECK(cx_chacha20_update(&ctx->chacha, in, out, len));
+    if (ctx->mode == CX_ENCRYPT) {
+        CX_CHECK(cx_poly1305_update(&ctx->poly, out, len));
+    }
+    ctx->data_len += len;
+
+end:
+    return error;
+}
+
+static cx_err_t chachapoly_compute_tag(cx_chachapoly_t *ctx,
+                                       uint8_t          tag[static CX_POLY1305_TAG_SIZE])
+{
+    cx_err_t error;
+    uint8_t  lengths[16];
+
+    if ((ctx == NULL) || !ctx->started) {
+        return CX_INVALID_PARAMETER;
+    }
+    if (ctx->data_len == 0) {
+        CX_CHECK(chachapoly_pad16(ctx, ctx->aad_len));
+    }
+    CX_CHECK(chachapoly_pad16(ctx, ctx->data_len));
+    U32TO8_LE(lengths, (uint32_t) ctx->aad_len);
+    U32TO8_LE(lengths + 4, (uint32_t) (ctx->aad_len >> 32));
+    U32TO8_LE(lengths + 8, (uint32_t) ctx->data_len);
+    U32TO8_LE(lengths + 12, (uint32_t) (ctx->data_len >> 32));
+    CX_CHECK(cx_poly1305_update(&ctx->poly, lengths, sizeof(lengths)));
+    CX_CHECK(cx_poly1305_final(&ctx->poly, tag));
+
+end:
+    return error;
+}
+
+cx_err_t cx_chachapoly_finish(cx_chachapoly_t *ctx, uint8_t tag[static CX_POLY1305_TAG_SIZE])
+{
+    cx_err_t error;
+
+    error = chachapoly_compute_tag(ctx, tag);
+    if (ctx != NULL) {
+        explicit_bzero(ctx, sizeof(cx_chachapoly_t));
+    }
+    return error;
+}
+
+cx_err_t cx_chachapoly_check_tag(cx_chachapoly_t *ctx,
+                                 const uint8_t    tag[static CX_POLY1305_TAG_SIZE])
+{
+    cx_err_t error;
+    uint8_t  computed[CX_POLY1305_TAG_SIZE];
+    uint8_t  diff = 0;
+
+    CX_CHECK(chachapoly_compute_tag(ctx, computed));
+    for (size_t i = 0; i < CX_POLY1305_TAG_SIZE; i++) {
+        diff |= computed[i] ^ tag[i];
+    }
+    if (diff != 0) {
+        error = CX_INVALID_PARAMETER_VALUE;
+    }
+
+end:
+    if (ctx != NULL) {
+        explicit_bzero(ctx, sizeof(cx_chachapoly_t));
+    }
+    return error;
+}
+
+#endif  // HAVE_CHACHA_POLY
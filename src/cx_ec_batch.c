@@ -0,0 +1,488 @@
+
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include <stdint.h>   // uint*_t
+#include <string.h>   // memset, explicit_bzero
+#include <stdbool.h>  // bool
+
+#include "cx.h"
+#include "lib_cxng/src/cx_ecfp.h"
+#include "os_math.h"
+#include "cx_ecpoint_internal.h"
+
+#ifdef HAVE_ECC
+
+#define EC_BATCH_DOMAIN_LEN 32
+
+static void ecpoint_swap(cx_ecpoint_t *P, cx_ecpoint_t *Q)
+{
+    cx_ecpoint_t tmp = *P;
+
+    *P = *Q;
+    *Q = tmp;
+}
+
+cx_err_t cx_ecpoint_multi_scalarmul(cx_ecpoint_t       *R,
+                                    const cx_ecpoint_t *P,
+                                    const uint8_t      *k,
+                                    size_t              k_len,
+                                    size_t              n)
+{
+    static const uint8_t two      = 2;
+    cx_err_t             error    = CX_OK;
+    bool                 infinity = true;
+    bool                 is_infinity;
+    cx_ecpoint_t         T;
+    uint8_t              mask;
+
+    if ((R == NULL) || (P == NULL) || (k == NULL) || (k_len == 0) || (n == 0)) {
+        return CX_INVALID_PARAMETER;
+    }
+
+    error = cx_ecpoint_alloc(&T, R->curve);
+    if (error != CX_OK) {
+        return error;
+    }
+
+    for (size_t bit = 0; bit < k_len * 8; bit++) {
+        mask = 0x80 >> (bit % 8);
+
+        // Leading zero bits cost nothing: R stays at infinity
+        if (!infinity) {
+            error = cx_ecpoint_scalarmul(R, &two, 1);
+            if (error == CX_EC_INFINITE_POINT) {
+                infinity = true;
+            }
+            else if (error != CX_OK) {
+                goto end;
+            }
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            if ((k[i * k_len + bit / 8] & mask) == 0) {
+                continue;
+            }
+            if (infinity) {
+                CX_CHECK(ecpoint_copy(R, &P[i]));
+                infinity = false;
+                continue;
+            }
+            error = cx_ecpoint_add(&T, R, &P[i]);
+            if (error == CX_EC_INFINITE_POINT) {
+                // Either R reached infinity at the previous addition,
+                // or R = -P[i] and the sum is the point at infinity
+                CX_CHECK(cx_ecpoint_is_at_infinity(R, &is_infinity));
+                if (is_infinity) {
+                    CX_CHECK(ecpoint_copy(R, &P[i]));
+                }
+                else {
+                    infinity = true;
+                }
+                continue;
+            }
+            if (error != CX_OK) {
+                goto end;
+            }
+            // The sum becomes the accumulator, without copying the coordinates
+            ecpoint_swap(R, &T);
+        }
+    }
+
+    if (!infinity) {
+        CX_CHECK(cx_ecpoint_is_at_infinity(R, &infinity));
+    }
+    error = infinity ? CX_EC_INFINITE_POINT : CX_OK;
+
+end:
+    cx_ecpoint_destroy(&T);
+    return error;
+}
+
+#if defined(HAVE_ECDSA) || defined(HAVE_ECSCHNORR)
+
+/**
+ * Batch verification state. Each signature contributes two points
+ * (R_i and the public key), the generator comes last.
+ */
+typedef struct {
+    cx_bn_t      n;    // curve order
+    cx_bn_t      p;    // field
+    cx_bn_t      acc;  // scalar of the generator
+    cx_bn_t      a;    // random coefficient of the current signature
+    cx_bn_t      t;
+    cx_bn_t      u;
+    cx_bn_t      w;
+    cx_ecpoint_t R;
+    cx_ecpoint_t points[2 * CX_EC_BATCH_MAX_SIZE + 1];
+    uint8_t      scalars[2 * CX_EC_BATCH_MAX_SIZE + 1][EC_BATCH_DOMAIN_LEN];
+} ec_batch_t;
+
+static cx_err_t ec_batch_start(ec_batch_t *batch, cx_curve_t curve, size_t count)
+{
+    cx_err_t error;
+
+    CX_CHECK(cx_bn_alloc(&batch->n, EC_BATCH_DOMAIN_LEN));
+    CX_CHECK(cx_ecdomain_parameter_bn(curve, CX_CURVE_PARAM_Order, batch->n));
+    CX_CHECK(cx_bn_alloc(&batch->p, EC_BATCH_DOMAIN_LEN));
+    CX_CHECK(cx_ecdomain_parameter_bn(curve, CX_CURVE_PARAM_Field, batch->p));
+    CX_CHECK(cx_bn_alloc(&batch->acc, EC_BATCH_DOMAIN_LEN));
+    CX_CHECK(cx_bn_alloc(&batch->a, EC_BATCH_DOMAIN_LEN));
+    CX_CHECK(cx_bn_alloc(&batch->t, EC_BATCH_DOMAIN_LEN));
+    CX_CHECK(cx_bn_alloc(&batch->u, EC_BATCH_DOMAIN_LEN));
+    CX_CHECK(cx_bn_alloc(&batch->w, EC_BATCH_DOMAIN_LEN));
+    CX_CHECK(cx_ecpoint_alloc(&batch->R, curve));
+    for (size_t i = 0; i < 2 * count + 1; i++) {
+        CX_CHECK(cx_ecpoint_alloc(&batch->points[i], curve));
+    }
+    CX_CHECK(cx_ecdomain_generator_bn(curve, &batch->points[2 * count]));
+
+end:
+    return error;
+}
+
+/**
+ * Draws the coefficient of the i-th signature. The first one is 1,
+ * the others are 128-bit random values as recommended by BIP340.
+ */
+static cx_err_t ec_batch_coefficient(ec_batch_t *batch, size_t i, uint8_t *a)
+{
+    memset(a, 0, EC_BATCH_DOMAIN_LEN);
+    if (i == 0) {
+        a[EC_BATCH_DOMAIN_LEN - 1] = 1;
+    }
+    else {
+        cx_rng_no_throw(a + EC_BATCH_DOMAIN_LEN - 16, 16);
+        a[EC_BATCH_DOMAIN_LEN - 1] |= 1;
+    }
+    return cx_bn_init(batch->a, a, EC_BATCH_DOMAIN_LEN);
+}
+
+/**
+ * Loads a 0 < x < n value into bn and checks its range.
+ */
+static cx_err_t ec_batch_load_scalar(const ec_batch_t *batch,
+                                     cx_bn_t           bn,
+                                     const uint8_t    *x,
+                                     size_t            x_len,
+                                     bool              allow_zero,
+                                     bool             *valid)
+{
+    cx_err_t error;
+    int      diff;
+
+    *valid = false;
+    CX_CHECK(cx_bn_init(bn, x, x_len));
+    CX_CHECK(cx_bn_cmp(bn, batch->n, &diff));
+    if (diff >= 0) {
+        goto end;
+    }
+    if (!allow_zero) {
+        CX_CHECK(cx_bn_cmp_u32(bn, 0, &diff));
+        if (diff == 0) {
+            goto end;
+        }
+    }
+    *valid = true;
+
+end:
+    return error;
+}
+
+/**
+ * Lifts an x-coordinate to the point with the given y parity.
+ */
+static cx_err_t ec_batch_lift_x(const ec_batch_t *batch,
+                                cx_ecpoint_t     *P,
+                                const uint8_t    *x,
+                                uint32_t          parity,
+                                bool             *valid)
+{
+    cx_err_t error;
+    int      diff;
+
+    *valid = false;
+    CX_CHECK(cx_bn_init(batch->t, x, EC_BATCH_DOMAIN_LEN));
+    CX_CHECK(cx_bn_cmp(batch->t, batch->p, &diff));
+    if (diff >= 0) {
+        goto end;
+    }
+    error = cx_ecpoint_decompress(P, x, EC_BATCH_DOMAIN_LEN, parity);
+    if (error == CX_NO_RESIDUE) {
+        error = CX_OK;
+        goto end;
+    }
+    CX_CHECK(error);
+    *valid = true;
+
+end:
+    return error;
+}
+
+/**
+ * Runs the multi-scalar multiplication: the batch holds if the
+ * combination of all the signature equations is the point at infinity.
+ */
+static cx_err_t ec_batch_finish(ec_batch_t *batch, size_t count, bool *verified)
+{
+    cx_err_t error;
+
+    CX_CHECK(cx_bn_export(batch->acc, batch->scalars[2 * count], EC_BATCH_DOMAIN_LEN));
+    error = cx_ecpoint_multi_scalarmul(
+        &batch->R, batch->points, batch->scalars[0], EC_BATCH_DOMAIN_LEN, 2 * count + 1);
+    if (error == CX_EC_INFINITE_POINT) {
+        *verified = true;
+        error     = CX_OK;
+    }
+
+end:
+    return error;
+}
+
+#endif  // HAVE_ECDSA || HAVE_ECSCHNORR
+
+#ifdef HAVE_ECDSA
+
+#define EC_BATCH_ECDSA_LIFTABLE(info) \
+    (((info) & (CX_ECDSA_BATCH_PARITY_KNOWN | CX_ECCINFO_xGTn)) == CX_ECDSA_BATCH_PARITY_KNOWN)
+cx_err_t cx_ecdsa_batch_verify_no_throw(const cx_ecdsa_batch_item_t *items,
+                                        size_t                       count,
+                                        bool                        *verified)
+{
+    cx_err_t       error;
+    ec_batch_t     batch;
+    cx_curve_t     curve;
+    size_t         domain_len;
+    size_t         batched = 0;
+    const uint8_t *r, *s;
+    size_t         r_len, s_len;
+    uint8_t        x[EC_BATCH_DOMAIN_LEN];
+    bool           valid;
+
+    if ((items == NULL) || (verified == NULL) || (count == 0) || (count > CX_EC_BATCH_MAX_SIZE)) {
+        return CX_INVALID_PARAMETER;
+    }
+    *verified = false;
+
+    for (size_t i = 0; i < count; i++) {
+        if ((items[i].pukey == NULL) || (items[i].hash == NULL) || (items[i].sig == NULL)) {
+            return CX_INVALID_PARAMETER;
+        }
+    }
+    curve = items[0].pukey->curve;
+    if (!CX_CURVE_RANGE(curve, WEIERSTRASS)) {
+        return CX_EC_INVALID_CURVE;
+    }
+    error = cx_ecdomain_parameters_length(curve, &domain_len);
+    if (error != CX_OK) {
+        return error;
+    }
+    if (domain_len != EC_BATCH_DOMAIN_LEN) {
+        return CX_EC_INVALID_CURVE;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (items[i].pukey->curve != curve) {
+            return CX_INVALID_PARAMETER;
+        }
+    }
+
+    // R cannot be recovered from r without its parity, nor when r = x(R) - n:
+    // such signatures are verified alone, before the batch locks the BN processor
+    for (size_t i = 0; i < count; i++) {
+        const cx_ecdsa_batch_item_t *item = &items[i];
+
+        if (EC_BATCH_ECDSA_LIFTABLE(item->info)) {
+            batched++;
+        }
+        else if (!cx_ecdsa_verify_no_throw(
+                     item->pukey, item->hash, item->hash_len, item->sig, item->sig_len)) {
+            return CX_OK;
+        }
+    }
+    if (batched == 0) {
+        *verified = true;
+        return CX_OK;
+    }
+
+    error = cx_bn_lock(EC_BATCH_DOMAIN_LEN, 0);
+    if (error != CX_OK) {
+        return error;
+    }
+    CX_CHECK(ec_batch_start(&batch, curve, batched));
+    CX_CHECK(cx_bn_set_u32(batch.acc, 0));
+
+    for (size_t i = 0, j = 0; i < count; i++) {
+        const cx_ecdsa_batch_item_t *item = &items[i];
+        const cx_ecfp_public_key_t  *Q    = item->pukey;
+
+        if (!EC_BATCH_ECDSA_LIFTABLE(item->info)) {
+            continue;
+        }
+        if ((Q->W_len != 1 + 2 * EC_BATCH_DOMAIN_LEN) || (Q->W[0] != 0x04)) {
+            goto end;
+        }
+        if (cx_ecfp_decode_sig_der(
+                item->sig, item->sig_len, EC_BATCH_DOMAIN_LEN, &r, &r_len, &s, &s_len)
+            != 1) {
+            goto end;
+        }
+
+        CX_CHECK(ec_batch_coefficient(&batch, j, x));
+        // w = s^-1
+        CX_CHECK(ec_batch_load_scalar(&batch, batch.u, s, s_len, false, &valid));
+        if (!valid) {
+            goto end;
+        }
+        CX_CHECK(cx_bn_mod_invert_nprime(batch.w, batch.u, batch.n));
+
+        // [a.u1]G with u1 = h.w, accumulated for the whole batch
+        CX_CHECK(cx_bn_init(batch.u, item->hash, MIN(item->hash_len, EC_BATCH_DOMAIN_LEN)));
+        CX_CHECK(cx_bn_reduce(batch.t, batch.u, batch.n));
+        CX_CHECK(cx_bn_mod_mul(batch.u, batch.t, batch.w, batch.n));
+        CX_CHECK(cx_bn_mod_mul(batch.t, batch.a, batch.u, batch.n));
+        CX_CHECK(cx_bn_mod_add(batch.u, batch.acc, batch.t, batch.n));
+        CX_CHECK(cx_bn_copy(batch.acc, batch.u));
+
+        // -[a]R
+        CX_CHECK(cx_bn_set_u32(batch.u, 0));
+        CX_CHECK(cx_bn_mod_sub(batch.t, batch.u, batch.a, batch.n));
+        CX_CHECK(cx_bn_export(batch.t, batch.scalars[2 * j], EC_BATCH_DOMAIN_LEN));
+        CX_CHECK(ec_batch_load_scalar(&batch, batch.u, r, r_len, false, &valid));
+        if (!valid) {
+            goto end;
+        }
+        CX_CHECK(cx_bn_export(batch.u, x, EC_BATCH_DOMAIN_LEN));
+        CX_CHECK(ec_batch_lift_x(
+            &batch, &batch.points[2 * j], x, item->info & CX_ECCINFO_PARITY_ODD, &valid));
+        if (!valid) {
+            goto end;
+        }
+
+        // [a.u2]Q with u2 = r.w
+        CX_CHECK(cx_bn_init(batch.u, r, r_len));
+        CX_CHECK(cx_bn_mod_mul(batch.t, batch.u, batch.w, batch.n));
+        CX_CHECK(cx_bn_mod_mul(batch.u, batch.a, batch.t, batch.n));
+        CX_CHECK(cx_bn_export(batch.u, batch.scalars[2 * j + 1], EC_BATCH_DOMAIN_LEN));
+        CX_CHECK(cx_ecpoint_init(&batch.points[2 * j + 1],
+                                 Q->W + 1,
+                                 EC_BATCH_DOMAIN_LEN,
+                                 Q->W + 1 + EC_BATCH_DOMAIN_LEN,
+                                 EC_BATCH_DOMAIN_LEN));
+        CX_CHECK(cx_ecpoint_is_on_curve(&batch.points[2 * j + 1], &valid));
+        if (!valid) {
+            goto end;
+        }
+        j++;
+    }
+
+    CX_CHECK(ec_batch_finish(&batch, batched, verified));
+
+end:
+    cx_bn_unlock();
+    explicit_bzero(&batch, sizeof(batch));
+    return error;
+}
+#endif  // HAVE_ECDSA
+
+#ifdef HAVE_ECSCHNORR
+
+static cx_err_t bip340_challenge(const uint8_t *r,
+                                 const uint8_t *pubkey,
+                                 const uint8_t *msg,
+                                 size_t         msg_len,
+                                 uint8_t        e[static CX_SHA256_SIZE])
+{
+    const cx_iovec_t iovec[] = {
+        {.iov_base = r, .iov_len = EC_BATCH_DOMAIN_LEN},
+        {.iov_base = pubkey, .iov_len = EC_BATCH_DOMAIN_LEN},
+        {.iov_base = msg, .iov_len = msg_len},
+    };
+
+    return cx_sha256_tagged_hash_iovec(
+        &cx_sha256_tag_bip340_challenge, iovec, sizeof(iovec) / sizeof(iovec[0]), e);
+}
+
+cx_err_t cx_ecschnorr_bip340_batch_verify_no_throw(const cx_ecschnorr_bip340_batch_item_t *items,
+                                                   size_t                                  count,
+                                                   bool *verified)
+{
+    cx_err_t   error;
+    ec_batch_t batch;
+    uint8_t    e[CX_SHA256_SIZE];
+    bool       valid;
+
+    if ((items == NULL) || (verified == NULL) || (count == 0) || (count > CX_EC_BATCH_MAX_SIZE)) {
+        return CX_INVALID_PARAMETER;
+    }
+    *verified = false;
+    for (size_t i = 0; i < count; i++) {
+        if ((items[i].pubkey == NULL) || (items[i].sig == NULL)) {
+            return CX_INVALID_PARAMETER;
+        }
+    }
+
+    error = cx_bn_lock(EC_BATCH_DOMAIN_LEN, 0);
+    if (error != CX_OK) {
+        return error;
+    }
+    CX_CHECK(ec_batch_start(&batch, CX_CURVE_SECP256K1, count));
+    CX_CHECK(cx_bn_set_u32(batch.acc, 0));
+
+    for (size_t i = 0; i < count; i++) {
+        const cx_ecschnorr_bip340_batch_item_t *item = &items[i];
+        const uint8_t                          *r    = item->sig;
+        const uint8_t                          *s    = item->sig + EC_BATCH_DOMAIN_LEN;
+
+        // [a]R, with R of even y
+        CX_CHECK(ec_batch_coefficient(&batch, i, batch.scalars[2 * i]));
+        CX_CHECK(ec_batch_lift_x(&batch, &batch.points[2 * i], r, 0, &valid));
+        if (!valid) {
+            goto end;
+        }
+
+        // [a.e]P, with P of even y
+        CX_CHECK(ec_batch_lift_x(&batch, &batch.points[2 * i + 1], item->pubkey, 0, &valid));
+        if (!valid) {
+            goto end;
+        }
+        CX_CHECK(bip340_challenge(r, item->pubkey, item->msg, item->msg_len, e));
+        CX_CHECK(cx_bn_init(batch.u, e, sizeof(e)));
+        CX_CHECK(cx_bn_reduce(batch.t, batch.u, batch.n));
+        CX_CHECK(cx_bn_mod_mul(batch.u, batch.a, batch.t, batch.n));
+        CX_CHECK(cx_bn_export(batch.u, batch.scalars[2 * i + 1], EC_BATCH_DOMAIN_LEN));
+
+        // -[a.s]G, accumulated for the whole batch
+        CX_CHECK(ec_batch_load_scalar(&batch, batch.u, s, EC_BATCH_DOMAIN_LEN, true, &valid));
+        if (!valid) {
+            goto end;
+        }
+        CX_CHECK(cx_bn_mod_mul(batch.t, batch.a, batch.u, batch.n));
+        CX_CHECK(cx_bn_mod_add(batch.u, batch.acc, batch.t, batch.n));
+        CX_CHECK(cx_bn_copy(batch.acc, batch.u));
+    }
+    CX_CHECK(cx_bn_set_u32(batch.u, 0));
+    CX_CHECK(cx_bn_mod_sub(batch.t, batch.u, batch.acc, batch.n));
+    CX_CHECK(cx_bn_copy(batch.acc, batch.t));
+
+    CX_CHECK(ec_batch_finish(&batch, count, verified));
+
+end:
+    cx_bn_unlock();
+    explicit_bzero(&batch, sizeof(batch));
+    return error;
+}
+#endif  // HAVE_ECSCHNORR
+
+#endif  // HAVE_ECC
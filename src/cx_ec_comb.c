@@ -0,0 +1,302 @@
+
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include <stdint.h>   // uint*_t
+#include <string.h>   // memcpy, memset
+#include <stdbool.h>  // bool
+
+#include "cx.h"
+#include "os_nvm.h"
+#include "os_math.h"
+#include "cx_ecpoint_internal.h"
+
+#ifdef HAVE_ECC
+
+static cx_err_t comb_domain_len(cx_curve_t curve, size_t *domain_len)
+{
+    if (!CX_CURVE_RANGE(curve, WEIERSTRASS) && !CX_CURVE_RANGE(curve, TWISTED_EDWARDS)
+        && !CX_CURVE_RANGE(curve, MONTGOMERY)) {
+        return CX_EC_INVALID_CURVE;
+    }
+    return cx_ecdomain_parameters_length(curve, domain_len);
+}
+
+static size_t comb_entry_len(const cx_ecpoint_comb_t *comb)
+{
+    return 2 * comb->domain_len;
+}
+
+static size_t comb_entry_offset(const cx_ecpoint_comb_t *comb, size_t block, uint32_t b)
+{
+    return (block * ((1u << comb->teeth) - 1) + (b - 1)) * comb_entry_len(comb);
+}
+
+static cx_err_t comb_load(const cx_ecpoint_comb_t *comb,
+                          cx_ecpoint_t            *P,
+                          size_t                   block,
+                          uint32_t                 b)
+{
+    const uint8_t *entry = comb->table + comb_entry_offset(comb, block, b);
+
+    return cx_ecpoint_init(P, entry, comb->domain_len, entry + comb->domain_len, comb->domain_len);
+}
+
+static cx_err_t comb_store(const cx_ecpoint_comb_t *comb,
+                           const cx_ecpoint_t      *P,
+                           size_t                   block,
+                           uint32_t                 b,
+                           bool                     nvm)
+{
+    cx_err_t error;
+    uint8_t  entry[2 * CX_MAX_DOMAIN_LENGTH];
+
+    CX_CHECK(cx_ecpoint_export(
+        P, entry, comb->domain_len, entry + comb->domain_len, comb->domain_len));
+    if (nvm) {
+        nvm_write(comb->table + comb_entry_offset(comb, block, b), entry, comb_entry_len(comb));
+    }
+    else {
+        memcpy(comb->table + comb_entry_offset(comb, block, b), entry, comb_entry_len(comb));
+    }
+
+end:
+    return error;
+}
+
+static cx_err_t comb_alloc_points(cx_curve_t curve, cx_ecpoint_t *P, size_t n)
+{
+    cx_err_t error;
+
+    for (size_t i = 0; i < n; i++) {
+        error = cx_ecpoint_alloc(&P[i], curve);
+        if (error != CX_OK) {
+            while (i-- > 0) {
+                cx_ecpoint_destroy(&P[i]);
+            }
+            return error;
+        }
+    }
+    return CX_OK;
+}
+
+static void comb_destroy_points(cx_ecpoint_t *P, size_t n)
+{
+    while (n-- > 0) {
+        cx_ecpoint_destroy(&P[n]);
+    }
+}
+
+/**
+ * Computes P = [2^e]P, by steps of at most [2^(bits - 1)] so that
+ * the scalar fits in the domain length.
+ */
+static cx_err_t ecpoint_mul_pow2(cx_ecpoint_t *P, size_t e, size_t domain_len)
+{
+    cx_err_t error = CX_OK;
+    uint8_t  k[CX_MAX_DOMAIN_LENGTH];
+    size_t   step;
+
+    while (e > 0) {
+        step = MIN(e, domain_len * 8 - 1);
+        memset(k, 0, domain_len);
+        k[domain_len - 1 - step / 8] = 1 << (step % 8);
+        CX_CHECK(cx_ecpoint_scalarmul(P, k, domain_len));
+        e -= step;
+    }
+
+end:
+    return error;
+}
+
+size_t cx_ecpoint_comb_table_len(cx_curve_t curve, uint8_t teeth, uint8_t blocks)
+{
+    size_t domain_len;
+
+    if ((teeth == 0) || (teeth > CX_ECPOINT_COMB_MAX_TEETH) || (blocks == 0)) {
+        return 0;
+    }
+    if (comb_domain_len(curve, &domain_len) != CX_OK) {
+        return 0;
+    }
+    return (size_t) blocks * ((1u << teeth) - 1) * 2 * domain_len;
+}
+
+cx_err_t cx_ecpoint_comb_init(cx_ecpoint_comb_t *comb,
+                              cx_curve_t         curve,
+                              uint8_t            teeth,
+                              uint8_t            blocks,
+                              uint8_t           *table,
+                              size_t             table_len)
+{
+    cx_err_t error;
+    size_t   bits;
+
+    if ((comb == NULL) || (table == NULL) || (teeth == 0) || (teeth > CX_ECPOINT_COMB_MAX_TEETH)
+        || (blocks == 0)) {
+        return CX_INVALID_PARAMETER;
+    }
+    CX_CHECK(comb_domain_len(curve, &comb->domain_len));
+    if (table_len < cx_ecpoint_comb_table_len(curve, teeth, blocks)) {
+        return CX_INVALID_PARAMETER_SIZE;
+    }
+
+    bits          = comb->domain_len * 8;
+    comb->table   = table;
+    comb->curve   = curve;
+    comb->teeth   = teeth;
+    comb->blocks  = blocks;
+    // Rows are padded to a whole number of blocks
+    comb->spacing = ((bits + teeth - 1) / teeth + blocks - 1) / blocks;
+    comb->rows    = comb->spacing * blocks;
+
+end:
+    return error;
+}
+
+cx_err_t cx_ecpoint_comb_precompute(const cx_ecpoint_comb_t *comb,
+                                    const cx_ecpoint_t      *P,
+                                    bool                     nvm)
+{
+    cx_err_t      error;
+    cx_ecpoint_t  points[4];
+    cx_ecpoint_t *B = &points[0], *Q = &points[1], *T = &points[2], *U = &points[3];
+
+    if ((comb == NULL) || (P == NULL) || (P->curve != comb->curve)) {
+        return CX_INVALID_PARAMETER;
+    }
+
+    error = comb_alloc_points(comb->curve, points, 4);
+    if (error != CX_OK) {
+        return error;
+    }
+    CX_CHECK(ecpoint_copy(B, P));
+
+    for (size_t j = 0; j < comb->blocks; j++) {
+        // B = [2^(j.spacing)]P
+        if (j > 0) {
+            CX_CHECK(ecpoint_mul_pow2(B, comb->spacing, comb->domain_len));
+        }
+        CX_CHECK(ecpoint_copy(Q, B));
+        for (size_t i = 0; i < comb->teeth; i++) {
+            // Q = [2^(i.rows)]B
+            if (i > 0) {
+                CX_CHECK(ecpoint_mul_pow2(Q, comb->rows, comb->domain_len));
+            }
+            CX_CHECK(comb_store(comb, Q, j, 1u << i, nvm));
+            // Entries with top bit i are the previous ones plus Q
+            for (uint32_t b = 1; b < (1u << i); b++) {
+                CX_CHECK(comb_load(comb, T, j, b));
+                CX_CHECK(cx_ecpoint_add(U, T, Q));
+                CX_CHECK(comb_store(comb, U, j, b | (1u << i), nvm));
+            }
+        }
+    }
+
+end:
+    comb_destroy_points(points, 4);
+    return error;
+}
+
+static uint32_t comb_scalar_bit(const uint8_t *k, size_t k_len, size_t pos)
+{
+    if (pos >= k_len * 8) {
+        return 0;
+    }
+    return (k[k_len - 1 - pos / 8] >> (pos % 8)) & 1;
+}
+
+cx_err_t cx_ecpoint_comb_scalarmul(const cx_ecpoint_comb_t *comb,
+                                   cx_ecpoint_t            *R,
+                                   const uint8_t           *k,
+                                   size_t                   k_len)
+{
+    static const uint8_t two      = 2;
+    cx_err_t             error    = CX_OK;
+    bool                 infinity = true;
+    bool                 is_infinity;
+    cx_ecpoint_t         points[2];
+    cx_ecpoint_t        *T = &points[0], *U = &points[1];
+    cx_ecpoint_t         tmp;
+    uint32_t             b;
+
+    if ((comb == NULL) || (R == NULL) || (k == NULL) || (R->curve != comb->curve)) {
+        return CX_INVALID_PARAMETER;
+    }
+    if (k_len > comb->domain_len) {
+        return CX_INVALID_PARAMETER_SIZE;
+    }
+
+    error = comb_alloc_points(comb->curve, points, 2);
+    if (error != CX_OK) {
+        return error;
+    }
+
+    for (size_t t = comb->spacing; t-- > 0;) {
+        if (!infinity) {
+            error = cx_ecpoint_scalarmul(R, &two, 1);
+            if (error == CX_EC_INFINITE_POINT) {
+                infinity = true;
+            }
+            else if (error != CX_OK) {
+                goto end;
+            }
+        }
+        for (size_t j = 0; j < comb->blocks; j++) {
+            b = 0;
+            for (size_t i = 0; i < comb->teeth; i++) {
+                b |= comb_scalar_bit(k, k_len, i * comb->rows + j * comb->spacing + t) << i;
+            }
+            if (b == 0) {
+                continue;
+            }
+            if (infinity) {
+                CX_CHECK(comb_load(comb, R, j, b));
+                infinity = false;
+                continue;
+            }
+            CX_CHECK(comb_load(comb, T, j, b));
+            error = cx_ecpoint_add(U, R, T);
+            if (error == CX_EC_INFINITE_POINT) {
+                CX_CHECK(cx_ecpoint_is_at_infinity(R, &is_infinity));
+                if (is_infinity) {
+                    CX_CHECK(comb_load(comb, R, j, b));
+                }
+                else {
+                    infinity = true;
+                }
+                continue;
+            }
+            if (error != CX_OK) {
+                goto end;
+            }
+            // The sum becomes the accumulator, without copying the coordinates
+            tmp = *R;
+            *R  = *U;
+            *U  = tmp;
+        }
+    }
+
+    if (!infinity) {
+        CX_CHECK(cx_ecpoint_is_at_infinity(R, &infinity));
+    }
+    error = infinity ? CX_EC_INFINITE_POINT : CX_OK;
+
+end:
+    comb_destroy_points(points, 2);
+    return error;
+}
+
+#endif  // HAVE_ECC
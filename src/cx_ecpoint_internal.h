@@ -0,0 +1,22 @@
+#pragma once
+
+#ifdef HAVE_ECC
+
+#include "cx.h"
+
+/**
+ * Copies the coordinates of Q into P, allocated on the same curve.
+ */
+static inline cx_err_t ecpoint_copy(cx_ecpoint_t *P, const cx_ecpoint_t *Q)
+{
+    cx_err_t error;
+
+    CX_CHECK(cx_bn_copy(P->x, Q->x));
+    CX_CHECK(cx_bn_copy(P->y, Q->y));
+    CX_CHECK(cx_bn_copy(P->z, Q->z));
+
+end:
+    return error;
+}
+
+#endif  // HAVE_ECC
@@ -0,0 +1,219 @@
+
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include <stdint.h>  // uint*_t
+#include <string.h>  // memcpy, memcmp, explicit_bzero
+
+#include "cx.h"
+
+#if defined(HAVE_EDDSA) && defined(HAVE_SHA512) && defined(HAVE_SHA256)
+
+#define EDDSA_SIGN_NONCE     1
+#define EDDSA_SIGN_CHALLENGE 2
+
+#define ED25519_SIZE 32
+
+/**
+ * Encodes a point 04 || x || y as specified by RFC8032:
+ * little-endian y with the parity of x in the top bit.
+ */
+static void eddsa_encode_point(uint8_t *out, const uint8_t *W)
+{
+    for (size_t i = 0; i < ED25519_SIZE; i++) {
+        out[i] = W[2 * ED25519_SIZE - i];
+    }
+    out[ED25519_SIZE - 1] |= (W[ED25519_SIZE] & 1) << 7;
+}
+
+/**
+ * Reduces a little-endian SHA-512 digest modulo the order, into
+ * a big-endian scalar.
+ */
+static cx_err_t eddsa_digest_to_scalar(uint8_t *h, uint8_t *scalar)
+{
+    cx_err_t error;
+    uint8_t  order[ED25519_SIZE];
+    uint8_t  tmp;
+
+    for (size_t i = 0; i < ED25519_SIZE; i++) {
+        tmp                         = h[i];
+        h[i]                        = h[2 * ED25519_SIZE - 1 - i];
+        h[2 * ED25519_SIZE - 1 - i] = tmp;
+    }
+    CX_CHECK(cx_ecdomain_parameter(CX_CURVE_Ed25519, CX_CURVE_PARAM_Order, order, sizeof(order)));
+    CX_CHECK(cx_math_modm_no_throw(h, 2 * ED25519_SIZE, order, sizeof(order)));
+    memcpy(scalar, h + ED25519_SIZE, ED25519_SIZE);
+
+end:
+    return error;
+}
+
+/**
+ * Ends the first pass: computes the nonce r and R = [r]B, then starts
+ * the challenge hash H(R || A || M).
+ */
+static cx_err_t eddsa_sign_end_nonce(cx_eddsa_sign_ctx_t *ctx)
+{
+    cx_err_t error;
+    uint8_t  h[2 * ED25519_SIZE];
+    uint8_t  Q[1 + 2 * ED25519_SIZE];
+
+    CX_CHECK(cx_hash_final(&ctx->hash.header, h));
+    CX_CHECK(eddsa_digest_to_scalar(h, ctx->r));
+
+    Q[0] = 0x04;
+    CX_CHECK(cx_ecdomain_generator(CX_CURVE_Ed25519, Q + 1, Q + 1 + ED25519_SIZE, ED25519_SIZE));
+    CX_CHECK(cx_ecfp_scalar_mult_no_throw(CX_CURVE_Ed25519, Q, ctx->r, ED25519_SIZE));
+    eddsa_encode_point(ctx->R, Q);
+
+    CX_CHECK(cx_hash_final(&ctx->check.header, ctx->digest));
+    cx_sha256_init_no_throw(&ctx->check);
+
+    cx_sha512_init_no_throw(&ctx->hash);
+    CX_CHECK(cx_hash_update(&ctx->hash.header, ctx->R, ED25519_SIZE));
+    CX_CHECK(cx_hash_update(&ctx->hash.header, ctx->A, ED25519_SIZE));
+    ctx->state = EDDSA_SIGN_CHALLENGE;
+
+end:
+    explicit_bzero(h, sizeof(h));
+    if (error != CX_OK) {
+        explicit_bzero(ctx, sizeof(cx_eddsa_sign_ctx_t));
+    }
+    return error;
+}
+
+cx_err_t cx_eddsa_sign_init_no_throw(cx_eddsa_sign_ctx_t         *ctx,
+                                     const cx_ecfp_private_key_t *pvkey,
+                                     cx_md_t                      hashID)
+{
+    cx_err_t                 error;
+    cx_ecfp_256_public_key_t pukey;
+    uint8_t                  prefix[ED25519_SIZE];
+
+    if ((ctx == NULL) || (pvkey == NULL) || (hashID != CX_SHA512)) {
+        return CX_INVALID_PARAMETER;
+    }
+    if (pvkey->curve != CX_CURVE_Ed25519) {
+        return CX_EC_INVALID_CURVE;
+    }
+
+    explicit_bzero(ctx, sizeof(cx_eddsa_sign_ctx_t));
+    // a is returned as a big-endian scalar, the public key as 04 || x || y
+    CX_CHECK(cx_eddsa_get_public_key_no_throw(
+        pvkey, CX_SHA512, &pukey, ctx->a, sizeof(ctx->a), prefix, sizeof(prefix)));
+    eddsa_encode_point(ctx->A, pukey.W);
+
+    cx_sha512_init_no_throw(&ctx->hash);
+    CX_CHECK(cx_hash_update(&ctx->hash.header, prefix, sizeof(prefix)));
+    cx_sha256_init_no_throw(&ctx->check);
+    ctx->state = EDDSA_SIGN_NONCE;
+
+end:
+    explicit_bzero(prefix, sizeof(prefix));
+    if (error != CX_OK) {
+        explicit_bzero(ctx, sizeof(cx_eddsa_sign_ctx_t));
+    }
+    return error;
+}
+
+cx_err_t cx_eddsa_sign_update_nonce_no_throw(cx_eddsa_sign_ctx_t *ctx,
+                                             const uint8_t       *data,
+                                             size_t               len)
+{
+    cx_err_t error;
+
+    if ((ctx == NULL) || (ctx->state != EDDSA_SIGN_NONCE)) {
+        return CX_INVALID_PARAMETER;
+    }
+    CX_CHECK(cx_hash_update(&ctx->hash.header, data, len));
+    CX_CHECK(cx_hash_update(&ctx->check.header, data, len));
+
+end:
+    return error;
+}
+
+cx_err_t cx_eddsa_sign_update_challenge_no_throw(cx_eddsa_sign_ctx_t *ctx,
+                                                 const uint8_t       *data,
+                                                 size_t               len)
+{
+    cx_err_t error;
+
+    if (ctx == NULL) {
+        return CX_INVALID_PARAMETER;
+    }
+    if (ctx->state == EDDSA_SIGN_NONCE) {
+        CX_CHECK(eddsa_sign_end_nonce(ctx));
+    }
+    if (ctx->state != EDDSA_SIGN_CHALLENGE) {
+        return CX_INVALID_PARAMETER;
+    }
+    CX_CHECK(cx_hash_update(&ctx->hash.header, data, len));
+    CX_CHECK(cx_hash_update(&ctx->check.header, data, len));
+
+end:
+    return error;
+}
+
+cx_err_t cx_eddsa_sign_final_no_throw(cx_eddsa_sign_ctx_t *ctx, uint8_t *sig, size_t sig_len)
+{
+    cx_err_t error;
+    uint8_t  h[2 * ED25519_SIZE];
+    uint8_t  digest[CX_SHA256_SIZE];
+    uint8_t  order[ED25519_SIZE];
+    uint8_t  s[ED25519_SIZE];
+
+    if ((ctx == NULL) || (sig == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+    if (sig_len < 2 * ED25519_SIZE) {
+        error = CX_INVALID_PARAMETER_SIZE;
+        goto end;
+    }
+    // An empty message has no second pass update
+    if (ctx->state == EDDSA_SIGN_NONCE) {
+        CX_CHECK(eddsa_sign_end_nonce(ctx));
+    }
+    if (ctx->state != EDDSA_SIGN_CHALLENGE) {
+        error = CX_INVALID_PARAMETER;
+        goto end;
+    }
+
+    CX_CHECK(cx_hash_final(&ctx->check.header, digest));
+    if (memcmp(digest, ctx->digest, sizeof(digest)) != 0) {
+        error = CX_INVALID_PARAMETER_VALUE;
+        goto end;
+    }
+
+    // S = r + k.a mod L
+    CX_CHECK(cx_hash_final(&ctx->hash.header, h));
+    CX_CHECK(eddsa_digest_to_scalar(h, s));
+    CX_CHECK(cx_ecdomain_parameter(CX_CURVE_Ed25519, CX_CURVE_PARAM_Order, order, sizeof(order)));
+    CX_CHECK(cx_math_multm_no_throw(s, s, ctx->a, order, ED25519_SIZE));
+    CX_CHECK(cx_math_addm_no_throw(s, s, ctx->r, order, ED25519_SIZE));
+
+    memcpy(sig, ctx->R, ED25519_SIZE);
+    for (size_t i = 0; i < ED25519_SIZE; i++) {
+        sig[ED25519_SIZE + i] = s[ED25519_SIZE - 1 - i];
+    }
+
+end:
+    explicit_bzero(h, sizeof(h));
+    explicit_bzero(s, sizeof(s));
+    explicit_bzero(ctx, sizeof(cx_eddsa_sign_ctx_t));
+    return error;
+}
+
+#endif  // HAVE_EDDSA && HAVE_SHA512 && HAVE_SHA256
@@ -28,6 +28,8 @@
 __attribute__((weak)) union cx_u G_cx;
 #endif
 
+// hash_ctx is the whole context, of hash_ctx_size bytes, cast from the context
+// pointer rather than taken as &ctx->header, which would make it look 16 bytes long
 static cx_err_t hash_iovec(cx_hash_t        *hash_ctx,
                            size_t            hash_ctx_size,
                            cx_md_t           hash_id,
@@ -84,7 +86,7 @@ cx_err_t cx_ripemd160_hash_iovec(const cx_iovec_t *iovec,
 #endif
 
     return hash_iovec(
-        &hash->header, sizeof(cx_ripemd160_t), CX_RIPEMD160, iovec, iovec_len, digest);
+        (cx_hash_t *) hash, sizeof(cx_ripemd160_t), CX_RIPEMD160, iovec, iovec_len, digest);
 }
 #endif
 
@@ -101,7 +103,7 @@ cx_err_t cx_sha224_hash_iovec(const cx_iovec_t *iovec,
     cx_sha256_t    *hash = &sha256;
 #endif
 
-    return hash_iovec(&hash->header, sizeof(cx_sha256_t), CX_SHA224, iovec, iovec_len, digest);
+    return hash_iovec((cx_hash_t *) hash, sizeof(cx_sha256_t), CX_SHA224, iovec, iovec_len, digest);
 }
 #endif
 
@@ -117,7 +119,7 @@ cx_err_t cx_sha256_hash_iovec(const cx_iovec_t *iovec,
     cx_sha256_t    *hash = &sha256;
 #endif
 
-    return hash_iovec(&hash->header, sizeof(cx_sha256_t), CX_SHA256, iovec, iovec_len, digest);
+    return hash_iovec((cx_hash_t *) hash, sizeof(cx_sha256_t), CX_SHA256, iovec, iovec_len, digest);
 }
 #endif
 
@@ -133,7 +135,7 @@ cx_err_t cx_sha384_hash_iovec(const cx_iovec_t *iovec,
     cx_sha512_t    *hash = &sha512;
 #endif
 
-    return hash_iovec(&hash->header, sizeof(cx_sha512_t), CX_SHA384, iovec, iovec_len, digest);
+    return hash_iovec((cx_hash_t *) hash, sizeof(cx_sha512_t), CX_SHA384, iovec, iovec_len, digest);
 }
 #endif
 
@@ -149,7 +151,7 @@ cx_err_t cx_sha512_hash_iovec(const cx_iovec_t *iovec,
     cx_sha512_t    *hash = &sha512;
 #endif
 
-    return hash_iovec(&hash->header, sizeof(cx_sha512_t), CX_SHA512, iovec, iovec_len, digest);
+    return hash_iovec((cx_hash_t *) hash, sizeof(cx_sha512_t), CX_SHA512, iovec, iovec_len, digest);
 }
 #endif
 
@@ -162,13 +164,63 @@ cx_err_t cx_sha512_hash_iovec(const cx_iovec_t *iovec,
     cx_sha3_t *hash = &sha3
 #endif
 
-#define CX_SHA3_BASED_FUNC(func_name, hash_id, digest_len)                                    \
-    cx_err_t func_name(                                                                       \
-        const cx_iovec_t *iovec, size_t iovec_len, uint8_t digest[static digest_len])         \
-    {                                                                                         \
-        ALLOCATE_SHA3_HASH();                                                                 \
-        return hash_iovec_ex(                                                                 \
-            &hash->header, sizeof(cx_sha3_t), hash_id, digest_len, iovec, iovec_len, digest); \
+#ifdef HAVE_APP_KECCAK
+// The in-app Keccak is only reached through the cx_sha3 API, not the generic cx_hash one
+static cx_err_t sha3_hash_iovec(cx_sha3_t        *hash,
+                                cx_md_t           hash_id,
+                                size_t            digest_len,
+                                const cx_iovec_t *iovec,
+                                size_t            iovec_len,
+                                uint8_t          *digest)
+{
+    cx_err_t error;
+
+    switch (hash_id) {
+        case CX_SHA3:
+            CX_CHECK(cx_sha3_init_no_throw(hash, digest_len * 8));
+            break;
+        case CX_KECCAK:
+            CX_CHECK(cx_keccak_init_no_throw(hash, digest_len * 8));
+            break;
+        case CX_SHAKE128:
+            CX_CHECK(cx_sha3_xof_init_no_throw(hash, 128, digest_len));
+            break;
+        case CX_SHAKE256:
+            CX_CHECK(cx_sha3_xof_init_no_throw(hash, 256, digest_len));
+            break;
+        default:
+            error = CX_INVALID_PARAMETER;
+            goto end;
+    }
+    for (size_t i = 0; i < iovec_len; i++) {
+        CX_CHECK(cx_sha3_update(hash, iovec[i].iov_base, iovec[i].iov_len));
+    }
+    CX_CHECK(cx_sha3_final(hash, digest));
+
+end:
+    explicit_bzero(hash, sizeof(cx_sha3_t));
+
+    return error;
+}
+#else
+static cx_err_t sha3_hash_iovec(cx_sha3_t        *hash,
+                                cx_md_t           hash_id,
+                                size_t            digest_len,
+                                const cx_iovec_t *iovec,
+                                size_t            iovec_len,
+                                uint8_t          *digest)
+{
+    return hash_iovec_ex(
+        (cx_hash_t *) hash, sizeof(cx_sha3_t), hash_id, digest_len, iovec, iovec_len, digest);
+}
+#endif
+
+#define CX_SHA3_BASED_FUNC(func_name, hash_id, digest_len)                            \
+    cx_err_t func_name(                                                               \
+        const cx_iovec_t *iovec, size_t iovec_len, uint8_t digest[static digest_len]) \
+    {                                                                                 \
+        ALLOCATE_SHA3_HASH();                                                         \
+        return sha3_hash_iovec(hash, hash_id, digest_len, iovec, iovec_len, digest);  \
     }
 
 CX_SHA3_BASED_FUNC(cx_sha3_224_hash_iovec, CX_SHA3, CX_SHA3_224_SIZE)
@@ -187,8 +239,7 @@ cx_err_t cx_shake128_hash_iovec(const cx_iovec_t *iovec,
                                 size_t            out_length)
 {
     ALLOCATE_SHA3_HASH();
-    return hash_iovec_ex(
-        &hash->header, sizeof(cx_sha3_t), CX_SHAKE128, out_length, iovec, iovec_len, digest);
+    return sha3_hash_iovec(hash, CX_SHAKE128, out_length, iovec, iovec_len, digest);
 }
 
 cx_err_t cx_shake256_hash_iovec(const cx_iovec_t *iovec,
@@ -197,8 +248,7 @@ cx_err_t cx_shake256_hash_iovec(const cx_iovec_t *iovec,
                                 size_t            out_length)
 {
     ALLOCATE_SHA3_HASH();
-    return hash_iovec_ex(
-        &hash->header, sizeof(cx_sha3_t), CX_SHAKE256, out_length, iovec, iovec_len, digest);
+    return sha3_hash_iovec(hash, CX_SHAKE256, out_length, iovec, iovec_len, digest);
 }
 #endif
 
@@ -214,7 +264,7 @@ cx_err_t cx_blake2b_256_hash_iovec(const cx_iovec_t *iovec,
     cx_blake2b_t   *hash = &blake;
 #endif
 
-    return hash_iovec_ex(&hash->header,
+    return hash_iovec_ex((cx_hash_t *) hash,
                          sizeof(cx_blake2b_t),
                          CX_BLAKE2B,
                          CX_BLAKE2B_256_SIZE,
@@ -234,7 +284,7 @@ cx_err_t cx_blake2b_512_hash_iovec(const cx_iovec_t *iovec,
     cx_blake2b_t   *hash = &blake;
 #endif
 
-    return hash_iovec_ex(&hash->header,
+    return hash_iovec_ex((cx_hash_t *) hash,
                          sizeof(cx_blake2b_t),
                          CX_BLAKE2B,
                          CX_BLAKE2B_512_SIZE,
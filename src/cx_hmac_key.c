@@ -0,0 +1,304 @@
+
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include <stdint.h>  // uint*_t
+#include <string.h>  // memset, memcpy, explicit_bzero
+
+#include "cx.h"
+#include "os_math.h"
+#include "os_utils.h"
+#include "lib_cxng/src/cx_hkdf.h"
+#include "lib_cxng/src/cx_pbkdf2.h"
+
+#if defined(HAVE_HMAC)                                                       \
+    && (defined(HAVE_SHA224) || defined(HAVE_SHA256) || defined(HAVE_SHA384) \
+        || defined(HAVE_SHA512))
+
+#define HMAC_IPAD           0x36
+#define HMAC_OPAD           0x5c
+#define HMAC_MAX_BLOCK_SIZE 128
+#define HMAC_MAX_MAC_LEN    64
+
+static cx_err_t hmac_key_sizes(cx_md_t hash_id, size_t *block_size, size_t *mac_len)
+{
+    switch (hash_id) {
+#ifdef HAVE_SHA224
+        case CX_SHA224:
+            *block_size = 64;
+            *mac_len    = CX_SHA224_SIZE;
+            break;
+#endif
+#ifdef HAVE_SHA256
+        case CX_SHA256:
+            *block_size = 64;
+            *mac_len    = CX_SHA256_SIZE;
+            break;
+#endif
+#ifdef HAVE_SHA384
+        case CX_SHA384:
+            *block_size = 128;
+            *mac_len    = CX_SHA384_SIZE;
+            break;
+#endif
+#ifdef HAVE_SHA512
+        case CX_SHA512:
+            *block_size = 128;
+            *mac_len    = CX_SHA512_SIZE;
+            break;
+#endif
+        default:
+            return CX_INVALID_PARAMETER;
+    }
+    return CX_OK;
+}
+
+cx_err_t cx_hmac_key_init(cx_hmac_key_t *hkey,
+                          cx_md_t        hash_id,
+                          const uint8_t *key,
+                          size_t         key_len)
+{
+    cx_err_t error;
+    uint8_t  pad[HMAC_MAX_BLOCK_SIZE];
+    uint8_t  hashed_key[HMAC_MAX_MAC_LEN];
+    size_t   block_size;
+
+    if ((hkey == NULL) || ((key == NULL) && (key_len != 0))) {
+        return CX_INVALID_PARAMETER;
+    }
+    explicit_bzero(hkey, sizeof(cx_hmac_key_t));
+    CX_CHECK(hmac_key_sizes(hash_id, &block_size, &hkey->mac_len));
+
+    // Keys longer than a block are replaced by their hash
+    if (key_len > block_size) {
+        CX_CHECK(cx_hash_init(&hkey->inner.header, hash_id));
+        CX_CHECK(cx_hash_update(&hkey->inner.header, key, key_len));
+        CX_CHECK(cx_hash_final(&hkey->inner.header, hashed_key));
+        key     = hashed_key;
+        key_len = hkey->mac_len;
+    }
+
+    memset(pad, HMAC_IPAD, block_size);
+    for (size_t i = 0; i < key_len; i++) {
+        pad[i] ^= key[i];
+    }
+    CX_CHECK(cx_hash_init(&hkey->inner.header, hash_id));
+    CX_CHECK(cx_hash_update(&hkey->inner.header, pad, block_size));
+
+    for (size_t i = 0; i < block_size; i++) {
+        pad[i] ^= HMAC_IPAD ^ HMAC_OPAD;
+    }
+    CX_CHECK(cx_hash_init(&hkey->outer.header, hash_id));
+    CX_CHECK(cx_hash_update(&hkey->outer.header, pad, block_size));
+
+end:
+    explicit_bzero(pad, sizeof(pad));
+    explicit_bzero(hashed_key, sizeof(hashed_key));
+    if (error != CX_OK) {
+        explicit_bzero(hkey, sizeof(cx_hmac_key_t));
+    }
+    return error;
+}
+
+cx_err_t cx_hmac_key_compute_iovec(const cx_hmac_key_t *hkey,
+                                   const cx_iovec_t    *iovec,
+                                   size_t               iovec_len,
+                                   uint8_t             *mac)
+{
+    cx_err_t        error;
+    cx_hmac_state_t state;
+    uint8_t         inner_mac[HMAC_MAX_MAC_LEN];
+
+    if ((hkey == NULL) || (hkey->mac_len == 0) || ((iovec == NULL) && (iovec_len != 0))
+        || (mac == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+
+    // The precomputed states are copied, so that hkey can be reused
+    memcpy(&state, &hkey->inner, sizeof(state));
+    for (size_t i = 0; i < iovec_len; i++) {
+        CX_CHECK(cx_hash_update(&state.header, iovec[i].iov_base, iovec[i].iov_len));
+    }
+    CX_CHECK(cx_hash_final(&state.header, inner_mac));
+
+    memcpy(&state, &hkey->outer, sizeof(state));
+    CX_CHECK(cx_hash_update(&state.header, inner_mac, hkey->mac_len));
+    CX_CHECK(cx_hash_final(&state.header, mac));
+
+end:
+    explicit_bzero(&state, sizeof(state));
+    explicit_bzero(inner_mac, sizeof(inner_mac));
+    return error;
+}
+
+cx_err_t cx_hkdf_expand_init(cx_hkdf_expand_t *ctx,
+                             cx_md_t           hash_id,
+                             const uint8_t    *prk,
+                             size_t            prk_len,
+                             const uint8_t    *info,
+                             size_t            info_len)
+{
+    cx_err_t error;
+
+    if ((ctx == NULL) || ((info == NULL) && (info_len != 0))) {
+        return CX_INVALID_PARAMETER;
+    }
+    explicit_bzero(ctx, sizeof(cx_hkdf_expand_t));
+    CX_CHECK(cx_hmac_key_init(&ctx->hkey, hash_id, prk, prk_len));
+    ctx->info     = info;
+    ctx->info_len = info_len;
+    // No block computed yet
+    ctx->offset = ctx->hkey.mac_len;
+
+end:
+    return error;
+}
+
+cx_err_t cx_hkdf_expand_read(cx_hkdf_expand_t *ctx, uint8_t *out, size_t len)
+{
+    cx_err_t   error = CX_OK;
+    cx_iovec_t iovec[3];
+    size_t     mac_len;
+    size_t     n;
+
+    if ((ctx == NULL) || (ctx->hkey.mac_len == 0) || ((out == NULL) && (len != 0))) {
+        return CX_INVALID_PARAMETER;
+    }
+    mac_len = ctx->hkey.mac_len;
+    if (len > (255 - ctx->counter) * mac_len + (mac_len - ctx->offset)) {
+        return CX_INVALID_PARAMETER;
+    }
+
+    // T(i) = HMAC(PRK, T(i - 1) || info || i), with T(0) empty
+    iovec[0].iov_base = ctx->block;
+    iovec[1].iov_base = ctx->info;
+    iovec[1].iov_len  = ctx->info_len;
+    iovec[2].iov_base = &ctx->counter;
+    iovec[2].iov_len  = 1;
+    while (len > 0) {
+        if (ctx->offset == mac_len) {
+            iovec[0].iov_len = (ctx->counter == 0) ? 0 : mac_len;
+            ctx->counter++;
+            CX_CHECK(cx_hmac_key_compute_iovec(&ctx->hkey, iovec, 3, ctx->block));
+            ctx->offset = 0;
+        }
+        n = MIN(len, mac_len - ctx->offset);
+        memcpy(out, ctx->block + ctx->offset, n);
+        ctx->offset += n;
+        out += n;
+        len -= n;
+    }
+
+end:
+    return error;
+}
+
+#ifdef HAVE_APP_HMAC_KDF
+
+/*
+ * The following functions replace the OS ones, which initialize the HMAC
+ * from the raw key at each iteration.
+ */
+
+#ifdef HAVE_PBKDF2
+cx_err_t cx_pbkdf2_hmac(cx_md_t        md_type,
+                        const uint8_t *password,
+                        size_t         password_len,
+                        const uint8_t *salt,
+                        size_t         salt_len,
+                        uint32_t       iterations,
+                        uint8_t       *key,
+                        size_t         key_len)
+{
+    cx_err_t      error;
+    cx_hmac_key_t hkey;
+    uint8_t       u[HMAC_MAX_MAC_LEN];
+    uint8_t       t[HMAC_MAX_MAC_LEN];
+    uint8_t       counter[4];
+    cx_iovec_t    iovec[2];
+    size_t        len;
+
+    if ((iterations == 0) || ((salt == NULL) && (salt_len != 0))
+        || ((key == NULL) && (key_len != 0))) {
+        return CX_INVALID_PARAMETER;
+    }
+    CX_CHECK(cx_hmac_key_init(&hkey, md_type, password, password_len));
+
+    iovec[0].iov_base = salt;
+    iovec[0].iov_len  = salt_len;
+    iovec[1].iov_base = counter;
+    iovec[1].iov_len  = sizeof(counter);
+    for (uint32_t block = 1; key_len > 0; block++) {
+        // U_1 = PRF(P, S || INT(i)), U_j = PRF(P, U_{j-1}), T_i = U_1 ^ ... ^ U_c
+        U4BE_ENCODE(counter, 0, block);
+        CX_CHECK(cx_hmac_key_compute_iovec(&hkey, iovec, 2, u));
+        memcpy(t, u, hkey.mac_len);
+        for (uint32_t j = 1; j < iterations; j++) {
+            CX_CHECK(cx_hmac_key_compute(&hkey, u, hkey.mac_len, u));
+            for (size_t i = 0; i < hkey.mac_len; i++) {
+                t[i] ^= u[i];
+            }
+        }
+        len = MIN(key_len, hkey.mac_len);
+        memcpy(key, t, len);
+        key += len;
+        key_len -= len;
+    }
+
+end:
+    explicit_bzero(&hkey, sizeof(hkey));
+    explicit_bzero(u, sizeof(u));
+    explicit_bzero(t, sizeof(t));
+    return error;
+}
+
+cx_err_t cx_pbkdf2_no_throw(cx_md_t        md_type,
+                            const uint8_t *password,
+                            size_t         passwordlen,
+                            uint8_t       *salt,
+                            size_t         saltlen,
+                            uint32_t       iterations,
+                            uint8_t       *out,
+                            size_t         outLength)
+{
+    return cx_pbkdf2_hmac(
+        md_type, password, passwordlen, salt, saltlen, iterations, out, outLength);
+}
+#endif  // HAVE_PBKDF2
+
+void cx_hkdf_expand(const cx_md_t        hash_id,
+                    const unsigned char *prk,
+                    unsigned int         prk_len,
+                    unsigned char       *info,
+                    unsigned int         info_len,
+                    unsigned char       *okm,
+                    unsigned int         okm_len)
+{
+    cx_err_t         error;
+    cx_hkdf_expand_t ctx;
+
+    CX_CHECK(cx_hkdf_expand_init(&ctx, hash_id, prk, prk_len, info, info_len));
+    CX_CHECK(cx_hkdf_expand_read(&ctx, okm, okm_len));
+
+end:
+    explicit_bzero(&ctx, sizeof(ctx));
+    if (error != CX_OK) {
+        THROW(error);
+    }
+}
+
+#endif  // HAVE_APP_HMAC_KDF
+
+#endif  // HAVE_HMAC && (HAVE_SHA224 || HAVE_SHA256 || HAVE_SHA384 || HAVE_SHA512)
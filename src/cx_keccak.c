@@ -0,0 +1,350 @@
+
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include <stdint.h>  // uint*_t
+#include <string.h>  // memset, memcpy, explicit_bzero
+
+#include "cx.h"
+#include "lib_cxng/src/cx_hash.h"
+#include "lib_cxng/src/cx_sha3.h"
+#include "os_math.h"
+
+#if defined(HAVE_SHA3) && defined(HAVE_APP_KECCAK)
+
+/*
+ * In-app Keccak-f[1600], replacing the cx_sha3 syscalls.
+ *
+ * The state is bit-interleaved: each 64-bit lane is held as two 32-bit
+ * words, one with the even bits and one with the odd bits, so that a
+ * 64-bit rotation becomes two 32-bit rotations. The cx_sha3_t context
+ * keeps the standard lane layout between calls, so a context can still
+ * be handed to the generic cx_hash functions.
+ */
+
+#define KECCAK_LANES      25
+#define KECCAK_STATE_SIZE 200
+#define KECCAK_ROUNDS     24
+
+#define ROTL32(v, n) (((v) << (n)) | ((v) >> ((32 - (n)) & 31)))
+
+// Round constants, as (even bits, odd bits)
+static const uint32_t keccak_rc[KECCAK_ROUNDS][2] = {
+    {0x00000001, 0x00000000}, {0x00000000, 0x00000089}, {0x00000000, 0x8000008b},
+    {0x00000000, 0x80008080}, {0x00000001, 0x0000008b}, {0x00000001, 0x00008000},
+    {0x00000001, 0x80008088}, {0x00000001, 0x80000082}, {0x00000000, 0x0000000b},
+    {0x00000000, 0x0000000a}, {0x00000001, 0x00008082}, {0x00000000, 0x00008003},
+    {0x00000001, 0x0000808b}, {0x00000001, 0x8000000b}, {0x00000001, 0x8000008a},
+    {0x00000001, 0x80000081}, {0x00000000, 0x80000081}, {0x00000000, 0x80000008},
+    {0x00000000, 0x00000083}, {0x00000000, 0x80008003}, {0x00000001, 0x80008088},
+    {0x00000000, 0x80000088}, {0x00000001, 0x00008000}, {0x00000000, 0x80008082},
+};
+
+// Rho offsets and Pi destinations, following the Pi cycle from lane 1
+static const uint8_t keccak_rho[KECCAK_LANES - 1]
+    = {1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14, 27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44};
+static const uint8_t keccak_pi[KECCAK_LANES - 1]
+    = {10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4, 15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1};
+
+static uint32_t keccak_load32(const uint8_t *p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16)
+           | ((uint32_t) p[3] << 24);
+}
+
+static void keccak_store32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = v >> 24;
+}
+
+// Moves the even bits of x to the low half and the odd bits to the high half
+static uint32_t keccak_unshuffle(uint32_t x)
+{
+    uint32_t t;
+
+    t = (x ^ (x >> 1)) & 0x22222222;
+    x ^= t ^ (t << 1);
+    t = (x ^ (x >> 2)) & 0x0c0c0c0c;
+    x ^= t ^ (t << 2);
+    t = (x ^ (x >> 4)) & 0x00f000f0;
+    x ^= t ^ (t << 4);
+    t = (x ^ (x >> 8)) & 0x0000ff00;
+    x ^= t ^ (t << 8);
+    return x;
+}
+
+static uint32_t keccak_shuffle(uint32_t x)
+{
+    uint32_t t;
+
+    t = (x ^ (x >> 8)) & 0x0000ff00;
+    x ^= t ^ (t << 8);
+    t = (x ^ (x >> 4)) & 0x00f000f0;
+    x ^= t ^ (t << 4);
+    t = (x ^ (x >> 2)) & 0x0c0c0c0c;
+    x ^= t ^ (t << 2);
+    t = (x ^ (x >> 1)) & 0x22222222;
+    x ^= t ^ (t << 1);
+    return x;
+}
+
+// XORs little-endian 64-bit lanes into the interleaved state
+static void keccak_xor_lanes(uint32_t A[2 * KECCAK_LANES], const uint8_t *in, size_t lanes)
+{
+    uint32_t lo, hi;
+
+    for (size_t i = 0; i < lanes; i++) {
+        lo = keccak_unshuffle(keccak_load32(in + 8 * i));
+        hi = keccak_unshuffle(keccak_load32(in + 8 * i + 4));
+        A[2 * i] ^= (lo & 0x0000ffff) | (hi << 16);
+        A[2 * i + 1] ^= (lo >> 16) | (hi & 0xffff0000);
+    }
+}
+
+static void keccak_extract_lanes(const uint32_t A[2 * KECCAK_LANES], uint8_t *out, size_t lanes)
+{
+    uint32_t lo, hi;
+
+    for (size_t i = 0; i < lanes; i++) {
+        lo = (A[2 * i] & 0x0000ffff) | (A[2 * i + 1] << 16);
+        hi = (A[2 * i] >> 16) | (A[2 * i + 1] & 0xffff0000);
+        keccak_store32(out + 8 * i, keccak_shuffle(lo));
+        keccak_store32(out + 8 * i + 4, keccak_shuffle(hi));
+    }
+}
+
+/*
+ * 64-bit rotation of an interleaved lane: an even amount rotates both
+ * halves, an odd amount also swaps them.
+ */
+static void keccak_rotl64(uint32_t *even, uint32_t *odd, uint32_t n)
+{
+    uint32_t e = *even;
+    uint32_t o = *odd;
+
+    if (n & 1) {
+        *even = ROTL32(o, (n + 1) / 2);
+        *odd  = ROTL32(e, n / 2);
+    }
+    else {
+        *even = ROTL32(e, n / 2);
+        *odd  = ROTL32(o, n / 2);
+    }
+}
+
+static void keccak_f1600(uint32_t A[2 * KECCAK_LANES])
+{
+    uint32_t C[10];
+    uint32_t B[10];
+    uint32_t de, d_o, te, to, se, so;
+
+    for (size_t round = 0; round < KECCAK_ROUNDS; round++) {
+        // Theta
+        for (size_t x = 0; x < 10; x++) {
+            C[x] = A[x] ^ A[x + 10] ^ A[x + 20] ^ A[x + 30] ^ A[x + 40];
+        }
+        for (size_t x = 0; x < 5; x++) {
+            // D[x] = C[x - 1] ^ ROTL64(C[x + 1], 1)
+            de  = C[2 * ((x + 4) % 5)] ^ ROTL32(C[2 * ((x + 1) % 5) + 1], 1);
+            d_o = C[2 * ((x + 4) % 5) + 1] ^ C[2 * ((x + 1) % 5)];
+            for (size_t y = 0; y < 50; y += 10) {
+                A[y + 2 * x] ^= de;
+                A[y + 2 * x + 1] ^= d_o;
+            }
+        }
+
+        // Rho and Pi
+        te = A[2];
+        to = A[3];
+        for (size_t i = 0; i < KECCAK_LANES - 1; i++) {
+            size_t j = keccak_pi[i];
+
+            se = A[2 * j];
+            so = A[2 * j + 1];
+            keccak_rotl64(&te, &to, keccak_rho[i]);
+            A[2 * j]     = te;
+            A[2 * j + 1] = to;
+            te           = se;
+            to           = so;
+        }
+
+        // Chi
+        for (size_t y = 0; y < 50; y += 10) {
+            memcpy(B, A + y, sizeof(B));
+            for (size_t x = 0; x < 10; x++) {
+                A[y + x] = B[x] ^ (~B[(x + 2) % 10] & B[(x + 4) % 10]);
+            }
+        }
+
+        // Iota
+        A[0] ^= keccak_rc[round][0];
+        A[1] ^= keccak_rc[round][1];
+    }
+
+    explicit_bzero(C, sizeof(C));
+    explicit_bzero(B, sizeof(B));
+}
+
+static cx_err_t keccak_init(cx_sha3_t *hash, cx_md_t hash_id, size_t output_size, size_t capacity)
+{
+    if (hash == NULL) {
+        return CX_INVALID_PARAMETER;
+    }
+    memset(hash, 0, sizeof(cx_sha3_t));
+    hash->header.info = cx_hash_get_info(hash_id);
+    hash->output_size = output_size;
+    hash->block_size  = (1600 - capacity) / 8;
+    return CX_OK;
+}
+
+cx_err_t cx_sha3_init_no_throw(cx_sha3_t *hash, size_t size)
+{
+    if ((size != 224) && (size != 256) && (size != 384) && (size != 512)) {
+        return CX_INVALID_PARAMETER;
+    }
+    return keccak_init(hash, CX_SHA3, size / 8, 2 * size);
+}
+
+cx_err_t cx_keccak_init_no_throw(cx_sha3_t *hash, size_t size)
+{
+    if ((size != 224) && (size != 256) && (size != 384) && (size != 512)) {
+        return CX_INVALID_PARAMETER;
+    }
+    return keccak_init(hash, CX_KECCAK, size / 8, 2 * size);
+}
+
+cx_err_t cx_sha3_xof_init_no_throw(cx_sha3_t *hash, size_t size, size_t out_length)
+{
+    if (size == 128) {
+        return keccak_init(hash, CX_SHAKE128, out_length, 2 * size);
+    }
+    if (size == 256) {
+        return keccak_init(hash, CX_SHAKE256, out_length, 2 * size);
+    }
+    return CX_INVALID_PARAMETER;
+}
+
+size_t cx_sha3_get_output_size(const cx_sha3_t *ctx)
+{
+    return ctx->output_size;
+}
+
+cx_err_t cx_sha3_update(cx_sha3_t *ctx, const uint8_t *data, size_t len)
+{
+    uint32_t A[2 * KECCAK_LANES];
+    size_t   block_size;
+    size_t   r;
+
+    if ((ctx == NULL) || ((data == NULL) && (len != 0))) {
+        return CX_INVALID_PARAMETER;
+    }
+    block_size = ctx->block_size;
+    if ((block_size == 0) || (block_size % 8 != 0) || (block_size > KECCAK_STATE_SIZE)
+        || (ctx->blen >= block_size)) {
+        return CX_INVALID_PARAMETER;
+    }
+
+    if (ctx->blen + len < block_size) {
+        memcpy(ctx->block + ctx->blen, data, len);
+        ctx->blen += len;
+        return CX_OK;
+    }
+
+    // The state is interleaved once for all the blocks of this call
+    memset(A, 0, sizeof(A));
+    keccak_xor_lanes(A, (const uint8_t *) ctx->acc, KECCAK_LANES);
+    if (ctx->blen != 0) {
+        r = block_size - ctx->blen;
+        memcpy(ctx->block + ctx->blen, data, r);
+        keccak_xor_lanes(A, ctx->block, block_size / 8);
+        keccak_f1600(A);
+        ctx->header.counter++;
+        data += r;
+        len -= r;
+        ctx->blen = 0;
+    }
+    while (len >= block_size) {
+        keccak_xor_lanes(A, data, block_size / 8);
+        keccak_f1600(A);
+        ctx->header.counter++;
+        data += block_size;
+        len -= block_size;
+    }
+    memcpy(ctx->block, data, len);
+    ctx->blen = len;
+    keccak_extract_lanes(A, (uint8_t *) ctx->acc, KECCAK_LANES);
+
+    explicit_bzero(A, sizeof(A));
+    return CX_OK;
+}
+
+cx_err_t cx_sha3_final(cx_sha3_t *ctx, uint8_t *digest)
+{
+    uint32_t A[2 * KECCAK_LANES];
+    size_t   block_size;
+    size_t   len;
+    size_t   r;
+    uint8_t  suffix;
+
+    if ((ctx == NULL) || (digest == NULL)) {
+        return CX_INVALID_PARAMETER;
+    }
+    block_size = ctx->block_size;
+    len        = ctx->output_size;
+    if ((block_size == 0) || (block_size % 8 != 0) || (block_size > KECCAK_STATE_SIZE)
+        || (ctx->blen >= block_size)) {
+        return CX_INVALID_PARAMETER;
+    }
+
+    if (ctx->header.info == cx_hash_get_info(CX_KECCAK)) {
+        suffix = 0x01;
+    }
+    else if (ctx->header.info == cx_hash_get_info(CX_SHA3)) {
+        suffix = 0x06;
+    }
+    else {
+        suffix = 0x1f;
+    }
+
+    memset(ctx->block + ctx->blen, 0, sizeof(ctx->block) - ctx->blen);
+    ctx->block[ctx->blen] |= suffix;
+    ctx->block[block_size - 1] |= 0x80;
+
+    memset(A, 0, sizeof(A));
+    keccak_xor_lanes(A, (const uint8_t *) ctx->acc, KECCAK_LANES);
+    keccak_xor_lanes(A, ctx->block, block_size / 8);
+    keccak_f1600(A);
+    keccak_extract_lanes(A, (uint8_t *) ctx->acc, KECCAK_LANES);
+
+    // Only the extendable-output functions may need several squeezes
+    while (len > 0) {
+        r = MIN(len, block_size);
+        memcpy(digest, ctx->acc, r);
+        digest += r;
+        len -= r;
+        if (len > 0) {
+            keccak_f1600(A);
+            keccak_extract_lanes(A, (uint8_t *) ctx->acc, KECCAK_LANES);
+        }
+    }
+
+    explicit_bzero(A, sizeof(A));
+    return CX_OK;
+}
+
+#endif  // HAVE_SHA3 && HAVE_APP_KECCAK
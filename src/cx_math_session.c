@@ -0,0 +1,139 @@
+
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include <stdint.h>  // uint*_t
+#include <string.h>  // explicit_bzero
+
+#include "cx.h"
+
+#ifdef HAVE_MATH
+
+cx_err_t cx_math_session_start(cx_math_session_t *session, const uint8_t *m, size_t len)
+{
+    cx_err_t error;
+
+    if ((session == NULL) || (m == NULL) || (len == 0)) {
+        return CX_INVALID_PARAMETER;
+    }
+
+    error = cx_bn_lock(len, 0);
+    if (error != CX_OK) {
+        return error;
+    }
+    session->nbytes = len;
+    CX_CHECK(cx_mont_alloc(&session->mont, len));
+    CX_CHECK(cx_bn_init(session->mont.n, m, len));
+    CX_CHECK(cx_mont_init(&session->mont, session->mont.n));
+    return CX_OK;
+
+end:
+    cx_math_session_end(session);
+    return error;
+}
+
+cx_err_t cx_math_session_alloc(const cx_math_session_t *session, cx_bn_t *x)
+{
+    return cx_bn_alloc(x, session->nbytes);
+}
+
+cx_err_t cx_math_session_load(const cx_math_session_t *session,
+                              cx_bn_t                 *x,
+                              const uint8_t           *a,
+                              size_t                   len)
+{
+    cx_err_t error;
+    cx_bn_t  bn_a;
+
+    if (len > session->nbytes) {
+        return CX_INVALID_PARAMETER_SIZE;
+    }
+
+    CX_CHECK(cx_bn_alloc_init(&bn_a, session->nbytes, a, len));
+    error = cx_bn_alloc(x, session->nbytes);
+    if (error == CX_OK) {
+        error = cx_mont_to_montgomery(*x, bn_a, &session->mont);
+    }
+    cx_bn_destroy(&bn_a);
+
+end:
+    return error;
+}
+
+cx_err_t cx_math_session_store(const cx_math_session_t *session, uint8_t *r, const cx_bn_t x)
+{
+    cx_err_t error;
+    cx_bn_t  bn_r;
+
+    CX_CHECK(cx_bn_alloc(&bn_r, session->nbytes));
+    error = cx_mont_from_montgomery(bn_r, x, &session->mont);
+    if (error == CX_OK) {
+        error = cx_bn_export(bn_r, r, session->nbytes);
+    }
+    cx_bn_destroy(&bn_r);
+
+end:
+    return error;
+}
+
+cx_err_t cx_math_session_addm(const cx_math_session_t *session,
+                              cx_bn_t                  r,
+                              const cx_bn_t            a,
+                              const cx_bn_t            b)
+{
+    // Montgomery representation is linear: no conversion needed
+    return cx_bn_mod_add(r, a, b, session->mont.n);
+}
+
+cx_err_t cx_math_session_subm(const cx_math_session_t *session,
+                              cx_bn_t                  r,
+                              const cx_bn_t            a,
+                              const cx_bn_t            b)
+{
+    return cx_bn_mod_sub(r, a, b, session->mont.n);
+}
+
+cx_err_t cx_math_session_multm(const cx_math_session_t *session,
+                               cx_bn_t                  r,
+                               const cx_bn_t            a,
+                               const cx_bn_t            b)
+{
+    return cx_mont_mul(r, a, b, &session->mont);
+}
+
+cx_err_t cx_math_session_powm(const cx_math_session_t *session,
+                              cx_bn_t                  r,
+                              const cx_bn_t            a,
+                              const uint8_t           *e,
+                              size_t                   len_e)
+{
+    return cx_mont_pow(r, a, e, len_e, &session->mont);
+}
+
+cx_err_t cx_math_session_invprimem(const cx_math_session_t *session,
+                                   cx_bn_t                  r,
+                                   const cx_bn_t            a)
+{
+    return cx_mont_invert_nprime(r, a, &session->mont);
+}
+
+void cx_math_session_end(cx_math_session_t *session)
+{
+    // Unlocking erases every BN allocated during the session
+    cx_bn_unlock();
+    explicit_bzero(session, sizeof(cx_math_session_t));
+}
+
+#endif  // HAVE_MATH
@@ -0,0 +1,144 @@
+
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include <stdint.h>  // uint*_t
+#include <string.h>  // memcpy, explicit_bzero
+
+#include "bolos_target.h"
+#include "cx.h"
+#include "lib_cxng/src/cx_ram.h"
+
+#ifdef HAVE_SHA256
+
+// SHA-256 states after SHA-256(tag) || SHA-256(tag)
+const cx_sha256_tag_t cx_sha256_tag_bip340_aux = {{0x24dd3219,
+                                                   0x4eba7e70,
+                                                   0xca0fabb9,
+                                                   0x0fa3166d,
+                                                   0x3afbe4b1,
+                                                   0x4c44df97,
+                                                   0x4aac2739,
+                                                   0x249e850a}};
+
+const cx_sha256_tag_t cx_sha256_tag_bip340_nonce = {{0x46615b35,
+                                                     0xf4bfbff7,
+                                                     0x9f8dc671,
+                                                     0x83627ab3,
+                                                     0x60217180,
+                                                     0x57358661,
+                                                     0x21a29e54,
+                                                     0x68b07b4c}};
+
+const cx_sha256_tag_t cx_sha256_tag_bip340_challenge = {{0x9cecba11,
+                                                         0x23925381,
+                                                         0x11679112,
+                                                         0xd1627e0f,
+                                                         0x97c87550,
+                                                         0x003cc765,
+                                                         0x90f61164,
+                                                         0x33e9b66a}};
+
+const cx_sha256_tag_t cx_sha256_tag_tapleaf = {{0x9ce0e4e6,
+                                                0x7c116c39,
+                                                0x38b3caf2,
+                                                0xc30f5089,
+                                                0xd3f3936c,
+                                                0x47636e60,
+                                                0x7db33eea,
+                                                0xddc6f0c9}};
+
+const cx_sha256_tag_t cx_sha256_tag_tapbranch = {{0x23a865a9,
+                                                  0xb8a40da7,
+                                                  0x977c1e04,
+                                                  0xc49e246f,
+                                                  0xb5be1376,
+                                                  0x9d24c9b7,
+                                                  0xb583b5d4,
+                                                  0xa8d226d2}};
+
+const cx_sha256_tag_t cx_sha256_tag_taptweak = {{0xd129a2f3,
+                                                 0x701c655d,
+                                                 0x6583b6c3,
+                                                 0xb9419727,
+                                                 0x95f4e232,
+                                                 0x94fd54f4,
+                                                 0xa2ae8d85,
+                                                 0x47ca590b}};
+
+const cx_sha256_tag_t cx_sha256_tag_tapsighash = {{0xf504a425,
+                                                   0xd7f8783b,
+                                                   0x1363868a,
+                                                   0xe3e55658,
+                                                   0x6eee945d,
+                                                   0xbc7888dd,
+                                                   0x02a6e2c3,
+                                                   0x1873fe9f}};
+
+cx_err_t cx_sha256_tag_init(cx_sha256_tag_t *tag, const uint8_t *name, size_t name_len)
+{
+    cx_err_t    error;
+    cx_sha256_t hash;
+    uint8_t     tag_hash[CX_SHA256_SIZE];
+
+    if ((tag == NULL) || ((name == NULL) && (name_len != 0))) {
+        return CX_INVALID_PARAMETER;
+    }
+
+    CX_CHECK(cx_sha256_hash(name, name_len, tag_hash));
+    cx_sha256_init_no_throw(&hash);
+    CX_CHECK(cx_hash_update(&hash.header, tag_hash, sizeof(tag_hash)));
+    CX_CHECK(cx_hash_update(&hash.header, tag_hash, sizeof(tag_hash)));
+    // The block is full, hence already compressed into the accumulator
+    memcpy(tag->acc, hash.acc, sizeof(tag->acc));
+
+end:
+    explicit_bzero(&hash, sizeof(hash));
+    return error;
+}
+
+cx_err_t cx_sha256_tagged_init(cx_sha256_t *hash, const cx_sha256_tag_t *tag)
+{
+    cx_sha256_init_no_throw(hash);
+    memcpy(hash->acc, tag->acc, sizeof(hash->acc));
+    hash->header.counter = 1;
+    return CX_OK;
+}
+
+cx_err_t cx_sha256_tagged_hash_iovec(const cx_sha256_tag_t *tag,
+                                     const cx_iovec_t      *iovec,
+                                     size_t                 iovec_len,
+                                     uint8_t                digest[static CX_SHA256_SIZE])
+{
+    cx_err_t error;
+#ifdef TARGET_NANOS
+    cx_sha256_t *hash = &G_cx.sha256;
+#else
+    cx_sha256_t  sha256;
+    cx_sha256_t *hash = &sha256;
+#endif
+
+    cx_sha256_tagged_init(hash, tag);
+    for (size_t i = 0; i < iovec_len; i++) {
+        CX_CHECK(cx_hash_update(&hash->header, iovec[i].iov_base, iovec[i].iov_len));
+    }
+    CX_CHECK(cx_hash_final(&hash->header, digest));
+
+end:
+    explicit_bzero(hash, sizeof(cx_sha256_t));
+    return error;
+}
+
+#endif  // HAVE_SHA256
@@ -0,0 +1,147 @@
+
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+#ifdef HAVE_IO_LATENCY
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "io_latency.h"
+#include "os_io_seproxyhal.h"
+#include "os_utils.h"
+
+_Static_assert(IO_LATENCY_SLOTS > 1 && IO_LATENCY_SLOTS < 256,
+               "The dump APDU response gives the slot count on 1 byte");
+_Static_assert(IO_LATENCY_BUCKETS > 1 && 2 + IO_LATENCY_SLOT_SIZE <= 255,
+               "A slot must fit the dump APDU response");
+
+static io_latency_slot_t G_io_latency[IO_LATENCY_SLOTS];
+
+// Slot of the command being processed, NULL between the reply and the next command
+static io_latency_slot_t *G_io_latency_current;
+static uint32_t           G_io_latency_start;
+// The next command may be received while replying to the current one
+static bool     G_io_latency_rx_started;
+static uint32_t G_io_latency_rx_start;
+
+__attribute__((weak)) uint32_t io_latency_get_ticks(void)
+{
+    return G_io_app.ms;
+}
+
+static void io_latency_record(io_latency_phase_t phase, uint32_t duration)
+{
+    uint8_t   bucket   = 0;
+    uint16_t *counters = G_io_latency_current->histograms[phase];
+
+    while ((duration != 0) && (bucket < IO_LATENCY_BUCKETS - 1)) {
+        duration >>= 1;
+        bucket++;
+    }
+    if (counters[bucket] != 0xFFFF) {
+        counters[bucket]++;
+    }
+}
+
+static io_latency_slot_t *io_latency_slot(uint8_t ins)
+{
+    io_latency_slot_t *other = &G_io_latency[IO_LATENCY_SLOTS - 1];
+
+    for (unsigned int i = 0; i < IO_LATENCY_SLOTS - 1; i++) {
+        if (G_io_latency[i].used == IO_LATENCY_SLOT_FREE) {
+            G_io_latency[i].used = IO_LATENCY_SLOT_INS;
+            G_io_latency[i].ins  = ins;
+        }
+        if (G_io_latency[i].ins == ins) {
+            return &G_io_latency[i];
+        }
+    }
+    other->used = IO_LATENCY_SLOT_OTHER;
+    other->ins  = 0xFF;
+    return other;
+}
+
+void io_latency_rx_start(void)
+{
+    G_io_latency_rx_started = true;
+    G_io_latency_rx_start   = io_latency_get_ticks();
+}
+
+void io_latency_rx_done(uint8_t ins)
+{
+    uint32_t now = io_latency_get_ticks();
+
+    G_io_latency_current = io_latency_slot(ins);
+    // the start is unknown over the transports not reporting the first chunk
+    if (G_io_latency_rx_started) {
+        io_latency_record(IO_LATENCY_RECEPTION, now - G_io_latency_rx_start);
+    }
+    G_io_latency_rx_started = false;
+    G_io_latency_start      = now;
+}
+
+void io_latency_tx_start(void)
+{
+    uint32_t now = io_latency_get_ticks();
+
+    // the replies of the default APDUs aren't recorded
+    if (G_io_latency_current == NULL) {
+        return;
+    }
+    io_latency_record(IO_LATENCY_HANDLER, now - G_io_latency_start);
+    G_io_latency_start = now;
+}
+
+void io_latency_tx_done(void)
+{
+    if (G_io_latency_current == NULL) {
+        return;
+    }
+    io_latency_record(IO_LATENCY_REPLY, io_latency_get_ticks() - G_io_latency_start);
+    G_io_latency_current = NULL;
+}
+
+void io_latency_clear(void)
+{
+    memset(G_io_latency, 0, sizeof(G_io_latency));
+    G_io_latency_current    = NULL;
+    G_io_latency_rx_started = false;
+}
+
+uint16_t io_latency_dump(uint8_t slot, uint8_t *out, uint16_t out_len)
+{
+    uint16_t len = 2;
+
+    if ((slot >= IO_LATENCY_SLOTS) || (out_len < 2 + IO_LATENCY_SLOT_SIZE)) {
+        return 0;
+    }
+
+    out[0]     = IO_LATENCY_SLOTS;
+    out[1]     = IO_LATENCY_BUCKETS;
+    out[len++] = G_io_latency[slot].used;
+    out[len++] = G_io_latency[slot].ins;
+    for (unsigned int phase = 0; phase < IO_LATENCY_PHASES; phase++) {
+        for (unsigned int bucket = 0; bucket < IO_LATENCY_BUCKETS; bucket++) {
+            U2BE_ENCODE(out, len, G_io_latency[slot].histograms[phase][bucket]);
+            len += 2;
+        }
+    }
+    return len;
+}
+
+#endif  // HAVE_IO_LATENCY
@@ -25,6 +25,7 @@
 #include "os_io_seproxyhal.h"
 
 #include "ledger_protocol.h"
+#include "io_latency.h"
 
 /* Private enumerations ------------------------------------------------------*/
 
@@ -37,17 +38,28 @@
 #define TAG_ABORT                (0x03)
 #define TAG_APDU                 (0x05)
 #define TAG_MTU                  (0x08)
+#define TAG_COMPRESSION          (0x09)
+#define TAG_APDU_COMPRESSED      (0x0A)
 
 /* Private macros-------------------------------------------------------------*/
 
 /* Private functions prototypes ----------------------------------------------*/
 static void process_apdu_chunk(uint8_t *buffer, uint16_t length);
+static void process_mtu(uint8_t *buffer, uint16_t length);
+static void bound_mtu(void);
+#ifdef HAVE_APDU_COMPRESSION
+static void process_compressed_apdu_chunk(uint8_t *buffer, uint16_t length);
+#endif  // HAVE_APDU_COMPRESSION
+static void copy_tx_data(uint8_t *buffer, uint16_t length);
+static void build_tx_chunk(void);
 
 /* Exported variables --------------------------------------------------------*/
 
 /* Private variables ---------------------------------------------------------*/
 static const uint8_t protocol_version[4] = {0x00, 0x00, 0x00, 0x00};
 
+CCASSERT(ledger_protocol_chunk, LEDGER_PROTOCOL_CHUNK_SIZE >= LEDGER_PROTOCOL_MTU_MIN);
+
 static ledger_protocol_t *ledger_protocol;
 
 /* Private functions ---------------------------------------------------------*/
@@ -75,10 +87,23 @@ static void process_apdu_chunk(uint8_t *buffer, uint16_t length)
             return;
         }
         ledger_protocol->rx_apdu_offset = 0;
-        buffer                          = &buffer[4];
+#ifdef HAVE_APDU_COMPRESSION
+        ledger_protocol->rx_compressed_length = 0;
+#endif  // HAVE_APDU_COMPRESSION
+#ifdef HAVE_IO_LATENCY
+        io_latency_rx_start();
+#endif  // HAVE_IO_LATENCY
+        buffer = &buffer[4];
         length -= 4;
     }
     else {
+#ifdef HAVE_APDU_COMPRESSION
+        // Don't mix chunks of a compressed command
+        if (ledger_protocol->rx_compressed_length != 0) {
+            ledger_protocol->rx_apdu_status = APDU_STATUS_WAITING;
+            return;
+        }
+#endif  // HAVE_APDU_COMPRESSION
         // Next chunk
         buffer = &buffer[2];
         length -= 2;
@@ -102,12 +127,197 @@ static void process_apdu_chunk(uint8_t *buffer, uint16_t length)
     }
 }
 
+#ifdef HAVE_APDU_COMPRESSION
+static void process_compressed_apdu_chunk(uint8_t *buffer, uint16_t length)
+{
+    // Check the sequence number
+    if ((length < 2) || ((uint16_t) U2BE(buffer, 0) != ledger_protocol->rx_apdu_sequence_number)) {
+        goto error;
+    }
+
+    if (ledger_protocol->rx_apdu_sequence_number == 0) {
+        // First chunk, check the decompressed length and the compressed one, which bounds the
+        // decompression work
+        if ((length < 6) || (U2BE(buffer, 2) > ledger_protocol->rx_apdu_buffer_max_length)
+            || (U2BE(buffer, 4) == 0)
+            || (U2BE(buffer, 4) > LZSS_MAX_COMPRESSED_LENGTH(U2BE(buffer, 2)))) {
+            goto error;
+        }
+        ledger_protocol->rx_apdu_length       = U2BE(buffer, 2);
+        ledger_protocol->rx_apdu_offset       = 0;
+        ledger_protocol->rx_compressed_length = U2BE(buffer, 4);
+        ledger_protocol->rx_compressed_offset = 0;
+        lzss_init(&ledger_protocol->rx_lzss,
+                  ledger_protocol->rx_apdu_buffer,
+                  ledger_protocol->rx_apdu_length);
+#ifdef HAVE_IO_LATENCY
+        io_latency_rx_start();
+#endif  // HAVE_IO_LATENCY
+        buffer = &buffer[6];
+        length -= 6;
+    }
+    else {
+        // Next chunk
+        if (ledger_protocol->rx_compressed_length == 0) {
+            goto error;
+        }
+        buffer = &buffer[2];
+        length -= 2;
+    }
+
+    length = MIN(length,
+                 ledger_protocol->rx_compressed_length - ledger_protocol->rx_compressed_offset);
+    if (!lzss_decompress(&ledger_protocol->rx_lzss, buffer, length)) {
+        goto error;
+    }
+    ledger_protocol->rx_compressed_offset += length;
+    ledger_protocol->rx_apdu_offset = ledger_protocol->rx_lzss.out_offset;
+
+    if (ledger_protocol->rx_compressed_offset == ledger_protocol->rx_compressed_length) {
+        if (!lzss_finished(&ledger_protocol->rx_lzss)) {
+            goto error;
+        }
+        ledger_protocol->rx_compressed_length    = 0;
+        ledger_protocol->rx_apdu_sequence_number = 0;
+        ledger_protocol->rx_apdu_status          = APDU_STATUS_COMPLETE;
+        PRINTF("APDU COMPLETE\n");
+    }
+    else {
+        ledger_protocol->rx_apdu_sequence_number++;
+        ledger_protocol->rx_apdu_status = APDU_STATUS_NEED_MORE_DATA;
+        PRINTF("APDU NEED MORE DATA\n");
+    }
+    return;
+
+error:
+    ledger_protocol->rx_compressed_length    = 0;
+    ledger_protocol->rx_apdu_sequence_number = 0;
+    ledger_protocol->rx_apdu_status          = APDU_STATUS_WAITING;
+}
+#endif  // HAVE_APDU_COMPRESSION
+
+static void process_mtu(uint8_t *buffer, uint16_t length)
+{
+    bool accepted = false;
+
+    // The host may propose an MTU, which is bounded by the chunk size and the link. The legacy
+    // hosts send 4 zero bytes, i.e. no proposal.
+    if (length >= 5) {
+        uint16_t mtu = U2BE(buffer, 3);
+
+        if (mtu >= LEDGER_PROTOCOL_MTU_MIN) {
+            ledger_protocol->mtu            = mtu;
+            ledger_protocol->mtu_negotiated = 1;
+            accepted                        = true;
+        }
+    }
+    bound_mtu();
+
+    // <length (4B)> <mtu>, the mtu being encoded on one byte when possible if no proposal was
+    // accepted, for the legacy hosts which read it so
+    ledger_protocol->chunk[2] = TAG_MTU;
+    ledger_protocol->chunk[3] = 0x00;
+    ledger_protocol->chunk[4] = 0x00;
+    ledger_protocol->chunk[5] = 0x00;
+    if (!accepted && (ledger_protocol->mtu <= 0xFF)) {
+        ledger_protocol->chunk[6]     = 0x01;
+        ledger_protocol->chunk[7]     = ledger_protocol->mtu;
+        ledger_protocol->chunk_length = 8;
+    }
+    else {
+        ledger_protocol->chunk[6] = 0x02;
+        U2BE_ENCODE(ledger_protocol->chunk, 7, ledger_protocol->mtu);
+        ledger_protocol->chunk_length = 9;
+    }
+}
+
+// Keeps the MTU and its bound within [LEDGER_PROTOCOL_MTU_MIN, chunk size], the frame header
+// being subtracted from them when building a frame
+static void bound_mtu(void)
+{
+    uint16_t max = sizeof(ledger_protocol->chunk);
+
+    if (ledger_protocol->mtu_max != 0) {
+        ledger_protocol->mtu_max = MAX(ledger_protocol->mtu_max, LEDGER_PROTOCOL_MTU_MIN);
+        max                      = MIN(max, ledger_protocol->mtu_max);
+    }
+    ledger_protocol->mtu = MAX(MIN(ledger_protocol->mtu, max), LEDGER_PROTOCOL_MTU_MIN);
+}
+
+static void copy_tx_data(uint8_t *buffer, uint16_t length)
+{
+#ifdef HAVE_IO_SCATTER_GATHER
+    if (ledger_protocol->tx_iov_count) {
+        ledger_protocol->tx_apdu_offset += length;
+        while (length && (ledger_protocol->tx_iov_index < ledger_protocol->tx_iov_count)) {
+            const io_iovec_t *iov = &ledger_protocol->tx_iov[ledger_protocol->tx_iov_index];
+            uint16_t          len = MIN(length, iov->len - ledger_protocol->tx_iov_offset);
+
+            memcpy(buffer, &iov->ptr[ledger_protocol->tx_iov_offset], len);
+            buffer += len;
+            length -= len;
+            ledger_protocol->tx_iov_offset += len;
+            if (ledger_protocol->tx_iov_offset == iov->len) {
+                ledger_protocol->tx_iov_index++;
+                ledger_protocol->tx_iov_offset = 0;
+            }
+        }
+        return;
+    }
+#endif  // HAVE_IO_SCATTER_GATHER
+    memcpy(buffer, &ledger_protocol->tx_apdu_buffer[ledger_protocol->tx_apdu_offset], length);
+    ledger_protocol->tx_apdu_offset += length;
+}
+
+static void build_tx_chunk(void)
+{
+    uint16_t chunk_offset = 2;  // Because channel id has been already filled beforehand
+    uint16_t mtu          = ledger_protocol->mtu;
+
+    ledger_protocol->chunk[chunk_offset++] = TAG_APDU;
+
+    U2BE_ENCODE(ledger_protocol->chunk, chunk_offset, ledger_protocol->tx_apdu_sequence_number);
+    chunk_offset += 2;
+
+    if (ledger_protocol->tx_apdu_sequence_number == 0) {
+        U2BE_ENCODE(ledger_protocol->chunk, chunk_offset, ledger_protocol->tx_apdu_length);
+        chunk_offset += 2;
+    }
+    if ((ledger_protocol->tx_apdu_length + chunk_offset)
+        > (mtu + ledger_protocol->tx_apdu_offset)) {
+        // Remaining buffer length doesn't fit the chunk
+        copy_tx_data(&ledger_protocol->chunk[chunk_offset], mtu - chunk_offset);
+        ledger_protocol->tx_apdu_sequence_number++;
+        chunk_offset = mtu;
+    }
+    else {
+        // Remaining buffer fits the chunk TODO pad for usb
+        uint16_t length = ledger_protocol->tx_apdu_length - ledger_protocol->tx_apdu_offset;
+
+        copy_tx_data(&ledger_protocol->chunk[chunk_offset], length);
+        chunk_offset += length;
+        ledger_protocol->tx_apdu_buffer = NULL;
+#ifdef HAVE_IO_SCATTER_GATHER
+        ledger_protocol->tx_iov_count = 0;
+#endif  // HAVE_IO_SCATTER_GATHER
+    }
+    ledger_protocol->chunk_length = chunk_offset;
+    PRINTF(" %d\n", ledger_protocol->chunk_length);
+}
+
 /* Exported functions --------------------------------------------------------*/
 void LEDGER_PROTOCOL_init(ledger_protocol_t *data)
 {
     ledger_protocol                          = data;
     ledger_protocol->rx_apdu_status          = APDU_STATUS_WAITING;
     ledger_protocol->rx_apdu_sequence_number = 0;
+    bound_mtu();
+}
+
+void LEDGER_PROTOCOL_set_mtu_max(uint16_t mtu_max)
+{
+    ledger_protocol->mtu_max = mtu_max;
+    bound_mtu();
 }
 
 void LEDGER_PROTOCOL_rx(uint8_t *buffer, uint16_t length)
@@ -148,15 +358,23 @@ void LEDGER_PROTOCOL_rx(uint8_t *buffer, uint16_t length)
 
         case TAG_MTU:
             PRINTF("TAG_MTU\n");
-            ledger_protocol->chunk[2]     = TAG_MTU;
-            ledger_protocol->chunk[3]     = 0x00;
-            ledger_protocol->chunk[4]     = 0x00;
-            ledger_protocol->chunk[5]     = 0x00;
-            ledger_protocol->chunk[6]     = 0x01;
-            ledger_protocol->chunk[7]     = ledger_protocol->mtu;
-            ledger_protocol->chunk_length = 8;
+            process_mtu(buffer, length);
             break;
 
+#ifdef HAVE_APDU_COMPRESSION
+        case TAG_COMPRESSION:
+            PRINTF("TAG_COMPRESSION\n");
+            ledger_protocol->chunk[2]     = TAG_COMPRESSION;
+            ledger_protocol->chunk[3]     = LZSS_CAPABILITY;
+            ledger_protocol->chunk_length = 4;
+            break;
+
+        case TAG_APDU_COMPRESSED:
+            PRINTF("TAG_APDU_COMPRESSED\n");
+            process_compressed_apdu_chunk(&buffer[3], length - 3);
+            break;
+#endif  // HAVE_APDU_COMPRESSION
+
         default:
             // Unsupported command
             break;
@@ -174,41 +392,48 @@ void LEDGER_PROTOCOL_tx(uint8_t *buffer, uint16_t length)
         ledger_protocol->tx_apdu_length          = length;
         ledger_protocol->tx_apdu_sequence_number = 0;
         ledger_protocol->tx_apdu_offset          = 0;
+#ifdef HAVE_IO_SCATTER_GATHER
+        ledger_protocol->tx_iov_count = 0;
+#endif  // HAVE_IO_SCATTER_GATHER
     }
     else {
         PRINTF("NEXT CHUNK");
     }
 
-    uint16_t chunk_offset = 2;  // Because channel id has been already filled beforehand
-
-    ledger_protocol->chunk[chunk_offset++] = TAG_APDU;
+    build_tx_chunk();
+}
 
-    U2BE_ENCODE(ledger_protocol->chunk, chunk_offset, ledger_protocol->tx_apdu_sequence_number);
-    chunk_offset += 2;
+#ifdef HAVE_IO_SCATTER_GATHER
+void LEDGER_PROTOCOL_tx_iov(const io_iovec_t *iov, uint8_t count)
+{
+    uint32_t length = 0;
 
-    if (ledger_protocol->tx_apdu_sequence_number == 0) {
-        U2BE_ENCODE(ledger_protocol->chunk, chunk_offset, ledger_protocol->tx_apdu_length);
-        chunk_offset += 2;
+    if (!iov || (count > IO_IOVEC_MAX)) {
+        return;
     }
-    if ((ledger_protocol->tx_apdu_length + chunk_offset)
-        >= (ledger_protocol->mtu + ledger_protocol->tx_apdu_offset)) {
-        // Remaining buffer length doesn't fit the chunk
-        memcpy(&ledger_protocol->chunk[chunk_offset],
-               &ledger_protocol->tx_apdu_buffer[ledger_protocol->tx_apdu_offset],
-               ledger_protocol->mtu - chunk_offset);
-        ledger_protocol->tx_apdu_offset += ledger_protocol->mtu - chunk_offset;
-        ledger_protocol->tx_apdu_sequence_number++;
-        chunk_offset = ledger_protocol->mtu;
+
+    // keep the non empty buffers only
+    ledger_protocol->tx_iov_count = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (iov[i].len != 0) {
+            ledger_protocol->tx_iov[ledger_protocol->tx_iov_count++] = iov[i];
+            length += iov[i].len;
+        }
     }
-    else {
-        // Remaining buffer fits the chunk TODO pad for usb
-        memcpy(&ledger_protocol->chunk[chunk_offset],
-               &ledger_protocol->tx_apdu_buffer[ledger_protocol->tx_apdu_offset],
-               ledger_protocol->tx_apdu_length - ledger_protocol->tx_apdu_offset);
-        chunk_offset += (ledger_protocol->tx_apdu_length - ledger_protocol->tx_apdu_offset);
-        ledger_protocol->tx_apdu_offset = ledger_protocol->tx_apdu_length;
-        ledger_protocol->tx_apdu_buffer = NULL;
+    if (length > 0xFFFF) {
+        ledger_protocol->tx_iov_count = 0;
+        return;
     }
-    ledger_protocol->chunk_length = chunk_offset;
-    PRINTF(" %d\n", ledger_protocol->chunk_length);
-}
\ No newline at end of file
+
+    PRINTF("FIRST CHUNK");
+    // tx_apdu_buffer only tells whether chunks remain to be sent
+    ledger_protocol->tx_apdu_buffer          = ledger_protocol->chunk;
+    ledger_protocol->tx_apdu_length          = length;
+    ledger_protocol->tx_apdu_sequence_number = 0;
+    ledger_protocol->tx_apdu_offset          = 0;
+    ledger_protocol->tx_iov_index            = 0;
+    ledger_protocol->tx_iov_offset           = 0;
+
+    build_tx_chunk();
+}
+#endif  // HAVE_IO_SCATTER_GATHER
@@ -0,0 +1,82 @@
+
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+#ifdef HAVE_APDU_COMPRESSION
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lzss.h"
+
+void lzss_init(lzss_ctx_t *ctx, uint8_t *out, uint16_t out_length)
+{
+    ctx->out         = out;
+    ctx->out_length  = out_length;
+    ctx->out_offset  = 0;
+    ctx->flags       = 0;
+    ctx->flags_count = 0;
+    ctx->reference   = 0;
+    ctx->pending     = false;
+}
+
+bool lzss_decompress(lzss_ctx_t *ctx, const uint8_t *in, uint16_t in_length)
+{
+    for (uint16_t i = 0; i < in_length; i++) {
+        if (ctx->pending) {
+            uint16_t reference = (ctx->reference << 8) | in[i];
+            uint16_t offset    = (reference >> 4) + 1;
+            uint16_t length    = (reference & 0x0F) + LZSS_MIN_MATCH;
+
+            ctx->pending = false;
+            if ((offset > ctx->out_offset) || (length > ctx->out_length - ctx->out_offset)) {
+                return false;
+            }
+            // the source may overlap the destination, hence the bytewise copy
+            while (length--) {
+                ctx->out[ctx->out_offset] = ctx->out[ctx->out_offset - offset];
+                ctx->out_offset++;
+            }
+        }
+        else if (ctx->flags_count == 0) {
+            ctx->flags       = in[i];
+            ctx->flags_count = 8;
+        }
+        else {
+            if (ctx->flags & 1) {
+                if (ctx->out_offset >= ctx->out_length) {
+                    return false;
+                }
+                ctx->out[ctx->out_offset++] = in[i];
+            }
+            else {
+                ctx->reference = in[i];
+                ctx->pending   = true;
+            }
+            ctx->flags >>= 1;
+            ctx->flags_count--;
+        }
+    }
+
+    return true;
+}
+
+bool lzss_finished(const lzss_ctx_t *ctx)
+{
+    return (ctx->out_offset == ctx->out_length) && !ctx->pending;
+}
+
+#endif  // HAVE_APDU_COMPRESSION
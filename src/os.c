@@ -22,6 +22,7 @@
 #include "os_io.h"
 #include "os_utils.h"
 #include "os.h"
+#include <stdint.h>
 #include <string.h>
 
 #ifndef HAVE_LOCAL_APDU_BUFFE
@@ -47,41 +48,87 @@ void os_memset4(void *dst, unsigned int initval, unsigned int nbintval)
     }
 }
 
+/*
+ * Buffers sharing the same alignment are processed one 32-bit word at a time,
+ * apart from the unaligned head and tail bytes. The execution time only depends
+ * on the length and on the alignment of the buffers, never on their content.
+ */
+typedef uint32_t __attribute__((may_alias)) os_word_t;
+
+#define OS_WORD_SIZE          sizeof(os_word_t)
+#define OS_WORD_OFFSET(p)     (((uintptr_t) (p)) & (OS_WORD_SIZE - 1))
+#define OS_SAME_ALIGN(p1, p2) (OS_WORD_OFFSET(((uintptr_t) (p1)) ^ ((uintptr_t) (p2))) == 0)
+
+/*
+ * os_xor goes from the end to the start, as it always did, so that callers with
+ * overlapping buffers get the same result. Since the words are only used when
+ * the buffers share the same alignment, they never partially overlap, and going
+ * word by word gives the same result as going byte by byte.
+ */
 void os_xor(void *dst, void *src1, void *src2, unsigned int length)
 {
-#define SRC1 ((unsigned char const *) src1)
-#define SRC2 ((unsigned char const *) src2)
-#define DST  ((unsigned char *) dst)
-    unsigned int l = length;
-    // don't || to ensure all condition are evaluated
-    while (!(!length && !l)) {
-        length--;
-        DST[length] = SRC1[length] ^ SRC2[length];
+    unsigned char       *d  = dst;
+    unsigned char const *s1 = src1;
+    unsigned char const *s2 = src2;
+    unsigned int         i  = length;
+    unsigned int         l  = length;
+
+    if (OS_SAME_ALIGN(d, s1) && OS_SAME_ALIGN(d, s2)) {
+        while ((i > 0) && (OS_WORD_OFFSET(d + i) != 0)) {
+            i--;
+            l--;
+            d[i] = s1[i] ^ s2[i];
+        }
+        while (i >= OS_WORD_SIZE) {
+            i -= OS_WORD_SIZE;
+            l -= OS_WORD_SIZE;
+            *(os_word_t *) (d + i) = *(os_word_t const *) (s1 + i) ^ *(os_word_t const *) (s2 + i);
+        }
+    }
+    while (i > 0) {
+        i--;
         l--;
+        d[i] = s1[i] ^ s2[i];
     }
     // WHAT ??? glitch detected ?
-    if (*((volatile unsigned int *) &l) != *((volatile unsigned int *) &length)) {
+    if ((*(volatile unsigned int *) &l != 0) || (*(volatile unsigned int *) &i != 0)) {
         THROW(EXCEPTION);
     }
 }
 
 char os_secure_memcmp(void *src1, void *src2, unsigned int length)
 {
-#define SRC1 ((unsigned char const *) src1)
-#define SRC2 ((unsigned char const *) src2)
-    unsigned int  l      = length;
-    unsigned char xoracc = 0;
-    // don't || to ensure all condition are evaluated
-    while (!(!length && !l)) {
-        length--;
-        xoracc |= SRC1[length] ^ SRC2[length];
+    unsigned char const *s1     = src1;
+    unsigned char const *s2     = src2;
+    unsigned int         i      = 0;
+    unsigned int         l      = length;
+    os_word_t            xoracc = 0;
+
+    if (OS_SAME_ALIGN(s1, s2)) {
+        while ((i < length) && (OS_WORD_OFFSET(s1 + i) != 0)) {
+            xoracc |= s1[i] ^ s2[i];
+            i++;
+            l--;
+        }
+        while (length - i >= OS_WORD_SIZE) {
+            xoracc |= *(os_word_t const *) (s1 + i) ^ *(os_word_t const *) (s2 + i);
+            i += OS_WORD_SIZE;
+            l -= OS_WORD_SIZE;
+        }
+    }
+    while (i < length) {
+        xoracc |= s1[i] ^ s2[i];
+        i++;
         l--;
     }
     // WHAT ??? glitch detected ?
-    if (*(volatile unsigned int *) &l != *(volatile unsigned int *) &length) {
+    if ((*(volatile unsigned int *) &l != 0) || (*(volatile unsigned int *) &i != length)) {
         THROW(EXCEPTION);
     }
-    return xoracc;
+    // Same result as a byte-wise accumulation
+    xoracc |= xoracc >> 16;
+    xoracc |= xoracc >> 8;
+    return (char) (xoracc & 0xFF);
 }
 
 #ifndef HAVE_BOLOS
@@ -98,9 +98,23 @@ extern USBD_HandleTypeDef USBD_Device;
 #define DEFAULT_APDU_INS_STACK_CONSUMPTION 0x57
 #endif  // DEBUG_OS_STACK_CONSUMPTION
 
+#if defined(HAVE_SYSCALL_TRACE)
+#define DEFAULT_APDU_INS_SYSCALL_TRACE 0x5C
+#endif  // HAVE_SYSCALL_TRACE
+#if defined(HAVE_IO_LATENCY)
+#define DEFAULT_APDU_INS_IO_LATENCY 0x5D
+#endif  // HAVE_IO_LATENCY
+
 #define DEFAULT_APDU_INS_APP_EXIT 0xA7
 #endif  // !HAVE_BOLOS_NO_DEFAULT_APDU
 
+#ifdef HAVE_SYSCALL_TRACE
+#include "syscall_trace.h"
+#endif  // HAVE_SYSCALL_TRACE
+#ifdef HAVE_IO_LATENCY
+#include "io_latency.h"
+#endif  // HAVE_IO_LATENCY
+
 void io_seproxyhal_handle_ble_event(void);
 
 unsigned int os_io_seph_recv_and_process(unsigned int dont_process_ux_events);
@@ -109,6 +123,57 @@ unsigned int os_io_seph_recv_and_process(unsigned int dont_process_ux_events);
 io_seph_app_t G_io_app;
 #endif  // ! HAVE_BOLOS
 
+#ifdef HAVE_IO_PIPELINE
+unsigned char G_io_apdu_buffer_next[IO_APDU_BUFFER_SIZE];
+
+/**
+ * Moves the next command, if completely received, to the APDU buffer.
+ * Returns true when a command is available
+ */
+static bool io_pipeline_pop(void)
+{
+    if (G_io_app.pipeline_length == 0) {
+        return false;
+    }
+    memcpy(G_io_apdu_buffer, G_io_apdu_buffer_next, G_io_app.pipeline_length);
+    G_io_app.apdu_media  = G_io_app.pipeline_media;
+    G_io_app.apdu_state  = APDU_USB_HID;
+    G_io_app.apdu_length = G_io_app.pipeline_length;
+#ifdef HAVE_WEBUSB
+    if (G_io_app.pipeline_media == IO_APDU_MEDIA_USB_WEBUSB) {
+        G_io_app.apdu_state = APDU_USB_WEBUSB;
+    }
+#endif  // HAVE_WEBUSB
+    G_io_app.pipeline_length = 0;
+    return true;
+}
+
+/**
+ * Rearms the OUT endpoint left unarmed while the next command was pending, once it has been
+ * moved to the APDU buffer. The host is NAKed meanwhile, instead of its chunks being dropped.
+ * To be called when the MCU awaits commands, after an event
+ */
+static void io_pipeline_resume(void)
+{
+    if ((G_io_app.pipeline_paused_ep == 0) || (G_io_app.pipeline_length != 0)) {
+        return;
+    }
+    USBD_LL_PrepareReceive(&USBD_Device, G_io_app.pipeline_paused_ep, IO_HID_EP_LENGTH);
+    G_io_app.pipeline_paused_ep = 0;
+}
+
+/**
+ * Drops the next command, and receives the commands in G_io_apdu_buffer again until io_exchange
+ * is called with IO_PIPELINE
+ */
+static void io_pipeline_reset(void)
+{
+    G_io_app.pipeline        = false;
+    G_io_app.pipeline_length = 0;
+    io_pipeline_resume();
+}
+#endif  // HAVE_IO_PIPELINE
+
 #if defined(HAVE_BAGL) || defined(HAVE_NBGL)
 ux_seph_os_and_app_t G_ux_os;
 #endif
@@ -146,6 +211,14 @@ void io_seproxyhal_handle_usb_event(void)
         case SEPROXYHAL_TAG_USB_EVENT_RESET:
             USBD_LL_SetSpeed(&USBD_Device, USBD_SPEED_FULL);
             USBD_LL_Reset(&USBD_Device);
+#ifdef HAVE_IO_PIPELINE
+            // drop the next command, the host will send it again. The endpoints are armed again
+            // when the host configures the device
+            G_io_app.pipeline           = false;
+            G_io_app.pipeline_length    = 0;
+            G_io_app.pipeline_paused_ep = 0;
+            io_usb_hid_init();
+#endif  // HAVE_IO_PIPELINE
             // ongoing APDU detected, throw a reset, even if not the media. to avoid potential
             // troubles.
             if (G_io_app.apdu_media != IO_APDU_MEDIA_NONE) {
@@ -244,6 +317,10 @@ unsigned int io_seproxyhal_handle_event(void)
     unsigned int rx_len = U2BE(G_io_seproxyhal_spi_buffer, 1);
 #endif
 
+#ifdef HAVE_IO_PIPELINE
+    io_pipeline_resume();
+#endif  // HAVE_IO_PIPELINE
+
     switch (G_io_seproxyhal_spi_buffer[0]) {
 #ifdef HAVE_IO_USB
         case SEPROXYHAL_TAG_USB_EVENT:
@@ -314,7 +391,7 @@ unsigned int io_seproxyhal_handle_event(void)
 }
 
 // #define DEBUG_APDU
-#ifdef DEBUG_APDU
+#if defined(DEBUG_APDU) && !defined(DEBUG_APDU_REPLAY)
 volatile unsigned int debug_apdus_offset;
 const char            debug_apdus[] = {
     5,
@@ -325,7 +402,24 @@ const char            debug_apdus[] = {
     0x00,
     // 9, 0xe0, 0x22, 0x00, 0x00, 0x04, 0x31, 0x32, 0x33, 0x34,
 };
-#endif  // DEBUG_APDU
+
+// Fetches the next APDU of the compiled-in blob, 0 once all have been replayed
+static unsigned short debug_apdu_next(unsigned char *buffer, unsigned short max_length)
+{
+    unsigned short length;
+
+    if (debug_apdus_offset >= sizeof(debug_apdus)) {
+        return 0;
+    }
+    length = debug_apdus[debug_apdus_offset] & 0xFF;
+    if (length > max_length) {
+        THROW(INVALID_PARAMETER);
+    }
+    memcpy(buffer, &debug_apdus[debug_apdus_offset + 1], length);
+    debug_apdus_offset += length + 1;
+    return length;
+}
+#endif  // DEBUG_APDU && !DEBUG_APDU_REPLAY
 
 #ifdef HAVE_BOLOS_APP_STACK_CANARY
 #define APP_STACK_CANARY_MAGIC 0xDEAD0031
@@ -369,9 +463,9 @@ void io_seproxyhal_init(void)
 
     G_io_app.ms = 0;
 
-#ifdef DEBUG_APDU
+#if defined(DEBUG_APDU) && !defined(DEBUG_APDU_REPLAY)
     debug_apdus_offset = 0;
-#endif  // DEBUG_APDU
+#endif  // DEBUG_APDU && !DEBUG_APDU_REPLAY
 
 #ifdef HAVE_USB_APDU
     io_usb_hid_init();
@@ -387,12 +481,28 @@ void io_seproxyhal_init(void)
 
 #ifdef HAVE_BAGL
 
+#ifdef HAVE_DISPLAY_BATCH
+// Elements packed in a single SEPROXYHAL status, within the UX display loops
+#ifndef IO_DISPLAY_BATCH_SIZE
+#define IO_DISPLAY_BATCH_SIZE (IO_SEPROXYHAL_BUFFER_SIZE_B - 3)
+#endif  // IO_DISPLAY_BATCH_SIZE
+
+static bool           G_io_display_batch_enabled;
+static bool           G_io_display_batch_direct;  // the element is sent along with the batch
+static unsigned short G_io_display_batch_length;
+static unsigned char  G_io_display_batch[IO_DISPLAY_BATCH_SIZE];
+#endif  // HAVE_DISPLAY_BATCH
+
 void io_seproxyhal_init_ux(void)
 {
 #ifdef TARGET_BLUE
     // initialize the touch part
     G_ux_os.last_touched_not_released_component = NULL;
 #endif  // TARGET_BLUE
+#ifdef HAVE_DISPLAY_BATCH
+    // drop the elements of the previous screen
+    G_io_display_batch_length = 0;
+#endif  // HAVE_DISPLAY_BATCH
 }
 
 void io_seproxyhal_init_button(void)
@@ -730,6 +840,67 @@ unsigned int io_seproxyhal_display_icon_header_and_colors(bagl_component_t    *i
 }
 #endif  // SEPROXYHAL_TAG_SCREEN_DISPLAY_RAW_STATUS
 
+#ifdef HAVE_DISPLAY_BATCH
+static void io_seproxyhal_display_batch_send(unsigned short length)
+{
+    G_io_seproxyhal_spi_buffer[0] = SEPROXYHAL_TAG_SCREEN_DISPLAY_BATCH_STATUS;
+    G_io_seproxyhal_spi_buffer[1] = length >> 8;
+    G_io_seproxyhal_spi_buffer[2] = length;
+    io_seproxyhal_spi_send(G_io_seproxyhal_spi_buffer, 3);
+    io_seproxyhal_spi_send(G_io_display_batch, G_io_display_batch_length);
+    G_io_display_batch_length = 0;
+}
+
+/**
+ * Starts an element of the given length (component included) whose content is then given to
+ * io_seproxyhal_display_batch_write. When it doesn't fit, the pending elements are sent along with
+ * it, which ends the batch.
+ * @return false if the element is to be sent with a SCREEN_DISPLAY_STATUS.
+ */
+static bool io_seproxyhal_display_batch_element(unsigned short length)
+{
+    G_io_display_batch_direct = false;
+    if (!G_io_display_batch_enabled) {
+        return false;
+    }
+    if ((size_t) G_io_display_batch_length + 2 + length > sizeof(G_io_display_batch)) {
+        io_seproxyhal_display_batch_send(G_io_display_batch_length + 2 + length);
+        G_io_seproxyhal_spi_buffer[0] = length >> 8;
+        G_io_seproxyhal_spi_buffer[1] = length;
+        io_seproxyhal_spi_send(G_io_seproxyhal_spi_buffer, 2);
+        G_io_display_batch_direct = true;
+        return true;
+    }
+    U2BE_ENCODE(G_io_display_batch, G_io_display_batch_length, length);
+    G_io_display_batch_length += 2;
+    return true;
+}
+
+static void io_seproxyhal_display_batch_write(const void *data, unsigned short length)
+{
+    if (G_io_display_batch_direct) {
+        io_seproxyhal_spi_send((const unsigned char *) data, length);
+    }
+    else {
+        memcpy(G_io_display_batch + G_io_display_batch_length, data, length);
+        G_io_display_batch_length += length;
+    }
+}
+
+void io_seproxyhal_display_batch_start(void)
+{
+    G_io_display_batch_enabled = true;
+}
+
+void io_seproxyhal_display_batch_end(void)
+{
+    G_io_display_batch_enabled = false;
+    if (G_io_display_batch_length && !io_seproxyhal_spi_is_status_sent()) {
+        io_seproxyhal_display_batch_send(G_io_display_batch_length);
+    }
+}
+#endif  // HAVE_DISPLAY_BATCH
+
 void io_seproxyhal_display_icon(bagl_component_t *icon_component, bagl_icon_details_t *icon_det)
 {
     bagl_component_t           icon_component_mod;
@@ -789,6 +960,15 @@ void io_seproxyhal_display_icon(bagl_component_t *icon_component, bagl_icon_deta
         unsigned short length = sizeof(bagl_component_t) + 1 /* bpp */
                                 + h                          /* color index */
                                 + w;                         /* image bitmap size */
+#ifdef HAVE_DISPLAY_BATCH
+        if (io_seproxyhal_display_batch_element(length)) {
+            io_seproxyhal_display_batch_write(icon_component, sizeof(bagl_component_t));
+            io_seproxyhal_display_batch_write(&icon_details->bpp, 1);
+            io_seproxyhal_display_batch_write(PIC(icon_details->colors), h);
+            io_seproxyhal_display_batch_write(PIC(icon_details->bitmap), w);
+            return;
+        }
+#endif  // HAVE_DISPLAY_BATCH
         G_io_seproxyhal_spi_buffer[0] = SEPROXYHAL_TAG_SCREEN_DISPLAY_STATUS;
 #if defined(HAVE_SE_SCREEN) && defined(HAVE_PRINTF)
         G_io_seproxyhal_spi_buffer[0] = SEPROXYHAL_TAG_DBG_SCREEN_DISPLAY_STATUS;
@@ -833,6 +1013,13 @@ void io_seproxyhal_display_default(const bagl_element_t *element)
                     return;
                 }
                 unsigned short length = sizeof(bagl_component_t) + strlen((const char *) txt);
+#ifdef HAVE_DISPLAY_BATCH
+                if (io_seproxyhal_display_batch_element(length)) {
+                    io_seproxyhal_display_batch_write(&el->component, sizeof(bagl_component_t));
+                    io_seproxyhal_display_batch_write(txt, length - sizeof(bagl_component_t));
+                    return;
+                }
+#endif  // HAVE_DISPLAY_BATCH
                 G_io_seproxyhal_spi_buffer[0] = SEPROXYHAL_TAG_SCREEN_DISPLAY_STATUS;
 #if defined(HAVE_SE_SCREEN) && defined(HAVE_PRINTF)
                 G_io_seproxyhal_spi_buffer[0] = SEPROXYHAL_TAG_DBG_SCREEN_DISPLAY_STATUS;
@@ -853,7 +1040,13 @@ void io_seproxyhal_display_default(const bagl_element_t *element)
             if (io_seproxyhal_spi_is_status_sent()) {
                 return;
             }
-            unsigned short length         = sizeof(bagl_component_t);
+            unsigned short length = sizeof(bagl_component_t);
+#ifdef HAVE_DISPLAY_BATCH
+            if (io_seproxyhal_display_batch_element(length)) {
+                io_seproxyhal_display_batch_write(&el->component, sizeof(bagl_component_t));
+                return;
+            }
+#endif  // HAVE_DISPLAY_BATCH
             G_io_seproxyhal_spi_buffer[0] = SEPROXYHAL_TAG_SCREEN_DISPLAY_STATUS;
 #if defined(HAVE_SE_SCREEN) && defined(HAVE_PRINTF)
             G_io_seproxyhal_spi_buffer[0] = SEPROXYHAL_TAG_DBG_SCREEN_DISPLAY_STATUS;
@@ -882,14 +1075,14 @@ unsigned int bagl_label_roundtrip_duration_ms_buf(const bagl_element_t *e,
         return 0;
     }
 
-    unsigned int text_adr = (unsigned int) PIC((unsigned int) str);
-    unsigned int textlen  = 0;
+    const char  *text    = (const char *) PIC(str);
+    unsigned int textlen = 0;
 
     // no delay, no text to display
-    if (!text_adr) {
+    if (!text) {
         return 0;
     }
-    textlen = strlen((const char *) text_adr);
+    textlen = strlen(text);
 
     // no delay, all text fits
     textlen = textlen * average_char_width;
@@ -1199,6 +1392,58 @@ static bolos_bool_t io_process_default_apdus(unsigned char *channel, unsigned sh
                 break;
 #endif  // DEBUG_OS_STACK_CONSUMPTION
 
+#if defined(HAVE_SYSCALL_TRACE)
+            // syscall trace
+            // host: P1 = 0x00 to read the entries from the index P2, 0x01 to clear them
+            // device: <see syscall_trace_dump> 9000 | <nothing> 9000 | 650D
+            case DEFAULT_APDU_INS_SYSCALL_TRACE:
+                // Initialization.
+                *tx_len = 2;
+                U2BE_ENCODE(G_io_apdu_buffer, 0x00, SWO_APD_HDR_0D);
+
+                if (G_io_apdu_buffer[APDU_OFF_P1] == 0x00) {
+                    *tx_len = syscall_trace_dump(G_io_apdu_buffer[APDU_OFF_P2],
+                                                 G_io_apdu_buffer,
+                                                 sizeof(G_io_apdu_buffer) - 2);
+                    U2BE_ENCODE(G_io_apdu_buffer, *tx_len, SWO_SUCCESS);
+                    *tx_len += 2;
+                }
+                else if (G_io_apdu_buffer[APDU_OFF_P1] == 0x01) {
+                    syscall_trace_clear();
+                    U2BE_ENCODE(G_io_apdu_buffer, 0x00, SWO_SUCCESS);
+                }
+                *channel &= ~IO_FLAGS;
+                processed = BOLOS_TRUE;
+                break;
+#endif  // HAVE_SYSCALL_TRACE
+
+#if defined(HAVE_IO_LATENCY)
+            // latency histograms
+            // host: P1 = 0x00 to read the slot P2, 0x01 to clear the histograms
+            // device: <see io_latency_dump> 9000 | <nothing> 9000 | 650D
+            case DEFAULT_APDU_INS_IO_LATENCY:
+                // Initialization.
+                *tx_len = 2;
+                U2BE_ENCODE(G_io_apdu_buffer, 0x00, SWO_APD_HDR_0D);
+
+                if (G_io_apdu_buffer[APDU_OFF_P1] == 0x00) {
+                    uint16_t len = io_latency_dump(G_io_apdu_buffer[APDU_OFF_P2],
+                                                   G_io_apdu_buffer,
+                                                   sizeof(G_io_apdu_buffer) - 2);
+                    if (len != 0) {
+                        U2BE_ENCODE(G_io_apdu_buffer, len, SWO_SUCCESS);
+                        *tx_len = len + 2;
+                    }
+                }
+                else if (G_io_apdu_buffer[APDU_OFF_P1] == 0x01) {
+                    io_latency_clear();
+                    U2BE_ENCODE(G_io_apdu_buffer, 0x00, SWO_SUCCESS);
+                }
+                *channel &= ~IO_FLAGS;
+                processed = BOLOS_TRUE;
+                break;
+#endif  // HAVE_IO_LATENCY
+
             default:
                 // 'processed' is already initialized.
                 break;
@@ -1214,6 +1459,15 @@ unsigned short io_exchange(unsigned char channel, unsigned short tx_len)
 {
     unsigned short rx_len;
     unsigned int   timeout_ms;
+#ifdef HAVE_IO_SCATTER_GATHER
+    // the buffers of the reply may not outlive this call, whatever its outcome. They are only
+    // used by the USB transports
+    __attribute__((unused)) const io_iovec_t *tx_iov       = G_io_app.tx_iov;
+    __attribute__((unused)) unsigned char     tx_iov_count = G_io_app.tx_iov_count;
+
+    G_io_app.tx_iov       = NULL;
+    G_io_app.tx_iov_count = 0;
+#endif  // HAVE_IO_SCATTER_GATHER
 
 #ifdef HAVE_BOLOS_APP_STACK_CANARY
     // behavior upon detected stack overflow is to reset the SE
@@ -1224,24 +1478,42 @@ unsigned short io_exchange(unsigned char channel, unsigned short tx_len)
 
 #ifdef DEBUG_APDU
     if ((channel & ~(IO_FLAGS)) == CHANNEL_APDU) {
-        // ignore tx len
-
         // already received the data of the apdu when received the whole apdu
         if ((channel & (CHANNEL_APDU | IO_RECEIVE_DATA)) == (CHANNEL_APDU | IO_RECEIVE_DATA)) {
             // return apdu data - header
-            return G_io_apdu_length - 5;
+            return G_io_app.apdu_length - 5;
+        }
+
+        // a replayed apdu leaves the state idle, its reply is not sent anywhere
+        if (G_io_app.apdu_state == APDU_IDLE) {
+#ifdef DEBUG_APDU_REPLAY
+            if (tx_len && !(channel & IO_ASYNCH_REPLY)) {
+                debug_apdu_replied(tx_len);
+            }
+#endif  // DEBUG_APDU_REPLAY
+            if (channel & IO_RETURN_AFTER_TX) {
+                return 0;
+            }
         }
 
         // fetch next apdu
-        if (debug_apdus_offset < sizeof(debug_apdus)) {
-            G_io_apdu_length = debug_apdus[debug_apdus_offset] & 0xFF;
-            memcpy(G_io_apdu_buffer, &debug_apdus[debug_apdus_offset + 1], G_io_apdu_length);
-            debug_apdus_offset += G_io_apdu_length + 1;
-            return G_io_apdu_length;
+        G_io_app.apdu_length = debug_apdu_next(G_io_apdu_buffer, sizeof(G_io_apdu_buffer));
+        if (G_io_app.apdu_length) {
+#ifdef HAVE_SYSCALL_TRACE
+            syscall_trace_apdu_start();
+#endif  // HAVE_SYSCALL_TRACE
+            return G_io_app.apdu_length;
         }
     }
 #endif  // DEBUG_APDU
 
+#ifdef HAVE_IO_PIPELINE
+    // once enabled, the commands are received in G_io_apdu_buffer_next
+    if (((channel & ~(IO_FLAGS)) == CHANNEL_APDU) && (channel & IO_PIPELINE)) {
+        G_io_app.pipeline = true;
+    }
+#endif  // HAVE_IO_PIPELINE
+
 reply_apdu:
     switch (channel & ~(IO_FLAGS)) {
         case CHANNEL_APDU:
@@ -1257,6 +1529,10 @@ reply_apdu:
                     os_io_seph_recv_and_process(1);
                 }
 
+#ifdef HAVE_IO_LATENCY
+                io_latency_tx_start();
+#endif  // HAVE_IO_LATENCY
+
                 // reinit sending timeout for APDU replied within io_exchange
                 timeout_ms = G_io_app.ms + IO_RAPDU_TRANSMIT_TIMEOUT_MS;
 
@@ -1295,6 +1571,12 @@ reply_apdu:
                         case APDU_USB_HID:
                             // only send, don't perform synchronous reception of the next command
                             // (will be done later by the seproxyhal packet processing)
+#ifdef HAVE_IO_SCATTER_GATHER
+                            if (tx_iov_count) {
+                                io_usb_hid_send_iov(io_usb_send_apdu_data, tx_iov, tx_iov_count);
+                                goto break_send;
+                            }
+#endif  // HAVE_IO_SCATTER_GATHER
                             io_usb_hid_send(io_usb_send_apdu_data, tx_len, G_io_apdu_buffer);
                             goto break_send;
 #ifdef HAVE_USB_CLASS_CCID
@@ -1304,6 +1586,13 @@ reply_apdu:
 #endif  // HAVE_USB_CLASS_CCID
 #ifdef HAVE_WEBUSB
                         case APDU_USB_WEBUSB:
+#ifdef HAVE_IO_SCATTER_GATHER
+                            if (tx_iov_count) {
+                                io_usb_hid_send_iov(
+                                    io_usb_send_apdu_data_ep0x83, tx_iov, tx_iov_count);
+                                goto break_send;
+                            }
+#endif  // HAVE_IO_SCATTER_GATHER
                             io_usb_hid_send(io_usb_send_apdu_data_ep0x83, tx_len, G_io_apdu_buffer);
                             goto break_send;
 #endif  // HAVE_WEBUSB
@@ -1382,12 +1671,22 @@ reply_apdu:
                             // example)) this case shall be covered by usb_ep_timeout but is not,
                             // investigate that
                             if (G_io_app.ms >= timeout_ms) {
+#if defined(HAVE_IO_SCATTER_GATHER) && defined(HAVE_USB_APDU)
+                                // the remaining chunks may refer to the caller's buffers
+                                io_usb_hid_init();
+#endif  // HAVE_IO_SCATTER_GATHER && HAVE_USB_APDU
+#ifdef HAVE_IO_PIPELINE
+                                io_pipeline_reset();
+#endif  // HAVE_IO_PIPELINE
                                 THROW(EXCEPTION_IO_RESET);
                             }
                             // avoid a general status to be replied
                             io_seproxyhal_handle_event();
                         } while (io_seproxyhal_spi_is_status_sent());
                     }
+#ifdef HAVE_IO_LATENCY
+                    io_latency_tx_done();
+#endif  // HAVE_IO_LATENCY
                     // reset apdu state
                     G_io_app.apdu_state = APDU_IDLE;
                     G_io_app.apdu_media = IO_APDU_MEDIA_NONE;
@@ -1434,6 +1733,12 @@ reply_apdu:
 
             // until a new whole CAPDU is received
             for (;;) {
+#ifdef HAVE_IO_PIPELINE
+                // the next command may have been received meanwhile
+                if (io_pipeline_pop()) {
+                    goto apdu_received;
+                }
+#endif  // HAVE_IO_PIPELINE
                 io_seproxyhal_general_status();
                 // wait until a SPI packet is available
                 // NOTE: on ST31, dual wait ISO & RF (ISO instead of SPI)
@@ -1453,6 +1758,9 @@ reply_apdu:
 
                 io_seproxyhal_handle_event();
 
+#ifdef HAVE_IO_PIPELINE
+            apdu_received:
+#endif  // HAVE_IO_PIPELINE
                 // An apdu has been received asynchroneously.
                 if (G_io_app.apdu_state != APDU_IDLE && G_io_app.apdu_length > 0) {
                     if (os_perso_isonboarded() == BOLOS_TRUE
@@ -1471,6 +1779,12 @@ reply_apdu:
                     }
 #endif  // ! HAVE_BOLOS_NO_DEFAULT_APDU
 
+#ifdef HAVE_SYSCALL_TRACE
+                    syscall_trace_apdu_start();
+#endif  // HAVE_SYSCALL_TRACE
+#ifdef HAVE_IO_LATENCY
+                    io_latency_rx_done(G_io_apdu_buffer[APDU_OFF_INS]);
+#endif  // HAVE_IO_LATENCY
                     return G_io_app.apdu_length;
                 }
             }
@@ -19,6 +19,8 @@
 #include "os_io_usb.h"
 #include "os_utils.h"
 #include "lcx_rng.h"
+#include "lzss.h"
+#include "io_latency.h"
 #include <string.h>
 
 #ifdef HAVE_USB_APDU
@@ -26,6 +28,9 @@
 // usb endpoint buffer
 unsigned char G_io_usb_ep_buffer[MAX(USB_SEGMENT_SIZE, BLE_SEGMENT_SIZE)];
 
+// replies to the control commands, kept apart from the chunks of the reply being sent
+static unsigned char G_io_usb_hid_ctrl_reply[IO_HID_EP_LENGTH];
+
 uint16_t io_seproxyhal_get_ep_rx_size(uint8_t epnum)
 {
     if ((epnum & 0x7F) < IO_USB_MAX_ENDPOINTS) {
@@ -102,6 +107,11 @@ void io_usb_send_apdu_data(unsigned char *buffer, unsigned short length)
  * Direction:*          T:0x03 V:no  Abort. replied with an abort if accepted, else not replied.
  *  Direction:*          T:0x05 V=<sequence-idx-U16><seq==0?totallength:NONE><apducontent> APDU
  * (command/response) packet.
+ *  Direction:Host>Token T:0x09 V:no  Get compression capabilities (HAVE_APDU_COMPRESSION). Replied
+ * with a 1-byte bitmask, 0x01 for LZSS.
+ *  Direction:Host>Token T:0x0A
+ * V=<sequence-idx-U16><seq==0?totallength-compressedlength:NONE><lzsscontent> LZSS compressed
+ * command APDU packet, the total length being the decompressed one.
  */
 
 volatile unsigned int   G_io_usb_hid_total_length;
@@ -110,6 +120,86 @@ volatile unsigned int   G_io_usb_hid_remaining_length;
 volatile unsigned int   G_io_usb_hid_sequence_number;
 volatile unsigned char *G_io_usb_hid_current_buffer;
 
+#ifdef HAVE_IO_PIPELINE
+// The next command may be received while the reply is sent, each direction has its own state
+static volatile unsigned int   G_io_usb_hid_tx_remaining_length;
+static volatile unsigned int   G_io_usb_hid_tx_sequence_number;
+static volatile unsigned char *G_io_usb_hid_tx_current_buffer;
+#else  // HAVE_IO_PIPELINE
+#define G_io_usb_hid_tx_remaining_length G_io_usb_hid_remaining_length
+#define G_io_usb_hid_tx_sequence_number  G_io_usb_hid_sequence_number
+#define G_io_usb_hid_tx_current_buffer   G_io_usb_hid_current_buffer
+#endif  // HAVE_IO_PIPELINE
+
+#ifdef HAVE_IO_SCATTER_GATHER
+// The reply is read from the non empty buffers of the list, the current buffer being the
+// G_io_usb_hid_tx_iov_index-th one
+static io_iovec_t    G_io_usb_hid_tx_iov[IO_IOVEC_MAX];
+static unsigned char G_io_usb_hid_tx_iov_count;
+static unsigned char G_io_usb_hid_tx_iov_index;
+static unsigned int  G_io_usb_hid_tx_segment_length;
+#endif  // HAVE_IO_SCATTER_GATHER
+
+#ifdef HAVE_APDU_COMPRESSION
+// A compressed command is decompressed as received, the remaining length being the compressed one
+static lzss_ctx_t G_io_usb_hid_lzss;
+static bool       G_io_usb_hid_compressed;
+#endif  // HAVE_APDU_COMPRESSION
+
+static void io_usb_hid_rx_init(void)
+{
+    G_io_usb_hid_sequence_number  = 0;
+    G_io_usb_hid_remaining_length = 0;
+    G_io_usb_hid_current_buffer   = NULL;
+#ifdef HAVE_APDU_COMPRESSION
+    G_io_usb_hid_compressed = false;
+#endif  // HAVE_APDU_COMPRESSION
+}
+
+static void io_usb_hid_tx_init(void)
+{
+    G_io_usb_hid_tx_sequence_number  = 0;
+    G_io_usb_hid_tx_remaining_length = 0;
+    G_io_usb_hid_tx_current_buffer   = NULL;
+#ifdef HAVE_IO_SCATTER_GATHER
+    G_io_usb_hid_tx_iov_count      = 0;
+    G_io_usb_hid_tx_iov_index      = 0;
+    G_io_usb_hid_tx_segment_length = 0;
+#endif  // HAVE_IO_SCATTER_GATHER
+}
+
+/**
+ * copy the next l bytes of the reply, l being at most the remaining length
+ */
+static void io_usb_hid_tx_copy(unsigned char *dst, unsigned int l)
+{
+    G_io_usb_hid_tx_remaining_length -= l;
+#ifdef HAVE_IO_SCATTER_GATHER
+    while (l) {
+        unsigned int n;
+
+        if (G_io_usb_hid_tx_segment_length == 0) {
+            if (G_io_usb_hid_tx_iov_index + 1 >= G_io_usb_hid_tx_iov_count) {
+                break;
+            }
+            G_io_usb_hid_tx_iov_index++;
+            G_io_usb_hid_tx_current_buffer
+                = (volatile unsigned char *) G_io_usb_hid_tx_iov[G_io_usb_hid_tx_iov_index].ptr;
+            G_io_usb_hid_tx_segment_length = G_io_usb_hid_tx_iov[G_io_usb_hid_tx_iov_index].len;
+        }
+        n = MIN(l, G_io_usb_hid_tx_segment_length);
+        memmove(dst, (const void *) G_io_usb_hid_tx_current_buffer, n);
+        G_io_usb_hid_tx_current_buffer += n;
+        G_io_usb_hid_tx_segment_length -= n;
+        dst += n;
+        l -= n;
+    }
+#else  // HAVE_IO_SCATTER_GATHER
+    memmove(dst, (const void *) G_io_usb_hid_tx_current_buffer, l);
+    G_io_usb_hid_tx_current_buffer += l;
+#endif  // HAVE_IO_SCATTER_GATHER
+}
+
 io_usb_hid_receive_status_t io_usb_hid_receive(io_send_t      sndfct,
                                                unsigned char *buffer,
                                                unsigned short l,
@@ -127,36 +217,45 @@ io_usb_hid_receive_status_t io_usb_hid_receive(io_send_t      sndfct,
     {
         apdu_buf     = apdu_buffer->buf;
         apdu_buf_len = apdu_buffer->len;
-    }  // avoid over/under flows
-    if (buffer != G_io_usb_ep_buffer) {
+    }
+
+    // APDU chunks holding a whole header are parsed in place, and their content is copied once,
+    // straight into the APDU buffer. Other packets are zero padded in the endpoint buffer, and the
+    // replies to the control commands are built from them in G_io_usb_hid_ctrl_reply.
+    const unsigned char *packet = buffer;
+    if ((buffer != G_io_usb_ep_buffer) && ((l < 2 + 1 + 2 + 2) || (buffer[2] != 0x05))) {
+        // avoid over/under flows
         memset(G_io_usb_ep_buffer, 0, sizeof(G_io_usb_ep_buffer));
         memmove(G_io_usb_ep_buffer, buffer, MIN(l, sizeof(G_io_usb_ep_buffer)));
+        packet = G_io_usb_ep_buffer;
     }
 
     // process the chunk content
-    switch (G_io_usb_ep_buffer[2]) {
+    switch (packet[2]) {
         case 0x05:
             // ensure sequence idx is 0 for the first chunk !
-            if ((unsigned int) U2BE(G_io_usb_ep_buffer, 3)
-                != (unsigned int) G_io_usb_hid_sequence_number) {
+            if ((unsigned int) U2BE(packet, 3) != (unsigned int) G_io_usb_hid_sequence_number) {
                 // ignore packet
                 goto apdu_reset;
             }
+#ifdef HAVE_APDU_COMPRESSION
+            // don't mix chunks of a compressed command
+            if (G_io_usb_hid_compressed) {
+                goto apdu_reset;
+            }
+#endif  // HAVE_APDU_COMPRESSION
             // cid, tag, seq
             l -= 2 + 1 + 2;
 
             // append the received chunk to the current command apdu
             if (G_io_usb_hid_sequence_number == 0) {
                 /// This is the apdu first chunk
-                // total apdu size to receive
-                G_io_usb_hid_total_length
-                    = U2BE(G_io_usb_ep_buffer,
-                           5);  //(G_io_usb_ep_buffer[5]<<8)+(G_io_usb_ep_buffer[6]&0xFF);
                 // check for invalid length encoding (more data in chunk that announced in the total
-                // apdu)
-                if (G_io_usb_hid_total_length > (uint32_t) apdu_buf_len) {
+                // apdu), before retaining the total apdu size to receive
+                if (U2BE(packet, 5) > apdu_buf_len) {
                     goto apdu_reset;
                 }
+                G_io_usb_hid_total_length = U2BE(packet, 5);
                 // seq and total length
                 l -= 2;
                 // compute remaining size to receive
@@ -164,7 +263,10 @@ io_usb_hid_receive_status_t io_usb_hid_receive(io_send_t      sndfct,
                 G_io_usb_hid_current_buffer   = apdu_buf;
 
                 // retain the channel id to use for the reply
-                G_io_usb_hid_channel = U2BE(G_io_usb_ep_buffer, 0);
+                G_io_usb_hid_channel = U2BE(packet, 0);
+#ifdef HAVE_IO_LATENCY
+                io_latency_rx_start();
+#endif  // HAVE_IO_LATENCY
 
                 if (l > G_io_usb_hid_remaining_length) {
                     l = G_io_usb_hid_remaining_length;
@@ -175,7 +277,7 @@ io_usb_hid_receive_status_t io_usb_hid_receive(io_send_t      sndfct,
                 }
 
                 // copy data
-                memmove((void *) G_io_usb_hid_current_buffer, G_io_usb_ep_buffer + 7, l);
+                memcpy((void *) G_io_usb_hid_current_buffer, packet + 7, l);
             }
             else {
                 // check for invalid length encoding (more data in chunk that announced in the total
@@ -190,7 +292,7 @@ io_usb_hid_receive_status_t io_usb_hid_receive(io_send_t      sndfct,
 
                 /// This is a following chunk
                 // append content
-                memmove((void *) G_io_usb_hid_current_buffer, G_io_usb_ep_buffer + 5, l);
+                memcpy((void *) G_io_usb_hid_current_buffer, packet + 5, l);
             }
             // factorize (f)
             G_io_usb_hid_current_buffer += l;
@@ -198,26 +300,83 @@ io_usb_hid_receive_status_t io_usb_hid_receive(io_send_t      sndfct,
             G_io_usb_hid_sequence_number++;
             break;
 
+#ifdef HAVE_APDU_COMPRESSION
+        case 0x0A:  // COMPRESSED APDU
+            if ((l < 2 + 1 + 2) || (U2BE(packet, 3) != G_io_usb_hid_sequence_number)) {
+                goto apdu_reset;
+            }
+            if (G_io_usb_hid_sequence_number == 0) {
+                // decompressed and compressed lengths, the latter bounding the work (no bomb),
+                // and not null as it tells the chunks of a compressed command
+                if ((l < 2 + 1 + 2 + 2 + 2) || (U2BE(packet, 5) > apdu_buf_len)
+                    || (U2BE(packet, 7) == 0)
+                    || (U2BE(packet, 7) > LZSS_MAX_COMPRESSED_LENGTH(U2BE(packet, 5)))) {
+                    goto apdu_reset;
+                }
+                G_io_usb_hid_compressed       = true;
+                G_io_usb_hid_total_length     = U2BE(packet, 5);
+                G_io_usb_hid_remaining_length = U2BE(packet, 7);
+                G_io_usb_hid_channel          = U2BE(packet, 0);
+                lzss_init(&G_io_usb_hid_lzss, apdu_buf, G_io_usb_hid_total_length);
+#ifdef HAVE_IO_LATENCY
+                io_latency_rx_start();
+#endif  // HAVE_IO_LATENCY
+                l = MIN(l, sizeof(G_io_usb_ep_buffer)) - 9;
+                l = MIN(l, G_io_usb_hid_remaining_length);
+                if (!lzss_decompress(&G_io_usb_hid_lzss, packet + 9, l)) {
+                    goto apdu_reset;
+                }
+            }
+            else {
+                if (!G_io_usb_hid_compressed) {
+                    goto apdu_reset;
+                }
+                l = MIN(l, sizeof(G_io_usb_ep_buffer)) - 5;
+                l = MIN(l, G_io_usb_hid_remaining_length);
+                if (!lzss_decompress(&G_io_usb_hid_lzss, packet + 5, l)) {
+                    goto apdu_reset;
+                }
+            }
+            G_io_usb_hid_remaining_length -= l;
+            G_io_usb_hid_sequence_number++;
+            if ((G_io_usb_hid_remaining_length == 0) && !lzss_finished(&G_io_usb_hid_lzss)) {
+                goto apdu_reset;
+            }
+            break;
+
+        case 0x09:  // COMPRESSION CAPABILITIES
+            // as for the other control commands, the current apdu reception if any is dropped
+            memmove(G_io_usb_hid_ctrl_reply, packet, sizeof(G_io_usb_hid_ctrl_reply));
+            G_io_usb_hid_ctrl_reply[3] = LZSS_CAPABILITY;
+            // send the response
+            sndfct(G_io_usb_hid_ctrl_reply, IO_HID_EP_LENGTH);
+            // await for the next chunk
+            goto apdu_reset;
+#endif  // HAVE_APDU_COMPRESSION
+
         case 0x00:  // get version ID
             // do not reset the current apdu reception if any
-            memset(G_io_usb_ep_buffer + 3, 0, 4);  // PROTOCOL VERSION is 0
+            memmove(G_io_usb_hid_ctrl_reply, packet, sizeof(G_io_usb_hid_ctrl_reply));
+            memset(G_io_usb_hid_ctrl_reply + 3, 0, 4);  // PROTOCOL VERSION is 0
             // send the response
-            sndfct(G_io_usb_ep_buffer, IO_HID_EP_LENGTH);
+            sndfct(G_io_usb_hid_ctrl_reply, IO_HID_EP_LENGTH);
             // await for the next chunk
             goto apdu_reset;
 
         case 0x01:  // ALLOCATE CHANNEL
             // do not reset the current apdu reception if any
-            cx_rng_no_throw(G_io_usb_ep_buffer + 3, 4);
+            memmove(G_io_usb_hid_ctrl_reply, packet, sizeof(G_io_usb_hid_ctrl_reply));
+            cx_rng_no_throw(G_io_usb_hid_ctrl_reply + 3, 4);
             // send the response
-            sndfct(G_io_usb_ep_buffer, IO_HID_EP_LENGTH);
+            sndfct(G_io_usb_hid_ctrl_reply, IO_HID_EP_LENGTH);
             // await for the next chunk
             goto apdu_reset;
 
         case 0x02:  // ECHO|PING
             // do not reset the current apdu reception if any
+            memmove(G_io_usb_hid_ctrl_reply, packet, sizeof(G_io_usb_hid_ctrl_reply));
             // send the response
-            sndfct(G_io_usb_ep_buffer, IO_HID_EP_LENGTH);
+            sndfct(G_io_usb_hid_ctrl_reply, IO_HID_EP_LENGTH);
             // await for the next chunk
             goto apdu_reset;
     }
@@ -228,20 +387,38 @@ io_usb_hid_receive_status_t io_usb_hid_receive(io_send_t      sndfct,
     }
 
     // reset sequence number for next exchange
-    io_usb_hid_init();
+    io_usb_hid_rx_init();
     return IO_USB_APDU_RECEIVED;
 
 apdu_reset:
-    io_usb_hid_init();
+    io_usb_hid_rx_init();
     return IO_USB_APDU_RESET;
 }
 
 void io_usb_hid_init(void)
 {
-    G_io_usb_hid_sequence_number  = 0;
-    G_io_usb_hid_remaining_length = 0;
-    G_io_usb_hid_current_buffer   = NULL;
+    io_usb_hid_rx_init();
+    io_usb_hid_tx_init();
+}
+
+#ifdef HAVE_IO_PIPELINE
+void io_usb_hid_receive_next(io_send_t       sndfct,
+                             unsigned char  *buffer,
+                             unsigned short  l,
+                             io_apdu_media_t media)
+{
+    apdu_buffer_t next = {.buf = G_io_apdu_buffer_next, .len = sizeof(G_io_apdu_buffer_next)};
+
+    // a single command can be pending, until adopted by io_exchange
+    if (G_io_app.pipeline_length != 0) {
+        return;
+    }
+    if (io_usb_hid_receive(sndfct, buffer, l, &next) == IO_USB_APDU_RECEIVED) {
+        G_io_app.pipeline_media  = media;
+        G_io_app.pipeline_length = G_io_usb_hid_total_length;
+    }
 }
+#endif  // HAVE_IO_PIPELINE
 
 /**
  * sent the next io_usb_hid transport chunk (rx on the host, tx on the device)
@@ -251,7 +428,7 @@ void io_usb_hid_sent(io_send_t sndfct)
     unsigned int l;
 
     // only prepare next chunk if some data to be sent remain
-    if (G_io_usb_hid_remaining_length && G_io_usb_hid_current_buffer) {
+    if (G_io_usb_hid_tx_remaining_length && G_io_usb_hid_tx_current_buffer) {
         // fill the chunk
         memset(G_io_usb_ep_buffer, 0, sizeof(G_io_usb_ep_buffer));
 
@@ -259,52 +436,91 @@ void io_usb_hid_sent(io_send_t sndfct)
         G_io_usb_ep_buffer[0] = (G_io_usb_hid_channel >> 8) & 0xFF;
         G_io_usb_ep_buffer[1] = G_io_usb_hid_channel & 0xFF;
         G_io_usb_ep_buffer[2] = 0x05;
-        G_io_usb_ep_buffer[3] = G_io_usb_hid_sequence_number >> 8;
-        G_io_usb_ep_buffer[4] = G_io_usb_hid_sequence_number;
+        G_io_usb_ep_buffer[3] = G_io_usb_hid_tx_sequence_number >> 8;
+        G_io_usb_ep_buffer[4] = G_io_usb_hid_tx_sequence_number;
 
-        if (G_io_usb_hid_sequence_number == 0) {
-            l                     = ((G_io_usb_hid_remaining_length > IO_HID_EP_LENGTH - 7)
+        if (G_io_usb_hid_tx_sequence_number == 0) {
+            l                     = ((G_io_usb_hid_tx_remaining_length > IO_HID_EP_LENGTH - 7)
                                          ? IO_HID_EP_LENGTH - 7
-                                         : G_io_usb_hid_remaining_length);
-            G_io_usb_ep_buffer[5] = G_io_usb_hid_remaining_length >> 8;
-            G_io_usb_ep_buffer[6] = G_io_usb_hid_remaining_length;
-            memmove(G_io_usb_ep_buffer + 7, (const void *) G_io_usb_hid_current_buffer, l);
-            G_io_usb_hid_current_buffer += l;
-            G_io_usb_hid_remaining_length -= l;
+                                         : G_io_usb_hid_tx_remaining_length);
+            G_io_usb_ep_buffer[5] = G_io_usb_hid_tx_remaining_length >> 8;
+            G_io_usb_ep_buffer[6] = G_io_usb_hid_tx_remaining_length;
+            io_usb_hid_tx_copy(G_io_usb_ep_buffer + 7, l);
         }
         else {
-            l = ((G_io_usb_hid_remaining_length > IO_HID_EP_LENGTH - 5)
+            l = ((G_io_usb_hid_tx_remaining_length > IO_HID_EP_LENGTH - 5)
                      ? IO_HID_EP_LENGTH - 5
-                     : G_io_usb_hid_remaining_length);
-            memmove(G_io_usb_ep_buffer + 5, (const void *) G_io_usb_hid_current_buffer, l);
-            G_io_usb_hid_current_buffer += l;
-            G_io_usb_hid_remaining_length -= l;
+                     : G_io_usb_hid_tx_remaining_length);
+            io_usb_hid_tx_copy(G_io_usb_ep_buffer + 5, l);
         }
         // prepare next chunk numbering
-        G_io_usb_hid_sequence_number++;
+        G_io_usb_hid_tx_sequence_number++;
         // send the chunk
         // always padded (USB HID transport) :)
         sndfct(G_io_usb_ep_buffer, sizeof(G_io_usb_ep_buffer));
     }
     // cleanup when everything has been sent (ack for the last sent usb in packet)
     else {
-        io_usb_hid_init();
+        io_usb_hid_tx_init();
 
         // we sent the whole response
         G_io_app.apdu_state = APDU_IDLE;
     }
 }
 
+#ifdef HAVE_IO_SCATTER_GATHER
+void io_usb_hid_send_iov(io_send_t sndfct, const io_iovec_t *iov, unsigned char count)
+{
+    unsigned int length = 0;
+
+    if (count > IO_IOVEC_MAX) {
+        return;
+    }
+
+    // keep the non empty buffers only, the first one being the current buffer
+    G_io_usb_hid_tx_iov_count = 0;
+    for (unsigned char i = 0; i < count; i++) {
+        if (iov[i].len != 0) {
+            G_io_usb_hid_tx_iov[G_io_usb_hid_tx_iov_count++] = iov[i];
+            length += iov[i].len;
+        }
+    }
+    if ((length == 0) || (length > 0xFFFF)) {
+        G_io_usb_hid_tx_iov_count = 0;
+        return;
+    }
+
+    // perform send
+    G_io_usb_hid_tx_sequence_number  = 0;
+    G_io_usb_hid_tx_iov_index        = 0;
+    G_io_usb_hid_tx_current_buffer   = (volatile unsigned char *) G_io_usb_hid_tx_iov[0].ptr;
+    G_io_usb_hid_tx_segment_length   = G_io_usb_hid_tx_iov[0].len;
+    G_io_usb_hid_tx_remaining_length = length;
+#ifndef HAVE_IO_PIPELINE
+    G_io_usb_hid_total_length = length;
+#endif  // HAVE_IO_PIPELINE
+    io_usb_hid_sent(sndfct);
+}
+#endif  // HAVE_IO_SCATTER_GATHER
+
 void io_usb_hid_send(io_send_t sndfct, unsigned short sndlength, unsigned char *apdu_buffer)
 {
+#ifdef HAVE_IO_SCATTER_GATHER
+    io_iovec_t iov = {.ptr = apdu_buffer, .len = sndlength};
+
+    io_usb_hid_send_iov(sndfct, &iov, 1);
+#else  // HAVE_IO_SCATTER_GATHER
     // perform send
     if (sndlength) {
-        G_io_usb_hid_sequence_number  = 0;
-        G_io_usb_hid_current_buffer   = apdu_buffer;
-        G_io_usb_hid_remaining_length = sndlength;
-        G_io_usb_hid_total_length     = sndlength;
+        G_io_usb_hid_tx_sequence_number  = 0;
+        G_io_usb_hid_tx_current_buffer   = apdu_buffer;
+        G_io_usb_hid_tx_remaining_length = sndlength;
+#ifndef HAVE_IO_PIPELINE
+        G_io_usb_hid_total_length = sndlength;
+#endif  // HAVE_IO_PIPELINE
         io_usb_hid_sent(sndfct);
     }
+#endif  // HAVE_IO_SCATTER_GATHER
 }
 
 #endif  // HAVE_USB_APDU
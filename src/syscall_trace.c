@@ -0,0 +1,116 @@
+
+/*******************************************************************************
+ *   (c) 2023 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+#ifdef HAVE_SYSCALL_TRACE
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "os_io_seproxyhal.h"
+#include "os_utils.h"
+#include "syscall_trace.h"
+
+_Static_assert(SYSCALL_TRACE_ENTRIES > 0 && SYSCALL_TRACE_ENTRIES <= 256,
+               "The dump APDU addresses at most 256 entries");
+
+static syscall_trace_entry_t G_syscall_trace[SYSCALL_TRACE_ENTRIES];
+// Sequence number of the next syscall, never reset
+static uint32_t G_syscall_trace_seq;
+// Sequence number of the first syscall since the last clear
+static uint32_t G_syscall_trace_first;
+static uint16_t G_syscall_trace_apdu;
+
+__attribute__((weak)) uint32_t syscall_trace_get_ticks(void)
+{
+    return G_io_app.ms;
+}
+
+uint32_t syscall_trace_begin(uint32_t id)
+{
+    uint32_t               seq   = G_syscall_trace_seq++;
+    syscall_trace_entry_t *entry = &G_syscall_trace[seq % SYSCALL_TRACE_ENTRIES];
+
+    entry->seq      = seq;
+    entry->id       = id;
+    entry->apdu     = G_syscall_trace_apdu;
+    entry->duration = SYSCALL_TRACE_NO_RETURN;
+    entry->start    = syscall_trace_get_ticks();
+    return seq;
+}
+
+void syscall_trace_end(uint32_t seq)
+{
+    syscall_trace_entry_t *entry = &G_syscall_trace[seq % SYSCALL_TRACE_ENTRIES];
+    uint32_t               duration;
+
+    // The entry may have been reused by the syscalls issued by a callback
+    if (entry->seq != seq) {
+        return;
+    }
+    duration = syscall_trace_get_ticks() - entry->start;
+    if (duration >= SYSCALL_TRACE_NO_RETURN) {
+        duration = SYSCALL_TRACE_NO_RETURN - 1;
+    }
+    entry->duration = duration;
+}
+
+void syscall_trace_apdu_start(void)
+{
+    G_syscall_trace_apdu++;
+}
+
+void syscall_trace_clear(void)
+{
+    G_syscall_trace_first = G_syscall_trace_seq;
+    G_syscall_trace_apdu  = 0;
+}
+
+uint16_t syscall_trace_dump(uint16_t first, uint8_t *out, uint16_t out_len)
+{
+    uint32_t total    = G_syscall_trace_seq - G_syscall_trace_first;
+    uint32_t retained = total;
+    uint32_t oldest;
+    uint16_t count = 0;
+    uint16_t len   = 7;
+
+    if (out_len < len) {
+        return 0;
+    }
+    if (retained > SYSCALL_TRACE_ENTRIES) {
+        retained = SYSCALL_TRACE_ENTRIES;
+    }
+    oldest = G_syscall_trace_seq - retained;
+
+    while ((first + count < retained) && (len + SYSCALL_TRACE_ENTRY_SIZE <= out_len)) {
+        const syscall_trace_entry_t *entry
+            = &G_syscall_trace[(oldest + first + count) % SYSCALL_TRACE_ENTRIES];
+
+        U4BE_ENCODE(out, len, entry->id);
+        U4BE_ENCODE(out, len + 4, entry->start);
+        U2BE_ENCODE(out, len + 8, entry->duration);
+        U2BE_ENCODE(out, len + 10, entry->apdu);
+        len += SYSCALL_TRACE_ENTRY_SIZE;
+        count++;
+    }
+
+    U4BE_ENCODE(out, 0, total);
+    U2BE_ENCODE(out, 4, retained);
+    out[6] = count;
+    return len;
+}
+
+#endif  // HAVE_SYSCALL_TRACE
@@ -23,6 +23,32 @@
 unsigned int SVC_Call(unsigned int syscall_id, void *parameters);
 unsigned int SVC_cx_call(unsigned int syscall_id, unsigned int *parameters);
 
+#ifdef HAVE_SYSCALL_TRACE
+#include "syscall_trace.h"
+
+static unsigned int SVC_Call_traced(unsigned int syscall_id, void *parameters)
+{
+    uint32_t     seq = syscall_trace_begin(syscall_id);
+    unsigned int ret = SVC_Call(syscall_id, parameters);
+
+    syscall_trace_end(seq);
+    return ret;
+}
+
+static unsigned int SVC_cx_call_traced(unsigned int syscall_id, unsigned int *parameters)
+{
+    uint32_t     seq = syscall_trace_begin(syscall_id);
+    unsigned int ret = SVC_cx_call(syscall_id, parameters);
+
+    syscall_trace_end(seq);
+    return ret;
+}
+
+// All the stubs below go through the tracing wrappers
+#define SVC_Call    SVC_Call_traced
+#define SVC_cx_call SVC_cx_call_traced
+#endif  // HAVE_SYSCALL_TRACE
+
 unsigned int get_api_level(void)
 {
     unsigned int parameters[2 + 1];
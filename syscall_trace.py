@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+
+"""
+Decodes the syscall trace of an app built with ENABLE_SYSCALL_TRACE=1.
+
+The trace is read with the default APDU B0 5C: P1 = 00 returns the entries
+starting at the index P2, P1 = 01 clears them. The responses (hexadecimal,
+one per line, status word included or not) are read from a file or stdin, or
+fetched from the device with ledgercomm when --fetch is given.
+
+The output is either a per-APDU summary, or folded stacks
+("apdu;syscall weight") to be given to flamegraph.pl.
+"""
+
+import argparse
+import collections
+import os
+import re
+import struct
+import sys
+
+HEADER = struct.Struct(">IHB")
+ENTRY = struct.Struct(">IIHH")
+NO_RETURN = 0xFFFF
+
+
+def load_syscall_names():
+    """Maps the syscall IDs to their names, from include/syscalls.h."""
+    path = os.path.join(os.path.dirname(os.path.abspath(__file__)), "include", "syscalls.h")
+    names = {}
+    with open(path) as f:
+        for line in f:
+            m = re.match(r"#define\s+SYSCALL_(\w+)_ID_IN\s+(0x[0-9a-fA-F]+)", line)
+            if m:
+                names.setdefault(int(m.group(2), 16), m.group(1))
+    return names
+
+
+def parse_response(data):
+    """Returns (total, retained, entries) of a dump response."""
+    if len(data) >= HEADER.size + 2 and data[-2:] == b"\x90\x00":
+        data = data[:-2]
+    total, retained, count = HEADER.unpack_from(data)
+    if len(data) != HEADER.size + count * ENTRY.size:
+        raise ValueError("invalid response length %d" % len(data))
+    entries = [ENTRY.unpack_from(data, HEADER.size + i * ENTRY.size) for i in range(count)]
+    return total, retained, entries
+
+
+def read_responses(stream):
+    for line in stream:
+        line = line.strip()
+        if line:
+            yield bytes.fromhex(line)
+
+
+def fetch_responses():
+    from ledgercomm import Transport  # pylint: disable=import-outside-toplevel
+
+    transport = Transport(interface="hid")
+    index = 0
+    while True:
+        sw, data = transport.exchange(cla=0xB0, ins=0x5C, p1=0x00, p2=index)
+        if sw != 0x9000:
+            raise RuntimeError("dump APDU failed with status 0x%04X" % sw)
+        yield data
+        total, retained, entries = parse_response(data)
+        index += len(entries)
+        if not entries or index >= retained or index > 0xFF:
+            break
+    transport.close()
+
+
+def collect(responses):
+    total = 0
+    entries = []
+    for data in responses:
+        total, _, chunk = parse_response(data)
+        entries.extend(chunk)
+    return total, entries
+
+
+def summarize(total, entries, names):
+    print("%d syscalls issued, %d retained" % (total, len(entries)))
+    per_apdu = collections.OrderedDict()
+    for entry in entries:
+        per_apdu.setdefault(entry[3], []).append(entry)
+
+    for apdu, calls in per_apdu.items():
+        stats = collections.defaultdict(lambda: [0, 0, 0])
+        for sid, _, duration, _ in calls:
+            stat = stats[names.get(sid, "0x%08x" % sid)]
+            stat[0] += 1
+            if duration == NO_RETURN:
+                stat[2] += 1
+            else:
+                stat[1] += duration
+        ticks = sum(s[1] for s in stats.values())
+        print("\nAPDU %d: %d syscalls, %d ticks" % (apdu, len(calls), ticks))
+        for name, (count, duration, thrown) in sorted(stats.items(),
+                                                      key=lambda kv: (-kv[1][1], -kv[1][0])):
+            print("  %-40s %6d calls %8d ticks%s" % (name, count, duration,
+                                                     " (%d thrown)" % thrown if thrown else ""))
+
+
+def folded(entries, names, weight):
+    stacks = collections.Counter()
+    for sid, _, duration, apdu in entries:
+        name = names.get(sid, "0x%08x" % sid)
+        if weight == "count":
+            stacks["apdu_%d;%s" % (apdu, name)] += 1
+        elif duration != NO_RETURN:
+            stacks["apdu_%d;%s" % (apdu, name)] += duration
+    for stack, value in stacks.items():
+        print("%s %d" % (stack, value))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", nargs="?", help="file of hexadecimal responses (default: stdin)")
+    parser.add_argument("--fetch", action="store_true", help="read the trace from the device")
+    parser.add_argument("--folded", choices=["ticks", "count"],
+                        help="print folded stacks weighted by ticks or by call count")
+    args = parser.parse_args()
+
+    if args.fetch:
+        responses = fetch_responses()
+    elif args.input:
+        responses = read_responses(open(args.input))
+    else:
+        responses = read_responses(sys.stdin)
+
+    total, entries = collect(responses)
+    names = load_syscall_names()
+    if args.folded:
+        folded(entries, names, args.folded)
+    else:
+        summarize(total, entries, names)